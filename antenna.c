@@ -35,6 +35,7 @@
 #include "lef.h"
 #include "def.h"
 #include "point.h"
+#include "bitplane.h"
 
 /* Node Hash Table routines taken from delay.c */
 extern GATE FindGateNode(Tcl_HashTable *, NODE, int *);
@@ -172,7 +173,7 @@ find_free_antenna_taps(char *antennacell)
 		noderec = ginst->noderec[i];
 		if ((netnum == 0) && (noderec == NULL)) {
 		    ginst->netnum[i] = ANTENNA_NET;
-		    ginst->noderec[i] = (NODE)calloc(1, sizeof(struct node_));
+		    ginst->noderec[i] = (NODE)allocDesign(sizeof(struct node_));
 		    ginst->noderec[i]->netnum = ANTENNA_NET;
 		}
 	    }
@@ -235,6 +236,7 @@ void revert_antenna_taps(int netnum, NODE node)
 			if ((lnode == NULL) || (lnode->nodesav != node)) {
 			    OBSVAL(x, y, lay) &= ~(NETNUM_MASK | ROUTED_NET);
 			    OBSVAL(x, y, lay) |= ANTENNA_NET;
+			    update_obs_planes(x, y, lay);
 			}
 		    }
 		}
@@ -690,7 +692,7 @@ get_route_area_reverse_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 	u_char *visited, u_char method, Tcl_HashTable *NodeTable,
 	struct routeinfo_ *iroute)
 {
-    SEG seg, dseg, newseg, firstseg, saveseg;
+    SEG seg, newseg, firstseg, saveseg;
     NODE savestartnode, saveendnode;
     float area;
     u_char saveflags;
@@ -699,7 +701,7 @@ get_route_area_reverse_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 
     /* Reverse the route */
     for (seg = rt->segments; seg; seg = seg->next) {
-	newseg = (SEG)malloc(sizeof(struct seg_));
+	newseg = allocSEG();
 	newseg->layer = seg->layer;
 	newseg->x1 = seg->x2;
 	newseg->x2 = seg->x1;
@@ -742,11 +744,7 @@ get_route_area_reverse_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
     rt->flags |= saveflags;
 
     /* Free the reversed route */
-    for (seg = firstseg; seg; ) {
-	dseg = seg->next;
-	free(seg);
-	seg = dseg;
-    }
+    freeSEGlist(firstseg);
     return area;
 }
 
@@ -1014,6 +1012,7 @@ int set_antenna_to_net(int newflags, struct routeinfo_ *iroute,
 			rval = 1;
 			OBSVAL(x, y, lay) &= ~NETNUM_MASK;
 			OBSVAL(x, y, lay) |= net->netnum;
+			update_obs_planes(x, y, lay);
 		    }
 		}
 
@@ -1035,7 +1034,8 @@ int set_antenna_to_net(int newflags, struct routeinfo_ *iroute,
 int antenna_setup(struct routeinfo_ *iroute, ANTENNAINFO violation,
 	Tcl_HashTable *NodeTable)
 {
-    int i, j, netnum, rval;
+    int i, j, rval;
+    obsword netnum;
     PROUTE *Pr;
 
     for (i = 0; i < Num_layers; i++) {
@@ -1141,7 +1141,7 @@ int doantennaroute(ANTENNAINFO violation, Tcl_HashTable *NodeTable)
     if (result < 0) {
 	/* To do:  Handle failures? */
 	Fprintf(stderr, "Antenna anchoring route failed.\n");
-	free(rt1);
+	freeROUTE(rt1);
     }
     else {
 	TotalRoutes++;
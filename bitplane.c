@@ -0,0 +1,221 @@
+/*--------------------------------------------------------------*/
+/* bitplane.c --						*/
+/*								*/
+/* Obstruction bitplanes.  The Obs[] array packs a net number	*/
+/* and a set of flags into each grid position, so asking	*/
+/* whether a run of positions is free, or counting how many	*/
+/* are routed, means reading and masking every word.  The	*/
+/* planes below keep one bit per position for each flag of	*/
+/* interest, so that such questions are answered 64 positions	*/
+/* at a time with popcount and count-trailing-zeros.		*/
+/*								*/
+/* The planes are built from Obs[] once the design has been	*/
+/* set up, and every routine that changes Obs[] afterward	*/
+/* calls update_obs_planes() on the positions it changes.	*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "qconfig.h"
+#include "bitplane.h"
+
+planeword *ObsPlane[NUM_OBS_PLANES][MAX_LAYERS];
+int PlaneWords = 0;
+
+static const obsword ObsPlaneMask[NUM_OBS_PLANES] = {
+    NETNUM_MASK,	/* PLANE_OCCUPIED  */
+    ROUTED_NET,		/* PLANE_ROUTED	   */
+    NO_NET,		/* PLANE_NO_NET	   */
+    PINOBSTRUCTMASK,	/* PLANE_PINOBS	   */
+    BLOCKED_N,		/* PLANE_BLOCKED_N */
+    BLOCKED_S,		/* PLANE_BLOCKED_S */
+    BLOCKED_E,		/* PLANE_BLOCKED_E */
+    BLOCKED_W,		/* PLANE_BLOCKED_W */
+    BLOCKED_U,		/* PLANE_BLOCKED_U */
+    BLOCKED_D		/* PLANE_BLOCKED_D */
+};
+
+#ifndef __GNUC__
+
+/* Portable versions of the bit counting builtins */
+
+int plane_popcount(planeword w)
+{
+    int n = 0;
+
+    for (; w; w &= w - 1) n++;
+    return n;
+}
+
+int plane_ctz(planeword w)
+{
+    int n = 0;
+
+    for (; !(w & 1); w >>= 1) n++;
+    return n;
+}
+
+#endif
+
+/* Mask of bits from position "b" up to the end of a word, and	*/
+/* of bits up to and including position "b".			*/
+
+#define MASK_FROM(b)	(~(planeword)0 << (b))
+#define MASK_TO(b)	(~(planeword)0 >> (63 - (b)))
+
+/*--------------------------------------------------------------*/
+/* free_obs_planes ---						*/
+/*								*/
+/* Release the bitplanes, as when a new design is read.	*/
+/*--------------------------------------------------------------*/
+
+void free_obs_planes(void)
+{
+    int p, i;
+
+    for (p = 0; p < NUM_OBS_PLANES; p++) {
+	for (i = 0; i < MAX_LAYERS; i++) {
+	    free(ObsPlane[p][i]);
+	    ObsPlane[p][i] = NULL;
+	}
+    }
+    PlaneWords = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* build_obs_planes ---						*/
+/*								*/
+/* (Re)generate all bitplanes from the current Obs[] array.	*/
+/*--------------------------------------------------------------*/
+
+void build_obs_planes(void)
+{
+    int p, i, x, y;
+    obsword obsval;
+    planeword bit, *row[NUM_OBS_PLANES];
+
+    free_obs_planes();
+    PlaneWords = (NumChannelsX + 63) >> 6;
+
+    for (p = 0; p < NUM_OBS_PLANES; p++) {
+	for (i = 0; i < Num_layers; i++) {
+	    ObsPlane[p][i] = (planeword *)calloc(PlaneWords * NumChannelsY,
+			sizeof(planeword));
+	    if (ObsPlane[p][i] == NULL) {
+		Fprintf(stderr, "Out of memory allocating obstruction planes.\n");
+		exit(4);
+	    }
+	}
+    }
+
+    for (i = 0; i < Num_layers; i++) {
+	for (y = 0; y < NumChannelsY; y++) {
+	    for (p = 0; p < NUM_OBS_PLANES; p++)
+		row[p] = PLANEROW(p, y, i);
+	    for (x = 0; x < NumChannelsX; x++) {
+		obsval = OBSVAL(x, y, i);
+		bit = (planeword)1 << (x & 63);
+		for (p = 0; p < NUM_OBS_PLANES; p++)
+		    if (obsval & ObsPlaneMask[p])
+			row[p][x >> 6] |= bit;
+	    }
+	}
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* update_obs_planes ---					*/
+/*								*/
+/* Bring the bitplanes up to date with the Obs[] value at one	*/
+/* position.  Called after every change to Obs[] that is made	*/
+/* once the design has been set up.				*/
+/*--------------------------------------------------------------*/
+
+void update_obs_planes(int x, int y, int lay)
+{
+    int p, w;
+    obsword obsval;
+    planeword bit;
+
+    if (PlaneWords == 0) return;	/* Planes not built yet */
+
+    obsval = OBSVAL(x, y, lay);
+    w = y * PlaneWords + (x >> 6);
+    bit = (planeword)1 << (x & 63);
+
+    for (p = 0; p < NUM_OBS_PLANES; p++) {
+	if (obsval & ObsPlaneMask[p])
+	    ObsPlane[p][lay][w] |= bit;
+	else
+	    ObsPlane[p][lay][w] &= ~bit;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* count_plane_run ---						*/
+/*								*/
+/* Return the number of positions from xmin to xmax (inclusive)	*/
+/* in row y of layer lay that are set in the given plane.	*/
+/*--------------------------------------------------------------*/
+
+int count_plane_run(int plane, int lay, int y, int xmin, int xmax)
+{
+    planeword *row, word;
+    int w, wmin, wmax, count;
+
+    if (xmin < 0) xmin = 0;
+    if (xmax >= NumChannelsX) xmax = NumChannelsX - 1;
+    if (xmin > xmax) return 0;
+
+    row = PLANEROW(plane, y, lay);
+    wmin = xmin >> 6;
+    wmax = xmax >> 6;
+
+    if (wmin == wmax) {
+	word = row[wmin] & MASK_FROM(xmin & 63) & MASK_TO(xmax & 63);
+	return PLANE_POPCOUNT(word);
+    }
+
+    count = PLANE_POPCOUNT(row[wmin] & MASK_FROM(xmin & 63));
+    for (w = wmin + 1; w < wmax; w++)
+	count += PLANE_POPCOUNT(row[w]);
+    count += PLANE_POPCOUNT(row[wmax] & MASK_TO(xmax & 63));
+    return count;
+}
+
+/*--------------------------------------------------------------*/
+/* find_plane_run ---						*/
+/*								*/
+/* Return the first position from xmin to xmax (inclusive) in	*/
+/* row y of layer lay whose bit in the given plane is set (if	*/
+/* "set" is TRUE) or clear (if "set" is FALSE), or -1 if there	*/
+/* is none.  For example, a run of positions is free of nets	*/
+/* and obstructions if					*/
+/*								*/
+/*    find_plane_run(PLANE_OCCUPIED, lay, y, x1, x2, TRUE) < 0	*/
+/*--------------------------------------------------------------*/
+
+int find_plane_run(int plane, int lay, int y, int xmin, int xmax, u_char set)
+{
+    planeword *row, word;
+    int w, wmin, wmax;
+
+    if (xmin < 0) xmin = 0;
+    if (xmax >= NumChannelsX) xmax = NumChannelsX - 1;
+    if (xmin > xmax) return -1;
+
+    row = PLANEROW(plane, y, lay);
+    wmin = xmin >> 6;
+    wmax = xmax >> 6;
+
+    for (w = wmin; w <= wmax; w++) {
+	word = (set) ? row[w] : ~row[w];
+	if (w == wmin) word &= MASK_FROM(xmin & 63);
+	if (w == wmax) word &= MASK_TO(xmax & 63);
+	if (word != 0) return (w << 6) + PLANE_CTZ(word);
+    }
+    return -1;
+}
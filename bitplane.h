@@ -0,0 +1,58 @@
+/*
+ * bitplane.h --
+ *
+ * Per-layer bitplanes derived from the Obs[] array, for counting
+ * and scanning runs of grid positions a 64-bit word at a time.
+ *
+ */
+
+#ifndef _BITPLANEINT_H
+#define _BITPLANEINT_H
+
+#include <stdint.h>
+
+/* Each plane holds one bit per grid position, set when the	*/
+/* position's Obs[] value has any of the bits in the plane's	*/
+/* mask (see ObsPlaneMask[] in bitplane.c).  Rows are padded	*/
+/* out to a whole number of 64-bit words.			*/
+
+#define PLANE_OCCUPIED	0	/* Net number or NO_NET (not free)	*/
+#define PLANE_ROUTED	1	/* ROUTED_NET				*/
+#define PLANE_NO_NET	2	/* NO_NET				*/
+#define PLANE_PINOBS	3	/* OFFSET_TAP or STUBROUTE		*/
+#define PLANE_BLOCKED_N	4	/* Blocked directions, one plane each	*/
+#define PLANE_BLOCKED_S	5
+#define PLANE_BLOCKED_E	6
+#define PLANE_BLOCKED_W	7
+#define PLANE_BLOCKED_U	8
+#define PLANE_BLOCKED_D	9
+#define NUM_OBS_PLANES	10
+
+typedef uint64_t planeword;
+
+extern planeword *ObsPlane[NUM_OBS_PLANES][MAX_LAYERS];
+extern int PlaneWords;		/* Words per row of a plane */
+
+#define PLANEROW(p, y, l)  (ObsPlane[p][l] + ((y) * PlaneWords))
+
+/* Population count and count of trailing zeros of one word	*/
+/* (PLANE_CTZ is undefined for a zero word).			*/
+
+#ifdef __GNUC__
+#define PLANE_POPCOUNT(w)	__builtin_popcountll(w)
+#define PLANE_CTZ(w)		__builtin_ctzll(w)
+#else
+extern int plane_popcount(planeword w);
+extern int plane_ctz(planeword w);
+#define PLANE_POPCOUNT(w)	plane_popcount(w)
+#define PLANE_CTZ(w)		plane_ctz(w)
+#endif
+
+extern void build_obs_planes(void);
+extern void free_obs_planes(void);
+extern void update_obs_planes(int x, int y, int lay);
+extern int count_plane_run(int plane, int lay, int y, int xmin, int xmax);
+extern int find_plane_run(int plane, int lay, int y, int xmin, int xmax,
+		u_char set);
+
+#endif /* _BITPLANEINT_H */
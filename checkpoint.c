@@ -0,0 +1,723 @@
+/*--------------------------------------------------------------*/
+/* checkpoint.c --						*/
+/*								*/
+/* Save the routing state of the current design to a binary	*/
+/* file, and restore it, so that routing can be resumed from	*/
+/* the end of any stage without routing again, or reading	*/
+/* routes back from DEF (and checking them).			*/
+/*								*/
+/* A checkpoint holds everything that routing changes:  the	*/
+/* Obs[] and Nodeinfo[] arrays;  each net's routes, flags,	*/
+/* order and rip-up history;  the list of failed nets;  and	*/
+/* the routing parameters.  It does not hold the design	*/
+/* itself, which is read from the same LEF, DEF and		*/
+/* configuration files as usual before the checkpoint is	*/
+/* loaded.  The checkpoint records enough about the design	*/
+/* (net names, node counts and the route grid) to refuse to	*/
+/* be loaded onto a different one.				*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "qrouter.h"
+#include "qconfig.h"
+#include "point.h"
+#include "bitplane.h"
+#include "checkpoint.h"
+
+extern int TotalRoutes;
+
+char *ckptsavename = NULL;
+char *ckptloadname = NULL;
+
+#define CKPT_VERSION	1
+#define CKPT_TRAILER	0x51524350	/* Marks a complete file */
+
+typedef struct ckptheader_ {
+    char     magic[8];		/* "QRCKPT" */
+    u_int    version;
+    u_int    wordsize;		/* Size of an Obs[] entry */
+    int      numnets;
+    int      numnodes;
+    int      num_layers;
+    int      pinlayers;
+    int      channelsx, channelsy;
+    double   xlower, ylower;
+    double   pitchx, pitchy;
+    uint64_t design;		/* Hash of net names and node counts */
+} CkptHeader;
+
+/* Table for finding the index of a node or route record from	*/
+/* its address.							*/
+
+typedef struct ckptref_ {
+    void *ptr;
+    int   idx;
+} CkptRef;
+
+typedef struct ckptin_ {
+    char  *pos, *end;
+    u_char bad;
+} CkptIn;
+
+/*--------------------------------------------------------------*/
+/* Output and input of values					*/
+/*--------------------------------------------------------------*/
+
+static void ckPut(FILE *f, void *data, size_t len) { fwrite(data, 1, len, f); }
+static void ckPutInt(FILE *f, int v)		    { fwrite(&v, sizeof(int), 1, f); }
+
+static void
+ckGet(CkptIn *in, void *data, size_t len)
+{
+    if (in->bad || (len > (size_t)(in->end - in->pos))) {
+	in->bad = TRUE;
+	memset(data, 0, len);
+	return;
+    }
+    memcpy(data, in->pos, len);
+    in->pos += len;
+}
+
+static int
+ckGetInt(CkptIn *in)
+{
+    int v;
+
+    ckGet(in, &v, sizeof(int));
+    return v;
+}
+
+static int
+ckRefCompare(const void *a, const void *b)
+{
+    char *pa = (char *)((CkptRef *)a)->ptr;
+    char *pb = (char *)((CkptRef *)b)->ptr;
+
+    return (pa < pb) ? -1 : (pa > pb) ? 1 : 0;
+}
+
+/* Return the index of the record at "ptr", -1 for NULL, or -2	*/
+/* if the record is not in the table.				*/
+
+static int
+ckRefIndex(CkptRef *table, int n, void *ptr)
+{
+    CkptRef key, *ref;
+
+    if (ptr == NULL) return -1;
+    key.ptr = ptr;
+    ref = (CkptRef *)bsearch(&key, table, n, sizeof(CkptRef), ckRefCompare);
+    return (ref) ? ref->idx : -2;
+}
+
+/* Nets are identified by their position in order of name, as	*/
+/* net numbers are not necessarily unique (power nets may share	*/
+/* a number with a signal net) and Nlnets is reordered by	*/
+/* routing.							*/
+
+static int
+ckNetCompare(const void *a, const void *b)
+{
+    return strcmp((*(NET *)a)->netname, (*(NET *)b)->netname);
+}
+
+static NET *
+ckNetsByName()
+{
+    NET *nets;
+
+    nets = (NET *)malloc((Numnets + 1) * sizeof(NET));
+    memcpy(nets, Nlnets, Numnets * sizeof(NET));
+    qsort(nets, Numnets, sizeof(NET), ckNetCompare);
+    return nets;
+}
+
+/*--------------------------------------------------------------*/
+/* Fill in the header describing the current design		*/
+/*--------------------------------------------------------------*/
+
+static void
+ckMakeHeader(CkptHeader *hdr)
+{
+    NET net;
+    NODE node;
+    uint64_t h;
+    char *p;
+    int i;
+
+    memset(hdr, 0, sizeof(CkptHeader));
+    strcpy(hdr->magic, "QRCKPT");
+    hdr->version = CKPT_VERSION;
+    hdr->wordsize = sizeof(obsword);
+    hdr->numnets = Numnets;
+    hdr->num_layers = Num_layers;
+    hdr->pinlayers = Pinlayers;
+    hdr->channelsx = NumChannelsX;
+    hdr->channelsy = NumChannelsY;
+    hdr->xlower = Xlowerbound;
+    hdr->ylower = Ylowerbound;
+    hdr->pitchx = PitchX;
+    hdr->pitchy = PitchY;
+
+    /* Sum of per-net hashes, so that the order of Nlnets,	*/
+    /* which routing may change, does not matter.		*/
+
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	h = 14695981039346656037ULL;
+	for (p = net->netname; *p; p++)
+	    h = (h ^ (uint64_t)(u_char)*p) * 1099511628211ULL;
+	h = (h ^ (uint64_t)net->netnum) * 1099511628211ULL;
+	for (node = net->netnodes; node; node = node->next) {
+	    hdr->numnodes++;
+	    h = (h ^ (uint64_t)node->nodenum) * 1099511628211ULL;
+	}
+	hdr->design += h;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* save_checkpoint ---						*/
+/*								*/
+/* Write the routing state of the current design to		*/
+/* "filename".  The file is written under a temporary name	*/
+/* and renamed when complete.					*/
+/*								*/
+/* Returns 0 on success, 1 on failure.				*/
+/*--------------------------------------------------------------*/
+
+int
+save_checkpoint(char *filename)
+{
+    CkptHeader hdr;
+    CkptRef *nodetab, *routetab, *nettab;
+    NET net, *byname;
+    NODE node;
+    ROUTE rt;
+    SEG seg;
+    NETLIST nl;
+    NODEINFO ni;
+    FILE *f;
+    char *tmpname;
+    int i, j, n, numnodes, numroutes, result;
+    u_char cfg[3];
+
+    if ((Nlnets == NULL) || (Obs[0] == NULL)) {
+	Fprintf(stderr, "No design has been set up, nothing to save.\n");
+	return 1;
+    }
+    ckMakeHeader(&hdr);
+
+    /* Number every node and route, in the order they are written */
+
+    numroutes = 0;
+    for (i = 0; i < Numnets; i++)
+	for (rt = Nlnets[i]->routes; rt; rt = rt->next) numroutes++;
+
+    nodetab = (CkptRef *)malloc((hdr.numnodes + 1) * sizeof(CkptRef));
+    routetab = (CkptRef *)malloc((numroutes + 1) * sizeof(CkptRef));
+    numnodes = numroutes = 0;
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	for (node = net->netnodes; node; node = node->next) {
+	    nodetab[numnodes].ptr = (void *)node;
+	    nodetab[numnodes].idx = numnodes;
+	    numnodes++;
+	}
+	for (rt = net->routes; rt; rt = rt->next) {
+	    routetab[numroutes].ptr = (void *)rt;
+	    routetab[numroutes].idx = numroutes;
+	    numroutes++;
+	}
+    }
+    qsort(nodetab, numnodes, sizeof(CkptRef), ckRefCompare);
+    qsort(routetab, numroutes, sizeof(CkptRef), ckRefCompare);
+
+    byname = ckNetsByName();
+    nettab = (CkptRef *)malloc((Numnets + 1) * sizeof(CkptRef));
+    for (i = 0; i < Numnets; i++) {
+	nettab[i].ptr = (void *)byname[i];
+	nettab[i].idx = i;
+    }
+    free(byname);
+    qsort(nettab, Numnets, sizeof(CkptRef), ckRefCompare);
+
+    tmpname = (char *)malloc(strlen(filename) + 16);
+    sprintf(tmpname, "%s.%d", filename, (int)getpid());
+    f = fopen(tmpname, "w");
+    if (f == NULL) {
+	Fprintf(stderr, "Cannot open checkpoint file %s for writing.\n", filename);
+	free(tmpname);
+	free(nodetab);
+	free(routetab);
+	free(nettab);
+	return 1;
+    }
+
+    ckPut(f, &hdr, sizeof(CkptHeader));
+
+    /* Routing parameters */
+
+    ckPutInt(f, Numpasses);
+    ckPutInt(f, (int)StackedContacts);
+    ckPutInt(f, SegCost);
+    ckPutInt(f, ViaCost);
+    ckPutInt(f, JogCost);
+    ckPutInt(f, XverCost);
+    ckPutInt(f, BlockCost);
+    ckPutInt(f, OffsetCost);
+    ckPutInt(f, ConflictCost);
+    ckPutInt(f, TotalRoutes);
+    cfg[0] = maskMode;
+    cfg[1] = ripLimit;
+    cfg[2] = unblockAll;
+    ckPut(f, cfg, 3);
+    ckPut(f, needblock, MAX_LAYERS);
+
+    /* Net order */
+
+    for (i = 0; i < Numnets; i++)
+	ckPutInt(f, ckRefIndex(nettab, Numnets, (void *)Nlnets[i]));
+
+    /* Nets, in order */
+
+    result = 0;
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	ckPutInt(f, (int)net->flags);
+	ckPutInt(f, net->netorder);
+	ckPutInt(f, net->xmin);
+	ckPutInt(f, net->ymin);
+	ckPutInt(f, net->xmax);
+	ckPutInt(f, net->ymax);
+	ckPutInt(f, net->trunkx);
+	ckPutInt(f, net->trunky);
+
+	for (n = 0, nl = net->noripup; nl; nl = nl->next) n++;
+	ckPutInt(f, n);
+	for (nl = net->noripup; nl; nl = nl->next)
+	    ckPutInt(f, ckRefIndex(nettab, Numnets, (void *)nl->net));
+
+	for (node = net->netnodes; node; node = node->next) {
+	    ckPutInt(f, (int)node->numtaps);
+	    ckPutInt(f, node->branchx);
+	    ckPutInt(f, node->branchy);
+	}
+
+	for (n = 0, rt = net->routes; rt; rt = rt->next) n++;
+	ckPutInt(f, n);
+	for (rt = net->routes; rt; rt = rt->next) {
+	    ckPutInt(f, rt->netnum);
+	    ckPutInt(f, (int)rt->flags);
+	    if (rt->flags & RT_START_NODE)
+		j = ckRefIndex(nodetab, numnodes, (void *)rt->start.node);
+	    else
+		j = ckRefIndex(routetab, numroutes, (void *)rt->start.route);
+	    if (j == -2) result = 1;
+	    ckPutInt(f, j);
+	    if (rt->flags & RT_END_NODE)
+		j = ckRefIndex(nodetab, numnodes, (void *)rt->end.node);
+	    else
+		j = ckRefIndex(routetab, numroutes, (void *)rt->end.route);
+	    if (j == -2) result = 1;
+	    ckPutInt(f, j);
+
+	    for (n = 0, seg = rt->segments; seg; seg = seg->next) n++;
+	    ckPutInt(f, n);
+	    for (seg = rt->segments; seg; seg = seg->next) {
+		ckPutInt(f, seg->layer);
+		ckPutInt(f, seg->x1);
+		ckPutInt(f, seg->y1);
+		ckPutInt(f, seg->x2);
+		ckPutInt(f, seg->y2);
+		ckPut(f, &seg->segtype, 1);
+	    }
+	}
+    }
+
+    /* Failed nets */
+
+    ckPutInt(f, countlist(FailedNets));
+    for (nl = FailedNets; nl; nl = nl->next)
+	ckPutInt(f, ckRefIndex(nettab, Numnets, (void *)nl->net));
+
+    /* Obstruction and node information arrays */
+
+    for (i = 0; i < Num_layers; i++)
+	ckPut(f, Obs[i], NumChannelsX * NumChannelsY * sizeof(obsword));
+
+    for (i = 0; i < Pinlayers; i++) {
+	for (n = 0, j = 0; j < NumChannelsX * NumChannelsY; j++)
+	    if (Nodeinfo[i][j]) n++;
+	ckPutInt(f, n);
+	for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
+	    ni = Nodeinfo[i][j];
+	    if (ni == NULL) continue;
+	    ckPutInt(f, j);
+	    n = ckRefIndex(nodetab, numnodes, (void *)ni->nodesav);
+	    if (n == -2) result = 1;
+	    ckPutInt(f, n);
+	    n = ckRefIndex(nodetab, numnodes, (void *)ni->nodeloc);
+	    if (n == -2) result = 1;
+	    ckPutInt(f, n);
+	    ckPut(f, &ni->stub, sizeof(float));
+	    ckPut(f, &ni->offset, sizeof(float));
+	    ckPut(f, &ni->flags, 1);
+	}
+    }
+    ckPutInt(f, CKPT_TRAILER);
+
+    free(nodetab);
+    free(routetab);
+    free(nettab);
+
+    if (result != 0)
+	Fprintf(stderr, "Checkpoint:  Routing database refers to records "
+		"outside of the netlist, cannot save.\n");
+    else if (ferror(f))
+	result = 1;
+    if (fclose(f) != 0) result = 1;
+    if ((result == 0) && (rename(tmpname, filename) != 0)) result = 1;
+    if (result != 0) {
+	unlink(tmpname);
+	Fprintf(stderr, "Failed to write checkpoint file %s.\n", filename);
+    }
+    else if (Verbose > 0)
+	Fprintf(stdout, "Saved routing checkpoint to %s.\n", filename);
+
+    free(tmpname);
+    return result;
+}
+
+/*--------------------------------------------------------------*/
+/* load_checkpoint ---						*/
+/*								*/
+/* Replace the routing state of the current design with the	*/
+/* one saved in "filename".  The design must have been read	*/
+/* (read_def) from the same files as when the checkpoint was	*/
+/* saved.							*/
+/*								*/
+/* Returns 0 on success, 1 on failure.  If the file does not	*/
+/* match the design, nothing is changed.			*/
+/*--------------------------------------------------------------*/
+
+int
+load_checkpoint(char *filename)
+{
+    CkptHeader hdr;
+    CkptIn in;
+    NET net, *byname, *order;
+    NODE node, *nodes;
+    ROUTE rt, lastrt, *routes;
+    SEG seg, lastseg;
+    NETLIST nl, lastnl;
+    NODEINFO ni;
+    struct stat st;
+    char *data;
+    int fd, i, j, n, s, numnodes, numroutes, allroutes, trailer;
+    int *startref, *endref, params[10];
+    u_char cfg[3], blocks[MAX_LAYERS], *seen;
+
+    if ((Nlnets == NULL) || (Obs[0] == NULL)) {
+	Fprintf(stderr, "No design has been set up, cannot load a checkpoint.\n");
+	return 1;
+    }
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+	Fprintf(stderr, "Cannot open checkpoint file %s.\n", filename);
+	return 1;
+    }
+    if ((fstat(fd, &st) != 0) || (st.st_size < sizeof(CkptHeader) + sizeof(int))) {
+	close(fd);
+	Fprintf(stderr, "Checkpoint file %s is not valid.\n", filename);
+	return 1;
+    }
+#ifdef HAVE_SYS_MMAN_H
+    data = (char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ((void *)data == MAP_FAILED) {
+	Fprintf(stderr, "Cannot read checkpoint file %s.\n", filename);
+	return 1;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+#else
+    data = (char *)malloc(st.st_size);
+    n = read(fd, data, st.st_size);
+    close(fd);
+    if (n != st.st_size) {
+	free(data);
+	Fprintf(stderr, "Cannot read checkpoint file %s.\n", filename);
+	return 1;
+    }
+#endif
+
+    /* Check that the file is complete and matches the design */
+
+    ckMakeHeader(&hdr);
+    memcpy(&trailer, data + st.st_size - sizeof(int), sizeof(int));
+    if (memcmp(data, "QRCKPT", 7) || (trailer != CKPT_TRAILER)) {
+	Fprintf(stderr, "File %s is not a complete routing checkpoint.\n", filename);
+	goto failed;
+    }
+    if (memcmp(data, &hdr, sizeof(CkptHeader))) {
+	Fprintf(stderr, "Checkpoint %s was not saved from this design "
+		"(or from this version of qrouter).\n", filename);
+	goto failed;
+    }
+    in.pos = data + sizeof(CkptHeader);
+    in.end = data + st.st_size - sizeof(int);
+    in.bad = FALSE;
+
+    /* Routing parameters.  These are applied only after the net	*/
+    /* order has been checked, as that is the last chance to leave	*/
+    /* the design unchanged.						*/
+
+    for (i = 0; i < 10; i++)
+	params[i] = ckGetInt(&in);
+    ckGet(&in, cfg, 3);
+    ckGet(&in, blocks, MAX_LAYERS);
+
+    /* Net order */
+
+    byname = ckNetsByName();
+
+    order = (NET *)malloc(Numnets * sizeof(NET));
+    seen = (u_char *)calloc(Numnets + 1, sizeof(u_char));
+    for (i = 0; i < Numnets; i++) {
+	n = ckGetInt(&in);
+	if ((n < 0) || (n >= Numnets) || seen[n]) {
+	    in.bad = TRUE;
+	    break;
+	}
+	seen[n] = TRUE;
+	order[i] = byname[n];
+    }
+    free(seen);
+    if (in.bad) {
+	Fprintf(stderr, "Checkpoint %s is corrupt.\n", filename);
+	free(order);
+	free(byname);
+	goto failed;
+    }
+
+    Numpasses = params[0];
+    StackedContacts = (char)params[1];
+    SegCost = params[2];
+    ViaCost = params[3];
+    JogCost = params[4];
+    XverCost = params[5];
+    BlockCost = params[6];
+    OffsetCost = params[7];
+    ConflictCost = params[8];
+    TotalRoutes = params[9];
+    maskMode = cfg[0];
+    ripLimit = cfg[1];
+    unblockAll = cfg[2];
+    memcpy(needblock, blocks, MAX_LAYERS);
+
+    /* Release the current routing state */
+
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	freeROUTElist(net->routes);
+	net->routes = NULL;
+	freeNETLISTlist(net->noripup);
+	net->noripup = NULL;
+    }
+    remove_failed();
+
+    memcpy(Nlnets, order, Numnets * sizeof(NET));
+    free(order);
+
+    nodes = (NODE *)malloc((hdr.numnodes + 1) * sizeof(NODE));
+    numnodes = 0;
+    for (i = 0; i < Numnets; i++)
+	for (node = Nlnets[i]->netnodes; node; node = node->next)
+	    nodes[numnodes++] = node;
+
+    /* Nets.  References between routes are resolved once all	*/
+    /* routes have been read.					*/
+
+    allroutes = 1024;
+    routes = (ROUTE *)malloc(allroutes * sizeof(ROUTE));
+    startref = (int *)malloc(allroutes * sizeof(int));
+    endref = (int *)malloc(allroutes * sizeof(int));
+    numroutes = 0;
+
+    for (i = 0; (i < Numnets) && !in.bad; i++) {
+	net = Nlnets[i];
+	net->flags = (u_char)ckGetInt(&in);
+	net->netorder = ckGetInt(&in);
+	net->xmin = ckGetInt(&in);
+	net->ymin = ckGetInt(&in);
+	net->xmax = ckGetInt(&in);
+	net->ymax = ckGetInt(&in);
+	net->trunkx = ckGetInt(&in);
+	net->trunky = ckGetInt(&in);
+
+	lastnl = NULL;
+	for (n = ckGetInt(&in); (n > 0) && !in.bad; n--) {
+	    j = ckGetInt(&in);
+	    if ((j < 0) || (j >= Numnets)) {
+		in.bad = TRUE;
+		break;
+	    }
+	    nl = allocNETLIST();
+	    nl->net = byname[j];
+	    nl->next = NULL;
+	    if (lastnl) lastnl->next = nl; else net->noripup = nl;
+	    lastnl = nl;
+	}
+
+	for (node = net->netnodes; node; node = node->next) {
+	    node->numtaps = (u_char)ckGetInt(&in);
+	    node->branchx = ckGetInt(&in);
+	    node->branchy = ckGetInt(&in);
+	}
+
+	lastrt = NULL;
+	for (n = ckGetInt(&in); (n > 0) && !in.bad; n--) {
+	    if (numroutes == allroutes) {
+		allroutes *= 2;
+		routes = (ROUTE *)realloc(routes, allroutes * sizeof(ROUTE));
+		startref = (int *)realloc(startref, allroutes * sizeof(int));
+		endref = (int *)realloc(endref, allroutes * sizeof(int));
+	    }
+	    rt = allocROUTE();
+	    rt->netnum = ckGetInt(&in);
+	    rt->flags = (u_char)ckGetInt(&in);
+	    startref[numroutes] = ckGetInt(&in);
+	    endref[numroutes] = ckGetInt(&in);
+	    rt->start.route = rt->end.route = NULL;
+	    rt->segments = NULL;
+	    rt->next = NULL;
+	    if (lastrt) lastrt->next = rt; else net->routes = rt;
+	    lastrt = rt;
+	    routes[numroutes++] = rt;
+
+	    lastseg = NULL;
+	    for (s = ckGetInt(&in); (s > 0) && !in.bad; s--) {
+		seg = allocSEG();
+		seg->layer = ckGetInt(&in);
+		seg->x1 = ckGetInt(&in);
+		seg->y1 = ckGetInt(&in);
+		seg->x2 = ckGetInt(&in);
+		seg->y2 = ckGetInt(&in);
+		ckGet(&in, &seg->segtype, 1);
+		seg->next = NULL;
+		if (lastseg) lastseg->next = seg; else rt->segments = seg;
+		lastseg = seg;
+	    }
+	}
+    }
+
+    for (i = 0; (i < numroutes) && !in.bad; i++) {
+	rt = routes[i];
+	j = startref[i];
+	if (j >= ((rt->flags & RT_START_NODE) ? numnodes : numroutes))
+	    in.bad = TRUE;
+	else if (j >= 0) {
+	    if (rt->flags & RT_START_NODE)
+		rt->start.node = nodes[j];
+	    else
+		rt->start.route = routes[j];
+	}
+	j = endref[i];
+	if (j >= ((rt->flags & RT_END_NODE) ? numnodes : numroutes))
+	    in.bad = TRUE;
+	else if (j >= 0) {
+	    if (rt->flags & RT_END_NODE)
+		rt->end.node = nodes[j];
+	    else
+		rt->end.route = routes[j];
+	}
+    }
+    free(routes);
+    free(startref);
+    free(endref);
+
+    /* Failed nets */
+
+    lastnl = NULL;
+    for (n = ckGetInt(&in); (n > 0) && !in.bad; n--) {
+	j = ckGetInt(&in);
+	if ((j < 0) || (j >= Numnets)) {
+	    in.bad = TRUE;
+	    break;
+	}
+	nl = allocNETLIST();
+	nl->net = byname[j];
+	nl->next = NULL;
+	if (lastnl) lastnl->next = nl; else FailedNets = nl;
+	lastnl = nl;
+    }
+    free(byname);
+
+    /* Obstruction and node information arrays */
+
+    for (i = 0; i < Num_layers; i++)
+	ckGet(&in, Obs[i], NumChannelsX * NumChannelsY * sizeof(obsword));
+
+    for (i = 0; (i < Pinlayers) && !in.bad; i++) {
+	for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
+	    if (Nodeinfo[i][j]) {
+		freeNODEINFO(Nodeinfo[i][j]);
+		Nodeinfo[i][j] = NULL;
+	    }
+	}
+	for (n = ckGetInt(&in); (n > 0) && !in.bad; n--) {
+	    j = ckGetInt(&in);
+	    if ((j < 0) || (j >= NumChannelsX * NumChannelsY)) {
+		in.bad = TRUE;
+		break;
+	    }
+	    ni = allocNODEINFO();
+	    s = ckGetInt(&in);
+	    ni->nodesav = ((s >= 0) && (s < numnodes)) ? nodes[s] : NULL;
+	    s = ckGetInt(&in);
+	    ni->nodeloc = ((s >= 0) && (s < numnodes)) ? nodes[s] : NULL;
+	    ckGet(&in, &ni->stub, sizeof(float));
+	    ckGet(&in, &ni->offset, sizeof(float));
+	    ckGet(&in, &ni->flags, 1);
+	    Nodeinfo[i][j] = ni;
+	}
+    }
+    free(nodes);
+
+    if (in.bad || (in.pos != in.end)) {
+	Fprintf(stderr, "Checkpoint %s is corrupt;  the routing state is "
+		"incomplete.  Read the DEF file again.\n", filename);
+	goto failed;
+    }
+
+    /* The obstruction bitplanes are derived from Obs[] */
+    build_obs_planes();
+
+#ifdef HAVE_SYS_MMAN_H
+    munmap(data, (size_t)st.st_size);
+#else
+    free(data);
+#endif
+    if (Verbose > 0)
+	Fprintf(stdout, "Loaded routing checkpoint from %s (%d nets failing).\n",
+		filename, countlist(FailedNets));
+    return 0;
+
+failed:
+#ifdef HAVE_SYS_MMAN_H
+    munmap(data, (size_t)st.st_size);
+#else
+    free(data);
+#endif
+    return 1;
+}
@@ -0,0 +1,17 @@
+/*
+ * checkpoint.h --
+ *
+ * Saving and restoring the routing state of a design.
+ *
+ */
+
+#ifndef _CHECKPOINTINT_H
+#define _CHECKPOINTINT_H
+
+extern char *ckptsavename;	/* Checkpoint to write after routing (-S) */
+extern char *ckptloadname;	/* Checkpoint to resume from (-L) */
+
+int    save_checkpoint(char *filename);
+int    load_checkpoint(char *filename);
+
+#endif /* _CHECKPOINTINT_H */
@@ -24,80 +24,40 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <math.h>		/* for roundf() function, if std=c99 */
+#include <sys/stat.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include "qrouter.h"
+#include "point.h"
 #include "node.h"
 #include "qconfig.h"
 #include "maze.h"
 #include "lef.h"
 #include "def.h"
+#include "hash.h"
+#include "zfile.h"
 
 TRACKS *Tracks = NULL;
+static int numTracks = 0;	/* Number of layers in Tracks */
 int numSpecial = 0;		/* Tracks number of specialnets */
+DefSections DefSectionInfo = {0, 0, 0, -1, -1, -1, -1};
 
-#ifndef TCL_QROUTER
+/* These hash tables speed up DEF file reading.  Instance and	*/
+/* net names are case sensitive (NAMESCASESENSITIVE ON) in the	*/
+/* Tcl version, as they were with Tcl hash tables.  The		*/
+/* standalone version has always matched them regardless of	*/
+/* case, and still does.					*/
 
-/* Find an instance in the instance list.  If qrouter	*/
-/* is compiled with Tcl support, then this routine	*/
-/* uses Tcl hash tables, greatly speeding up the	*/
-/* read-in of large DEF files.				*/
+#ifdef TCL_QROUTER
+#define DEF_NAME_CASE	HASH_CASE
+#else
+#define DEF_NAME_CASE	HASH_NOCASE
+#endif
 
-GATE
-DefFindGate(char *name)
-{
-    GATE ginst;
-
-    for (ginst = Nlgates; ginst; ginst = ginst->next) {
-	if (!strcasecmp(ginst->gatename, name))
-	    return ginst;
-    }
-    return NULL;
-}
-
-/* Find a net in the list of nets.  If qrouter is	*/
-/* compiled with Tcl support, then this routine		*/
-/* uses Tcl hash tables, greatly speeding up the	*/
-/* read-in of large DEF files.				*/
-
-NET
-DefFindNet(char *name)
-{
-    int i;
-    NET net;
-
-    for (i = 0; i < Numnets; i++) {
-	net = Nlnets[i];
-	if (!strcasecmp(net->netname, name))
-	    return net;
-    }
-    return NULL;
-}
-
-/* For the non-Tcl version, these are empty placeholders */
-
-static void
-DefHashInit(void)
-{
-}
-
-static void
-DefHashInstance(GATE gateginfo)
-{
-}
-
-static void
-DefHashNet(NET net)
-{
-}
-
-#else /* The versions using TCL hash tables */
-
-#include <tk.h>
-
-/* These hash tables speed up DEF file reading */
-
-static Tcl_HashTable InstanceTable;
-static Tcl_HashTable NetTable;
+static HashTable InstanceTable;
+static HashTable NetTable;
 
 /*--------------------------------------------------------------*/
 /* Cell macro lookup based on the hash table			*/
@@ -106,35 +66,28 @@ static Tcl_HashTable NetTable;
 static void
 DefHashInit(void)
 {
-   /* Initialize the macro hash table */
+   /* Initialize the macro hash table.  Any entries remaining	*/
+   /* from a previous design are discarded.			*/
 
-   Tcl_InitHashTable(&InstanceTable, TCL_STRING_KEYS);
-   Tcl_InitHashTable(&NetTable, TCL_STRING_KEYS);
+   HashKill(&InstanceTable);
+   HashKill(&NetTable);
+   HashInit(&InstanceTable, 1024, DEF_NAME_CASE);
+   HashInit(&NetTable, 1024, DEF_NAME_CASE);
 }
 
 GATE
 DefFindGate(char *name)
 {
-    GATE ginst;
-    Tcl_HashEntry *entry;
-
-    entry = Tcl_FindHashEntry(&InstanceTable, name);
-    ginst = (entry) ? (GATE)Tcl_GetHashValue(entry) : NULL;
-    return ginst;
+    return (GATE)HashLookup(&InstanceTable, name);
 }
 
 NET
 DefFindNet(char *name)
 {
-    NET net;
-    Tcl_HashEntry *entry;
-
     // Guard against calls to find nets before DEF file is read
     if (Numnets == 0) return NULL;
 
-    entry = Tcl_FindHashEntry(&NetTable, name);
-    net = (entry) ? (NET)Tcl_GetHashValue(entry) : NULL;
-    return net;
+    return (NET)HashLookup(&NetTable, name);
 }
 
 /*--------------------------------------------------------------*/
@@ -147,13 +100,7 @@ DefFindNet(char *name)
 static void
 DefHashInstance(GATE gateginfo)
 {
-    int new;
-    Tcl_HashEntry *entry;
-
-    entry = Tcl_CreateHashEntry(&InstanceTable,
-		gateginfo->gatename, &new);
-    if (entry != NULL)
-	Tcl_SetHashValue(entry, (ClientData)gateginfo);
+    HashInsert(&InstanceTable, gateginfo->gatename, (void *)gateginfo);
 }
 
 /*--------------------------------------------------------------*/
@@ -166,16 +113,9 @@ DefHashInstance(GATE gateginfo)
 static void
 DefHashNet(NET net)
 {
-    int new;
-    Tcl_HashEntry *entry;
-
-    entry = Tcl_CreateHashEntry(&NetTable, net->netname, &new);
-    if (entry != NULL)
-	Tcl_SetHashValue(entry, (ClientData)net);
+    HashInsert(&NetTable, net->netname, (void *)net);
 }
 
-#endif	/* TCL_QROUTER */
-
 /*
  *------------------------------------------------------------
  *
@@ -197,6 +137,32 @@ DefGetTracks(int layer)
 	return NULL;
 }
 
+/*
+ *------------------------------------------------------------
+ *
+ * DefReset --
+ *
+ *	Forget the TRACKS and the special net count of the
+ *	last DEF file read, before another one is read.
+ *
+ *------------------------------------------------------------
+ */
+
+void
+DefReset(void)
+{
+    int i;
+
+    if (Tracks) {
+	for (i = 0; i < numTracks; i++)
+	    if (Tracks[i] != NULL) free(Tracks[i]);
+	free(Tracks);
+	Tracks = NULL;
+	numTracks = 0;
+    }
+    numSpecial = 0;
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -290,7 +256,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 	    // Create a new route record, add to the 1st node
 
 	    if (special == (char)0) {
-	       routednet = (ROUTE)malloc(sizeof(struct route_));
+	       routednet = allocROUTE();
 	       routednet->next = net->routes;
 	       net->routes = routednet;
 
@@ -376,7 +342,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		if ((special == (char)0) && (paintLayer >= 0) &&
 				(paintLayer < (Num_layers - 1))) {
 
-		    newRoute = (SEG)malloc(sizeof(struct seg_));
+		    newRoute = allocSEG();
 		    newRoute->segtype = ST_VIA;
 		    newRoute->x1 = refp.x1;
 		    newRoute->x2 = refp.x1;
@@ -385,7 +351,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		    newRoute->layer = paintLayer;
 
 		    if (routednet == NULL) {
-			routednet = (ROUTE)malloc(sizeof(struct route_));
+			routednet = allocROUTE();
 			routednet->next = net->routes;
 			net->routes = routednet;
 
@@ -460,7 +426,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		{
 		    LefError(DEF_ERROR, "No reference point for \"*\" wildcard\n"); 
 		    if (newRoute != NULL) {
-			free(newRoute);
+			freeSEG(newRoute);
 			newRoute = NULL;
 		    }
 		    goto endCoord;
@@ -539,7 +505,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		   }
 		}
 		else if ((paintLayer >= 0) && (paintLayer < Num_layers)) {
-		   newRoute = (SEG)malloc(sizeof(struct seg_));
+		   newRoute = allocSEG();
 		   newRoute->segtype = ST_WIRE;
 		   // NOTE: Segments are added at the front of the linked
 		   // list, so they are backwards from the entry in the
@@ -552,7 +518,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		   newRoute->layer = paintLayer;
 
 		   if (routednet == NULL) {
-			routednet = (ROUTE)malloc(sizeof(struct route_));
+			routednet = allocROUTE();
 			routednet->next = net->routes;
 			net->routes = routednet;
 
@@ -595,6 +561,95 @@ endCoord:
     return token;	/* Pass back the last token found */
 }
 
+/* Store for the tap points made by DefGridTaps() in this	*/
+/* thread (see DefReadParallel()).				*/
+
+static STORE_THREAD_LOCAL RecStore *defDPOINTStore = &DPOINTStore;
+
+/*
+ *------------------------------------------------------------
+ *
+ * DefGridTaps ---
+ *
+ *	Fill in the lists of routing grid points of "node" that
+ *	lie inside the pin rectangles "rects" (taps) or within
+ *	the keepout halo "home" of them (extend).
+ *
+ *------------------------------------------------------------
+ */
+
+static void
+DefGridTaps(NODE node, DSEG rects, double *home)
+{
+    DSEG drect;
+    double dx, dy;
+    int gridx, gridy;
+    DPOINT dp;
+
+    node->taps = (DPOINT)NULL;
+    node->extend = (DPOINT)NULL;
+
+    for (drect = rects; drect; drect = drect->next) {
+
+	// Add all routing gridpoints that fall inside
+	// the rectangle.  Much to do here:
+	// (1) routable area should extend 1/2 route width
+	// to each side, as spacing to obstructions allows.
+	// (2) terminals that are wide enough to route to
+	// but not centered on gridpoints should be marked
+	// in some way, and handled appropriately.
+
+	gridx = (int)((drect->x1 - Xlowerbound) / PitchX) - 1;
+
+	if (gridx < 0) gridx = 0;
+	while (1) {
+	    if (gridx >= NumChannelsX) break;
+	    dx = (gridx * PitchX) + Xlowerbound;
+	    if (dx > drect->x2 + home[drect->layer] - EPS) break;
+	    if (dx < drect->x1 - home[drect->layer] + EPS) {
+		gridx++;
+		continue;
+	    }
+	    gridy = (int)((drect->y1 - Ylowerbound) / PitchY) - 1;
+
+	    if (gridy < 0) gridy = 0;
+	    while (1) {
+		if (gridy >= NumChannelsY) break;
+		dy = (gridy * PitchY) + Ylowerbound;
+		if (dy > drect->y2 + home[drect->layer] - EPS) break;
+		if (dy < drect->y1 - home[drect->layer] + EPS) {
+		    gridy++;
+		    continue;
+		}
+
+		// Routing grid point is an interior point
+		// of a gate port.  Record the position
+
+		dp = (DPOINT)allocRecord(defDPOINTStore);
+		dp->layer = drect->layer;
+		dp->x = dx;
+		dp->y = dy;
+		dp->gridx = gridx;
+		dp->gridy = gridy;
+
+		if ((dy >= drect->y1 - EPS) &&
+			    (dx >= drect->x1 - EPS) &&
+			    (dy <= drect->y2 + EPS) &&
+			    (dx <= drect->x2 + EPS)) {
+		    dp->next = node->taps;
+		    node->taps = dp;
+		}
+		else {
+		    dp->next = node->extend;
+		    node->extend = dp;
+		}
+		gridy++;
+	    }
+	    gridx++;
+	}
+    }
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -609,16 +664,25 @@ endCoord:
  *------------------------------------------------------------
  */
 
+/* Attach node "node", for pin "i" of instance "g", to net "net"	*/
+
+static void
+DefAddNetNode(NET net, NODE node, GATE g, int i)
+{
+    node->netnum = net->netnum;
+    g->netnum[i] = net->netnum;
+    g->noderec[i] = node;
+    node->netname = net->netname;
+    node->next = net->netnodes;
+    net->netnodes = node;
+}
+
 static void
 DefReadGatePin(NET net, NODE node, char *instname, char *pinname, double *home)
 {
     int i;
     GATE gateginfo;
-    DSEG drect;
     GATE g;
-    double dx, dy;
-    int gridx, gridy;
-    DPOINT dp;
 
     g = DefFindGate(instname);
     if (g) {
@@ -630,80 +694,11 @@ DefReadGatePin(NET net, NODE node, char *instname, char *pinname, double *home)
 				instname, pinname, net->netname);
 	    return;
 	}
-	for (i = 0; i < gateginfo->nodes; i++) {
-	    if (!strcasecmp(gateginfo->node[i], pinname)) {
-		node->taps = (DPOINT)NULL;
-		node->extend = (DPOINT)NULL;
-
-		for (drect = g->taps[i]; drect; drect = drect->next) {
-
-		    // Add all routing gridpoints that fall inside
-		    // the rectangle.  Much to do here:
-		    // (1) routable area should extend 1/2 route width
-		    // to each side, as spacing to obstructions allows.
-		    // (2) terminals that are wide enough to route to
-		    // but not centered on gridpoints should be marked
-		    // in some way, and handled appropriately.
-
-		    gridx = (int)((drect->x1 - Xlowerbound) / PitchX) - 1;
-
-		    if (gridx < 0) gridx = 0;
-		    while (1) {
-			if (gridx >= NumChannelsX) break;
-			dx = (gridx * PitchX) + Xlowerbound;
-			if (dx > drect->x2 + home[drect->layer] - EPS) break;
-			if (dx < drect->x1 - home[drect->layer] + EPS) {
-			    gridx++;
-			    continue;
-			}
-			gridy = (int)((drect->y1 - Ylowerbound) / PitchY) - 1;
-
-			if (gridy < 0) gridy = 0;
-			while (1) {
-			    if (gridy >= NumChannelsY) break;
-			    dy = (gridy * PitchY) + Ylowerbound;
-			    if (dy > drect->y2 + home[drect->layer] - EPS) break;
-			    if (dy < drect->y1 - home[drect->layer] + EPS) {
-				gridy++;
-				continue;
-			    }
-
-			    // Routing grid point is an interior point
-			    // of a gate port.  Record the position
-
-			    dp = (DPOINT)malloc(sizeof(struct dpoint_));
-			    dp->layer = drect->layer;
-			    dp->x = dx;
-			    dp->y = dy;
-			    dp->gridx = gridx;
-			    dp->gridy = gridy;
-
-			    if ((dy >= drect->y1 - EPS) &&
-					(dx >= drect->x1 - EPS) &&
-					(dy <= drect->y2 + EPS) &&
-					(dx <= drect->x2 + EPS)) {
-				dp->next = node->taps;
-				node->taps = dp;
-			    }
-			    else {
-				dp->next = node->extend;
-				node->extend = dp;
-			    }
-			    gridy++;
-			}
-			gridx++;
-		    }
-		}
-		node->netnum = net->netnum;
-		g->netnum[i] = net->netnum;
-		g->noderec[i] = node;
-		node->netname = net->netname;
-		node->next = net->netnodes;
-		net->netnodes = node;
-		break;
-	    }
+	i = LefFindPin(gateginfo, pinname);
+	if (i >= 0) {
+	    DefGridTaps(node, g->taps[i], home);
+	    DefAddNetNode(net, node, g, i);
 	}
-	if (i < gateginfo->nodes) return;
     }
 }
 
@@ -734,6 +729,56 @@ enum def_netprop_keys {
 	DEF_NETPROP_COVER, DEF_NETPROP_SHAPE, DEF_NETPROP_SOURCE,
 	DEF_NETPROP_WEIGHT, DEF_NETPROP_PROPERTY};
 
+static char *net_property_keys[] = {
+    "USE",
+    "ROUTED",
+    "FIXED",
+    "COVER",
+    "SHAPE",
+    "SOURCE",
+    "WEIGHT",
+    "PROPERTY",
+    NULL
+};
+
+static u_char DefReadParallel(FILE *f, char *sname, u_char nets, float oscale,
+		double *home, int *netidx, int *processed);
+
+/* Create a new net named "netname" (a string in the design	*/
+/* arena), add it to Nlnets and the net hash table, and give	*/
+/* it the next net number from "netidx".			*/
+
+static NET
+DefNewNet(char *netname, int *netidx)
+{
+    NET net;
+
+    net = (NET)allocDesign(sizeof(struct net_));
+    Nlnets[Numnets++] = net;
+    net->netorder = 0;
+    net->numnodes = 0;
+    net->flags = 0;
+    net->netname = netname;
+    net->netnodes = (NODE)NULL;
+    net->noripup = (NETLIST)NULL;
+    net->routes = (ROUTE)NULL;
+    net->xmin = net->ymin = 0;
+    net->xmax = net->ymax = 0;
+
+    // Net numbers start at MIN_NET_NUMBER for regular nets,
+    // use VDD_NET and GND_NET for power and ground, and 0
+    // is not a valid net number.
+
+    if (vddnet && !strcmp(netname, vddnet))
+       net->netnum = VDD_NET;
+    else if (gndnet && !strcmp(netname, gndnet))
+       net->netnum = GND_NET;
+    else
+       net->netnum = (*netidx)++;
+    DefHashNet(net);
+    return net;
+}
+
 static int
 DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 {
@@ -756,34 +801,19 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	NULL
     };
 
-    static char *net_property_keys[] = {
-	"USE",
-	"ROUTED",
-	"FIXED",
-	"COVER",
-	"SHAPE",
-	"SOURCE",
-	"WEIGHT",
-	"PROPERTY",
-	NULL
-    };
-
     /* Set pitches and allocate memory for Obs[] if we haven't yet. */
     set_num_channels();
 
+    /* The routing grid is known, so gate obstructions may be found	*/
+    /* while the nets are read.					*/
+    begin_obstructions_from_gates();
+
     if (Numnets == 0)
     {
 	// Initialize net and node records
 	netidx = MIN_NET_NUMBER;
 	Nlnets = (NET *)malloc(total * sizeof(NET));
 	for (i = 0; i < total; i++) Nlnets[i] = NULL;
-
-	// Compute distance for keepout halo for each route layer
-	// NOTE:  This must match the definition for the keepout halo
-	// used in nodes.c!
-	for (i = 0; i < Num_layers; i++) {
-	    home[i] = LefGetViaWidth(i, i, 0) / 2.0 + LefGetRouteSpacing(i);
-	}
     }
     else {
 	netidx = Numnets;
@@ -791,6 +821,17 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	for (i = Numnets; i < (Numnets + total); i++) Nlnets[i] = NULL;
     }
 
+    // Compute distance for keepout halo for each route layer
+    // NOTE:  This must match the definition for the keepout halo
+    // used in nodes.c!
+    for (i = 0; i < Num_layers; i++) {
+	home[i] = LefGetViaWidth(i, i, 0) / 2.0 + LefGetRouteSpacing(i);
+    }
+
+    /* Regular nets may be read by several threads */
+    if (special == FALSE)
+	DefReadParallel(f, sname, TRUE, oscale, home, &netidx, &processed);
+
     while ((token = LefNextToken(f, TRUE)) != NULL)
     {
 	keyword = Lookup(token, net_keys);
@@ -811,30 +852,7 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 		net = DefFindNet(token);
 
 		if (net == NULL) {
-		    net = (NET)malloc(sizeof(struct net_));
-		    Nlnets[Numnets++] = net;
-		    net->netorder = 0;
-		    net->numnodes = 0;
-		    net->flags = 0;
-		    net->netname = strdup(token);
-		    net->netnodes = (NODE)NULL;
-		    net->noripup = (NETLIST)NULL;
-		    net->routes = (ROUTE)NULL;
-		    net->xmin = net->ymin = 0;
-		    net->xmax = net->ymax = 0;
-
-		    // Net numbers start at MIN_NET_NUMBER for regular nets,
-		    // use VDD_NET and GND_NET for power and ground, and 0
-		    // is not a valid net number.
-
-		    if (vddnet && !strcmp(token, vddnet))
-		       net->netnum = VDD_NET;
-		    else if (gndnet && !strcmp(token, gndnet))
-		       net->netnum = GND_NET;
-		    else
-		       net->netnum = netidx++;
-		    DefHashNet(net);
-
+		    net = DefNewNet(strdupDesign(token), &netidx);
 		    nodeidx = 0;
 		    is_new = TRUE;
 		}
@@ -868,7 +886,7 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 			else
 			    strcpy(pinname, token);
 
-			node = (NODE)calloc(1, sizeof(struct node_));
+			node = (NODE)allocDesign(sizeof(struct node_));
 			node->nodenum = nodeidx++;
 			DefReadGatePin(net, node, instname, pinname, home);
 
@@ -1178,7 +1196,7 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 		}
 
 		/* Create the pin record */
-		gate = (GATE)malloc(sizeof(struct gate_));
+		gate = (GATE)allocDesign(sizeof(struct gate_));
 		gate->gatetype = PinMacro;
 		gate->gatename = NULL;	/* Use NET, but if none, use	*/
 					/* the pin name, set at end.	*/
@@ -1186,12 +1204,12 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 		curlayer = -1;
 
 		/* Pin record has one node;  allocate memory for it */
-		gate->taps = (DSEG *)malloc(sizeof(DSEG));
-		gate->noderec = (NODE *)malloc(sizeof(NODE));
-		gate->direction = (u_char *)malloc(sizeof(u_char));
-		gate->area = (float *)malloc(sizeof(float));
-		gate->netnum = (int *)malloc(sizeof(int));
-		gate->node = (char **)malloc(sizeof(char *));
+		gate->taps = (DSEG *)allocDesign(sizeof(DSEG));
+		gate->noderec = (NODE *)allocDesign(sizeof(NODE));
+		gate->direction = (u_char *)allocDesign(sizeof(u_char));
+		gate->area = (float *)allocDesign(sizeof(float));
+		gate->netnum = (int *)allocDesign(sizeof(int));
+		gate->node = (char **)allocDesign(sizeof(char *));
 		gate->taps[0] = NULL;
 		gate->noderec[0] = NULL;
 		gate->netnum[0] = -1;
@@ -1220,8 +1238,8 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 			case DEF_PINS_PROP_NET:
 			    /* Get the net name */
 			    token = LefNextToken(f, TRUE);
-			    gate->gatename = strdup(token);
-			    gate->node[0] = strdup(token);
+			    gate->gatename = strdupDesign(token);
+			    gate->node[0] = strdupDesign(token);
 			    break;
 			case DEF_PINS_PROP_DIR:
 			    token = LefNextToken(f, TRUE);
@@ -1260,10 +1278,10 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 
 		    /* If no NET was declared for pin, use pinname */
 		    if (gate->gatename == NULL)
-			gate->gatename = strdup(pinname);
+			gate->gatename = strdupDesign(pinname);
 
 		    /* Make sure pin is at least the size of the route layer */
-		    drect = (DSEG)malloc(sizeof(struct dseg_));
+		    drect = (DSEG)allocDesign(sizeof(struct dseg_));
 		    gate->taps[0] = drect;
 		    drect->next = (DSEG)NULL;
 
@@ -1285,14 +1303,9 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 		    DefHashInstance(gate);
 		}
 		else {
+		    /* The unused pin record stays in the design arena */
 		    LefError(DEF_ERROR, "Pin %s is defined outside of route "
 				"layer area!\n", pinname);
-		    free(gate->taps);
-		    free(gate->noderec);
-		    free(gate->direction);
-		    free(gate->netnum);
-		    free(gate->node);
-		    free(gate);
 		}
 
 		break;
@@ -1586,16 +1599,17 @@ DefReadBlockages(FILE *f, char *sname, float oscale, int total)
 /*
  *------------------------------------------------------------
  *
- * DefReadComponents --
+ * DefReadComponent --
  *
- *	Read a COMPONENTS section from a DEF file.
+ *	Read one component from a COMPONENTS section of a DEF
+ *	file, from the use name following the "-" up to the
+ *	closing ";", and make its gate record with pin and
+ *	obstruction geometry placed.
  *
  * Results:
- *	0 on success, 1 on fatal error.
- *
- * Side Effects:
- *	Many.  Cell instances are created and added to
- *	the database.
+ *	The new gate record, which is not yet in the Nlgates
+ *	list or hashed, or NULL on error (in which case
+ *	err_fatal is incremented).
  *
  *------------------------------------------------------------
  */
@@ -1608,25 +1622,16 @@ enum def_prop_keys {
 	DEF_PROP_REGION, DEF_PROP_GENERATE, DEF_PROP_PROPERTY,
 	DEF_PROP_EEQMASTER};
 
-static int
-DefReadComponents(FILE *f, char *sname, float oscale, int total)
+static GATE
+DefReadComponent(FILE *f, float oscale, int *err_fatal)
 {
     GATE gateginfo;
     GATE gate = NULL;
     char *token;
     char usename[512];
-    int keyword, subkey, i;
-    int processed = 0;
-    char OK;
+    int subkey, i;
     DSEG drect, newrect;
     double tmp;
-    int err_fatal = 0;
-
-    static char *component_keys[] = {
-	"-",
-	"END",
-	NULL
-    };
 
     static char *property_keys[] = {
 	"FIXED",
@@ -1643,251 +1648,286 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
 	NULL
     };
 
+    /* Get use and macro names */
+    token = LefNextToken(f, TRUE);
+    if (sscanf(token, "%511s", usename) != 1)
+    {
+	LefError(DEF_ERROR, "Bad component statement:  Need use "
+		    "and macro names\n");
+	LefEndStatement(f);
+	(*err_fatal)++;
+	return NULL;
+    }
+    token = LefNextToken(f, TRUE);
+
+    /* Find the corresponding macro */
+    gateginfo = lefFindCell(token);
+    if (gateginfo == NULL) {
+	LefError(DEF_ERROR, "Could not find a macro definition for \"%s\"\n",
+		    token);
+	gate = NULL;
+	(*err_fatal)++;
+    }
+    else {
+	gate = (GATE)allocDesign(sizeof(struct gate_));
+	gate->gatename = strdupDesign(usename);
+	gate->gatetype = gateginfo;
+    }
+		
+    /* Now do a search through the line for "+" entries	*/
+    /* And process each.					*/
+
     while ((token = LefNextToken(f, TRUE)) != NULL)
     {
-	keyword = Lookup(token, component_keys);
+	if (*token == ';') break;
+	if (*token != '+') continue;
 
-	if (keyword < 0)
+	token = LefNextToken(f, TRUE);
+	subkey = Lookup(token, property_keys);
+	if (subkey < 0)
 	{
-	    LefError(DEF_WARNING, "Unknown keyword \"%s\" in COMPONENT "
-			"definition; ignoring.\n", token);
-	    LefEndStatement(f);
+	    LefError(DEF_WARNING, "Unknown component property \"%s\" in "
+		    "COMPONENT definition; ignoring.\n", token);
 	    continue;
 	}
-	switch (keyword)
+	switch (subkey)
 	{
-	    case DEF_COMP_START:		/* "-" keyword */
+	    case DEF_PROP_PLACED:
+	    case DEF_PROP_UNPLACED:
+	    case DEF_PROP_FIXED:
+	    case DEF_PROP_COVER:
+		DefReadLocation(gate, f, oscale);
+		break;
+	    case DEF_PROP_SOURCE:
+	    case DEF_PROP_WEIGHT:
+	    case DEF_PROP_FOREIGN:
+	    case DEF_PROP_REGION:
+	    case DEF_PROP_GENERATE:
+	    case DEF_PROP_PROPERTY:
+	    case DEF_PROP_EEQMASTER:
+		token = LefNextToken(f, TRUE);
+		break;
+	}
+    }
 
-		/* Update the record of the number of components	*/
-		/* processed and spit out a message for every 5% done.	*/
- 
-		processed++;
+    if (gate != NULL)
+    {
+	/* Process the gate */
+	gate->width = gateginfo->width;   
+	gate->height = gateginfo->height;   
+	gate->nodes = gateginfo->nodes;   
+	gate->obs = (DSEG)NULL;
+
+	gate->taps = (DSEG *)allocDesign(gate->nodes * sizeof(DSEG));
+	gate->noderec = (NODE *)allocDesign(gate->nodes * sizeof(NODE));
+	gate->direction = (u_char *)allocDesign(gate->nodes * sizeof(u_char));
+	gate->area = (float *)allocDesign(gate->nodes * sizeof(float));
+	gate->netnum = (int *)allocDesign(gate->nodes * sizeof(int));
+	gate->node = (char **)allocDesign(gate->nodes * sizeof(char *));
+
+	for (i = 0; i < gate->nodes; i++) {
+	    /* Let the node names point to the master cell;	*/
+	    /* this is just diagnostic;  allows us, for	*/
+	    /* instance, to identify vdd and gnd nodes, so	*/
+	    /* we don't complain about them being		*/
+	    /* disconnected.				*/
+
+	    gate->node[i] = gateginfo->node[i];  /* copy pointer */
+	    gate->direction[i] = gateginfo->direction[i];  /* copy */
+	    gate->area[i] = gateginfo->area[i];
+	    gate->taps[i] = (DSEG)NULL;
+
+	    /* Global power/ground bus check */
+	    if (vddnet && gate->node[i] &&
+			    !strcmp(gate->node[i], vddnet)) {
+	       /* Create a placeholder node with no taps */
+	       gate->netnum[i] = VDD_NET;
+	       gate->noderec[i] = (NODE)allocDesign(sizeof(struct node_));
+	       gate->noderec[i]->netnum = VDD_NET;
+	    }
+	    else if (gndnet && gate->node[i] &&
+			    !strcmp(gate->node[i], gndnet)) {
+	       /* Create a placeholder node with no taps */
+	       gate->netnum[i] = GND_NET;
+	       gate->noderec[i] = (NODE)allocDesign(sizeof(struct node_));
+	       gate->noderec[i]->netnum = GND_NET;
+	    }
+	    else {
+	       gate->netnum[i] = 0;		/* Until we read NETS */
+	       gate->noderec[i] = NULL;
+	    }
 
-		/* Get use and macro names */
-		token = LefNextToken(f, TRUE);
-		if (sscanf(token, "%511s", usename) != 1)
-		{
-		    LefError(DEF_ERROR, "Bad component statement:  Need use "
-				"and macro names\n");
-		    LefEndStatement(f);
-		    err_fatal++;
-		    break;
+	    /* Make a copy of the gate nodes and adjust for	*/
+	    /* instance position and number of layers	*/
+
+	    for (drect = gateginfo->taps[i]; drect; drect = drect->next) {
+		if (drect->layer < Num_layers) {
+		    newrect = (DSEG)allocDesign(sizeof(struct dseg_));
+		    *newrect = *drect;
+		    newrect->next = gate->taps[i];
+		    gate->taps[i] = newrect;
 		}
-		token = LefNextToken(f, TRUE);
+	    }
 
-		/* Find the corresponding macro */
-		OK = 0;
-		for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next) {
-		    if (!strcasecmp(gateginfo->gatename, token)) {
-			OK = 1;
-			break;
-		    }
+	    for (drect = gate->taps[i]; drect; drect = drect->next) {
+		// handle offset from gate origin
+		drect->x1 -= gateginfo->placedX;
+		drect->x2 -= gateginfo->placedX;
+		drect->y1 -= gateginfo->placedY;
+		drect->y2 -= gateginfo->placedY;
+
+		// handle rotations and orientations here
+		if (gate->orient & R90) {
+		    tmp = drect->y1;
+		    drect->y1 = -drect->x1;
+		    drect->y1 += gateginfo->width;
+		    drect->x1 = tmp;
+
+		    tmp = drect->y2;
+		    drect->y2 = -drect->x2;
+		    drect->y2 += gateginfo->width;
+		    drect->x2 = tmp;
 		}
-		if (!OK) {
-		    LefError(DEF_ERROR, "Could not find a macro definition for \"%s\"\n",
-				token);
-		    gate = NULL;
-		    err_fatal++;
+			    
+		if (gate->orient & MX) {
+		    tmp = drect->x1;
+		    drect->x1 = -drect->x2;
+		    drect->x1 += gate->placedX + gateginfo->width;
+		    drect->x2 = -tmp;
+		    drect->x2 += gate->placedX + gateginfo->width;
 		}
 		else {
-		    gate = (GATE)malloc(sizeof(struct gate_));
-		    gate->gatename = strdup(usename);
-		    gate->gatetype = gateginfo;
+		    drect->x1 += gate->placedX;
+		    drect->x2 += gate->placedX;
 		}
-		
-		/* Now do a search through the line for "+" entries	*/
-		/* And process each.					*/
+		if (gate->orient & MY) {
+		    tmp = drect->y1;
+		    drect->y1 = -drect->y2;
+		    drect->y1 += gate->placedY + gateginfo->height;
+		    drect->y2 = -tmp;
+		    drect->y2 += gate->placedY + gateginfo->height;
+		}
+		else {
+		    drect->y1 += gate->placedY;
+		    drect->y2 += gate->placedY;
+		}
+	    }
+	}
 
-		while ((token = LefNextToken(f, TRUE)) != NULL)
-		{
-		    if (*token == ';') break;
-		    if (*token != '+') continue;
+	/* Make a copy of the gate obstructions and adjust	*/
+	/* for instance position				*/
+	for (drect = gateginfo->obs; drect; drect = drect->next) {
+	    if (drect->layer < Num_layers) {
+		newrect = (DSEG)allocDesign(sizeof(struct dseg_));
+		*newrect = *drect;
+		newrect->next = gate->obs;
+		gate->obs = newrect;
+	    }
+	}
 
-		    token = LefNextToken(f, TRUE);
-		    subkey = Lookup(token, property_keys);
-		    if (subkey < 0)
-		    {
-			LefError(DEF_WARNING, "Unknown component property \"%s\" in "
-				"COMPONENT definition; ignoring.\n", token);
-			continue;
-		    }
-		    switch (subkey)
-		    {
-			case DEF_PROP_PLACED:
-			case DEF_PROP_UNPLACED:
-			case DEF_PROP_FIXED:
-			case DEF_PROP_COVER:
-			    DefReadLocation(gate, f, oscale);
-			    break;
-			case DEF_PROP_SOURCE:
-			case DEF_PROP_WEIGHT:
-			case DEF_PROP_FOREIGN:
-			case DEF_PROP_REGION:
-			case DEF_PROP_GENERATE:
-			case DEF_PROP_PROPERTY:
-			case DEF_PROP_EEQMASTER:
-			    token = LefNextToken(f, TRUE);
-			    break;
-		    }
-		}
+	for (drect = gate->obs; drect; drect = drect->next) {
+	    drect->x1 -= gateginfo->placedX;
+	    drect->x2 -= gateginfo->placedX;
+	    drect->y1 -= gateginfo->placedY;
+	    drect->y2 -= gateginfo->placedY;
+
+	    // handle rotations and orientations here
+	    if (gate->orient & R90) {
+		tmp = drect->y1;
+		drect->y1 = -drect->x1;
+		drect->y1 += gateginfo->width;
+		drect->x1 = tmp;
+
+		tmp = drect->y2;
+		drect->y2 = -drect->x2;
+		drect->y2 += gateginfo->width;
+		drect->x2 = tmp;
+	    }
+			    
+	    if (gate->orient & MX) {
+		tmp = drect->x1;
+		drect->x1 = -drect->x2;
+		drect->x1 += gate->placedX + gateginfo->width;
+		drect->x2 = -tmp;
+		drect->x2 += gate->placedX + gateginfo->width;
+	    }
+	    else {
+		drect->x1 += gate->placedX;
+		drect->x2 += gate->placedX;
+	    }
+	    if (gate->orient & MY) {
+		tmp = drect->y1;
+		drect->y1 = -drect->y2;
+		drect->y1 += gate->placedY + gateginfo->height;
+		drect->y2 = -tmp;
+		drect->y2 += gate->placedY + gateginfo->height;
+	    }
+	    else {
+		drect->y1 += gate->placedY;
+		drect->y2 += gate->placedY;
+	    }
+	}
+    }
+    return gate;
+}
 
-		if (gate != NULL)
-		{
-		    /* Process the gate */
-		    gate->width = gateginfo->width;   
-		    gate->height = gateginfo->height;   
-		    gate->nodes = gateginfo->nodes;   
-		    gate->obs = (DSEG)NULL;
+/*
+ *------------------------------------------------------------
+ *
+ * DefReadComponents --
+ *
+ *	Read a COMPONENTS section from a DEF file.
+ *
+ * Results:
+ *	0 on success, 1 on fatal error.
+ *
+ * Side Effects:
+ *	Many.  Cell instances are created and added to
+ *	the database.
+ *
+ *------------------------------------------------------------
+ */
 
-                    gate->taps = (DSEG *)malloc(gate->nodes * sizeof(DSEG));
-                    gate->noderec = (NODE *)malloc(gate->nodes * sizeof(NODE));
-                    gate->direction = (u_char *)malloc(gate->nodes * sizeof(u_char));
-                    gate->area = (float *)malloc(gate->nodes * sizeof(float));
-                    gate->netnum = (int *)malloc(gate->nodes * sizeof(int));
-                    gate->node = (char **)malloc(gate->nodes * sizeof(char *));
-
-		    for (i = 0; i < gate->nodes; i++) {
-			/* Let the node names point to the master cell;	*/
-			/* this is just diagnostic;  allows us, for	*/
-			/* instance, to identify vdd and gnd nodes, so	*/
-			/* we don't complain about them being		*/
-			/* disconnected.				*/
-
-			gate->node[i] = gateginfo->node[i];  /* copy pointer */
-			gate->direction[i] = gateginfo->direction[i];  /* copy */
-			gate->area[i] = gateginfo->area[i];
-			gate->taps[i] = (DSEG)NULL;
-
-			/* Global power/ground bus check */
-			if (vddnet && gate->node[i] &&
-					!strcmp(gate->node[i], vddnet)) {
-			   /* Create a placeholder node with no taps */
-			   gate->netnum[i] = VDD_NET;
-			   gate->noderec[i] = (NODE)calloc(1, sizeof(struct node_));
-			   gate->noderec[i]->netnum = VDD_NET;
-			}
-			else if (gndnet && gate->node[i] &&
-					!strcmp(gate->node[i], gndnet)) {
-			   /* Create a placeholder node with no taps */
-			   gate->netnum[i] = GND_NET;
-			   gate->noderec[i] = (NODE)calloc(1, sizeof(struct node_));
-			   gate->noderec[i]->netnum = GND_NET;
-			}
-			else {
-			   gate->netnum[i] = 0;		/* Until we read NETS */
-			   gate->noderec[i] = NULL;
-			}
+static int
+DefReadComponents(FILE *f, char *sname, float oscale, int total)
+{
+    GATE gate = NULL;
+    char *token;
+    int keyword;
+    int processed = 0;
+    int err_fatal = 0;
 
-			/* Make a copy of the gate nodes and adjust for	*/
-			/* instance position and number of layers	*/
+    static char *component_keys[] = {
+	"-",
+	"END",
+	NULL
+    };
 
-			for (drect = gateginfo->taps[i]; drect; drect = drect->next) {
-			    if (drect->layer < Num_layers) {
-				newrect = (DSEG)malloc(sizeof(struct dseg_));
-				*newrect = *drect;
-				newrect->next = gate->taps[i];
-				gate->taps[i] = newrect;
-			    }
-			}
+    DefReadParallel(f, sname, FALSE, oscale, NULL, NULL, &processed);
 
-			for (drect = gate->taps[i]; drect; drect = drect->next) {
-			    // handle offset from gate origin
-			    drect->x1 -= gateginfo->placedX;
-			    drect->x2 -= gateginfo->placedX;
-			    drect->y1 -= gateginfo->placedY;
-			    drect->y2 -= gateginfo->placedY;
-
-			    // handle rotations and orientations here
-			    if (gate->orient & R90) {
-				tmp = drect->y1;
-				drect->y1 = -drect->x1;
-				drect->y1 += gateginfo->width;
-				drect->x1 = tmp;
-
-				tmp = drect->y2;
-				drect->y2 = -drect->x2;
-				drect->y2 += gateginfo->width;
-				drect->x2 = tmp;
-			    }
-			    
-			    if (gate->orient & MX) {
-				tmp = drect->x1;
-				drect->x1 = -drect->x2;
-				drect->x1 += gate->placedX + gateginfo->width;
-				drect->x2 = -tmp;
-				drect->x2 += gate->placedX + gateginfo->width;
-			    }
-			    else {
-				drect->x1 += gate->placedX;
-				drect->x2 += gate->placedX;
-			    }
-			    if (gate->orient & MY) {
-				tmp = drect->y1;
-				drect->y1 = -drect->y2;
-				drect->y1 += gate->placedY + gateginfo->height;
-				drect->y2 = -tmp;
-				drect->y2 += gate->placedY + gateginfo->height;
-			    }
-			    else {
-				drect->y1 += gate->placedY;
-				drect->y2 += gate->placedY;
-			    }
-			}
-		    }
+    while ((token = LefNextToken(f, TRUE)) != NULL)
+    {
+	keyword = Lookup(token, component_keys);
 
-		    /* Make a copy of the gate obstructions and adjust	*/
-		    /* for instance position				*/
-		    for (drect = gateginfo->obs; drect; drect = drect->next) {
-			if (drect->layer < Num_layers) {
-			    newrect = (DSEG)malloc(sizeof(struct dseg_));
-			    *newrect = *drect;
-			    newrect->next = gate->obs;
-			    gate->obs = newrect;
-			}
-		    }
+	if (keyword < 0)
+	{
+	    LefError(DEF_WARNING, "Unknown keyword \"%s\" in COMPONENT "
+			"definition; ignoring.\n", token);
+	    LefEndStatement(f);
+	    continue;
+	}
+	switch (keyword)
+	{
+	    case DEF_COMP_START:		/* "-" keyword */
 
-		    for (drect = gate->obs; drect; drect = drect->next) {
-			drect->x1 -= gateginfo->placedX;
-			drect->x2 -= gateginfo->placedX;
-			drect->y1 -= gateginfo->placedY;
-			drect->y2 -= gateginfo->placedY;
-
-			// handle rotations and orientations here
-			if (gate->orient & R90) {
-			    tmp = drect->y1;
-			    drect->y1 = -drect->x1;
-			    drect->y1 += gateginfo->width;
-			    drect->x1 = tmp;
-
-			    tmp = drect->y2;
-			    drect->y2 = -drect->x2;
-			    drect->y2 += gateginfo->width;
-			    drect->x2 = tmp;
-			}
-			    
-			if (gate->orient & MX) {
-			    tmp = drect->x1;
-			    drect->x1 = -drect->x2;
-			    drect->x1 += gate->placedX + gateginfo->width;
-			    drect->x2 = -tmp;
-			    drect->x2 += gate->placedX + gateginfo->width;
-			}
-			else {
-			    drect->x1 += gate->placedX;
-			    drect->x2 += gate->placedX;
-			}
-			if (gate->orient & MY) {
-			    tmp = drect->y1;
-			    drect->y1 = -drect->y2;
-			    drect->y1 += gate->placedY + gateginfo->height;
-			    drect->y2 = -tmp;
-			    drect->y2 += gate->placedY + gateginfo->height;
-			}
-			else {
-			    drect->y1 += gate->placedY;
-			    drect->y2 += gate->placedY;
-			}
-		    }
+		/* Update the record of the number of components	*/
+		/* processed and spit out a message for every 5% done.	*/
+ 
+		processed++;
+
+		/* Get use and macro names, and the rest of the record */
+		gate = DefReadComponent(f, oscale, &err_fatal);
+		if (gate != NULL) {
 		    gate->next = Nlgates;
 		    Nlgates = gate;
 
@@ -1925,6 +1965,453 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
     return err_fatal;
 }
 
+/*--------------------------------------------------------------*/
+/* Parallel reading of the COMPONENTS and NETS sections.	*/
+/*								*/
+/* When NumThreads > 1 and the DEF file is mapped, a large	*/
+/* section is split at record boundaries (a line starting with	*/
+/* "-" following a ";") into one chunk per thread.  Each worker	*/
+/* tokenizes its own chunk and allocates from its own arena,	*/
+/* collecting the records it reads without changing anything	*/
+/* shared.  The main thread then enters the records into the	*/
+/* database in file order, doing exactly what the serial	*/
+/* reader would.  If a worker meets an error or warning, or	*/
+/* anything the workers leave to the serial reader (such as a	*/
+/* net with a route), the section is read again serially, so	*/
+/* that the messages and results are those of the serial	*/
+/* reader.							*/
+/*--------------------------------------------------------------*/
+
+#define DEF_PARALLEL_MIN	(1 << 16)  /* Smallest section to split (bytes) */
+
+#if defined(HAVE_LIBPTHREAD) && defined(HAVE_STORE_THREAD_LOCAL)
+
+/* One connection of a net, as read by a worker */
+
+typedef struct defconn_ {
+    NODE node;		/* Node record, taps filled in if pin found */
+    GATE gate;		/* Instance connected, or NULL if not found */
+    int  pin;		/* Index of pin in gate, or -1 if not found */
+} DefConn;
+
+/* One net record, as read by a worker */
+
+typedef struct defnetrec_ {
+    char *netname;	/* Copy of the net name, in the worker's arena */
+    int   conns;	/* Index of the first connection in the chunk */
+    int   numconns;	/* Number of connections */
+} DefNetRec;
+
+typedef struct defchunk_ {
+    FILE      *f;
+    char      *start;		/* Chunk text, starting at a record */
+    char      *end;
+    u_char     nets;		/* TRUE for NETS, FALSE for COMPONENTS */
+    float      oscale;
+    double    *home;		/* Keepout halo per layer (NETS) */
+    RecStore   arena;		/* Worker's design arena */
+    RecStore   dpoints;		/* Worker's tap point store */
+    int        lines;		/* Lines read */
+    int        records;		/* Records ("-" statements) read */
+    int        errors;		/* Errors and warnings held back */
+    u_char     serial;		/* Chunk must be left to the serial reader */
+    GATE       gates;		/* Components read, in file order */
+    GATE       lastgate;
+    DefNetRec *netrecs;		/* Nets read, in file order */
+    int        numnetrecs, maxnetrecs;
+    DefConn   *conns;		/* Their connections */
+    int        numconns, maxconns;
+} DefChunk;
+
+/* Read the components of one chunk */
+
+static void
+defComponentChunk(DefChunk *ck)
+{
+    char *token;
+    GATE gate;
+    int err_fatal = 0;
+
+    while ((token = LefNextToken(ck->f, TRUE)) != NULL)
+    {
+	if (strcmp(token, "-")) {
+	    ck->serial = TRUE;
+	    return;
+	}
+	ck->records++;
+
+	gate = DefReadComponent(ck->f, ck->oscale, &err_fatal);
+	if (gate != NULL) {
+	    gate->next = NULL;
+	    if (ck->lastgate)
+		ck->lastgate->next = gate;
+	    else
+		ck->gates = gate;
+	    ck->lastgate = gate;
+	}
+    }
+}
+
+/* Read the nets of one chunk.  This follows the token handling	*/
+/* of DefReadNets(), but only records each connection.		*/
+
+static void
+defNetChunk(DefChunk *ck)
+{
+    FILE *f = ck->f;
+    char *token;
+    char instname[MAX_NAME_LEN], pinname[MAX_NAME_LEN];
+    int subkey;
+    DefNetRec *rec;
+    DefConn *conn;
+
+    while ((token = LefNextToken(f, TRUE)) != NULL)
+    {
+	if (strcmp(token, "-")) {
+	    ck->serial = TRUE;
+	    return;
+	}
+	ck->records++;
+
+	if (ck->numnetrecs == ck->maxnetrecs) {
+	    ck->maxnetrecs = (ck->maxnetrecs) ? ck->maxnetrecs * 2 : 1024;
+	    ck->netrecs = (DefNetRec *)realloc(ck->netrecs,
+			ck->maxnetrecs * sizeof(DefNetRec));
+	}
+	rec = &ck->netrecs[ck->numnetrecs++];
+
+	/* Get net name */
+	token = LefNextToken(f, TRUE);
+	rec->netname = strdupDesign(token);
+	rec->conns = ck->numconns;
+	rec->numconns = 0;
+
+	token = LefNextToken(f, TRUE);
+	while (token && (*token != ';'))
+	{
+	    if (*token == '(')
+	    {
+		token = LefNextToken(f, TRUE);  /* get pin or gate */
+		strcpy(instname, token);
+		token = LefNextToken(f, TRUE);	/* get node name */
+
+		if (!strcasecmp(instname, "pin")) {
+		    strcpy(instname, token);
+		    strcpy(pinname, "pin");
+		}
+		else
+		    strcpy(pinname, token);
+
+		if (ck->numconns == ck->maxconns) {
+		    ck->maxconns = (ck->maxconns) ? ck->maxconns * 2 : 4096;
+		    ck->conns = (DefConn *)realloc(ck->conns,
+				ck->maxconns * sizeof(DefConn));
+		}
+		conn = &ck->conns[ck->numconns++];
+		rec->numconns++;
+
+		conn->node = (NODE)allocDesign(sizeof(struct node_));
+		conn->gate = DefFindGate(instname);
+		conn->pin = -1;
+		if (conn->gate) {
+		    if (conn->gate->gatetype == NULL) {
+			ck->serial = TRUE;	/* Error, reported serially */
+			return;
+		    }
+		    conn->pin = LefFindPin(conn->gate->gatetype, pinname);
+		    if (conn->pin >= 0)
+			DefGridTaps(conn->node, conn->gate->taps[conn->pin],
+				ck->home);
+		}
+
+		token = LefNextToken(f, TRUE);	/* should be ')' */
+		continue;
+	    }
+	    else if (*token != '+')
+	    {
+		token = LefNextToken(f, TRUE);	/* Not a property */
+		continue;
+	    }
+	    else
+		token = LefNextToken(f, TRUE);
+
+	    subkey = Lookup(token, net_property_keys);
+	    switch (subkey)
+	    {
+		case DEF_NETPROP_USE:
+		case DEF_NETPROP_SOURCE:
+		case DEF_NETPROP_WEIGHT:
+		case DEF_NETPROP_PROPERTY:
+		    break;
+		case DEF_NETPROP_SHAPE:
+		    token = LefNextToken(f, TRUE);
+		    break;
+		default:
+		    /* Routes and unknown properties */
+		    ck->serial = TRUE;
+		    return;
+	    }
+	}
+    }
+}
+
+/* Worker thread:  read one chunk */
+
+static void *
+defReadChunk(void *arg)
+{
+    DefChunk *ck = (DefChunk *)arg;
+    RecStore *prevarena;
+
+    LefSetInputRange(ck->f, ck->start, ck->end, &ck->lines);
+    LefDeferErrors(TRUE);
+    prevarena = setDesignArena(&ck->arena);
+    defDPOINTStore = &ck->dpoints;
+
+    if (ck->nets)
+	defNetChunk(ck);
+    else
+	defComponentChunk(ck);
+
+    defDPOINTStore = &DPOINTStore;
+    setDesignArena(prevarena);
+    ck->errors = LefDeferErrors(FALSE);
+    LefCloseInput(ck->f);
+    return NULL;
+}
+
+/* Return the start of the line after the one containing "p"	*/
+
+static char *
+defNextLine(char *p, char *end)
+{
+    p = (char *)memchr(p, '\n', (size_t)(end - p));
+    return (p) ? p + 1 : end;
+}
+
+/* Return the first record boundary at or after the line after	*/
+/* "p":  a line whose first token is "-", where the last	*/
+/* non-blank character before the line is ";".  Returns "end"	*/
+/* if there is none.						*/
+
+static char *
+defNextRecord(char *p, char *lo, char *end)
+{
+    char *q, *b;
+
+    for (p = defNextLine(p, end); p < end; p = defNextLine(p, end)) {
+	for (q = p; (q < end) && ((*q == ' ') || (*q == '\t')); q++);
+	if ((q + 1 >= end) || (*q != '-') || !isspace(*(q + 1)))
+	    continue;
+	for (b = p - 1; (b > lo) && (isspace(*b) || (*b == '\0')); b--);
+	if (*b == ';') return p;
+    }
+    return end;
+}
+
+/* Return the start of the line "END <sname>" that ends the	*/
+/* section beginning at "p", or NULL if it cannot be found.	*/
+
+static char *
+defFindSectionEnd(char *p, char *end, char *sname)
+{
+    char *q;
+    size_t slen = strlen(sname);
+
+    for (; p < end; p = defNextLine(p, end)) {
+	for (q = p; (q < end) && ((*q == ' ') || (*q == '\t')); q++);
+	if ((end - q < 4 + slen) || strncmp(q, "END", 3) || !isspace(q[3]))
+	    continue;
+	for (q += 3; (q < end) && ((*q == ' ') || (*q == '\t')); q++);
+	if ((end - q >= slen) && !strncasecmp(q, sname, slen) &&
+		((q + slen == end) || isspace(q[slen])))
+	    return p;
+    }
+    return NULL;
+}
+
+#endif /* HAVE_LIBPTHREAD && HAVE_STORE_THREAD_LOCAL */
+
+/*
+ *------------------------------------------------------------
+ *
+ * DefReadParallel --
+ *
+ *	Try to read the records of the COMPONENTS section (if
+ *	"nets" is FALSE) or the NETS section (if TRUE) that
+ *	starts at the current position of "f", using NumThreads
+ *	worker threads.  "home" and "netidx" are as used by
+ *	DefReadNets().
+ *
+ * Results:
+ *	TRUE if the records were read, in which case the number
+ *	read is added to "processed" and the input is left at
+ *	the section's END statement.  FALSE if the section is
+ *	to be read serially (the input position is unchanged).
+ *
+ * Side Effects:
+ *	Gates or nets are added to the database, as they would
+ *	be by the serial reader.
+ *
+ *------------------------------------------------------------
+ */
+
+static u_char
+DefReadParallel(FILE *f, char *sname, u_char nets, float oscale,
+		double *home, int *netidx, int *processed)
+{
+#if defined(HAVE_LIBPTHREAD) && defined(HAVE_STORE_THREAD_LOCAL)
+    char *start, *send, *fend, *p;
+    int c, n, numchunks, lines, records;
+    u_char ok;
+    DefChunk *chunks, *ck;
+    pthread_t *threads;
+    u_char *started;
+    DefNetRec *rec;
+    DefConn *conn;
+    NET net;
+    GATE gate, nextgate;
+    int nodeidx;
+
+    if (NumThreads < 2) return FALSE;
+    start = LefGetInputRange(f, &fend);
+    if (start == NULL) return FALSE;
+    send = defFindSectionEnd(start, fend, sname);
+    if ((send == NULL) || (send - start < DEF_PARALLEL_MIN)) return FALSE;
+
+    /* Split the section into chunks at record boundaries */
+
+    chunks = (DefChunk *)calloc(NumThreads, sizeof(DefChunk));
+    numchunks = 0;
+    p = start;
+    for (c = 0; c < NumThreads; c++) {
+	ck = &chunks[numchunks];
+	ck->start = p;
+	if (c == NumThreads - 1)
+	    ck->end = send;
+	else
+	    ck->end = defNextRecord(start + (send - start) * (c + 1) / NumThreads,
+			start, send);
+	if (ck->end <= ck->start) continue;
+	p = ck->end;
+	numchunks++;
+	if (p >= send) break;
+    }
+    if (numchunks < 2) {
+	free(chunks);
+	return FALSE;
+    }
+
+    threads = (pthread_t *)malloc(numchunks * sizeof(pthread_t));
+    started = (u_char *)calloc(numchunks, sizeof(u_char));
+    for (c = 0; c < numchunks; c++) {
+	ck = &chunks[c];
+	ck->f = f;
+	ck->nets = nets;
+	ck->oscale = oscale;
+	ck->home = home;
+	ck->arena.name = DesignArena.name;
+	ck->dpoints.name = DPOINTStore.name;
+	ck->dpoints.size = DPOINTStore.size;
+	if (pthread_create(&threads[c], NULL, defReadChunk, (void *)ck) == 0)
+	    started[c] = TRUE;
+	else
+	    ck->serial = TRUE;
+    }
+
+    ok = TRUE;
+    lines = records = 0;
+    for (c = 0; c < numchunks; c++) {
+	ck = &chunks[c];
+	if (started[c]) pthread_join(threads[c], NULL);
+
+	/* Memory from the workers belongs to the design either way */
+	mergeRecordStore(&DesignArena, &ck->arena);
+	mergeRecordStore(&DPOINTStore, &ck->dpoints);
+
+	if (ck->serial || (ck->errors > 0)) ok = FALSE;
+	lines += ck->lines;
+	records += ck->records;
+    }
+    free(threads);
+    free(started);
+
+    /* Enter the records into the database, in file order */
+
+    for (c = 0; ok && (c < numchunks); c++) {
+	ck = &chunks[c];
+	if (nets == FALSE) {
+	    for (gate = ck->gates; gate; gate = nextgate) {
+		nextgate = gate->next;
+		gate->next = Nlgates;
+		Nlgates = gate;
+
+		// Used by Tcl version of qrouter
+		DefHashInstance(gate);
+	    }
+	}
+	else {
+	    for (n = 0; n < ck->numnetrecs; n++) {
+		rec = &ck->netrecs[n];
+		net = DefFindNet(rec->netname);
+		if (net == NULL) {
+		    net = DefNewNet(rec->netname, netidx);
+		    nodeidx = 0;
+		}
+		else
+		    nodeidx = net->numnodes;
+
+		for (conn = ck->conns + rec->conns;
+			conn < ck->conns + rec->conns + rec->numconns; conn++) {
+		    conn->node->nodenum = nodeidx++;
+		    if (conn->pin >= 0)
+			DefAddNetNode(net, conn->node, conn->gate, conn->pin);
+		}
+	    }
+	}
+    }
+
+    for (c = 0; c < numchunks; c++) {
+	free(chunks[c].netrecs);
+	free(chunks[c].conns);
+    }
+    free(chunks);
+
+    if (!ok) {
+	if (Verbose > 1)
+	    Fprintf(stdout, "  Reading %s serially.\n", sname);
+	return FALSE;
+    }
+
+    if (Verbose > 1)
+	Fprintf(stdout, "  Read %s using %d threads.\n", sname, numchunks);
+
+    *processed += records;
+    lefCurrentLine += lines;
+    LefSetInputRange(f, send, fend, &lefCurrentLine);
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+/* Start a new record of section positions for DEF file "f"	*/
+
+static void
+defNoteFile(FILE *f)
+{
+    struct stat st;
+
+    memset(&DefSectionInfo, 0, sizeof(DefSections));
+    DefSectionInfo.vias = DefSectionInfo.pins = (off_t)(-1);
+    DefSectionInfo.nets = DefSectionInfo.specialnets = (off_t)(-1);
+    if (fstat(ZFileDescriptor(f), &st) == 0) {
+	DefSectionInfo.size = (unsigned long)st.st_size;
+	DefSectionInfo.mtime = (unsigned long)st.st_mtime;
+	DefSectionInfo.inode = (unsigned long)st.st_ino;
+    }
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -2009,7 +2496,7 @@ DefRead(char *inName, float *retscale)
     else
 	strcpy(filename, inName);
    
-    f = fopen(filename, "r");
+    f = ZFileOpen(filename, "r");
 
     if (f == NULL)
     {
@@ -2019,6 +2506,9 @@ DefRead(char *inName, float *retscale)
 	return 1;
     }
 
+    LefOpenInput(f);
+    defNoteFile(f);
+
     /* Initialize */
 
     if (Verbose > 0) {
@@ -2088,6 +2578,7 @@ DefRead(char *inName, float *retscale)
 		LefEndStatement(f);
 		break;
 	    case DEF_TRACKS:
+		cancel_obstructions_from_gates();	/* Found on the old grid */
 		token = LefNextToken(f, TRUE);
 		if (strlen(token) != 1) {
 		    LefError(DEF_ERROR, "Problem parsing track orientation (X or Y).\n");
@@ -2138,8 +2629,10 @@ DefRead(char *inName, float *retscale)
 				"last one is used.");
 		}
 		else {
-		    if (Tracks == NULL)
+		    if (Tracks == NULL) {
 			Tracks = (TRACKS *)calloc(Num_layers, sizeof(TRACKS));
+			numTracks = Num_layers;
+		    }
 		    Tracks[curlayer] = (TRACKS)malloc(sizeof(struct tracks_));
 		}
 		Tracks[curlayer]->start = start / oscale;
@@ -2185,6 +2678,7 @@ DefRead(char *inName, float *retscale)
 		LefEndStatement(f);
 		break;
 	    case DEF_DIEAREA:
+		cancel_obstructions_from_gates();	/* Found on the old grid */
 		diearea = LefReadRect(f, 0, oscale); // no current layer, use 0
 		dXlowerbound = diearea->x1;
 		dYlowerbound = diearea->y1;
@@ -2216,12 +2710,15 @@ DefRead(char *inName, float *retscale)
 		DefReadBlockages(f, sections[DEF_BLOCKAGES], oscale, total);
 		break;
 	    case DEF_VIAS:
+		cancel_obstructions_from_gates();	/* Found with the old vias */
+		DefSectionInfo.vias = LefLineOffset(f);
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%d", &total) != 1) total = 0;
 		LefEndStatement(f);
 		DefReadVias(f, sections[DEF_VIAS], oscale, total);
 		break;
 	    case DEF_PINS:
+		DefSectionInfo.pins = LefLineOffset(f);
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%d", &total) != 1) total = 0;
 		LefEndStatement(f);
@@ -2231,6 +2728,7 @@ DefRead(char *inName, float *retscale)
 		LefSkipSection(f, sections[DEF_PINPROPERTIES]);
 		break;
 	    case DEF_SPECIALNETS:
+		DefSectionInfo.specialnets = LefLineOffset(f);
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%d", &total) != 1) total = 0;
 		LefEndStatement(f);
@@ -2238,12 +2736,13 @@ DefRead(char *inName, float *retscale)
 				total);
 		break;
 	    case DEF_NETS:
+		DefSectionInfo.nets = LefLineOffset(f);
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%d", &total) != 1) total = 0;
 		LefEndStatement(f);
 		if (total > MAX_NETNUMS) {
 		   LefError(DEF_WARNING, "Number of nets in design (%d) exceeds "
-				"maximum (%d)\n", total, MAX_NETNUMS);
+				"maximum (%d)\n", total, (int)MAX_NETNUMS);
 		}
 		DefReadNets(f, sections[DEF_NETS], oscale, FALSE, total);
 		break;
@@ -2288,7 +2787,8 @@ DefRead(char *inName, float *retscale)
 
     /* Cleanup */
 
-    if (f != NULL) fclose(f);
+    LefCloseInput(f);
+    if (f != NULL) ZFileClose(f);
     *retscale = oscale;
     return err_fatal;
 }
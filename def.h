@@ -16,10 +16,28 @@ typedef struct tracks_ {
     double pitch;
 } *TRACKS;
 
+/* Where sections begin in the DEF file last read (offsets of	*/
+/* the first line, or -1 if absent or unknown), and the file's	*/
+/* identity, so that writing the routed DEF can copy the text	*/
+/* around the sections it changes in blocks.			*/
+
+typedef struct defsections_ {
+    unsigned long size;		/* Size of the file on disk */
+    unsigned long mtime;
+    unsigned long inode;
+    off_t vias;
+    off_t pins;
+    off_t nets;
+    off_t specialnets;
+} DefSections;
+
+extern DefSections DefSectionInfo;
+
 extern int numSpecial;
 extern int DefRead(char *inName, float *);
 
 extern TRACKS DefGetTracks(int layer);
+extern void DefReset(void);
 extern GATE DefFindGate(char *name);
 extern NET DefFindNet(char *name);
 
@@ -18,10 +18,12 @@
 #include <tk.h>
 
 #include "qrouter.h"
+#include "point.h"
 #include "qconfig.h"
 #include "node.h"
 #include "lef.h"
 #include "def.h"
+#include "zfile.h"
 
 /*--------------------------------------------------------------*/
 /* Find a node in the node list.				*/
@@ -221,7 +223,7 @@ walk_route(int eidx, int driverend, endpointinfo *eptinfo,
 {
     SEG firstseg, lastseg;
     SEG walkseg, newseg, testseg;
-    SEG seg, nseg;
+    SEG seg;
     GATE g;
     NODE node;
     int i;
@@ -241,7 +243,7 @@ walk_route(int eidx, int driverend, endpointinfo *eptinfo,
 
 	/* Reverse the route */
 	for (seg = rt->segments; seg; seg = seg->next) {
-	    newseg = (SEG)malloc(sizeof(struct seg_));
+	    newseg = allocSEG();
 	    newseg->layer = seg->layer;
 	    newseg->x1 = seg->x2;
 	    newseg->x2 = seg->x1;
@@ -253,11 +255,7 @@ walk_route(int eidx, int driverend, endpointinfo *eptinfo,
 	}
 
 	/* Delete the original route and replace it */
-	for (seg = rt->segments; seg; ) {
-	    nseg = seg->next;
-	    free(seg);
-	    seg = nseg;
-	}
+	freeSEGlist(rt->segments);
 	rt->segments = firstseg;
 
 	/* Everything in eptinfo related to start and end needs	*/
@@ -409,10 +407,10 @@ int write_delays(char *filename)
 {
     FILE *delayFile;
     NET net;
-    ROUTE rt, nxroute;
+    ROUTE rt;
     ROUTE droutes, newroute, lastroute;
     NODEINFO nodeptr;
-    SEG seg, newseg, lastseg, nxseg;
+    SEG seg, newseg, lastseg;
     GATE g, drivergate;
     int i, j, n, new, driverend, testl;
     int drivernodeidx, driveridx;
@@ -426,9 +424,9 @@ int write_delays(char *filename)
     if (!strcmp(filename, "stdout"))
 	delayFile = stdout;
     else if (filename == NULL)
-	delayFile = fopen(delayfilename, "w");
+	delayFile = ZFileOpen(delayfilename, "w");
     else
-	delayFile = fopen(filename, "w");
+	delayFile = ZFileOpen(filename, "w");
 
     if (!delayFile) {
 	Fprintf(stderr, "write_delays():  Couldn't open output delay file.\n");
@@ -546,7 +544,7 @@ int write_delays(char *filename)
 	lastroute = (ROUTE)NULL;
 	i = 0;
 	for (rt = net->routes; rt; rt = rt->next) {
-	    newroute = (ROUTE)malloc(sizeof(struct route_));
+	    newroute = allocROUTE();
 	    newroute->next = NULL;
 	    if (lastroute == NULL)
 		droutes = newroute;
@@ -562,7 +560,7 @@ int write_delays(char *filename)
 
 	    lastseg = (SEG)NULL;
 	    for (seg = rt->segments; seg; seg = seg->next) {
-		newseg = (SEG)malloc(sizeof(struct seg_));
+		newseg = allocSEG();
 		if (lastseg == NULL)
 		    newroute->segments = newseg;
 		else
@@ -801,10 +799,10 @@ int write_delays(char *filename)
 		    /* determine which side of the break the via goes	*/
 		    /* to.						*/
 
-		    newroute = (ROUTE)malloc(sizeof(struct route_));
+		    newroute = allocROUTE();
 
 		    if (seg->segtype & ST_WIRE) {
-			newseg = (SEG)malloc(sizeof(struct seg_));
+			newseg = allocSEG();
 			newseg->segtype = seg->segtype;
 			newseg->x1 = brkx;
 			newseg->y1 = brky;
@@ -1037,22 +1035,14 @@ int write_delays(char *filename)
 
 	/* Free up allocated information */
 
-	for (rt = droutes; rt; ) {
-	    for (seg = rt->segments; seg; ) {
-		nxseg = seg->next;
-		free(seg);
-		seg = nxseg;
-	    }
-	    nxroute = rt->next;
-	    free(rt);
-	    rt = nxroute;
-	}
+	freeROUTElist(droutes);
 	for (i = 0; i < nroute; i++)
 	    if (eptinfo[i].branching != NULL)
 		free(eptinfo[i].branching);
 	free(eptinfo);
     }
-    fclose(delayFile);
+    if (ZFileClose(delayFile) != 0)
+	Fprintf(stderr, "write_delays():  Error writing output delay file.\n");
 
     free(lefrcvalues);
 
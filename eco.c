@@ -0,0 +1,407 @@
+/*--------------------------------------------------------------*/
+/* eco.c --							*/
+/*								*/
+/* Engineering change orders:  read an updated DEF file in	*/
+/* place of the design that is loaded and routed, and keep	*/
+/* the routes of every net that the change does not touch,	*/
+/* so that only the changed nets need to be routed again.	*/
+/*								*/
+/* Before the new DEF file is read, the routes of each net	*/
+/* are copied out, along with a hash of the net's pins:  the	*/
+/* instance and pin name of each node, and the grid positions	*/
+/* of its taps.  After the new design has been set up, a net	*/
+/* with the same pins gets its routes back, unless any part	*/
+/* of them now lands on an obstruction or on another net (for	*/
+/* example, an instance that has moved on top of the route).	*/
+/* Nets that get their routes back are flagged NET_KEPT, and	*/
+/* stages 1 and 3 leave them alone.  All other nets are	*/
+/* routed as usual.						*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "qrouter.h"
+#include "qconfig.h"
+#include "point.h"
+#include "node.h"
+#include "maze.h"
+#include "hash.h"
+#include "eco.h"
+
+/* A route segment, copied out of the design */
+
+typedef struct ecoseg_ {
+    int layer;
+    int x1, y1, x2, y2;
+    u_char segtype;
+} EcoSeg;
+
+/* The routes of one net, copied out of the design */
+
+typedef struct econet_ {
+    char    *netname;
+    uint64_t pinhash;	/* Sum of the hashes of the net's nodes */
+    int      numpins;
+    u_char   netflags;	/* NET_STUB */
+    int      numroutes;
+    u_char  *rtflags;	/* RT_STUB and RT_CHECK, by route */
+    int     *rtsegs;	/* Number of segments, by route */
+    int      numsegs;
+    EcoSeg  *segs;
+} EcoNet;
+
+/* The grid that the copied routes were made on */
+
+typedef struct ecogrid_ {
+    int    num_layers;
+    int    channelsx, channelsy;
+    double xlower, ylower;
+    double pitchx, pitchy;
+} EcoGrid;
+
+#define ECO_HASH(h, v)	((h) = ((h) ^ (uint64_t)(v)) * 1099511628211ULL)
+
+/*--------------------------------------------------------------*/
+/* Hash the pins of every net of the current design, and add	*/
+/* them to the EcoNet records in "table", by net name.  Nets	*/
+/* not found in the table are skipped.				*/
+/*--------------------------------------------------------------*/
+
+static void
+eco_hash_pins(HashTable *table)
+{
+    GATE g;
+    NODE node;
+    DPOINT dp;
+    EcoNet *en;
+    uint64_t h;
+    char *p;
+    int i;
+
+    for (g = Nlgates; g; g = g->next) {
+	for (i = 0; i < g->nodes; i++) {
+	    if (g->netnum[i] == 0) continue;
+	    node = g->noderec[i];
+	    if ((node == NULL) || (node->netname == NULL)) continue;
+	    en = (EcoNet *)HashLookup(table, node->netname);
+	    if (en == NULL) continue;
+
+	    h = 14695981039346656037ULL;
+	    for (p = g->gatename; *p; p++) ECO_HASH(h, (u_char)*p);
+	    ECO_HASH(h, 0);
+	    if (g->node[i])
+		for (p = g->node[i]; *p; p++) ECO_HASH(h, (u_char)*p);
+	    ECO_HASH(h, 0);
+	    for (dp = node->taps; dp; dp = dp->next) {
+		ECO_HASH(h, dp->layer);
+		ECO_HASH(h, dp->gridx);
+		ECO_HASH(h, dp->gridy);
+	    }
+	    ECO_HASH(h, 0);
+	    for (dp = node->extend; dp; dp = dp->next) {
+		ECO_HASH(h, dp->layer);
+		ECO_HASH(h, dp->gridx);
+		ECO_HASH(h, dp->gridy);
+	    }
+	    en->pinhash += h;
+	    en->numpins++;
+	}
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* Copy the routes of every net of the current design.		*/
+/* Returns an array of "*numptr" records.			*/
+/*--------------------------------------------------------------*/
+
+static EcoNet *
+eco_save_routes(HashTable *table, int *numptr)
+{
+    EcoNet *nets, *en;
+    NET net;
+    ROUTE rt;
+    SEG seg;
+    int i, r, s;
+
+    nets = (EcoNet *)calloc(Numnets + 1, sizeof(EcoNet));
+    HashInit(table, Numnets, HASH_CASE);
+
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	en = &nets[i];
+	en->netname = strdup(net->netname);
+	en->netflags = net->flags & NET_STUB;
+	HashInsert(table, en->netname, (void *)en);
+
+	for (rt = net->routes; rt; rt = rt->next) {
+	    en->numroutes++;
+	    for (seg = rt->segments; seg; seg = seg->next) en->numsegs++;
+	}
+	if (en->numroutes == 0) continue;
+
+	en->rtflags = (u_char *)malloc(en->numroutes);
+	en->rtsegs = (int *)malloc(en->numroutes * sizeof(int));
+	en->segs = (EcoSeg *)malloc(MAX(en->numsegs, 1) * sizeof(EcoSeg));
+	r = s = 0;
+	for (rt = net->routes; rt; rt = rt->next) {
+	    en->rtflags[r] = rt->flags & (RT_STUB | RT_CHECK);
+	    en->rtsegs[r] = 0;
+	    for (seg = rt->segments; seg; seg = seg->next) {
+		en->segs[s].layer = seg->layer;
+		en->segs[s].x1 = seg->x1;
+		en->segs[s].y1 = seg->y1;
+		en->segs[s].x2 = seg->x2;
+		en->segs[s].y2 = seg->y2;
+		en->segs[s].segtype = seg->segtype;
+		en->rtsegs[r]++;
+		s++;
+	    }
+	    r++;
+	}
+    }
+    eco_hash_pins(table);
+
+    *numptr = Numnets;
+    return nets;
+}
+
+/*--------------------------------------------------------------*/
+/* Return TRUE if grid position (x, y, lay) can take a route	*/
+/* of net "net":  it is on the grid, and it is free, or	*/
+/* belongs to the net, or is one of the net's own pins.	*/
+/*--------------------------------------------------------------*/
+
+static u_char
+eco_position_free(NET net, int x, int y, int lay)
+{
+    obsword obsval, netnum;
+    NODEINFO lnode;
+
+    if ((x < 0) || (x >= NumChannelsX) || (y < 0) || (y >= NumChannelsY))
+	return FALSE;
+    if ((lay < 0) || (lay >= Num_layers))
+	return FALSE;
+
+    obsval = OBSVAL(x, y, lay);
+    if ((obsval & DRC_BLOCKAGE) == DRC_BLOCKAGE)
+	return FALSE;
+
+    if (obsval & NO_NET) {
+	/* Routes may cross obstructions to reach their own pins */
+	if (lay >= Pinlayers) return FALSE;
+	lnode = NODEIPTR(x, y, lay);
+	if ((lnode == NULL) || (lnode->nodesav == NULL)) return FALSE;
+	return (lnode->nodesav->netnum == net->netnum) ? TRUE : FALSE;
+    }
+
+    netnum = obsval & NETNUM_MASK;
+    if ((netnum != 0) && (netnum != (obsword)net->netnum))
+	return FALSE;
+    return TRUE;
+}
+
+/*--------------------------------------------------------------*/
+/* Return TRUE if every position of the copied routes of "en"	*/
+/* is free for net "net" in the new design.			*/
+/*--------------------------------------------------------------*/
+
+static u_char
+eco_routes_free(NET net, EcoNet *en)
+{
+    EcoSeg *es;
+    int s, x, y;
+
+    for (s = 0; s < en->numsegs; s++) {
+	es = &en->segs[s];
+	if (es->segtype & ST_VIA) {
+	    if (!eco_position_free(net, es->x1, es->y1, es->layer + 1))
+		return FALSE;
+	}
+	for (x = es->x1; ; x += (es->x2 > es->x1) ? 1 : -1) {
+	    if (!eco_position_free(net, x, es->y1, es->layer))
+		return FALSE;
+	    if (x == es->x2) break;
+	}
+	for (y = es->y1; ; y += (es->y2 > es->y1) ? 1 : -1) {
+	    if (!eco_position_free(net, es->x2, y, es->layer))
+		return FALSE;
+	    if (y == es->y2) break;
+	}
+    }
+    return TRUE;
+}
+
+/*--------------------------------------------------------------*/
+/* Give net "net" the copied routes of "en", and write them	*/
+/* into the Obs[] array.					*/
+/*--------------------------------------------------------------*/
+
+static void
+eco_restore_routes(NET net, EcoNet *en)
+{
+    ROUTE rt, lastrt;
+    SEG seg, lastseg;
+    EcoSeg *es;
+    int r, s, k;
+
+    lastrt = NULL;
+    s = 0;
+    for (r = 0; r < en->numroutes; r++) {
+	rt = createemptyroute();
+	rt->netnum = net->netnum;
+	rt->flags = en->rtflags[r];
+	lastseg = NULL;
+	for (k = 0; k < en->rtsegs[r]; k++, s++) {
+	    es = &en->segs[s];
+	    seg = allocSEG();
+	    seg->layer = es->layer;
+	    seg->x1 = es->x1;
+	    seg->y1 = es->y1;
+	    seg->x2 = es->x2;
+	    seg->y2 = es->y2;
+	    seg->segtype = es->segtype;
+	    seg->next = NULL;
+	    if (lastseg) lastseg->next = seg; else rt->segments = seg;
+	    lastseg = seg;
+	}
+	if (lastrt) lastrt->next = rt; else net->routes = rt;
+	lastrt = rt;
+    }
+
+    for (rt = net->routes; rt; rt = rt->next)
+	if (rt->segments) route_set_connections(net, rt);
+    writeback_all_routes(net);
+
+    net->flags |= NET_KEPT | en->netflags;
+}
+
+/*--------------------------------------------------------------*/
+/* Free the copied routes					*/
+/*--------------------------------------------------------------*/
+
+static void
+eco_free_routes(HashTable *table, EcoNet *nets, int numnets)
+{
+    int i;
+
+    for (i = 0; i < numnets; i++) {
+	free(nets[i].netname);
+	free(nets[i].rtflags);
+	free(nets[i].rtsegs);
+	free(nets[i].segs);
+    }
+    free(nets);
+    HashKill(table);
+}
+
+/*--------------------------------------------------------------*/
+/* read_eco ---							*/
+/*								*/
+/* Read the DEF file "filename" in place of the current	*/
+/* design, as read_def() does, then give back the routes of	*/
+/* the previous design to each net whose pins are unchanged	*/
+/* and whose routes are still clear.  Nets given routes by	*/
+/* the DEF file itself are left as read.  If no design has	*/
+/* been read yet, this is the same as read_def().		*/
+/*								*/
+/* Returns the result of read_def().				*/
+/*--------------------------------------------------------------*/
+
+int
+read_eco(char *filename)
+{
+    HashTable oldtable, newtable;
+    EcoNet *oldnets, *newnets, *en, *nn, **keep;
+    EcoGrid grid;
+    NET net;
+    int i, result, numold;
+    int kept, moved, blocked, added;
+
+    if ((Nlgates == NULL) || (Numnets == 0) || (Obs2[0] == NULL))
+	return read_def(filename);
+
+    oldnets = eco_save_routes(&oldtable, &numold);
+    grid.num_layers = Num_layers;
+    grid.channelsx = NumChannelsX;
+    grid.channelsy = NumChannelsY;
+    grid.xlower = Xlowerbound;
+    grid.ylower = Ylowerbound;
+    grid.pitchx = PitchX;
+    grid.pitchy = PitchY;
+
+    result = read_def(filename);
+
+    if ((grid.num_layers != Num_layers) || (grid.channelsx != NumChannelsX) ||
+		(grid.channelsy != NumChannelsY) ||
+		(grid.xlower != Xlowerbound) || (grid.ylower != Ylowerbound) ||
+		(grid.pitchx != PitchX) || (grid.pitchy != PitchY)) {
+	Fprintf(stderr, "ECO:  Route grid has changed;  no routes were kept.\n");
+	eco_free_routes(&oldtable, oldnets, numold);
+	return result;
+    }
+
+    // Hash the pins of the new design the same way as the old.
+
+    newnets = (EcoNet *)calloc(Numnets + 1, sizeof(EcoNet));
+    HashInit(&newtable, Numnets, HASH_CASE);
+    for (i = 0; i < Numnets; i++) {
+	newnets[i].netname = Nlnets[i]->netname;
+	HashInsert(&newtable, newnets[i].netname, (void *)&newnets[i]);
+    }
+    eco_hash_pins(&newtable);
+
+    // Check all of the nets before giving any of them routes, as the
+    // DRC blockages written alongside one kept route would otherwise
+    // block its neighbors, which were routed next to it before.
+
+    keep = (EcoNet **)calloc(Numnets + 1, sizeof(EcoNet *));
+    kept = moved = blocked = added = 0;
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	nn = &newnets[i];
+	if (net->routes != NULL) continue;	/* Routed by the DEF file */
+	if (net->flags & NET_IGNORED) continue;
+
+	en = (EcoNet *)HashLookup(&oldtable, net->netname);
+	if ((en == NULL) || (en->numroutes == 0)) {
+	    added++;
+	    if (Verbose > 1)
+		Fprintf(stdout, "ECO:  Net %s is new or was not routed.\n",
+			net->netname);
+	}
+	else if ((en->pinhash != nn->pinhash) || (en->numpins != nn->numpins)) {
+	    moved++;
+	    if (Verbose > 1)
+		Fprintf(stdout, "ECO:  Net %s has changed pins.\n", net->netname);
+	}
+	else if (!eco_routes_free(net, en)) {
+	    blocked++;
+	    if (Verbose > 1)
+		Fprintf(stdout, "ECO:  Route of net %s is now blocked.\n",
+			net->netname);
+	}
+	else {
+	    keep[i] = en;
+	    kept++;
+	}
+    }
+    for (i = 0; i < Numnets; i++)
+	if (keep[i] != NULL)
+	    eco_restore_routes(Nlnets[i], keep[i]);
+    free(keep);
+
+    Fprintf(stdout, "ECO:  Kept the routes of %d nets;  %d nets to route "
+		"(%d with changed pins, %d blocked, %d new or unrouted).\n",
+		kept, moved + blocked + added, moved, blocked, added);
+    Flush(stdout);
+
+    free(newnets);
+    HashKill(&newtable);
+    eco_free_routes(&oldtable, oldnets, numold);
+    return result;
+}
+
+/* end of eco.c */
@@ -0,0 +1,14 @@
+/*
+ * eco.h --
+ *
+ * Reading an updated DEF file over a routed design, keeping
+ * the routes of the nets that it does not change.
+ *
+ */
+
+#ifndef _ECOINT_H
+#define _ECOINT_H
+
+int    read_eco(char *filename);
+
+#endif /* _ECOINT_H */
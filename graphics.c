@@ -15,10 +15,12 @@
 #include <tk.h>
 
 #include "qrouter.h"
+#include "point.h"
 #include "qconfig.h"
 #include "node.h"
 #include "maze.h"
 #include "lef.h"
+#include "bitplane.h"
 
 /*------------------------------*/
 /* Type declarations		*/
@@ -264,28 +266,40 @@ static void
 map_congestion()
 {
     int xspc, yspc, hspc;
-    int i, x, y, n, norm;
+    int i, p, w, x, y, norm;
     u_char *Congestion;
     u_char value, maxval;
+    planeword bits[4], m;
 
     if (dpy == NULL) return;
+    if (PlaneWords == 0) return;
 
     hspc = spacing >> 1;
 
     Congestion = (u_char *)calloc(NumChannelsX * NumChannelsY,
 			sizeof(u_char));
 
-    // Analyze Obs[] array for congestion
+    // Analyze obstruction bitplanes for congestion.  Each position
+    // scores one for each of ROUTED_NET, any blocked direction,
+    // NO_NET, and a pin obstruction, on each layer.
     for (i = 0; i < Num_layers; i++) {
-	for (x = 0; x < NumChannelsX; x++) {
-	    for (y = 0; y < NumChannelsY; y++) {
-		value = (u_char)0;
-		n = OBSVAL(x, y, i);
-		if (n & ROUTED_NET) value++;
-		if (n & BLOCKED_MASK) value++;
-		if (n & NO_NET) value++;
-		if (n & PINOBSTRUCTMASK) value++;
-		CONGEST(x, y) += value;
+	for (y = 0; y < NumChannelsY; y++) {
+	    for (w = 0; w < PlaneWords; w++) {
+		bits[0] = PLANEROW(PLANE_ROUTED, y, i)[w];
+		bits[1] = PLANEROW(PLANE_NO_NET, y, i)[w];
+		bits[2] = PLANEROW(PLANE_PINOBS, y, i)[w];
+		bits[3] = PLANEROW(PLANE_BLOCKED_N, y, i)[w] |
+			PLANEROW(PLANE_BLOCKED_S, y, i)[w] |
+			PLANEROW(PLANE_BLOCKED_E, y, i)[w] |
+			PLANEROW(PLANE_BLOCKED_W, y, i)[w] |
+			PLANEROW(PLANE_BLOCKED_U, y, i)[w] |
+			PLANEROW(PLANE_BLOCKED_D, y, i)[w];
+		for (p = 0; p < 4; p++) {
+		    for (m = bits[p]; m; m &= m - 1) {
+			x = (w << 6) + PLANE_CTZ(m);
+			CONGEST(x, y)++;
+		    }
+		}
 	    }
 	}
     }
@@ -466,10 +480,10 @@ draw_net_nodes(NET net) {
     /* Compute bbox for each node and draw it */
     for (node = net->netnodes, n = 0; node != NULL; node = node->next, n++) {
         if (bboxlist == NULL) {
-            lastbbox = bboxlist = (SEG)malloc(sizeof(struct seg_));
+            lastbbox = bboxlist = allocSEG();
         }
         else {
-            lastbbox->next = (SEG)malloc(sizeof(struct seg_));
+            lastbbox->next = allocSEG();
             lastbbox = lastbbox->next;
         }
         lastbbox->next = NULL;
@@ -535,7 +549,7 @@ draw_net_nodes(NET net) {
 
     for (bboxit = bboxlist; bboxit != NULL; bboxit = lastbbox) {
         lastbbox = bboxit->next;
-        free(bboxit);
+        freeSEG(bboxit);
     }
 }
 
@@ -0,0 +1,220 @@
+/*--------------------------------------------------------------*/
+/* hash.c --							*/
+/*								*/
+/* String-keyed hash tables for instance, net, macro, pin and	*/
+/* layer name lookups.  Tables use open addressing with linear	*/
+/* probing, so that an entry costs no allocation of its own	*/
+/* and a lookup touches consecutive memory.			*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "qrouter.h"
+#include "hash.h"
+
+/* Marker for a slot whose entry was deleted.  Lookups probe	*/
+/* past it;  insertions may reuse it.				*/
+
+static char HashDeleted[] = "";
+
+#define HASH_DEFAULT_SIZE	64
+
+/*--------------------------------------------------------------*/
+/* FNV-1a hash of a string, optionally folded to lowercase	*/
+/*--------------------------------------------------------------*/
+
+static u_int
+hashString(char *key, u_char nocase)
+{
+    u_int h = 2166136261U;
+    u_char *p;
+
+    if (nocase)
+	for (p = (u_char *)key; *p; p++)
+	    h = (h ^ (u_int)tolower(*p)) * 16777619U;
+    else
+	for (p = (u_char *)key; *p; p++)
+	    h = (h ^ (u_int)*p) * 16777619U;
+    return h;
+}
+
+static int
+hashKeyMatch(HashTable *ht, char *k1, char *k2)
+{
+    return (ht->nocase) ? !strcasecmp(k1, k2) : !strcmp(k1, k2);
+}
+
+/*--------------------------------------------------------------*/
+/* HashInit ---							*/
+/*								*/
+/* Set up an empty table sized for about "size" entries.  If	*/
+/* nocase is HASH_NOCASE, keys that differ only in case are	*/
+/* the same key.						*/
+/*--------------------------------------------------------------*/
+
+void
+HashInit(HashTable *ht, int size, u_char nocase)
+{
+    u_int slots;
+
+    for (slots = HASH_DEFAULT_SIZE; slots < (u_int)size * 2; slots <<= 1);
+    ht->table = (HashEnt *)calloc(slots, sizeof(HashEnt));
+    ht->size = slots;
+    ht->used = 0;
+    ht->nocase = nocase;
+}
+
+/*--------------------------------------------------------------*/
+/* HashKill ---							*/
+/*								*/
+/* Free the table's slots.  The keys and values are owned by	*/
+/* the caller and are not touched.  The table may be reused	*/
+/* after another call to HashInit().				*/
+/*--------------------------------------------------------------*/
+
+void
+HashKill(HashTable *ht)
+{
+    free(ht->table);
+    ht->table = NULL;
+    ht->size = 0;
+    ht->used = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* Find the slot holding "key", or NULL if there is none.	*/
+/*--------------------------------------------------------------*/
+
+static HashEnt *
+hashFind(HashTable *ht, char *key)
+{
+    u_int i, mask;
+    HashEnt *he;
+
+    if (ht->size == 0) return NULL;
+
+    mask = ht->size - 1;
+    for (i = hashString(key, ht->nocase) & mask; ; i = (i + 1) & mask) {
+	he = &ht->table[i];
+	if (he->key == NULL) return NULL;
+	if ((he->key != HashDeleted) && hashKeyMatch(ht, he->key, key))
+	    return he;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* Re-enter every entry into a new array of slots, dropping	*/
+/* the deleted markers.  The number of slots is doubled only	*/
+/* if the entries still in the table fill more than half of	*/
+/* it;  otherwise the table keeps its size, so that repeated	*/
+/* inserts and deletes do not make it grow without bound.	*/
+/*--------------------------------------------------------------*/
+
+static void
+hashGrow(HashTable *ht)
+{
+    HashEnt *oldtable, *he;
+    u_int oldsize, live, i, j, mask;
+
+    oldtable = ht->table;
+    oldsize = ht->size;
+
+    for (live = 0, i = 0; i < oldsize; i++)
+	if ((oldtable[i].key != NULL) && (oldtable[i].key != HashDeleted))
+	    live++;
+
+    if (oldsize == 0)
+	ht->size = HASH_DEFAULT_SIZE;
+    else if ((live + 1) * 2 > oldsize)
+	ht->size = oldsize * 2;
+    ht->table = (HashEnt *)calloc(ht->size, sizeof(HashEnt));
+    ht->used = 0;
+    mask = ht->size - 1;
+
+    for (i = 0; i < oldsize; i++) {
+	he = &oldtable[i];
+	if ((he->key == NULL) || (he->key == HashDeleted)) continue;
+	for (j = hashString(he->key, ht->nocase) & mask; ht->table[j].key;
+			j = (j + 1) & mask);
+	ht->table[j] = *he;
+	ht->used++;
+    }
+    free(oldtable);
+}
+
+/*--------------------------------------------------------------*/
+/* HashLookup ---						*/
+/*								*/
+/* Return the value stored under "key", or NULL if none.	*/
+/*--------------------------------------------------------------*/
+
+void *
+HashLookup(HashTable *ht, char *key)
+{
+    HashEnt *he;
+
+    he = hashFind(ht, key);
+    return (he) ? he->value : NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* HashInsert ---						*/
+/*								*/
+/* Store "value" under "key".  If the key is already present,	*/
+/* its value (and key string) are replaced.			*/
+/*--------------------------------------------------------------*/
+
+void
+HashInsert(HashTable *ht, char *key, void *value)
+{
+    u_int i, mask;
+    HashEnt *he, *free_he;
+
+    he = hashFind(ht, key);
+    if (he) {
+	he->key = key;
+	he->value = value;
+	return;
+    }
+
+    /* Keep the table no more than 3/4 full, counting deleted slots */
+    if ((ht->used + 1) * 4 > ht->size * 3) hashGrow(ht);
+
+    mask = ht->size - 1;
+    free_he = NULL;
+    for (i = hashString(key, ht->nocase) & mask; ; i = (i + 1) & mask) {
+	he = &ht->table[i];
+	if (he->key == HashDeleted) {
+	    free_he = he;	/* Reuse a deleted slot */
+	    break;
+	}
+	if (he->key == NULL) {
+	    free_he = he;
+	    ht->used++;
+	    break;
+	}
+    }
+    free_he->key = key;
+    free_he->value = value;
+}
+
+/*--------------------------------------------------------------*/
+/* HashDelete ---						*/
+/*								*/
+/* Remove "key" from the table, if present.			*/
+/*--------------------------------------------------------------*/
+
+void
+HashDelete(HashTable *ht, char *key)
+{
+    HashEnt *he;
+
+    he = hashFind(ht, key);
+    if (he) {
+	he->key = HashDeleted;
+	he->value = NULL;
+    }
+}
@@ -0,0 +1,38 @@
+/*
+ * hash.h --
+ *
+ * Simple string-keyed hash tables for name lookups, used in
+ * place of linear list searches (and independent of Tcl, so
+ * that the standalone build gets them too).
+ *
+ */
+
+#ifndef _HASHINT_H
+#define _HASHINT_H
+
+/* Keys are not copied.  The key string must remain valid for as	*/
+/* long as the entry is in the table;  normally it is the name	*/
+/* field of the record being indexed.					*/
+
+typedef struct hashent_ {
+    char *key;
+    void *value;
+} HashEnt;
+
+typedef struct hashtable_ {
+    HashEnt *table;	/* Open-addressed slots, size is a power of 2	*/
+    u_int size;		/* Number of slots				*/
+    u_int used;		/* Slots holding an entry or a deleted marker	*/
+    u_char nocase;	/* Compare keys without regard to case		*/
+} HashTable;
+
+#define HASH_CASE	(u_char)0
+#define HASH_NOCASE	(u_char)1
+
+extern void HashInit(HashTable *ht, int size, u_char nocase);
+extern void HashKill(HashTable *ht);
+extern void *HashLookup(HashTable *ht, char *key);
+extern void HashInsert(HashTable *ht, char *key, void *value);
+extern void HashDelete(HashTable *ht, char *key);
+
+#endif /* _HASHINT_H */
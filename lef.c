@@ -25,14 +25,39 @@
 #include <string.h>
 #include <errno.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <sys/time.h>
+#include <sys/stat.h>
 #include <math.h>
 
 #include "qrouter.h"
+#include "point.h"
 #include "node.h"
 #include "qconfig.h"
 #include "maze.h"
 #include "lef.h"
+#include "hash.h"
+#include "zfile.h"
+
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+
+/* Indexes that are built on first use (keyword tables, macro	*/
+/* pin names) may be first used by several parsing threads at	*/
+/* once.  Each is built under this lock, and made visible only	*/
+/* once it is complete.						*/
+
+static pthread_mutex_t lefIndexLock = PTHREAD_MUTEX_INITIALIZER;
+#define LEF_INDEX_LOCK()	pthread_mutex_lock(&lefIndexLock)
+#define LEF_INDEX_UNLOCK()	pthread_mutex_unlock(&lefIndexLock)
+#define LEF_INDEX_PUBLISH()	__sync_synchronize()
+#else
+#define LEF_INDEX_LOCK()
+#define LEF_INDEX_UNLOCK()
+#define LEF_INDEX_PUBLISH()
+#endif
 
 /* ---------------------------------------------------------------------*/
 
@@ -42,11 +67,130 @@ int lefCurrentLine = 0;
 /* Information about routing layers */
 LefList LefInfo = NULL;
 
+/* Hash table of layer names.  New records are always added to	*/
+/* the front of LefInfo, so the table is rebuilt whenever the	*/
+/* head of the list is not the one it was built from.  Setting	*/
+/* LayerTableHead to NULL forces a rebuild.			*/
+
+static HashTable LayerTable;
+static LefList LayerTableHead = NULL;
+
 /* Information about what vias to use */
 LinkedStringPtr AllowedVias = NULL;
 
 /* Gate information is in the linked list GateInfo, imported */
 
+/*---------------------------------------------------------
+ * Keyword tables --
+ *	Each table of keywords passed to Lookup() gets a perfect
+ *	hash of its entries on first use, so that the exact match
+ *	which is the usual case costs one hash and one compare.
+ *	Abbreviations still fall back to a scan of the table.
+ *	Tables are found by address, so they must be static.
+ *---------------------------------------------------------
+ */
+
+typedef struct keytable_ {
+    char **table;	/* Keyword table indexed (NULL if slot unused)	*/
+    short *slot;	/* Hash slot to table index, or -1 (NULL if	*/
+			/* no perfect hash was found)			*/
+    u_int mask;		/* Number of slots - 1				*/
+    u_int seed;		/* Hash seed giving no collisions		*/
+} KeyTable;
+
+#define KEYTABLE_MAX	256	/* Tables indexed;  more are just scanned */
+
+static KeyTable KeyTables[KEYTABLE_MAX];
+
+/* Hash of a keyword up to its first blank, ignoring case */
+
+static u_int
+keyHash(char *str, u_int seed)
+{
+    u_int h = seed;
+
+    for (; (*str != '\0') && (*str != ' '); str++)
+	h = (h ^ (u_int)(*str | 0x20)) * 16777619U;
+    return h;
+}
+
+/* Return TRUE if "str" is exactly the keyword "tabc" (up to	*/
+/* the keyword's first blank), ignoring case.			*/
+
+static u_char
+keyMatch(char *tabc, char *str)
+{
+    for (; (*str != '\0') && (*tabc != ' ') && (*tabc != '\0'); str++, tabc++)
+	if (tolower(*tabc) != tolower(*str))
+	    return FALSE;
+    return ((*str == '\0') && ((*tabc == ' ') || (*tabc == '\0'))) ? TRUE : FALSE;
+}
+
+/* Try to build a collision-free hash of "table" into "kt".	*/
+
+static u_char
+keyTableBuild(KeyTable *kt, char **table)
+{
+    int n, pos, tries;
+    u_int size, h;
+
+    for (n = 0; table[n] != NULL; n++);
+    for (size = 8; size < (u_int)(n * 2); size <<= 1);
+
+    kt->slot = (short *)malloc(size * sizeof(short));
+    for (tries = 0; tries < 64; tries++) {
+	kt->seed = 2166136261U + tries * 0x9e3779b9U;
+	kt->mask = size - 1;
+	for (h = 0; h < size; h++) kt->slot[h] = -1;
+
+	for (pos = 0; pos < n; pos++) {
+	    h = keyHash(table[pos], kt->seed) & kt->mask;
+	    if (kt->slot[h] < 0)
+		kt->slot[h] = (short)pos;
+	    else if (!keyMatch(table[kt->slot[h]], table[pos]))
+		break;		/* Collision (duplicates keep the first) */
+	}
+	if (pos == n) return TRUE;
+	if ((tries & 7) == 7) {
+	    size <<= 1;
+	    kt->slot = (short *)realloc(kt->slot, size * sizeof(short));
+	}
+    }
+    free(kt->slot);
+    kt->slot = NULL;
+    return FALSE;
+}
+
+/* Find (or make) the perfect hash for "table", or return NULL	*/
+/* if it could not be made.					*/
+
+static KeyTable *
+keyTableFind(char **table)
+{
+    u_int i, n;
+    KeyTable *kt;
+
+    i = (u_int)(((unsigned long)table >> 3) % KEYTABLE_MAX);
+    for (n = 0; n < KEYTABLE_MAX; n++) {
+	kt = &KeyTables[i];
+	if (kt->table == table)
+	    return (kt->slot != NULL) ? kt : NULL;
+	if (kt->table == NULL) {
+	    LEF_INDEX_LOCK();
+	    if (kt->table == NULL) {
+		keyTableBuild(kt, table);
+		LEF_INDEX_PUBLISH();
+		kt->table = table;
+	    }
+	    LEF_INDEX_UNLOCK();
+	    if (kt->table == table)
+		return (kt->slot != NULL) ? kt : NULL;
+	}
+	i = (i + 1) % KEYTABLE_MAX;
+    }
+    return NULL;
+}
+
 /*---------------------------------------------------------
  * Lookup --
  *	Searches a table of strings to find one that matches a given
@@ -86,6 +230,15 @@ Lookup(str, table)
     int match = -2;	/* result, initialized to -2 = no match */
     int pos;
     int ststart = 0;
+    KeyTable *kt;
+
+    /* Exact match through the table's perfect hash */
+    kt = keyTableFind(table);
+    if (kt != NULL) {
+	pos = kt->slot[keyHash(str, kt->seed) & kt->mask];
+	if ((pos >= 0) && keyMatch(table[pos], str))
+	    return pos;
+    }
 
     /* search for match */
     for (pos=0; table[pos] != NULL; pos++)
@@ -176,6 +329,345 @@ LookupFull(name, table)
 }
 
 
+/*--------------------------------------------------------------*/
+/* Memory-mapped input.  A LEF or DEF file opened through	*/
+/* LefOpenInput() is mapped (copy-on-write) in its entirety,	*/
+/* and LefNextToken() splits it into tokens in place, writing	*/
+/* a null byte over the space or tab that ends each token.	*/
+/* Newlines are left alone (a token ending a line is copied	*/
+/* out instead), and a null byte reads as a space, so that a	*/
+/* section can be tokenized again if need be.  Input from a	*/
+/* pipe (such as a compressed file being decompressed, see	*/
+/* zfile.c) is read into memory whole and tokenized the same	*/
+/* way.  Files that cannot be mapped (empty files, or systems	*/
+/* without mmap) are read a line at a time with fgets().	*/
+/*								*/
+/* The input position is kept per thread, so that worker	*/
+/* threads can each tokenize a range of the same file (see	*/
+/* LefSetInputRange()).						*/
+/*--------------------------------------------------------------*/
+
+#define LEF_CC_SPACE	0x01	/* Whitespace other than newline */
+#define LEF_CC_EOL	0x02	/* Newline */
+#define LEF_CC_COMMENT	0x04	/* Comment, at the start of a token */
+
+static const u_char LefCharClass[256] = {
+    ['\0'] = LEF_CC_SPACE,
+    ['\t'] = LEF_CC_SPACE, ['\v'] = LEF_CC_SPACE, ['\f'] = LEF_CC_SPACE,
+    ['\r'] = LEF_CC_SPACE, [' '] = LEF_CC_SPACE,
+    ['\n'] = LEF_CC_EOL,
+    ['#'] = LEF_CC_COMMENT
+};
+
+typedef struct lefinput_ {
+    FILE   *f;		/* File that is mapped */
+    char   *map;	/* Start of mapping or range, or NULL if none */
+    char   *end;	/* End of file or range */
+    char   *pos;	/* Next token, or start of next line */
+    char   *line;	/* Start of the line of the last token */
+    int    *lines;	/* Line counter to advance */
+    u_char midline;	/* TRUE if "pos" is a token on the current line */
+    u_char owned;	/* How "map" is to be released on close (below) */
+} LefInput;
+
+#define LEF_INPUT_RANGE		0	/* Owned by another thread */
+#define LEF_INPUT_MAPPED	1	/* Unmapped on close */
+#define LEF_INPUT_BUFFER	2	/* Freed on close */
+
+static STORE_THREAD_LOCAL LefInput lefInput;
+
+static char lefEOLToken[] = "\n";
+
+/* Read the whole of the input from pipe "f" into memory,	*/
+/* to be tokenized in place as for a mapped file.		*/
+
+static void
+lefReadInput(FILE *f)
+{
+    char *buf;
+    size_t len, size, n;
+
+    size = 1 << 20;
+    buf = (char *)malloc(size);
+    len = 0;
+    while ((n = fread(buf + len, 1, size - len, f)) > 0) {
+	len += n;
+	if (len == size) {
+	    size <<= 1;
+	    buf = (char *)realloc(buf, size);
+	}
+    }
+    if (len == 0) {
+	free(buf);
+	return;
+    }
+
+    lefInput.f = f;
+    lefInput.map = buf;
+    lefInput.end = buf + len;
+    lefInput.pos = buf;
+    lefInput.lines = &lefCurrentLine;
+    lefInput.midline = FALSE;
+    lefInput.owned = LEF_INPUT_BUFFER;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefOpenInput --
+ *
+ *	Map the contents of the file just opened as "f", for
+ *	parsing with LefNextToken().  If the file cannot be
+ *	mapped, it will be read with fgets() instead.
+ *
+ * Results:
+ *	None.
+ *
+ * Side Effects:
+ *	Any file previously opened with LefOpenInput() is
+ *	released.
+ *
+ *------------------------------------------------------------
+ */
+
+void
+LefOpenInput(FILE *f)
+{
+    struct stat st;
+#ifdef HAVE_SYS_MMAN_H
+    void *map;
+#endif
+
+    LefCloseInput(lefInput.f);
+
+    if (fstat(fileno(f), &st) != 0) return;
+    if (S_ISFIFO(st.st_mode)) {
+	lefReadInput(f);
+	return;
+    }
+
+#ifdef HAVE_SYS_MMAN_H
+    if (!S_ISREG(st.st_mode) || (st.st_size == 0)) return;
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		fileno(f), 0);
+    if (map == MAP_FAILED) return;
+#ifdef MADV_SEQUENTIAL
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    lefInput.f = f;
+    lefInput.map = (char *)map;
+    lefInput.end = lefInput.map + st.st_size;
+    lefInput.pos = lefInput.map;
+    lefInput.lines = &lefCurrentLine;
+    lefInput.midline = FALSE;
+    lefInput.owned = LEF_INPUT_MAPPED;
+#endif
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefCloseInput --
+ *
+ *	Release the mapping of file "f" made by LefOpenInput().
+ *	To be called before the file is closed.  Tokens from the
+ *	file are no longer valid afterward.
+ *
+ *------------------------------------------------------------
+ */
+
+void
+LefCloseInput(FILE *f)
+{
+    if ((f == NULL) || (f != lefInput.f)) return;
+#ifdef HAVE_SYS_MMAN_H
+    if (lefInput.owned == LEF_INPUT_MAPPED)
+	munmap(lefInput.map, (size_t)(lefInput.end - lefInput.map));
+#endif
+    if (lefInput.owned == LEF_INPUT_BUFFER)
+	free(lefInput.map);
+    lefInput.f = NULL;
+    lefInput.map = NULL;
+    lefInput.end = NULL;
+    lefInput.pos = NULL;
+    lefInput.line = NULL;
+    lefInput.lines = NULL;
+    lefInput.midline = FALSE;
+    lefInput.owned = LEF_INPUT_RANGE;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefLineOffset --
+ *
+ *	Return the offset in file "f" of the start of the line
+ *	holding the token last returned by LefNextToken(), or
+ *	-1 if the file is not held in memory (so the offset is
+ *	not known).  For a compressed file, this is the offset
+ *	in the uncompressed text.
+ *
+ *------------------------------------------------------------
+ */
+
+off_t
+LefLineOffset(FILE *f)
+{
+    if ((f != lefInput.f) || (lefInput.map == NULL) || (lefInput.line == NULL)
+		|| (lefInput.owned == LEF_INPUT_RANGE))
+	return (off_t)(-1);
+    return (off_t)(lefInput.line - lefInput.map);
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefGetInputRange --
+ *
+ *	For a mapped file, return the position of the next line
+ *	to be read by LefNextToken() (NULL if the file is not
+ *	mapped, or is part way through a line), and the end of
+ *	the file in "endptr".
+ *
+ *------------------------------------------------------------
+ */
+
+char *
+LefGetInputRange(FILE *f, char **endptr)
+{
+    if ((f != lefInput.f) || (lefInput.map == NULL) || lefInput.midline)
+	return NULL;
+    if (endptr) *endptr = lefInput.end;
+    return lefInput.pos;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefSetInputRange --
+ *
+ *	Make LefNextToken(f, ...) in the calling thread read the
+ *	text from "start" (which must be the start of a line) up
+ *	to "end", both within the mapping of "f".  Lines read are
+ *	counted in "lines".  In the thread that mapped the file,
+ *	this moves the read position;  in a worker thread, it
+ *	sets up a private position that is dropped with
+ *	LefCloseInput(f).
+ *
+ *------------------------------------------------------------
+ */
+
+void
+LefSetInputRange(FILE *f, char *start, char *end, int *lines)
+{
+    if (f != lefInput.f) {
+	lefInput.f = f;
+	lefInput.map = start;
+	lefInput.owned = LEF_INPUT_RANGE;
+    }
+    lefInput.pos = start;
+    lefInput.end = end;
+    lefInput.lines = lines;
+    lefInput.midline = FALSE;
+}
+
+/* Return the start of the line following position "p" */
+
+static char *
+lefSkipLine(char *p, char *end)
+{
+    char *nl;
+
+    nl = (char *)memchr(p, '\n', (size_t)(end - p));
+    return (nl) ? nl + 1 : end;
+}
+
+/* LefNextToken() for a mapped file */
+
+static char *
+lefMapNextToken(u_char ignore_eol)
+{
+    static STORE_THREAD_LOCAL char lasttoken[LEF_LINE_MAX + 2];
+    char *p, *q, *token, *end = lefInput.end;
+    size_t len;
+
+    p = lefInput.pos;
+
+    /* Move to the next line that has a token, if necessary */
+
+    if (!lefInput.midline)
+    {
+	for (;;)
+	{
+	    if (p >= end) {
+		lefInput.pos = end;
+		return NULL;
+	    }
+	    (*lefInput.lines)++;
+	    lefInput.line = p;
+	    while ((p < end) && (LefCharClass[(u_char)*p] == LEF_CC_SPACE))
+		p++;		/* skip leading whitespace */
+
+	    if ((p < end) && !(LefCharClass[(u_char)*p] &
+			(LEF_CC_EOL | LEF_CC_COMMENT)))
+		break;
+	    p = lefSkipLine(p, end);
+	}
+	lefInput.pos = p;
+	lefInput.midline = TRUE;
+	if (!ignore_eol)
+	    return lefEOLToken;
+    }
+
+    /* Find the end of the token.  Quoted material (which may	*/
+    /* run over several lines) is a single token.		*/
+
+    token = p;
+    if (*p == '\"') {
+	for (p++; p < end; p++)
+	    if ((*p == '\"') && (*(p - 1) != '\\'))
+		break;
+	if (p >= end) {
+	    lefInput.pos = end;
+	    lefInput.midline = FALSE;
+	    return NULL;
+	}
+	p++;
+    }
+    else {
+	while ((p < end) && !(LefCharClass[(u_char)*p] &
+			(LEF_CC_SPACE | LEF_CC_EOL)))
+	    p++;
+    }
+
+    /* Find the next token on the line, if any */
+
+    q = p;
+    while ((q < end) && (LefCharClass[(u_char)*q] == LEF_CC_SPACE))
+	q++;
+    if ((q >= end) || (LefCharClass[(u_char)*q] & (LEF_CC_EOL | LEF_CC_COMMENT))) {
+	lefInput.midline = FALSE;
+	q = lefSkipLine(q, end);
+    }
+    lefInput.pos = q;
+
+    /* Terminate the token in place if it is followed by a	*/
+    /* space.  Otherwise (end of line or file, or a quote run	*/
+    /* into the next token) copy it out.			*/
+
+    if ((p < end) && (LefCharClass[(u_char)*p] == LEF_CC_SPACE)) {
+	*p = '\0';
+	return token;
+    }
+    len = (size_t)(p - token);
+    if (len > LEF_LINE_MAX) len = LEF_LINE_MAX;
+    memcpy(lasttoken, token, len);
+    lasttoken[len] = '\0';
+    return lasttoken;
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -195,7 +687,9 @@ LookupFull(name, table)
  * Warnings:
  *	The return result of LefNextToken will be overwritten by
  *	subsequent calls to LefNextToken if more than one line of
- *	input is parsed.
+ *	input is parsed.  (Tokens from a file opened with
+ *	LefOpenInput() last until LefCloseInput(), but callers
+ *	should not depend on it.)
  *
  *------------------------------------------------------------
  */
@@ -208,6 +702,9 @@ LefNextToken(FILE *f, u_char ignore_eol)
     static char *curtoken;		/* pointer to current token */
     static char eol_token='\n';
 
+    if ((f == lefInput.f) && (lefInput.map != NULL))
+	return lefMapNextToken(ignore_eol);
+
     /* Read a new line if necessary */
 
     if (nexttoken == NULL)
@@ -285,30 +782,43 @@ LefNextToken(FILE *f, u_char ignore_eol)
  *------------------------------------------------------------
  */
 
+/* Count of errors and warnings held back in this thread, or -1	*/
+/* if they are being reported (see LefDeferErrors()).		*/
+
+static STORE_THREAD_LOCAL int lefDeferred = -1;
+
+/* Errors and warnings reported since the last summary */
+
+static int lefFatal = 0;
+static int lefNonfatal = 0;
+
 void
 LefError(int type, char *fmt, ...)
 {  
-    static int fatal = 0;
-    static int nonfatal = 0;
     char lefordef = 'L';
     int errors;
     va_list args;
 
+    if (lefDeferred >= 0) {
+	if (fmt != NULL) lefDeferred++;
+	return;
+    }
+
     if (Verbose == 0) return;
 
     if ((type == DEF_WARNING) || (type == DEF_ERROR)) lefordef = 'D';
 
-    errors = fatal + nonfatal;
+    errors = lefFatal + lefNonfatal;
     if (fmt == NULL)  /* Special case:  report any errors and reset */
     {
 	if (errors > 0)
 	{
 	    Fprintf(stdout, "%cEF Read: encountered %d error%s and %d warning%s total.\n",
 			lefordef,
-			fatal, (fatal == 1) ? "" : "s",
-			nonfatal, (nonfatal == 1) ? "" : "s");
-	    fatal = 0;
-	    nonfatal = 0;
+			lefFatal, (lefFatal == 1) ? "" : "s",
+			lefNonfatal, (lefNonfatal == 1) ? "" : "s");
+	    lefFatal = 0;
+	    lefNonfatal = 0;
 	}
 	return;
     }
@@ -326,9 +836,36 @@ LefError(int type, char *fmt, ...)
 		lefordef);
 
     if ((type == LEF_ERROR) || (type == DEF_ERROR))
-	fatal++;
+	lefFatal++;
     else if ((type == LEF_WARNING) || (type == DEF_WARNING))
-	nonfatal++;
+	lefNonfatal++;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefDeferErrors --
+ *
+ *	If "defer" is TRUE, errors and warnings raised by the
+ *	calling thread are counted but not printed, as when a
+ *	worker thread parses part of a file that will be read
+ *	again serially if anything is wrong with it.  If FALSE,
+ *	reporting resumes.
+ *
+ * Results:
+ *	The number of errors and warnings held back since the
+ *	last call.
+ *
+ *------------------------------------------------------------
+ */
+
+int
+LefDeferErrors(u_char defer)
+{
+    int held = (lefDeferred > 0) ? lefDeferred : 0;
+
+    lefDeferred = (defer) ? 0 : -1;
+    return held;
 }
 
 /*
@@ -444,16 +981,98 @@ LefSkipSection(FILE *f, char *section)
  *------------------------------------------------------------
  */
 
+/* Macro names are not case sensitive.  Where two macros share	*/
+/* a name, the one most recently added to GateInfo is found.	*/
+/* MacroExact holds the same records by exact name, for the	*/
+/* check for duplicate definitions in LefReadMacro().		*/
+
+static HashTable MacroTable;
+static HashTable MacroExact;
+
 GATE
 lefFindCell(char *name)
 {
-    GATE gateginfo;
+    return (GATE)HashLookup(&MacroTable, name);
+}
 
-    for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next) { 
-	if (!strcasecmp(gateginfo->gatename, name))
-	    return gateginfo;
+/*
+ *------------------------------------------------------------
+ *
+ * LefHashCell --
+ *
+ *	Enter a new macro record into the hash table of macro
+ *	names.  Must be called for every record added to
+ *	GateInfo, with its pinindex NULL or a valid index.
+ *
+ *------------------------------------------------------------
+ */
+
+void
+LefHashCell(GATE gateginfo)
+{
+    if (MacroTable.size == 0) {
+	HashInit(&MacroTable, 256, HASH_NOCASE);
+	HashInit(&MacroExact, 256, HASH_CASE);
+    }
+
+    /* Any pin index made before is rebuilt on next use */
+    if (gateginfo->pinindex != NULL) {
+	HashKill(gateginfo->pinindex);
+	free(gateginfo->pinindex);
+	gateginfo->pinindex = NULL;
+    }
+    HashInsert(&MacroTable, gateginfo->gatename, (void *)gateginfo);
+    HashInsert(&MacroExact, gateginfo->gatename, (void *)gateginfo);
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefFindPin --
+ *
+ *	Return the index of the pin named "pinname" in macro
+ *	"gateginfo", or -1 if the macro has no such pin.  Pin
+ *	names are not case sensitive.  Macros with more than a
+ *	handful of pins get a hash table of pin names, made on
+ *	first use (the macro's pins are complete by then).
+ *
+ *------------------------------------------------------------
+ */
+
+#define PIN_INDEX_MIN	8	/* Fewer pins than this are just scanned */
+
+int
+LefFindPin(GATE gateginfo, char *pinname)
+{
+    int i;
+    char **pinptr;
+    HashTable *pinindex;
+
+    if (gateginfo->nodes < PIN_INDEX_MIN) {
+	for (i = 0; i < gateginfo->nodes; i++)
+	    if (!strcasecmp(gateginfo->node[i], pinname))
+		return i;
+	return -1;
+    }
+
+    if (gateginfo->pinindex == NULL) {
+	LEF_INDEX_LOCK();
+	if (gateginfo->pinindex == NULL) {
+	    pinindex = (HashTable *)malloc(sizeof(HashTable));
+	    HashInit(pinindex, gateginfo->nodes, HASH_NOCASE);
+
+	    /* The first of any duplicate names is the one found */
+	    for (i = gateginfo->nodes - 1; i >= 0; i--)
+		if (gateginfo->node[i] != NULL)
+		    HashInsert(pinindex, gateginfo->node[i],
+				(void *)&gateginfo->node[i]);
+	    LEF_INDEX_PUBLISH();
+	    gateginfo->pinindex = pinindex;
+	}
+	LEF_INDEX_UNLOCK();
     }
-    return (GATE)NULL;
+    pinptr = (char **)HashLookup(gateginfo->pinindex, pinname);
+    return (pinptr) ? (int)(pinptr - gateginfo->node) : -1;
 }
 
 /*
@@ -559,6 +1178,7 @@ LefRedefined(LefList lefl, char *redefname)
     newlefl->info.via.cell = (GATE)NULL;
     newlefl->info.via.lr = (DSEG)NULL;
 
+    LayerTableHead = NULL;	/* Names may have changed */
     return newlefl;
 }
 
@@ -571,17 +1191,21 @@ LefRedefined(LefList lefl, char *redefname)
 LefList
 LefFindLayer(char *token)
 {
-    LefList lefl, rlefl;
+    LefList lefl;
    
     if (token == NULL) return NULL;
-    rlefl = (LefList)NULL;
-    for (lefl = LefInfo; lefl; lefl = lefl->next) {
-	if (!strcmp(lefl->lefName, token)) {
-	   rlefl = lefl;
-	   break;
-	}
+
+    if (LayerTableHead != LefInfo) {
+	HashKill(&LayerTable);
+	HashInit(&LayerTable, 64, HASH_CASE);
+
+	/* The first record in the list with a given name is found */
+	for (lefl = LefInfo; lefl; lefl = lefl->next)
+	    if (HashLookup(&LayerTable, lefl->lefName) == NULL)
+		HashInsert(&LayerTable, lefl->lefName, (void *)lefl);
+	LayerTableHead = LefInfo;
     }
-    return rlefl;
+    return (LefList)HashLookup(&LayerTable, token);
 }
 	
 /*
@@ -1730,7 +2354,7 @@ LefPolygonToRects(DSEG *rectListPtr, DPOINT pointlist)
 
    if ((ptail->x != pointlist->x) || (ptail->y != pointlist->y))
    {
-	p = (DPOINT)malloc(sizeof(struct dpoint_));
+	p = allocDPOINT();
 	p->x = pointlist->x;
 	p->y = pointlist->y;
 	p->layer = pointlist->layer;
@@ -1875,7 +2499,7 @@ LefReadPolygon(FILE *f, int curlayer, float oscale)
 	    break;
 	}
 
-	newPoint = (DPOINT)malloc(sizeof(struct dpoint_));
+	newPoint = allocDPOINT();
 	newPoint->x = px / (double)oscale;
 	newPoint->y = py / (double)oscale;
 	newPoint->layer = curlayer;
@@ -1968,6 +2592,7 @@ LefReadGeometry(GATE lefMacro, FILE *f, float oscale)
 	    case LEF_POLYGON:
 		pointlist = LefReadPolygon(f, curlayer, oscale);
 		LefPolygonToRects(&rectList, pointlist);
+		freeDPOINTlist(pointlist);
 		break;
 	    case LEF_VIA:
 		LefEndStatement(f);
@@ -2295,14 +2920,8 @@ LefReadMacro(f, mname, oscale)
 
     /* Start by creating a new celldef */
 
-    lefMacro = (GATE)NULL;
-    for (altMacro = GateInfo; altMacro; altMacro = altMacro->next)
-    {
-	if (!strcmp(altMacro->gatename, mname)) {
-	    lefMacro = altMacro;
-	    break;
-	}
-    }
+    lefMacro = (MacroExact.size == 0) ? (GATE)NULL :
+		(GATE)HashLookup(&MacroExact, mname);
 
     while (lefMacro)
     {
@@ -2312,22 +2931,28 @@ LefReadMacro(f, mname, oscale)
 	altMacro = lefMacro;
 	for (suffix = 1; altMacro != NULL; suffix++)
 	{
-	    sprintf(newname, "%250s_%d", mname, suffix);
-	    for (altMacro = GateInfo; altMacro; altMacro = altMacro->next)
-		if (!strcmp(altMacro->gatename, newname))
-		    break;
+	    snprintf(newname, sizeof(newname), "%s_%d", mname, suffix);
+	    altMacro = (GATE)HashLookup(&MacroExact, newname);
 	}
 	LefError(LEF_WARNING, "Cell \"%s\" was already defined in this file.  "
 		"Renaming original cell \"%s\"\n", mname, newname);
 
+	/* The case-insensitive entry may belong to a later macro */
+	if (lefFindCell(lefMacro->gatename) == lefMacro)
+	    HashDelete(&MacroTable, lefMacro->gatename);
+	HashDelete(&MacroExact, lefMacro->gatename);
 	lefMacro->gatename = strdup(newname);
-	lefMacro = lefFindCell(mname);
+	if (lefFindCell(lefMacro->gatename) == NULL)
+	    HashInsert(&MacroTable, lefMacro->gatename, (void *)lefMacro);
+	HashInsert(&MacroExact, lefMacro->gatename, (void *)lefMacro);
+	lefMacro = (GATE)HashLookup(&MacroExact, mname);
     }
 
     // Create the new cell
     lefMacro = (GATE)malloc(sizeof(struct gate_));
     lefMacro->gatename = strdup(mname);
     lefMacro->gatetype = NULL;
+    lefMacro->pinindex = NULL;
     lefMacro->width = 0.0;
     lefMacro->height = 0.0;
     lefMacro->placedX = 0.0;
@@ -2350,6 +2975,7 @@ LefReadMacro(f, mname, oscale)
     lefMacro->node[0] = NULL;
     lefMacro->netnum[0] = -1;
     GateInfo = lefMacro;
+    LefHashCell(lefMacro);
 
 
     /* Initial values */
@@ -3651,6 +4277,590 @@ LefAssignLayerVias()
     }
 }
 
+/*
+ *------------------------------------------------------------
+ * LEF cache --
+ *
+ *	The result of parsing a LEF file (the LefInfo layer and
+ *	via list, the GateInfo macro list, and the cut layer
+ *	names) can be saved to a binary file in the directory
+ *	LefCacheDir, and loaded from it on later runs in place
+ *	of parsing the file again.  Everything after the parse
+ *	(the "pin" macro, generated via orientations, and the
+ *	choice of vias) is still done as usual.
+ *
+ *	A cache file holds the complete state after the parse,
+ *	including anything read before.  It is keyed by:  the
+ *	format version and record sizes;  the LEF file's size,
+ *	modification time, inode, and a hash of its first and
+ *	last blocks;  the route.cfg values the parse depends on
+ *	(number of layers and pitches);  and the key of the LEF
+ *	read before it, if any.  The cache is used only when
+ *	the LEF state is known to be exactly what the previous
+ *	LEF read left (or empty), and no DEF has been read.
+ *
+ *	Errors and warnings from the original parse are not
+ *	repeated, but are counted in the summary.
+ *------------------------------------------------------------
+ */
+
+char *LefCacheDir = NULL;	/* Directory for cache files, or NULL */
+
+#define LEF_CACHE_VERSION	1
+#define LEF_CACHE_SAMPLE	65536	/* Bytes hashed at each end of the file */
+
+typedef struct lefcachekey_ {
+    char     magic[8];		/* "QRLEFC" */
+    u_int    version;
+    u_int    sizes[4];		/* Record sizes and layer limits */
+    uint64_t prior;		/* Key of the state before this read */
+    uint64_t size;		/* LEF file size */
+    uint64_t mtime;		/* LEF file modification time */
+    uint64_t inode;
+    uint64_t sample;		/* Hash of first and last blocks of file */
+    int      num_layers;	/* Settings used by the parse */
+    double   pitchx, pitchy;
+} LefCacheKey;
+
+#define LEF_CACHE_TRAILER	0x51524c45	/* Marks a complete file */
+
+/* Key of the state left by the last LEF read, if the state	*/
+/* has not been changed since (see lefCachePrior()).		*/
+
+static uint64_t lefCacheState = 0;
+static u_char	lefCacheValid = FALSE;
+static LefList	lefCacheInfo = NULL;
+static GATE	lefCacheGates = NULL;
+
+/* Growable output buffer, and bounded input for reading back	*/
+
+typedef struct lefcachebuf_ {
+    char  *data;
+    size_t len, alloc;
+} LefCacheBuf;
+
+typedef struct lefcachein_ {
+    char  *pos, *end;
+    u_char bad;
+} LefCacheIn;
+
+static uint64_t
+lefCacheHash(uint64_t h, void *data, size_t len)
+{
+    u_char *p;
+
+    for (p = (u_char *)data; len > 0; p++, len--)
+	h = (h ^ (uint64_t)*p) * 1099511628211ULL;
+    return h;
+}
+
+static void
+lcPut(LefCacheBuf *b, void *data, size_t len)
+{
+    if (b->len + len > b->alloc) {
+	while (b->len + len > b->alloc)
+	    b->alloc = (b->alloc) ? b->alloc * 2 : 65536;
+	b->data = (char *)realloc(b->data, b->alloc);
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static void lcPutInt(LefCacheBuf *b, int v)	  { lcPut(b, &v, sizeof(int)); }
+static void lcPutDouble(LefCacheBuf *b, double v) { lcPut(b, &v, sizeof(double)); }
+
+static void
+lcPutString(LefCacheBuf *b, char *s)
+{
+    int len = (s) ? strlen(s) : -1;
+
+    lcPutInt(b, len);
+    if (len > 0) lcPut(b, s, len);
+}
+
+static void
+lcPutSegs(LefCacheBuf *b, DSEG seg)
+{
+    DSEG ds;
+    int n = 0;
+
+    for (ds = seg; ds; ds = ds->next) n++;
+    lcPutInt(b, n);
+    for (ds = seg; ds; ds = ds->next) {
+	lcPutInt(b, ds->layer);
+	lcPutDouble(b, ds->x1);
+	lcPutDouble(b, ds->y1);
+	lcPutDouble(b, ds->x2);
+	lcPutDouble(b, ds->y2);
+    }
+}
+
+static void
+lcGet(LefCacheIn *in, void *data, size_t len)
+{
+    if (in->bad || (len > (size_t)(in->end - in->pos))) {
+	in->bad = TRUE;
+	memset(data, 0, len);
+	return;
+    }
+    memcpy(data, in->pos, len);
+    in->pos += len;
+}
+
+static int    lcGetInt(LefCacheIn *in)    { int v;    lcGet(in, &v, sizeof(int)); return v; }
+static double lcGetDouble(LefCacheIn *in) { double v; lcGet(in, &v, sizeof(double)); return v; }
+
+static char *
+lcGetString(LefCacheIn *in)
+{
+    int len = lcGetInt(in);
+    char *s;
+
+    if (in->bad || (len < 0)) return NULL;
+    if (len > in->end - in->pos) {
+	in->bad = TRUE;
+	return NULL;
+    }
+    s = (char *)malloc(len + 1);
+    memcpy(s, in->pos, len);
+    s[len] = '\0';
+    in->pos += len;
+    return s;
+}
+
+static DSEG
+lcGetSegs(LefCacheIn *in)
+{
+    DSEG first = NULL, last = NULL, ds;
+    int n;
+
+    for (n = lcGetInt(in); (n > 0) && !in->bad; n--) {
+	ds = (DSEG)malloc(sizeof(struct dseg_));
+	ds->layer = lcGetInt(in);
+	ds->x1 = lcGetDouble(in);
+	ds->y1 = lcGetDouble(in);
+	ds->x2 = lcGetDouble(in);
+	ds->y2 = lcGetDouble(in);
+	ds->next = NULL;
+	if (last) last->next = ds; else first = ds;
+	last = ds;
+    }
+    return first;
+}
+
+/* Set the directory used for LEF cache files ("none" or NULL	*/
+/* to stop using the cache).					*/
+
+void
+LefSetCacheDir(char *dir)
+{
+    if (LefCacheDir) free(LefCacheDir);
+    if ((dir == NULL) || (*dir == '\0') || !strcasecmp(dir, "none"))
+	LefCacheDir = NULL;
+    else
+	LefCacheDir = strdup(dir);
+}
+
+/* Determine the key of the LEF state before a read.  Returns	*/
+/* FALSE if the state is not one that a cache file can stand	*/
+/* for (it was changed since the last LEF read by something	*/
+/* else, such as a "gate" in route.cfg or a DEF VIAS section).	*/
+
+static u_char
+lefCachePrior(uint64_t *prior)
+{
+    if (Nlgates != NULL) return FALSE;
+    if ((LefInfo == NULL) && (GateInfo == NULL)) {
+	*prior = 0;
+	return TRUE;
+    }
+    if (lefCacheValid && (LefInfo == lefCacheInfo) && (GateInfo == lefCacheGates)) {
+	*prior = lefCacheState;
+	return TRUE;
+    }
+    return FALSE;
+}
+
+/* Fill in the cache key for reading LEF file "f".  Returns	*/
+/* FALSE if there is no usable key.				*/
+
+static u_char
+lefCacheMakeKey(FILE *f, LefCacheKey *key)
+{
+    struct stat st;
+    char *buf;
+    ssize_t n;
+    off_t tail;
+    int fd;
+
+    memset(key, 0, sizeof(LefCacheKey));
+    if (!lefCachePrior(&key->prior)) return FALSE;
+    fd = ZFileDescriptor(f);
+    if (fstat(fd, &st) != 0) return FALSE;
+    if (!S_ISREG(st.st_mode)) return FALSE;
+
+    strcpy(key->magic, "QRLEFC");
+    key->version = LEF_CACHE_VERSION;
+    key->sizes[0] = sizeof(struct gate_);
+    key->sizes[1] = sizeof(lefLayer);
+    key->sizes[2] = MAX_LAYERS;
+    key->sizes[3] = MAX_TYPES;
+    key->size = (uint64_t)st.st_size;
+    key->mtime = (uint64_t)st.st_mtime;
+    key->inode = (uint64_t)st.st_ino;
+    key->num_layers = Num_layers;
+    key->pitchx = PitchX;
+    key->pitchy = PitchY;
+
+    buf = (char *)malloc(LEF_CACHE_SAMPLE);
+    key->sample = 14695981039346656037ULL;
+    n = pread(fd, buf, LEF_CACHE_SAMPLE, 0);
+    if (n > 0) key->sample = lefCacheHash(key->sample, buf, (size_t)n);
+    tail = st.st_size - LEF_CACHE_SAMPLE;
+    if (tail > 0) {
+	n = pread(fd, buf, LEF_CACHE_SAMPLE, tail);
+	if (n > 0) key->sample = lefCacheHash(key->sample, buf, (size_t)n);
+    }
+    free(buf);
+    return TRUE;
+}
+
+/* Name of the cache file for LEF file "lefname" with "key" */
+
+static char *
+lefCacheFile(char *lefname, LefCacheKey *key)
+{
+    char *base, *path;
+    uint64_t h;
+
+    base = strrchr(lefname, '/');
+    base = (base) ? base + 1 : lefname;
+    h = lefCacheHash(14695981039346656037ULL, key, sizeof(LefCacheKey));
+
+    path = (char *)malloc(strlen(LefCacheDir) + strlen(base) + 24);
+    sprintf(path, "%s/%s.%016llx.qlc", LefCacheDir, base, (unsigned long long)h);
+    return path;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * lefCacheSave --
+ *
+ *	Write the LEF state as it stands after parsing a file
+ *	to the cache file for "key".  "oprecis", "lines",
+ *	"errors" and "warnings" are the results of the parse.
+ *	Failure to write the file is not an error;  the file
+ *	is written under a temporary name and renamed, so a
+ *	partial file is never seen.
+ *
+ *------------------------------------------------------------
+ */
+
+static void
+lefCacheSave(char *lefname, LefCacheKey *key, int oprecis, int lines,
+	int errors, int warnings)
+{
+    LefCacheBuf b = {NULL, 0, 0};
+    LefList lefl;
+    lefSpacingRule *rule;
+    GATE gate;
+    char *path, *tmppath;
+    FILE *cf;
+    int i, n;
+    u_char ok;
+
+    /* Only records in the form LefRead() makes can be saved */
+    for (gate = GateInfo; gate; gate = gate->next)
+	if (gate->gatetype != NULL) return;
+    for (lefl = LefInfo; lefl; lefl = lefl->next)
+	if (((lefl->lefClass == CLASS_CUT) || (lefl->lefClass == CLASS_VIA))
+		&& (lefl->info.via.cell != NULL))
+	    return;
+
+    lcPut(&b, key, sizeof(LefCacheKey));
+    lcPutInt(&b, oprecis);
+    lcPutInt(&b, lines);
+    lcPutInt(&b, errors);
+    lcPutInt(&b, warnings);
+
+    for (n = 0, lefl = LefInfo; lefl; lefl = lefl->next) n++;
+    lcPutInt(&b, n);
+    for (lefl = LefInfo; lefl; lefl = lefl->next) {
+	lcPutString(&b, lefl->lefName);
+	lcPutInt(&b, lefl->type);
+	lcPutInt(&b, lefl->obsType);
+	lcPutInt(&b, (int)lefl->lefClass);
+	if (lefl->lefClass == CLASS_ROUTE) {
+	    lefRoute *route = &lefl->info.route;
+
+	    lcPutDouble(&b, route->width);
+	    lcPutDouble(&b, route->pitchx);
+	    lcPutDouble(&b, route->pitchy);
+	    lcPutDouble(&b, route->offsetx);
+	    lcPutDouble(&b, route->offsety);
+	    lcPutDouble(&b, route->respersq);
+	    lcPutDouble(&b, route->areacap);
+	    lcPutDouble(&b, route->edgecap);
+	    lcPutDouble(&b, route->minarea);
+	    lcPutDouble(&b, route->thick);
+	    lcPutDouble(&b, route->antenna);
+	    lcPutInt(&b, (int)route->method);
+	    lcPutInt(&b, (int)route->hdirection);
+	    for (n = 0, rule = route->spacing; rule; rule = rule->next) n++;
+	    lcPutInt(&b, n);
+	    for (rule = route->spacing; rule; rule = rule->next) {
+		lcPutDouble(&b, rule->width);
+		lcPutDouble(&b, rule->spacing);
+	    }
+	}
+	else if ((lefl->lefClass == CLASS_CUT) || (lefl->lefClass == CLASS_VIA)) {
+	    lefVia *via = &lefl->info.via;
+
+	    lcPutInt(&b, via->area.layer);
+	    lcPutDouble(&b, via->area.x1);
+	    lcPutDouble(&b, via->area.y1);
+	    lcPutDouble(&b, via->area.x2);
+	    lcPutDouble(&b, via->area.y2);
+	    lcPutSegs(&b, via->lr);
+	    lcPutDouble(&b, via->respervia);
+	    lcPutInt(&b, via->obsType);
+	    lcPutInt(&b, (int)via->generated);
+	}
+    }
+
+    for (n = 0, gate = GateInfo; gate; gate = gate->next) n++;
+    lcPutInt(&b, n);
+    for (gate = GateInfo; gate; gate = gate->next) {
+	lcPutString(&b, gate->gatename);
+	lcPutDouble(&b, gate->width);
+	lcPutDouble(&b, gate->height);
+	lcPutDouble(&b, gate->placedX);
+	lcPutDouble(&b, gate->placedY);
+	lcPutInt(&b, gate->orient);
+	lcPutInt(&b, gate->nodes);
+	lcPutSegs(&b, gate->obs);
+	for (i = 0; i < gate->nodes; i++) {
+	    lcPutString(&b, gate->node[i]);
+	    lcPutInt(&b, gate->netnum[i]);
+	    lcPutInt(&b, (int)gate->direction[i]);
+	    lcPut(&b, &gate->area[i], sizeof(float));
+	    lcPutSegs(&b, gate->taps[i]);
+	}
+    }
+    lcPutInt(&b, LEF_CACHE_TRAILER);
+
+    path = lefCacheFile(lefname, key);
+    tmppath = (char *)malloc(strlen(path) + 16);
+    sprintf(tmppath, "%s.%d", path, (int)getpid());
+
+    ok = FALSE;
+    cf = fopen(tmppath, "w");
+    if (cf != NULL) {
+	ok = (fwrite(b.data, 1, b.len, cf) == b.len) ? TRUE : FALSE;
+	if (fclose(cf) != 0) ok = FALSE;
+	if (ok && (rename(tmppath, path) != 0)) ok = FALSE;
+	if (!ok) unlink(tmppath);
+    }
+    if (!ok)
+	Fprintf(stderr, "LEF cache:  Cannot write cache file %s.\n", path);
+    else if (Verbose > 0)
+	Fprintf(stdout, "LEF read: Saved to cache file %s.\n", path);
+
+    free(tmppath);
+    free(path);
+    free(b.data);
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * lefCacheLoad --
+ *
+ *	Look for a cache file for "key" and, if one is found,
+ *	replace the LEF state with its contents.
+ *
+ * Results:
+ *	TRUE if the state was loaded, in which case "oprecis",
+ *	"lines", "errors" and "warnings" are set from the
+ *	original parse.  FALSE if there is no (usable) cache
+ *	file, in which case nothing is changed.
+ *
+ *------------------------------------------------------------
+ */
+
+static u_char
+lefCacheLoad(char *lefname, LefCacheKey *key, int *oprecis, int *lines,
+	int *errors, int *warnings)
+{
+    LefCacheIn in;
+    LefList lefl, lefhead = NULL, leflast = NULL;
+    lefSpacingRule *rule, *rulelast;
+    GATE gate, gatehead = NULL, gatelast = NULL, *gates;
+    char *path, *data;
+    struct stat st;
+    int fd, i, n, numgates, alloc;
+    u_char ok = FALSE;
+
+    path = lefCacheFile(lefname, key);
+    fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) return FALSE;
+
+    if ((fstat(fd, &st) != 0) || (st.st_size < sizeof(LefCacheKey))) {
+	close(fd);
+	return FALSE;
+    }
+#ifdef HAVE_SYS_MMAN_H
+    data = (char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ((void *)data == MAP_FAILED) return FALSE;
+#else
+    data = (char *)malloc(st.st_size);
+    n = read(fd, data, st.st_size);
+    close(fd);
+    if (n != st.st_size) {
+	free(data);
+	return FALSE;
+    }
+#endif
+
+    in.pos = data;
+    in.end = data + st.st_size;
+    in.bad = FALSE;
+
+    if (memcmp(data, key, sizeof(LefCacheKey))) goto done;
+    in.pos += sizeof(LefCacheKey);
+
+    *oprecis = lcGetInt(&in);
+    *lines = lcGetInt(&in);
+    *errors = lcGetInt(&in);
+    *warnings = lcGetInt(&in);
+
+    for (n = lcGetInt(&in); (n > 0) && !in.bad; n--) {
+	lefl = (LefList)calloc(1, sizeof(lefLayer));
+	lefl->lefName = lcGetString(&in);
+	lefl->type = lcGetInt(&in);
+	lefl->obsType = lcGetInt(&in);
+	lefl->lefClass = (u_char)lcGetInt(&in);
+	if (lefl->lefClass == CLASS_ROUTE) {
+	    lefRoute *route = &lefl->info.route;
+
+	    route->width = lcGetDouble(&in);
+	    route->pitchx = lcGetDouble(&in);
+	    route->pitchy = lcGetDouble(&in);
+	    route->offsetx = lcGetDouble(&in);
+	    route->offsety = lcGetDouble(&in);
+	    route->respersq = lcGetDouble(&in);
+	    route->areacap = lcGetDouble(&in);
+	    route->edgecap = lcGetDouble(&in);
+	    route->minarea = lcGetDouble(&in);
+	    route->thick = lcGetDouble(&in);
+	    route->antenna = lcGetDouble(&in);
+	    route->method = (u_char)lcGetInt(&in);
+	    route->hdirection = (u_char)lcGetInt(&in);
+	    rulelast = NULL;
+	    for (i = lcGetInt(&in); (i > 0) && !in.bad; i--) {
+		rule = (lefSpacingRule *)malloc(sizeof(lefSpacingRule));
+		rule->width = lcGetDouble(&in);
+		rule->spacing = lcGetDouble(&in);
+		rule->next = NULL;
+		if (rulelast) rulelast->next = rule; else route->spacing = rule;
+		rulelast = rule;
+	    }
+	}
+	else if ((lefl->lefClass == CLASS_CUT) || (lefl->lefClass == CLASS_VIA)) {
+	    lefVia *via = &lefl->info.via;
+
+	    via->area.layer = lcGetInt(&in);
+	    via->area.x1 = lcGetDouble(&in);
+	    via->area.y1 = lcGetDouble(&in);
+	    via->area.x2 = lcGetDouble(&in);
+	    via->area.y2 = lcGetDouble(&in);
+	    via->lr = lcGetSegs(&in);
+	    via->respervia = lcGetDouble(&in);
+	    via->obsType = lcGetInt(&in);
+	    via->generated = (char)lcGetInt(&in);
+	}
+	if (leflast) leflast->next = lefl; else lefhead = lefl;
+	leflast = lefl;
+    }
+
+    numgates = 0;
+    for (n = lcGetInt(&in); (n > 0) && !in.bad; n--) {
+	gate = (GATE)calloc(1, sizeof(struct gate_));
+	gate->gatename = lcGetString(&in);
+	gate->width = lcGetDouble(&in);
+	gate->height = lcGetDouble(&in);
+	gate->placedX = lcGetDouble(&in);
+	gate->placedY = lcGetDouble(&in);
+	gate->orient = lcGetInt(&in);
+	gate->nodes = lcGetInt(&in);
+	gate->obs = lcGetSegs(&in);
+	if ((gate->nodes < 0) || (gate->nodes > in.end - in.pos)) {
+	    in.bad = TRUE;
+	    gate->nodes = 0;
+	}
+
+	/* Allocate pin arrays in the sizes LefReadPort() expects */
+	alloc = (gate->nodes / 10 + 1) * 10;
+	gate->taps = (DSEG *)calloc(alloc, sizeof(DSEG));
+	gate->noderec = (NODE *)calloc(alloc, sizeof(NODE));
+	gate->direction = (u_char *)calloc(alloc, sizeof(u_char));
+	gate->area = (float *)calloc(alloc, sizeof(float));
+	gate->netnum = (int *)calloc(alloc, sizeof(int));
+	gate->node = (char **)calloc(alloc, sizeof(char *));
+	gate->netnum[0] = -1;
+	for (i = 0; i < gate->nodes; i++) {
+	    gate->node[i] = lcGetString(&in);
+	    gate->netnum[i] = lcGetInt(&in);
+	    gate->direction[i] = (u_char)lcGetInt(&in);
+	    lcGet(&in, &gate->area[i], sizeof(float));
+	    gate->taps[i] = lcGetSegs(&in);
+	}
+	if (gatelast) gatelast->next = gate; else gatehead = gate;
+	gatelast = gate;
+	numgates++;
+    }
+    if (lcGetInt(&in) != LEF_CACHE_TRAILER) in.bad = TRUE;
+
+    /* A bad file leaves its partly-read records behind, unused */
+    if (in.bad) goto done;
+
+    /* Replace the LEF state.  The records it held are not	*/
+    /* freed, as anything might still point to them.		*/
+
+    LefInfo = lefhead;
+    LayerTableHead = NULL;
+    GateInfo = gatehead;
+
+    /* Most recently added macros take precedence in the table */
+    if (MacroTable.size != 0) {
+	HashKill(&MacroTable);
+	HashKill(&MacroExact);
+    }
+    gates = (GATE *)malloc((numgates + 1) * sizeof(GATE));
+    for (i = 0, gate = GateInfo; gate; gate = gate->next) gates[i++] = gate;
+    while (i-- > 0) LefHashCell(gates[i]);
+    free(gates);
+
+    /* Names of cut layers are assigned as they are parsed */
+    for (lefl = LefInfo; lefl; lefl = lefl->next)
+	if ((lefl->lefClass == CLASS_CUT) && (lefl->type >= 0) &&
+		(lefl->type < MAX_TYPES))
+	    strcpy(CIFLayer[lefl->type], lefl->lefName);
+
+    ok = TRUE;
+
+done:
+#ifdef HAVE_SYS_MMAN_H
+    munmap(data, (size_t)st.st_size);
+#else
+    free(data);
+#endif
+    return ok;
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -3686,6 +4896,9 @@ LefRead(inName)
     LefList lefl;
     DSEG grect;
     GATE gateginfo;
+    LefCacheKey cachekey;
+    u_char usecache, cached = FALSE;
+    int lines, errors, warnings;
 
     static char *sections[] = {
 	"VERSION",
@@ -3721,7 +4934,7 @@ LefRead(inName)
     else
 	strcpy(filename, inName);
 
-    f = fopen(filename, "r");
+    f = ZFileOpen(filename, "r");
 
     if (f == NULL)
     {
@@ -3735,9 +4948,27 @@ LefRead(inName)
 	Flush(stdout);
     }
 
+    /* Use the cached result of parsing this file, if there is one */
+
+    usecache = (LefCacheDir != NULL) ? lefCacheMakeKey(f, &cachekey) : FALSE;
+    if (usecache && lefCacheLoad(filename, &cachekey, &oprecis, &lines,
+		&errors, &warnings)) {
+	cached = TRUE;
+	lefCurrentLine += lines;
+	lefFatal += errors;
+	lefNonfatal += warnings;
+	if (Verbose > 0)
+	    Fprintf(stdout, "LEF read: Loaded from cache.\n");
+    }
+    else
+	LefOpenInput(f);
+    lines = lefCurrentLine;
+    errors = lefFatal;
+    warnings = lefNonfatal;
+
     oscale = 1;
 
-    while ((token = LefNextToken(f, TRUE)) != NULL)
+    while (!cached && ((token = LefNextToken(f, TRUE)) != NULL))
     {
 	keyword = Lookup(token, sections);
 	if (keyword < 0)
@@ -3894,24 +5125,28 @@ LefRead(inName)
 	}
 	if (keyword == LEF_END) break;
     }
+    if (usecache && !cached)
+	lefCacheSave(filename, &cachekey, oprecis, lefCurrentLine - lines,
+		lefFatal - errors, lefNonfatal - warnings);
+
     if (Verbose > 0) {
 	Fprintf(stdout, "LEF read: Processed %d lines.\n", lefCurrentLine);
 	LefError(LEF_ERROR, NULL);	/* print statement of errors, if any */
     }
 
     /* Cleanup */
-    if (f != NULL) fclose(f);
+    LefCloseInput(f);
+    if (f != NULL) ZFileClose(f);
 
     /* Make sure that the gate list has one entry called "pin" */
 
-    for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next)
-	if (!strcasecmp(gateginfo->gatename, "pin"))
-	    break;
+    gateginfo = lefFindCell("pin");
 
     if (!gateginfo) {
 	/* Add a new GateInfo entry for pseudo-gate "pin" */
 	gateginfo = (GATE)malloc(sizeof(struct gate_));
 	gateginfo->gatetype = NULL;
+	gateginfo->pinindex = NULL;
 	gateginfo->gatename = (char *)malloc(4);
 	strcpy(gateginfo->gatename, "pin");
 	gateginfo->width = 0.0;
@@ -3939,6 +5174,7 @@ LefRead(inName)
         gateginfo->netnum[0] = -1;
 	gateginfo->node[0] = strdup("pin");
 	GateInfo = gateginfo;
+	LefHashCell(gateginfo);
     }
     PinMacro = gateginfo;
 
@@ -4132,5 +5368,14 @@ LefRead(inName)
     /* Find the best via(s) to use per route layer and record it (them) */
     LefAssignLayerVias();
 
+    /* Record the state this read left, for the next read's cache key */
+    lefCacheValid = usecache;
+    if (usecache) {
+	lefCacheState = lefCacheHash(14695981039346656037ULL, &cachekey,
+		sizeof(LefCacheKey));
+	lefCacheInfo = LefInfo;
+	lefCacheGates = GateInfo;
+    }
+
     return oprecis;
 }
@@ -142,6 +142,7 @@ typedef struct _lefLayer {
 extern int lefCurrentLine;
 extern LefList LefInfo;
 extern LinkedStringPtr AllowedVias;
+extern char *LefCacheDir;
 
 /* Forward declarations */
 
@@ -152,6 +153,12 @@ void  LefSkipSection(FILE *f, char *match);
 void  LefEndStatement(FILE *f);
 GATE  lefFindCell(char *name);
 char *LefNextToken(FILE *f, u_char ignore_eol);
+void  LefOpenInput(FILE *f);
+void  LefCloseInput(FILE *f);
+off_t LefLineOffset(FILE *f);
+char *LefGetInputRange(FILE *f, char **endptr);
+void  LefSetInputRange(FILE *f, char *start, char *end, int *lines);
+int   LefDeferErrors(u_char defer);
 char *LefLower(char *token);
 DSEG  LefReadGeometry(GATE lefMacro, FILE *f, float oscale);
 LefList LefRedefined(LefList lefl, char *redefname);
@@ -185,10 +192,11 @@ int    LefGetRouteOrientation(int layer);
 int    LefGetMaxRouteLayer(void);
 int    LefGetMaxLayer(void);
 
-GATE   LefFindInstance(char *name);
 void   LefHashCell(GATE gateginfo);
+int    LefFindPin(GATE gateginfo, char *pinname);
 
 int    LefRead(char *inName);
+void   LefSetCacheDir(char *dir);
 void   LefAssignLayerVias();
 void   LefWriteGeneratedVias(FILE *f, double oscale, int defvias);
 
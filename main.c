@@ -7,6 +7,7 @@
 
 #include "qrouter.h"
 #include "output.h"
+#include "checkpoint.h"
 
 /*--------------------------------------------------------------*/
 /* Procedure main() performs the basic route steps without any	*/
@@ -26,12 +27,22 @@ main(int argc, char *argv[])
     if (result != 0) return result;
 
     read_def(NULL);
-    maskMode = MASK_AUTO;
-    dofirststage(0, -1);
+
+    /* A checkpoint (-L) replaces the first stage, and the second	*/
+    /* stage continues from wherever the checkpoint left off.	*/
+
+    if (ckptloadname != NULL) {
+	if (load_checkpoint(ckptloadname) != 0) return 1;
+    }
+    else {
+	maskMode = MASK_AUTO;
+	dofirststage(0, -1);
+    }
     maskMode = MASK_NONE;
     result = dosecondstage(0, FALSE, FALSE, (u_int)100);
     if (result < 5)
 	dosecondstage(0, FALSE, FALSE, (u_int)100);
+    if (ckptsavename != NULL) save_checkpoint(ckptsavename);
     write_def(NULL);
     /* write_delays() cannot work in a non-Tcl build */
     // write_delays((delayfilename == NULL) ? "stdout" : delayfilename);
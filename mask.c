@@ -24,6 +24,7 @@
 #include "node.h"
 #include "maze.h"
 #include "mask.h"
+#include "bitplane.h"
 #include "output.h"
 #include "lef.h"
 #include "def.h"
@@ -543,11 +544,15 @@ void createBboxMask(NET net, u_char halo)
 /* the neighboring positions as a function of congestion and	*/
 /* offset from the ideal location.  Return the position of the	*/
 /* best location for the trunk route.				*/
+/*								*/
+/* Each position scores one point for each of ROUTED_NET,	*/
+/* NO_NET and a pin obstruction on each layer, counted a	*/
+/* row at a time from the obstruction bitplanes.		*/
 /*--------------------------------------------------------------*/
 
 int analyzeCongestion(int ycent, int ymin, int ymax, int xmin, int xmax)
 {
-    int x, y, i, minidx = -1, sidx, n;
+    int y, i, minidx = -1, sidx;
     int *score, minscore;
 
     score = (int *)malloc((ymax - ymin + 1) * sizeof(int));
@@ -555,13 +560,10 @@ int analyzeCongestion(int ycent, int ymin, int ymax, int xmin, int xmax)
     for (y = ymin; y <= ymax; y++) {
 	sidx = y - ymin;
 	score[sidx] = ABSDIFF(ycent, y) * Num_layers;
-	for (x = xmin; x <= xmax; x++) {
-	    for (i = 0; i < Num_layers; i++) {
-		n = OBSVAL(x, y, i);
-		if (n & ROUTED_NET) score[sidx]++;
-		if (n & NO_NET) score[sidx]++;
-		if (n & PINOBSTRUCTMASK) score[sidx]++;
-	    }
+	for (i = 0; i < Num_layers; i++) {
+	    score[sidx] += count_plane_run(PLANE_ROUTED, i, y, xmin, xmax);
+	    score[sidx] += count_plane_run(PLANE_NO_NET, i, y, xmin, xmax);
+	    score[sidx] += count_plane_run(PLANE_PINOBS, i, y, xmin, xmax);
 	}
     }
     minscore = MAXRT;
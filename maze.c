@@ -13,6 +13,10 @@
 #include <math.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #define  MAZE
 
@@ -22,6 +26,7 @@
 #include "node.h"
 #include "maze.h"
 #include "lef.h"
+#include "bitplane.h"
 
 extern int TotalRoutes;
 
@@ -810,7 +815,7 @@ addcollidingnet(NETLIST *nlptr, int netnum, int x, int y, int lay)
     for (i = 0; i < Numnets; i++) {
 	fnet = Nlnets[i];
 	if (fnet->netnum == netnum) {
-	    cnl = (NETLIST)malloc(sizeof(struct netlist_));
+	    cnl = allocNETLIST();
 	    cnl->net = fnet;
 	    cnl->next = *nlptr;
 	    *nlptr = cnl;
@@ -866,7 +871,8 @@ NETLIST find_colliding(NET net, int *ripnum)
    NETLIST nl = (NETLIST)NULL, cnl;
    ROUTE rt;
    SEG seg;
-   int lay, x, y, orignet, rnum;
+   int lay, x, y, rnum;
+   obsword orignet;
 
    /* Scan the routed points for recorded collisions.	*/
 
@@ -1083,7 +1089,6 @@ void analyze_route_overwrite(int x, int y, int lay, int netnum)
 void remove_routes(ROUTE netroutes, u_char flagged)
 {
    ROUTE rt, rsave, rlast;
-   SEG seg;
 
    /* Remove all flagged routing information from this net	*/
    /* if "flagged" is true, otherwise remove all routing	*/
@@ -1100,12 +1105,7 @@ void remove_routes(ROUTE netroutes, u_char flagged)
 	    else
 		rlast->next = rsave->next;
 	    rsave = rsave->next;
-	    while (rt->segments) {
-	       seg = rt->segments->next;
-	       free(rt->segments);
-	       rt->segments = seg;
-	    }
-	    free(rt);
+	    freeROUTE(rt);
 	 }
 	 else {
 	    rlast = rsave;
@@ -1113,18 +1113,8 @@ void remove_routes(ROUTE netroutes, u_char flagged)
 	 }
       }
    }
-   else {
-      while (netroutes) {
-         rt = netroutes;
-         netroutes = rt->next;
-         while (rt->segments) {
-	    seg = rt->segments->next;
-	    free(rt->segments);
-	    rt->segments = seg;
-         }
-         free(rt);
-      }
-   }
+   else
+      freeROUTElist(netroutes);
 }
 
 /*--------------------------------------------------------------*/
@@ -1144,6 +1134,7 @@ void clear_drc_blockage(int x, int y, int lay)
 	OBSVAL(x, y, lay) |= (blockcount - 1);
     else
 	OBSVAL(x, y, lay) &= ~DRC_BLOCKAGE;
+    update_obs_planes(x, y, lay);
 }
 
 /*--------------------------------------------------------------*/
@@ -1151,7 +1142,8 @@ void clear_drc_blockage(int x, int y, int lay)
 
 void set_drc_blockage(int x, int y, int lay)
 {
-    int blockcount, obsval;
+    int blockcount;
+    obsword obsval;
 
     obsval = OBSVAL(x, y, lay);
     if ((obsval & DRC_BLOCKAGE) == DRC_BLOCKAGE) {
@@ -1163,6 +1155,7 @@ void set_drc_blockage(int x, int y, int lay)
 	OBSVAL(x, y, lay) &= ~OBSTRUCT_MASK;
 	OBSVAL(x, y, lay) |= DRC_BLOCKAGE;
     }
+    update_obs_planes(x, y, lay);
 }
 
 /*--------------------------------------------------------------*/
@@ -1185,7 +1178,8 @@ void set_drc_blockage(int x, int y, int lay)
 
 u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 {
-   int thisnet, oldnet, x, y, lay, dir;
+   int thisnet, x, y, lay;
+   obsword oldnet, dir;
    NODEINFO lnode;
    NODE node;
    ROUTE rt;
@@ -1208,7 +1202,7 @@ u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 	       if ((oldnet > 0) && (oldnet < MAXNETNUM)) {
 	          if (oldnet != thisnet) {
 		     Fprintf(stderr, "Error: position %d %d layer %d has net "
-				"%d not %d!\n", x, y, lay, oldnet, thisnet);
+				"%d not %d!\n", x, y, lay, (int)oldnet, thisnet);
 		     // Stop-gap:  Need to analyze the root of this problem.
 		     // However, a reasonable action is to try to find the
 		     // net and route associated with the incorrect net.
@@ -1235,6 +1229,7 @@ u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 		     // Clear routed mask bit
 		     OBSVAL(x, y, lay) &= ~ROUTED_NET;
 		  }
+		  update_obs_planes(x, y, lay);
 
 		  // Routes which had blockages added on the sides due
 		  // to spacing constraints have DRC_BLOCKAGE set;
@@ -1320,6 +1315,7 @@ u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 
       remove_routes(net->routes, flagged);
       net->routes = NULL;
+      net->flags &= ~NET_KEPT;	// Must be routed again
 
       // If we just ripped out a few of the routes, make sure all the
       // other net routes have not been overwritten.
@@ -1358,7 +1354,7 @@ u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 POINT eval_pt(GRIDP *ept, u_char flags, u_char stage)
 {
     int thiscost = 0;
-    int netnum;
+    obsword netnum;
     NODE node;
     NODEINFO nodeptr, lnode;
     NETLIST nl;
@@ -1612,17 +1608,18 @@ POINT eval_pt(GRIDP *ept, u_char flags, u_char stage)
 /* offset tap, then mark the tap unroutable.		*/
 /*------------------------------------------------------*/
 
-void writeback_segment(SEG seg, int netnum)
+void writeback_segment(SEG seg, obsword netnum)
 {
    double dist;
-   int  i, layer, dir;
-   u_int sobs;
+   int  i, layer;
+   obsword dir, sobs;
    NODEINFO lnode;
 
    if (seg->segtype & ST_VIA) {
       /* Preserve blocking information */
       dir = OBSVAL(seg->x1, seg->y1, seg->layer + 1) & (BLOCKED_MASK | PINOBSTRUCTMASK);
       OBSVAL(seg->x1, seg->y1, seg->layer + 1) = netnum | dir;
+      update_obs_planes(seg->x1, seg->y1, seg->layer + 1);
       if (needblock[seg->layer + 1] & VIABLOCKX) {
 	 if (seg->x1 < (NumChannelsX - 1))
  	    set_drc_blockage(seg->x1 + 1, seg->y1, seg->layer + 1);
@@ -1672,6 +1669,7 @@ void writeback_segment(SEG seg, int netnum)
    for (i = seg->x1; ; i += (seg->x2 > seg->x1) ? 1 : -1) {
       dir = OBSVAL(i, seg->y1, seg->layer) & (BLOCKED_MASK | PINOBSTRUCTMASK);
       OBSVAL(i, seg->y1, seg->layer) = netnum | dir;
+      update_obs_planes(i, seg->y1, seg->layer);
       if (needblock[seg->layer] & ROUTEBLOCKY) {
          if (seg->y1 < (NumChannelsY - 1))
 	    set_drc_blockage(i, seg->y1 + 1, seg->layer);
@@ -1719,6 +1717,7 @@ void writeback_segment(SEG seg, int netnum)
    if (seg->y1 != seg->y2) {
       dir = OBSVAL(seg->x2, seg->y2, seg->layer) & (BLOCKED_MASK | PINOBSTRUCTMASK);
       OBSVAL(seg->x2, seg->y2, seg->layer) = netnum | dir;
+      update_obs_planes(seg->x2, seg->y2, seg->layer);
       if (needblock[seg->layer] & ROUTEBLOCKY) {
          if (seg->y2 < (NumChannelsY - 1))
 	    set_drc_blockage(seg->x2, seg->y2 + 1, seg->layer);
@@ -1731,6 +1730,7 @@ void writeback_segment(SEG seg, int netnum)
    for (i = seg->y1; ; i += (seg->y2 > seg->y1) ? 1 : -1) {
       dir = OBSVAL(seg->x1, i, seg->layer) & (BLOCKED_MASK | PINOBSTRUCTMASK);
       OBSVAL(seg->x1, i, seg->layer) = netnum | dir;
+      update_obs_planes(seg->x1, i, seg->layer);
       if (needblock[seg->layer] & ROUTEBLOCKX) {
 	 if (seg->x1 < (NumChannelsX - 1))
 	    set_drc_blockage(seg->x1 + 1, i, seg->layer);
@@ -1774,6 +1774,7 @@ void writeback_segment(SEG seg, int netnum)
    if (seg->x1 != seg->x2) {
       dir = OBSVAL(seg->x2, seg->y2, seg->layer) & (BLOCKED_MASK | PINOBSTRUCTMASK);
       OBSVAL(seg->x2, seg->y2, seg->layer) = netnum | dir;
+      update_obs_planes(seg->x2, seg->y2, seg->layer);
       if (needblock[seg->layer] & ROUTEBLOCKX) {
 	 if (seg->x2 < (NumChannelsX - 1))
 	    set_drc_blockage(seg->x2 + 1, seg->y2, seg->layer);
@@ -2011,7 +2012,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
    NODEINFO lnode1, lnode2;
    int  lay2, rval;
    int  dx = -1, dy = -1, dl;
-   u_int netnum, netobs1, netobs2, dir1, dir2;
+   obsword netnum, netobs1, netobs2, dir1, dir2;
    u_char first = (u_char)1;
    u_char dmask;
    u_char pflags, p2flags;
@@ -2034,7 +2035,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
    // Generate an indexed route, recording the series of predecessors and their
    // positions.
 
-   lrtop = (POINT)malloc(sizeof(struct point_));
+   lrtop = allocPOINT();
    lrtop->x1 = ept->x;
    lrtop->y1 = ept->y;
    lrtop->layer = ept->lay;
@@ -2047,7 +2048,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
       dmask = Pr->flags & PR_PRED_DMASK;
       if (dmask == PR_PRED_NONE) break;
 
-      newlr = (POINT)malloc(sizeof(struct point_));
+      newlr = allocPOINT();
       newlr->x1 = lrend->x1;
       newlr->y1 = lrend->y1;
       newlr->layer = lrend->layer;
@@ -2270,14 +2271,14 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	       if (mincost < MAXRT) {
 	          pri = &OBS2VAL(minx, miny, cl);
 
-		  newlr = (POINT)malloc(sizeof(struct point_));
+		  newlr = allocPOINT();
 		  newlr->x1 = minx;
 		  newlr->y1 = miny;
 		  newlr->layer = cl;
 
 	          pri2 = &OBS2VAL(minx, miny, dl);
 
-		  newlr2 = (POINT)malloc(sizeof(struct point_));
+		  newlr2 = allocPOINT();
 		  newlr2->x1 = minx;
 		  newlr2->y1 = miny;
 		  newlr2->layer = dl;
@@ -2292,8 +2293,8 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 		     if (lrnext->x1 == minx && lrnext->y1 == miny &&
 				lrnext->layer == dl) {
 			newlr->next = lrnext;
-			free(lrppre);
-			free(newlr2);
+			freePOINT(lrppre);
+			freePOINT(newlr2);
 			lrppre = lrnext;	// ?
 		     }
 		     else
@@ -2408,12 +2409,12 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	          }
 
 		  if (mincost < MAXRT) {
-		     newlr = (POINT)malloc(sizeof(struct point_));
+		     newlr = allocPOINT();
 		     newlr->x1 = minx;
 		     newlr->y1 = miny;
 		     newlr->layer = cl;
 
-		     newlr2 = (POINT)malloc(sizeof(struct point_));
+		     newlr2 = allocPOINT();
 		     newlr2->x1 = minx;
 		     newlr2->y1 = miny;
 		     newlr2->layer = dl;
@@ -2431,7 +2432,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 			) {
 			lrtop = newlr;
 			lrend = newlr;
-			free(lrcur);
+			freePOINT(lrcur);
 			lrcur = newlr;
 		     }
 		     else
@@ -2445,8 +2446,8 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 		     if (lrppre->x1 == minx && lrppre->y1 == miny &&
 				lrppre->layer == dl) {
 			newlr->next = lrppre;
-			free(lrprev);
-			free(newlr2);
+			freePOINT(lrprev);
+			freePOINT(newlr2);
 			lrprev = lrcur;
 		     }
 		     else
@@ -2655,12 +2656,12 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
 	       if (mincost < MAXRT) {
 
-		  newlr = (POINT)malloc(sizeof(struct point_));
+		  newlr = allocPOINT();
 		  newlr->x1 = minx;
 		  newlr->y1 = miny;
 		  newlr->layer = cl;
 
-		  newlr2 = (POINT)malloc(sizeof(struct point_));
+		  newlr2 = allocPOINT();
 		  newlr2->x1 = cx;
 		  newlr2->y1 = cy;
 		  newlr2->layer = cl;
@@ -2718,7 +2719,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
    lseg = (SEG)NULL;
 
    while (1) {
-      seg = (SEG)malloc(sizeof(struct seg_));
+      seg = allocSEG();
       seg->next = NULL;
 
       seg->segtype = (lrcur->layer == lrprev->layer) ? ST_WIRE : ST_VIA;
@@ -2763,7 +2764,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
       if (Verbose > 3) {
          Fprintf(stdout, "commit: index = %d, net = %d\n",
-		Pr->prdata.net, netnum);
+		(int)Pr->prdata.net, (int)netnum);
 
 	 if (seg->segtype & ST_WIRE) {
             Fprintf(stdout, "commit: wire layer %d, (%d,%d) to (%d,%d)\n",
@@ -2816,6 +2817,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	    // if the path goes down instead of up (can happen on pins,
 	    // in particular)
 	    OBSVAL(seg->x1, seg->y1, lay2) |= dir2;
+	    update_obs_planes(seg->x1, seg->y1, lay2);
 	 }
       }
 
@@ -2824,6 +2826,8 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
       OBSVAL(seg->x1, seg->y1, seg->layer) |= dir1;
       OBSVAL(seg->x2, seg->y2, lay2) |= dir2;
+      update_obs_planes(seg->x1, seg->y1, seg->layer);
+      update_obs_planes(seg->x2, seg->y2, lay2);
 
       // An offset route end on the previous segment, if it is a via, needs
       // to carry over to this one, if it is a wire route.
@@ -2874,10 +2878,12 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
          if (dir2 && (stage == (u_char)0)) {
 	    OBSVAL(seg->x2, seg->y2, lay2) |= dir2;
+	    update_obs_planes(seg->x2, seg->y2, lay2);
          }
 	 else if (dir1 && (seg->segtype & ST_VIA)) {
 	    // This also applies to vias at the end of a route
 	    OBSVAL(seg->x1, seg->y1, seg->layer) |= dir1;
+	    update_obs_planes(seg->x1, seg->y1, seg->layer);
 	 }
 
 	 // Before returning, set *ept to the endpoint
@@ -2887,11 +2893,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	 ept->lay = lrend->layer;
 
 	 // Clean up allocated memory for the route. . .
-	 while (lrtop != NULL) {
-	    lrnext = lrtop->next;
-	    free(lrtop);
-	    lrtop = lrnext;
-	 }
+	 freePOINTlist(lrtop);
 	 return rval;	// Success
       }
       lseg = seg;	// Move to next segment position
@@ -2899,11 +2901,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
 cleanup:
 
-   while (lrtop != NULL) {
-      lrnext = lrtop->next;
-      free(lrtop);
-      lrtop = lrnext;
-   }
+   freePOINTlist(lrtop);
    return 0;
 
 } /* commit_proute() */
@@ -2924,7 +2922,7 @@ int writeback_route(ROUTE rt)
 {
    SEG seg;
    int  lay2;
-   u_int netnum, dir1, dir2;
+   obsword netnum, dir1, dir2;
    u_char first = (u_char)1;
 
    netnum = rt->netnum | ROUTED_NET;
@@ -2946,16 +2944,24 @@ int writeback_route(ROUTE rt)
 
       if (first) {
 	 first = (u_char)0;
-	 if (dir1)
+	 if (dir1) {
 	    OBSVAL(seg->x1, seg->y1, seg->layer) |= dir1;
-	 else if (dir2)
+	    update_obs_planes(seg->x1, seg->y1, seg->layer);
+	 }
+	 else if (dir2) {
 	    OBSVAL(seg->x2, seg->y2, lay2) |= dir2;
+	    update_obs_planes(seg->x2, seg->y2, lay2);
+	 }
       }
       else if (!seg->next) {
-	 if (dir1)
+	 if (dir1) {
 	    OBSVAL(seg->x1, seg->y1, seg->layer) |= dir1;
-	 else if (dir2)
+	    update_obs_planes(seg->x1, seg->y1, seg->layer);
+	 }
+	 else if (dir2) {
 	    OBSVAL(seg->x2, seg->y2, lay2) |= dir2;
+	    update_obs_planes(seg->x2, seg->y2, lay2);
+	 }
       }
    }
    return TRUE;
@@ -2977,4 +2983,313 @@ int writeback_all_routes(NET net)
    return result;
 }
 
+/*--------------------------------------------------------------*/
+/* Checking the routes read from a DEF file.			*/
+/*								*/
+/* Routes read from DEF are written into Obs[] as they are,	*/
+/* so a route that runs over an obstruction, over a pin of	*/
+/* another net, or into the route of another net would be	*/
+/* kept as a short.  check_def_routes() finds the nets with	*/
+/* such routes before they are written back, and removes	*/
+/* their routes so that they are routed again.			*/
+/*								*/
+/* All routes are first drawn into a map of the grid holding	*/
+/* the net that owns each position (DefOwner[]), with a mark	*/
+/* for positions claimed by more than one net.  Each net is	*/
+/* then checked against the map and against Obs[].  Both	*/
+/* steps are split between NumThreads threads, by layer and	*/
+/* by net, and the result does not depend on the order.	*/
+/*--------------------------------------------------------------*/
+
+#define DEF_OWNER_SHORT	(-1)	/* Position claimed by two nets */
+
+static int *DefOwner[MAX_LAYERS];
+static NET *DefNets;		/* Nets with routes */
+static u_char *DefBad;		/* Nets found to have bad routes */
+static int NumDefNets;
+
+#define DEFOWNER(x, y, l)  (DefOwner[l][OGRID(x, y)])
+
+/*--------------------------------------------------------------*/
+/* Draw the routes of net index k into DefOwner[] on those	*/
+/* layers l with (l % numjobs) == job.				*/
+/*--------------------------------------------------------------*/
+
+static void
+def_owner_mark(int k, int job, int numjobs)
+{
+   ROUTE rt;
+   SEG seg;
+   int x, y, lay, *op;
+
+   for (rt = DefNets[k]->routes; rt; rt = rt->next) {
+      for (seg = rt->segments; seg; seg = seg->next) {
+	 x = seg->x1;
+	 y = seg->y1;
+	 while (1) {
+	    if ((x >= 0) && (x < NumChannelsX) && (y >= 0) && (y < NumChannelsY)) {
+	       for (lay = seg->layer; lay <= seg->layer +
+			((seg->segtype & ST_VIA) ? 1 : 0); lay++) {
+		  if ((lay < 0) || (lay >= Num_layers)) continue;
+		  if ((lay % numjobs) != job) continue;
+		  op = &DEFOWNER(x, y, lay);
+		  if (*op == 0)
+		     *op = k + 1;
+		  else if (*op != k + 1)
+		     *op = DEF_OWNER_SHORT;
+	       }
+	    }
+	    if ((x == seg->x2) && (y == seg->y2)) break;
+	    if (x != seg->x2) x += (seg->x2 > x) ? 1 : -1;
+	    else y += (seg->y2 > y) ? 1 : -1;
+	 }
+      }
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* Return TRUE if the route position (x, y, lay) of net index	*/
+/* k lies over a neighbor (x + dx, y + dy) that another net's	*/
+/* route occupies, in a direction that writeback_segment()	*/
+/* would block for spacing ("mask" set in needblock[]).	*/
+/*--------------------------------------------------------------*/
+
+static u_char
+def_owner_spacing(int k, int x, int y, int lay, u_char mask)
+{
+   int nx, ny, d, owner;
+
+   if (!(needblock[lay] & mask)) return FALSE;
+   for (d = 0; d < 4; d++) {
+      nx = x + ((d == 0) ? 1 : (d == 1) ? -1 : 0);
+      ny = y + ((d == 2) ? 1 : (d == 3) ? -1 : 0);
+      if ((d < 2) && !(needblock[lay] & mask & (ROUTEBLOCKX | VIABLOCKX)))
+	 continue;
+      if ((d >= 2) && !(needblock[lay] & mask & (ROUTEBLOCKY | VIABLOCKY)))
+	 continue;
+      if ((nx < 0) || (nx >= NumChannelsX) || (ny < 0) || (ny >= NumChannelsY))
+	 continue;
+      owner = DEFOWNER(nx, ny, lay);
+      if ((owner == 0) || (owner == k + 1)) continue;
+
+      // As in set_drc_blockage(), only a free position would be
+      // blocked;  a route next to another net's pin is allowed.
+      if ((OBSVAL(nx, ny, lay) & NETNUM_MASK) == 0) return TRUE;
+   }
+   return FALSE;
+}
+
+/*--------------------------------------------------------------*/
+/* Return TRUE if the routes of net index k are good:  on the	*/
+/* grid, not shared with another net, not on an obstruction	*/
+/* or pin that belongs to another net, and not in a position	*/
+/* next to another net's route that spacing rules forbid.	*/
+/*--------------------------------------------------------------*/
+
+static u_char
+def_routes_good(int k)
+{
+   NET net = DefNets[k];
+   ROUTE rt;
+   SEG seg;
+   NODEINFO lnode;
+   obsword obsval, netnum;
+   int x, y, lay, first;
+   u_char mask;
+
+   for (rt = net->routes; rt; rt = rt->next) {
+      first = TRUE;
+      for (seg = rt->segments; seg; seg = seg->next) {
+	 x = seg->x1;
+	 y = seg->y1;
+	 while (1) {
+	    for (lay = seg->layer; lay <= seg->layer +
+			((seg->segtype & ST_VIA) ? 1 : 0); lay++) {
+	       if ((x < 0) || (x >= NumChannelsX) || (y < 0) ||
+			(y >= NumChannelsY) || (lay < 0) || (lay >= Num_layers))
+		  return FALSE;
+
+	       // Ends of routes flagged RT_CHECK may overshoot the
+	       // pin by a position (see route_set_connections()).
+
+	       if ((rt->flags & RT_CHECK) && (first || ((seg->next == NULL) &&
+			(x == seg->x2) && (y == seg->y2))))
+		  continue;
+
+	       if (DEFOWNER(x, y, lay) == DEF_OWNER_SHORT) return FALSE;
+
+	       obsval = OBSVAL(x, y, lay);
+	       if (obsval & NO_NET) {
+		  // Routes may cross obstructions to reach their own pins
+		  if (lay >= Pinlayers) return FALSE;
+		  lnode = NODEIPTR(x, y, lay);
+		  if ((lnode == NULL) || (lnode->nodesav == NULL) ||
+			(lnode->nodesav->netnum != net->netnum))
+		     return FALSE;
+	       }
+	       else {
+		  netnum = obsval & NETNUM_MASK;
+		  if ((netnum != 0) && (netnum != (obsword)net->netnum))
+		     return FALSE;
+	       }
+
+	       if ((seg->segtype & ST_VIA) && (lay > seg->layer))
+		  mask = VIABLOCKX | VIABLOCKY;
+	       else
+		  mask = ROUTEBLOCKX | ROUTEBLOCKY;
+	       if (def_owner_spacing(k, x, y, lay, mask)) return FALSE;
+	    }
+	    first = FALSE;
+	    if ((x == seg->x2) && (y == seg->y2)) break;
+	    if (x != seg->x2) x += (seg->x2 > x) ? 1 : -1;
+	    else y += (seg->y2 > y) ? 1 : -1;
+	 }
+      }
+   }
+   return TRUE;
+}
+
+#ifdef HAVE_LIBPTHREAD
+
+typedef struct defcheckjob_ {
+   pthread_t thread;
+   int job, numjobs;
+} DefCheckJob;
+
+static void *
+def_mark_worker(void *arg)
+{
+   DefCheckJob *dj = (DefCheckJob *)arg;
+   int k;
+
+   for (k = 0; k < NumDefNets; k++)
+      def_owner_mark(k, dj->job, dj->numjobs);
+   return NULL;
+}
+
+static void *
+def_check_worker(void *arg)
+{
+   DefCheckJob *dj = (DefCheckJob *)arg;
+   int k;
+
+   for (k = dj->job; k < NumDefNets; k += dj->numjobs)
+      DefBad[k] = def_routes_good(k) ? FALSE : TRUE;
+   return NULL;
+}
+
+/* Run "proc" on "numjobs" threads, one of them this one */
+
+static void
+def_check_run(void *(*proc)(void *), int numjobs)
+{
+   DefCheckJob *jobs;
+   int c;
+
+   jobs = (DefCheckJob *)calloc(numjobs, sizeof(DefCheckJob));
+   for (c = 0; c < numjobs; c++) {
+      jobs[c].job = c;
+      jobs[c].numjobs = numjobs;
+   }
+   for (c = 1; c < numjobs; c++)
+      if (pthread_create(&jobs[c].thread, NULL, proc, (void *)&jobs[c]) != 0)
+	 break;
+   numjobs = c;
+
+   // Any jobs that could not be started are run here.
+   for (c = 0; c < jobs[0].numjobs; c++)
+      if ((c == 0) || (c >= numjobs)) (*proc)((void *)&jobs[c]);
+   for (c = 1; c < numjobs; c++)
+      pthread_join(jobs[c].thread, NULL);
+   free(jobs);
+}
+
+#endif /* HAVE_LIBPTHREAD */
+
+/*--------------------------------------------------------------*/
+/* check_def_routes() ---					*/
+/*								*/
+/* Check the routes of all nets that were read from the DEF	*/
+/* file, before they are connected and written back, and	*/
+/* remove all of the routes of any net that has a bad one, so	*/
+/* that it will be routed again.  Fixed and cover nets		*/
+/* (NET_IGNORED) are only reported, since they are not routed	*/
+/* again.							*/
+/*								*/
+/* Returns the number of nets whose routes were removed.	*/
+/*--------------------------------------------------------------*/
+
+int
+check_def_routes(void)
+{
+   NET net;
+   int i, k, numbad, numjobs;
+
+   DefNets = (NET *)malloc((Numnets + 1) * sizeof(NET));
+   NumDefNets = 0;
+   for (i = 0; i < Numnets; i++) {
+      net = Nlnets[i];
+      if ((net->routes != NULL) && (net->numnodes > 0))
+	 DefNets[NumDefNets++] = net;
+   }
+   if (NumDefNets == 0) {
+      free(DefNets);
+      return 0;
+   }
+
+   for (i = 0; i < Num_layers; i++)
+      DefOwner[i] = (int *)calloc(NumChannelsX * NumChannelsY, sizeof(int));
+   DefBad = (u_char *)calloc(NumDefNets, sizeof(u_char));
+
+   numjobs = (NumThreads > 1) ? NumThreads : 1;
+#ifdef HAVE_LIBPTHREAD
+   if (numjobs > 1) {
+      def_check_run(def_mark_worker, MIN(numjobs, Num_layers));
+      def_check_run(def_check_worker, MIN(numjobs, NumDefNets));
+   }
+   else
+#endif
+   {
+      for (k = 0; k < NumDefNets; k++) def_owner_mark(k, 0, 1);
+      for (k = 0; k < NumDefNets; k++)
+	 DefBad[k] = def_routes_good(k) ? FALSE : TRUE;
+   }
+
+   numbad = 0;
+   for (k = 0; k < NumDefNets; k++) {
+      if (!DefBad[k]) continue;
+      net = DefNets[k];
+
+      // Fixed and cover nets are never routed again, and their
+      // wiring is copied to the output as it is, so they are kept
+      // in place as obstructions.  Any other net sharing their
+      // wiring is found bad and rerouted around them.
+
+      if (net->flags & NET_IGNORED) {
+	 Fprintf(stderr, "Fixed route of net %s from DEF is blocked or "
+		"shorted;  keeping it as it is.\n", net->netname);
+	 continue;
+      }
+      if (Verbose > 0)
+	 Fprintf(stdout, "Route of net %s from DEF is blocked or shorted;"
+		" net will be rerouted.\n", net->netname);
+      remove_routes(net->routes, FALSE);
+      net->routes = NULL;
+      numbad++;
+   }
+   if ((numbad > 0) || (Verbose > 1))
+      Fprintf(stdout, "Checked routes of %d nets from DEF;  removed routes"
+		" of %d nets.\n", NumDefNets, numbad);
+
+   for (i = 0; i < Num_layers; i++) {
+      free(DefOwner[i]);
+      DefOwner[i] = NULL;
+   }
+   free(DefBad);
+   free(DefNets);
+   DefBad = NULL;
+   DefNets = NULL;
+   return numbad;
+}
+
 /* end of maze.c */
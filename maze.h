@@ -18,7 +18,7 @@ void	remove_routes(ROUTE netroutes, u_char flagged);
 u_char  ripup_net(NET net, u_char restore, u_char topmost, u_char retain);
 POINT   eval_pt(GRIDP *ept, u_char flags, u_char stage);
 int     commit_proute(ROUTE rt, GRIDP *ept, u_char stage);
-void	writeback_segment(SEG seg, int netnum);
+void	writeback_segment(SEG seg, obsword netnum);
 int     writeback_route(ROUTE rt);
 int     writeback_all_routes(NET net);
 NETLIST find_colliding(NET net, int *ripnum);
@@ -28,6 +28,7 @@ int     count_targets(NET net);
 int	set_route_to_net(NET net, ROUTE rt, int newflags, POINT *pushlist,
 		SEG bbox, u_char stage);
 void    route_set_connections(NET net, ROUTE route);
+int     check_def_routes(void);
 
 
 #define MAZE_H
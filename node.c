@@ -13,13 +13,31 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include "qrouter.h"
+#include "point.h"
 #include "node.h"
 #include "qconfig.h"
 #include "lef.h"
 #include "def.h"
 #include "output.h"
+#include "bitplane.h"
+#include "hash.h"
+
+/* Nodeinfo records may be made and freed by gate passes	*/
+/* running on worker threads (see run_gate_pass()).		*/
+
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t NodeinfoLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_NODEINFO()		pthread_mutex_lock(&NodeinfoLock)
+#define UNLOCK_NODEINFO()	pthread_mutex_unlock(&NodeinfoLock)
+#else
+#define LOCK_NODEINFO()
+#define UNLOCK_NODEINFO()
+#endif
 
 /*--------------------------------------------------------------*/
 /* SetNodeinfo --						*/
@@ -36,7 +54,9 @@ SetNodeinfo(int gridx, int gridy, int layer, NODE node)
 
     lnodeptr = &NODEIPTR(gridx, gridy, layer);
     if (*lnodeptr == NULL) {
-	*lnodeptr = (NODEINFO)calloc(1, sizeof(struct nodeinfo_));
+	LOCK_NODEINFO();
+	*lnodeptr = allocNODEINFO();
+	memset(*lnodeptr, 0, sizeof(struct nodeinfo_));
 
 	/* Make sure this position is in the list of node's taps.  Add	*/
 	/* it if it is not there.					*/
@@ -49,7 +69,7 @@ SetNodeinfo(int gridx, int gridy, int layer, NODE node)
 		if (dp->gridx == gridx && dp->gridy == gridy && dp->layer == layer)
 		    break;
 	if (dp == NULL) {
-	    dp = (DPOINT)malloc(sizeof(struct dpoint_));
+	    dp = allocDPOINT();
 	    dp->gridx = gridx;
 	    dp->gridy = gridy;
 	    dp->layer = layer;
@@ -58,6 +78,7 @@ SetNodeinfo(int gridx, int gridy, int layer, NODE node)
 	    dp->next = node->extend;
 	    node->extend = dp;
 	}
+	UNLOCK_NODEINFO();
     }
     return *lnodeptr;
 }
@@ -76,7 +97,9 @@ FreeNodeinfo(int gridx, int gridy, int layer)
     lnodeptr = &NODEIPTR(gridx, gridy, layer);
 
     if (*lnodeptr != NULL) {
-        free(*lnodeptr);
+	LOCK_NODEINFO();
+        freeNODEINFO(*lnodeptr);
+	UNLOCK_NODEINFO();
 	*lnodeptr = NULL;
     }
 }
@@ -104,357 +127,515 @@ FreeNodeinfo(int gridx, int gridy, int layer)
 /*  only be used if obstructions are drawn in the style where	*/
 /*  they can abut pins (e.g., part of the pin has been marked	*/
 /*  as an obstruction).						*/
+/*								*/
+/*  The count is a scan of the grid.  The search for taps is	*/
+/*  done gate by gate with run_gate_list(), on worker threads	*/
+/*  unless it is reporting each tap it forces routable.		*/
 /*--------------------------------------------------------------*/
 
-void
-count_reachable_taps(u_char unblock_all)
+typedef void (*GatePassProc)(GATE);
+
+static double gate_pass_halo(void);
+static u_char gate_pass_area(GATE, double, int *, int *, int *, int *);
+static void run_gate_list(GatePassProc, GATE *, int, int);
+
+static u_char ReachUnblockAll;	/* "unblock_all" for reachable_taps_gate() */
+
+/*--------------------------------------------------------------*/
+/* reachable_taps_gate()					*/
+/*								*/
+/*  Make taps routable for each node of gate g that has none,	*/
+/*  or for every node if ReachUnblockAll is set.		*/
+/*--------------------------------------------------------------*/
+
+static void
+reachable_taps_gate(GATE g)
 {
     NODE node;
     NODEINFO lnode;
-    GATE g;
     DSEG ds;
-    int l, i, j, orient;
+    int i, orient;
     int gridx, gridy;
     double deltax, deltay;
     double dx, dy;
 
-    for (l = 0; l < Num_layers; l++) {
-	for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
-	    if (Nodeinfo[l][j]) {
-		node = Nodeinfo[l][j]->nodeloc;
-		if (node != NULL) {
-
-		    // Redundant check;  if Obs has NO_NET set, then
-		    // Nodeinfo->nodeloc for that position should already
-		    // be NULL
+    for (i = 0; i < g->nodes; i++) {
+	node = g->noderec[i];
+	if (node == NULL) continue;
+	if (node->numnodes == 0) continue;	 // e.g., vdd or gnd bus
+	if ((node->numtaps == 0) || (ReachUnblockAll == TRUE)) {
+
+	    /* Will try more than one via if available */
+	    for (orient = 0; orient < 4; orient += 2) {
+		for (ds = g->taps[i]; ds; ds = ds->next) {
+		    // Layers above the pin layers have no Nodeinfo once
+		    // count_pinlayers() has run (see update_reachable_taps())
+		    if (Nodeinfo[ds->layer] == NULL) continue;
+
+		    deltax = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 0, orient);
+		    deltay = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 1, orient);
+
+		    gridx = (int)((ds->x1 - Xlowerbound) / PitchX) - 1;
+		    if (gridx < 0) gridx = 0;
+		    while (1) {
+			dx = (gridx * PitchX) + Xlowerbound;
+			if (dx > ds->x2 || gridx >= NumChannelsX) break;
+
+			if (((dx - ds->x1 + EPS) > deltax) &&
+				    ((ds->x2 - dx + EPS) > deltax)) {
+			    gridy = (int)((ds->y1 - Ylowerbound)
+				    / PitchY) - 1;
+			    if (gridy < 0) gridy = 0;
+			    while (1) {
+				dy = (gridy * PitchY) + Ylowerbound;
+				if (dy > ds->y2 || gridy >= NumChannelsY)
+				    break;
 
-		    if (!(Obs[l][j] & NO_NET))
-			node->numtaps++;
-		}
-	    }
-	}
-    }
+				if (((dy - ds->y1 + EPS) > deltay) &&
+					    ((ds->y2 - dy + EPS) > deltay) &&
+					    !(OBSVAL(gridx, gridy, ds->layer)
+					    & ROUTED_NET)) {
+
+				    if ((ds->layer == Num_layers - 1) ||
+					    !(OBSVAL(gridx, gridy, ds->layer + 1)
+					    & NO_NET)) {
+
+					// Grid position is clear for placing a via
+
+					if ((orient == 0) && (Verbose > 1))
+					    Fprintf(stdout, "Tap position (%g, %g)"
+						" appears to be technically routable"
+						" so it is being forced routable.\n",
+						dx, dy);
+					else if (Verbose > 1)
+					    Fprintf(stdout, "Tap position (%g, %g)"
+						" appears to be technically routable"
+						" with alternate via, so it is being"
+						" forced routable.\n", dx, dy);
+
+					OBSVAL(gridx, gridy, ds->layer) =
+					    (OBSVAL(gridx, gridy, ds->layer)
+					    & BLOCKED_MASK)
+					    | (u_int)node->netnum;
+					lnode = SetNodeinfo(gridx, gridy, ds->layer,
+						    node);
+					lnode->nodeloc = node;
+					lnode->nodesav = node;
 
-    for (g = Nlgates; g; g = g->next) {
-	for (i = 0; i < g->nodes; i++) {
-	    node = g->noderec[i];
-	    if (node == NULL) continue;
-	    if (node->numnodes == 0) continue;	 // e.g., vdd or gnd bus
-	    if ((node->numtaps == 0) || (unblock_all == TRUE)) {
-
-		/* Will try more than one via if available */
-		for (orient = 0; orient < 4; orient += 2) {
-		    for (ds = g->taps[i]; ds; ds = ds->next) {
-			deltax = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 0, orient);
-			deltay = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 1, orient);
-
-			gridx = (int)((ds->x1 - Xlowerbound) / PitchX) - 1;
-			if (gridx < 0) gridx = 0;
-			while (1) {
-			    dx = (gridx * PitchX) + Xlowerbound;
-			    if (dx > ds->x2 || gridx >= NumChannelsX) break;
-
-			    if (((dx - ds->x1 + EPS) > deltax) &&
-					((ds->x2 - dx + EPS) > deltax)) {
-				gridy = (int)((ds->y1 - Ylowerbound)
-					/ PitchY) - 1;
-				if (gridy < 0) gridy = 0;
-				while (1) {
-				    dy = (gridy * PitchY) + Ylowerbound;
-				    if (dy > ds->y2 || gridy >= NumChannelsY)
-					break;
-
-				    if (((dy - ds->y1 + EPS) > deltay) &&
-						((ds->y2 - dy + EPS) > deltay)) {
-
-					if ((ds->layer == Num_layers - 1) ||
-						!(OBSVAL(gridx, gridy, ds->layer + 1)
-						& NO_NET)) {
-
-					    // Grid position is clear for placing a via
-
-					    if ((orient == 0) && (Verbose > 1))
-						Fprintf(stdout, "Tap position (%g, %g)"
-						    " appears to be technically routable"
-						    " so it is being forced routable.\n",
-						    dx, dy);
-					    else if (Verbose > 1)
-						Fprintf(stdout, "Tap position (%g, %g)"
-						    " appears to be technically routable"
-						    " with alternate via, so it is being"
-						    " forced routable.\n", dx, dy);
-
-					    OBSVAL(gridx, gridy, ds->layer) =
-						(OBSVAL(gridx, gridy, ds->layer)
-						& BLOCKED_MASK)
-						| (u_int)node->netnum;
-					    lnode = SetNodeinfo(gridx, gridy, ds->layer,
-							node);
-					    lnode->nodeloc = node;
-					    lnode->nodesav = node;
-
-					    /* If we got to orient = 2, mark NI_NO_VIAX */
-					    if (orient == 2) lnode->flags |= NI_NO_VIAX;
-					    /* This is a bit harsh, but should work */
-					    else lnode->flags |= NI_NO_VIAY;
-					    node->numtaps++;
-					}
+					/* If we got to orient = 2, mark NI_NO_VIAX */
+					if (orient == 2) lnode->flags |= NI_NO_VIAX;
+					/* This is a bit harsh, but should work */
+					else lnode->flags |= NI_NO_VIAY;
+					node->numtaps++;
 				    }
-				    gridy++;
 				}
+				gridy++;
 			    }
-			    gridx++;
 			}
+			gridx++;
 		    }
-		    /* If there's a solution, don't go looking at other vias */
-		    if (node->numtaps > 0) break;
 		}
+		/* If there's a solution, don't go looking at other vias */
+		if (node->numtaps > 0) break;
 	    }
-	    if (node->numtaps == 0) {
-		/* Node wasn't cleanly within tap geometry when centered */
-		/* on a grid point.  But if the via can be offset and is */
-		/* cleanly within the tap geometry, then allow it.	 */
-
-		double dist, mindist;
-		int dir, mask, tapx, tapy, tapl;
-
-		/* Will try more than one via if available */
-		for (orient = 0; orient < 4; orient += 2) {
-
-		    /* Initialize mindist to a large value */
-		    mask = 0;
-		    mindist = PitchX + PitchY;
-		    dir = 0;	/* Indicates no solution found */
+	}
+	if (node->numtaps == 0) {
+	    /* Node wasn't cleanly within tap geometry when centered */
+	    /* on a grid point.  But if the via can be offset and is */
+	    /* cleanly within the tap geometry, then allow it.	 */
+
+	    double dist, mindist;
+	    int dir, tapx, tapy, tapl;
+	    obsword mask;
+
+	    /* Will try more than one via if available */
+	    for (orient = 0; orient < 4; orient += 2) {
+
+		/* Initialize mindist to a large value */
+		mask = 0;
+		mindist = PitchX + PitchY;
+		dir = 0;	/* Indicates no solution found */
+
+		for (ds = g->taps[i]; ds; ds = ds->next) {
+		    if (Nodeinfo[ds->layer] == NULL) continue;
+
+		    deltax = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 0, orient);
+		    deltay = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 1, orient);
+
+		    gridx = (int)((ds->x1 - Xlowerbound) / PitchX) - 1;
+		    if (gridx < 0) gridx = 0;
+		    while (1) {
+			dx = (gridx * PitchX) + Xlowerbound;
+			if (dx > ds->x2 || gridx >= NumChannelsX) break;
+
+			if (((dx - ds->x1 + EPS) > -deltax) &&
+				    ((ds->x2 - dx + EPS) > -deltax)) {
+			    gridy = (int)((ds->y1 - Ylowerbound) / PitchY) - 1;
+			    if (gridy < 0) gridy = 0;
 
-		    for (ds = g->taps[i]; ds; ds = ds->next) {
-			deltax = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 0, orient);
-			deltay = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 1, orient);
+			    while (1) {
+				dy = (gridy * PitchY) + Ylowerbound;
+				if (dy > ds->y2 || gridy >= NumChannelsY)
+				    break;
 
-			gridx = (int)((ds->x1 - Xlowerbound) / PitchX) - 1;
-			if (gridx < 0) gridx = 0;
-			while (1) {
-			    dx = (gridx * PitchX) + Xlowerbound;
-			    if (dx > ds->x2 || gridx >= NumChannelsX) break;
-
-			    if (((dx - ds->x1 + EPS) > -deltax) &&
-					((ds->x2 - dx + EPS) > -deltax)) {
-				gridy = (int)((ds->y1 - Ylowerbound) / PitchY) - 1;
-				if (gridy < 0) gridy = 0;
-
-				while (1) {
-				    dy = (gridy * PitchY) + Ylowerbound;
-				    if (dy > ds->y2 || gridy >= NumChannelsY)
-					break;
-
-				    // Check that the grid position is inside the
-				    // tap rectangle.
-
-				    // NOTE: If the point above the grid is blocked,
-				    // then a via cannot be placed here, so skip it.
-				    // This currently looks only for completely
-				    // obstructed positions.  To do:  For directionally
-				    // obstructed positions, see if the obstruction
-				    // is in the opposite direction of the via's
-				    // offset and at least the same distance.
-				    // Otherwise, it won't clear.
-
-				    if (((ds->layer == Num_layers - 1) ||
-						!(OBSVAL(gridx, gridy, ds->layer + 1)
-						& (NO_NET || OBSTRUCT_MASK))) &&
-						((dy - ds->y1 + EPS) > -deltay) &&
-						((ds->y2 - dy + EPS) > -deltay)) {
-
-					// Grid point is inside tap geometry.
-					// Since it did not pass the simple insideness
-					// test previously, it can be assumed that
-					// one of the edges is closer to the grid point
-					// than 1/2 via width.  Find that edge and use
-					// it to determine the offset.
-
-					// Check right edge
-					if ((ds->x2 - dx + EPS) < deltax) {
-					    dist = deltax - ds->x2 + dx;
-					    // Confirm other edges
-					    if ((dx - dist - deltax + EPS > ds->x1) &&
-							(dy - deltay + EPS > ds->y1) &&
-							(dy + deltay - EPS < ds->y2)) {
-						if (dist < fabs(mindist)) {
-						    mindist = dist;
-						    mask = STUBROUTE;
-						    dir = NI_STUB_EW;
-						    tapx = gridx;
-						    tapy = gridy;
-						    tapl = ds->layer;
-						}
+				// Check that the grid position is inside the
+				// tap rectangle.
+
+				// NOTE: If the point above the grid is blocked,
+				// then a via cannot be placed here, so skip it.
+				// This currently looks only for completely
+				// obstructed positions.  To do:  For directionally
+				// obstructed positions, see if the obstruction
+				// is in the opposite direction of the via's
+				// offset and at least the same distance.
+				// Otherwise, it won't clear.
+
+				if (((ds->layer == Num_layers - 1) ||
+					    !(OBSVAL(gridx, gridy, ds->layer + 1)
+					    & (NO_NET || OBSTRUCT_MASK))) &&
+					    !(OBSVAL(gridx, gridy, ds->layer)
+					    & ROUTED_NET) &&
+					    ((dy - ds->y1 + EPS) > -deltay) &&
+					    ((ds->y2 - dy + EPS) > -deltay)) {
+
+				    // Grid point is inside tap geometry.
+				    // Since it did not pass the simple insideness
+				    // test previously, it can be assumed that
+				    // one of the edges is closer to the grid point
+				    // than 1/2 via width.  Find that edge and use
+				    // it to determine the offset.
+
+				    // Check right edge
+				    if ((ds->x2 - dx + EPS) < deltax) {
+					dist = deltax - ds->x2 + dx;
+					// Confirm other edges
+					if ((dx - dist - deltax + EPS > ds->x1) &&
+						    (dy - deltay + EPS > ds->y1) &&
+						    (dy + deltay - EPS < ds->y2)) {
+					    if (dist < fabs(mindist)) {
+						mindist = dist;
+						mask = STUBROUTE;
+						dir = NI_STUB_EW;
+						tapx = gridx;
+						tapy = gridy;
+						tapl = ds->layer;
 					    }
 					}
-					// Check left edge
-					if ((dx - ds->x1 + EPS) < deltax) {
-					    dist = deltax - dx + ds->x1;
-					    // Confirm other edges
-					    if ((dx + dist + deltax - EPS < ds->x2) &&
-							(dy - deltay + EPS > ds->y1) &&
-							(dy + deltay - EPS < ds->y2)) {
-						if (dist < fabs(mindist)) {
-						    mindist = -dist;
-						    mask = STUBROUTE;
-						    dir = NI_STUB_EW;
-						    tapx = gridx;
-						    tapy = gridy;
-						    tapl = ds->layer;
-						}
+				    }
+				    // Check left edge
+				    if ((dx - ds->x1 + EPS) < deltax) {
+					dist = deltax - dx + ds->x1;
+					// Confirm other edges
+					if ((dx + dist + deltax - EPS < ds->x2) &&
+						    (dy - deltay + EPS > ds->y1) &&
+						    (dy + deltay - EPS < ds->y2)) {
+					    if (dist < fabs(mindist)) {
+						mindist = -dist;
+						mask = STUBROUTE;
+						dir = NI_STUB_EW;
+						tapx = gridx;
+						tapy = gridy;
+						tapl = ds->layer;
 					    }
 					}
-					// Check top edge
-					if ((ds->y2 - dy + EPS) < deltay) {
-					    dist = deltay - ds->y2 + dy;
-					    // Confirm other edges
-					    if ((dx - deltax + EPS > ds->x1) &&
-						    (dx + deltax - EPS < ds->x2) &&
-						    (dy - dist - deltay + EPS > ds->y1)) {
-						if (dist < fabs(mindist)) {
-						    mindist = -dist;
-						    mask = STUBROUTE;
-						    dir = NI_STUB_NS;
-						    tapx = gridx;
-						    tapy = gridy;
-						    tapl = ds->layer;
-						}
+				    }
+				    // Check top edge
+				    if ((ds->y2 - dy + EPS) < deltay) {
+					dist = deltay - ds->y2 + dy;
+					// Confirm other edges
+					if ((dx - deltax + EPS > ds->x1) &&
+						(dx + deltax - EPS < ds->x2) &&
+						(dy - dist - deltay + EPS > ds->y1)) {
+					    if (dist < fabs(mindist)) {
+						mindist = -dist;
+						mask = STUBROUTE;
+						dir = NI_STUB_NS;
+						tapx = gridx;
+						tapy = gridy;
+						tapl = ds->layer;
 					    }
 					}
-					// Check bottom edge
-					if ((dy - ds->y1 + EPS) < deltay) {
-					    dist = deltay - dy + ds->y1;
-					    // Confirm other edges
-					    if ((dx - deltax + EPS > ds->x1) &&
-						    (dx + deltax - EPS < ds->x2) &&
-						    (dy + dist + deltay - EPS < ds->y2)) {
-						if (dist < fabs(mindist)) {
-					 	    mindist = dist;
-						    mask = STUBROUTE;
-						    dir = NI_STUB_NS;
-						    tapx = gridx;
-						    tapy = gridy;
-						    tapl = ds->layer;
-						}
+				    }
+				    // Check bottom edge
+				    if ((dy - ds->y1 + EPS) < deltay) {
+					dist = deltay - dy + ds->y1;
+					// Confirm other edges
+					if ((dx - deltax + EPS > ds->x1) &&
+						(dx + deltax - EPS < ds->x2) &&
+						(dy + dist + deltay - EPS < ds->y2)) {
+					    if (dist < fabs(mindist)) {
+						mindist = dist;
+						mask = STUBROUTE;
+						dir = NI_STUB_NS;
+						tapx = gridx;
+						tapy = gridy;
+						tapl = ds->layer;
 					    }
 					}
 				    }
-				    gridy++;
 				}
+				gridy++;
 			    }
-			    gridx++;
 			}
+			gridx++;
 		    }
+		}
+
+		/* Was a solution found? */
+		if (mask != 0) {
+		    // Grid position is clear for placing a via
+
+		    if (Verbose > 1)
+			Fprintf(stdout, "Tap position (%d, %d) appears to be"
+				    " technically routable with an offset, so"
+				    " it is being forced routable.\n",
+				    tapx, tapy);
+
+		    OBSVAL(tapx, tapy, tapl) =
+			    (OBSVAL(tapx, tapy, tapl) & BLOCKED_MASK)
+			    | mask | (u_int)node->netnum;
+		    lnode = SetNodeinfo(tapx, tapy, tapl, node);
+		    lnode->nodeloc = node;
+		    lnode->nodesav = node;
+		    lnode->stub = dist;
+		    lnode->flags |= dir;
+
+		    /* If we got to orient = 2 then mark NI_NO_VIAX */
+		    if (orient == 2) lnode->flags |= NI_NO_VIAX;
+
+		    node->numtaps++;
+		}
 
-		    /* Was a solution found? */
-		    if (mask != 0) {
-			// Grid position is clear for placing a via
+		/* If there's a solution, don't go looking at other vias */
+		if (node->numtaps > 0) break;
+	    }
+	}
+    }
+}
 
-			if (Verbose > 1)
-			    Fprintf(stdout, "Tap position (%d, %d) appears to be"
-					" technically routable with an offset, so"
-					" it is being forced routable.\n",
-					tapx, tapy);
+/*--------------------------------------------------------------*/
+/* report_unreachable_taps()					*/
+/*								*/
+/*  Output error messages for any nodes of gate g that were	*/
+/*  not handled by reachable_taps_gate().			*/
+/*--------------------------------------------------------------*/
 
-			OBSVAL(tapx, tapy, tapl) =
-				(OBSVAL(tapx, tapy, tapl) & BLOCKED_MASK)
-				| mask | (u_int)node->netnum;
-			lnode = SetNodeinfo(tapx, tapy, tapl, node);
-			lnode->nodeloc = node;
-			lnode->nodesav = node;
-			lnode->stub = dist;
-			lnode->flags |= dir;
+static void
+report_unreachable_taps(GATE g)
+{
+    NODE node;
+    DSEG ds;
+    int i, gridx, gridy;
+    double deltax, deltay;
+    double dx, dy;
 
-			/* If we got to orient = 2 then mark NI_NO_VIAX */
-			if (orient == 2) lnode->flags |= NI_NO_VIAX;
+    for (i = 0; i < g->nodes; i++) {
+	node = g->noderec[i];
+	if (node == NULL) continue;
+	if (node->numnodes == 0) continue;	 // e.g., vdd or gnd bus
+	if (node->numtaps == 0) {
+	    Fprintf(stderr, "Error: Node %s of net \"%s\" has no taps!\n",
+		    print_node_name(node), node->netname);
+	    Fprintf(stderr, "Qrouter will not be able to completely"
+		    " route this net.\n");
+	    if (Verbose > 1) {
+		int found_inside, found_inrange;
+		Fprintf(stderr, "Tap position blockage analysis:\n");
+
+		/* Unreachable taps are the most common problem with    */
+		/* new processes or buggy code, so make a detailed	    */
+		/* report of blockages affecting routing for debugging. */
+
+		found_inside = found_inrange = 0;
+		for (ds = g->taps[i]; ds; ds = ds->next) {
+		    unsigned char is_inside, is_inrange;
+
+		    deltax = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 0, 0);
+		    deltay = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 1, 0);
+
+		    Fprintf(stderr, "Tap geometry (%g %g) to (%g %g):\n",
+			    ds->x1, ds->y1, ds->x2, ds->y2);
 
-			node->numtaps++;
+		    gridx = (int)(((ds->x1 - 1) - Xlowerbound) / PitchX) - 1;
+		    if (gridx < 0) gridx = 0;
+		    while (1) {
+			dx = (gridx * PitchX) + Xlowerbound;
+			if (dx > (ds->x2 + 1) || gridx >= NumChannelsX) break;
+			gridy = (int)(((ds->y1 - 1) - Ylowerbound) / PitchY) - 1;
+			if (gridy < 0) gridy = 0;
+			while (1) {
+			    dy = (gridy * PitchY) + Ylowerbound;
+			    if (dy > (ds->y2 + 1) || gridy >= NumChannelsY)
+				break;
+
+			    is_inside = (dx >= ds->x1 && dx <= ds->x2 &&
+					 dy >= ds->y1 && dy <= ds->y2) ? 1 : 0;
+
+			    is_inrange = (dx > ds->x1 - deltax &&
+					 dx < ds->x2 + deltax &&
+					 dy > ds->y1 - deltay &&
+					 dy < ds->y2 + deltay) ? 1 : 0;
+
+			    if (is_inrange) {
+				Fprintf(stderr, "Grid position (%d %d) at (%g %g) "
+					"layer %d is %s tap geometry.\n",
+					gridx, gridy, dx, dy, ds->layer,
+					(is_inside == 1) ? "inside" : "outside");
+				print_grid_information(gridx, gridy, ds->layer);
+				found_inrange++;
+				if (is_inside) found_inside++;
+			    }
+			    gridy++;
+			}
+			gridx++;
 		    }
+		}
+		if (found_inrange == 0) Fprintf(stderr, "No positions analyzed.\n");
+		Fprintf(stderr, "%d grid position%s found "
+			"inside tap geometry\n", found_inside,
+			((found_inside == 1) ? " was" : "s were"));
+		Fprintf(stderr, "%d grid position%s found "
+			"nearby tap geometry\n", found_inrange,
+			((found_inrange == 1) ? " was" : "s were"));
+	    }
+	}
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* Make a list of all gates, in Nlgates order, for the gate	*/
+/* passes.  Returns the number of gates.			*/
+/*--------------------------------------------------------------*/
+
+static int
+all_gates(GATE **gatesptr)
+{
+    GATE g, *gates;
+    int numgates;
+
+    for (numgates = 0, g = Nlgates; g; g = g->next) numgates++;
+    gates = (GATE *)malloc(MAX(numgates, 1) * sizeof(GATE));
+    for (numgates = 0, g = Nlgates; g; g = g->next) gates[numgates++] = g;
+    *gatesptr = gates;
+    return numgates;
+}
+
+void
+count_reachable_taps(u_char unblock_all)
+{
+    NODE node;
+    GATE *gates;
+    int l, j, k, numgates;
+
+    for (l = 0; l < Num_layers; l++) {
+	for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
+	    if (Nodeinfo[l][j]) {
+		node = Nodeinfo[l][j]->nodeloc;
+		if (node != NULL) {
+
+		    // Redundant check;  if Obs has NO_NET set, then
+		    // Nodeinfo->nodeloc for that position should already
+		    // be NULL
 
-		    /* If there's a solution, don't go looking at other vias */
-		    if (node->numtaps > 0) break;
+		    if (!(Obs[l][j] & NO_NET))
+			node->numtaps++;
 		}
 	    }
 	}
     }
 
+    numgates = all_gates(&gates);
+
+    ReachUnblockAll = unblock_all;
+    run_gate_list(reachable_taps_gate, gates, numgates, 1);
+
     /* Last pass to output error messages for any taps that were not	*/
     /* handled by the code above.					*/
 
-    for (g = Nlgates; g; g = g->next) {
-	for (i = 0; i < g->nodes; i++) {
-	    node = g->noderec[i];
-	    if (node == NULL) continue;
-	    if (node->numnodes == 0) continue;	 // e.g., vdd or gnd bus
-	    if (node->numtaps == 0) {
-		Fprintf(stderr, "Error: Node %s of net \"%s\" has no taps!\n",
-			print_node_name(node), node->netname);
-		Fprintf(stderr, "Qrouter will not be able to completely"
-			" route this net.\n");
-		if (Verbose > 1) {
-		    int found_inside, found_inrange;
-		    Fprintf(stderr, "Tap position blockage analysis:\n");
-
-		    /* Unreachable taps are the most common problem with    */
-		    /* new processes or buggy code, so make a detailed	    */
-		    /* report of blockages affecting routing for debugging. */
-
-		    found_inside = found_inrange = 0;
-		    for (ds = g->taps[i]; ds; ds = ds->next) {
-			unsigned char is_inside, is_inrange;
-
-			deltax = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 0, 0);
-			deltay = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 1, 0);
-
-			Fprintf(stderr, "Tap geometry (%g %g) to (%g %g):\n",
-				ds->x1, ds->y1, ds->x2, ds->y2);
-
-			gridx = (int)(((ds->x1 - 1) - Xlowerbound) / PitchX) - 1;
-			if (gridx < 0) gridx = 0;
-			while (1) {
-			    dx = (gridx * PitchX) + Xlowerbound;
-			    if (dx > (ds->x2 + 1) || gridx >= NumChannelsX) break;
-			    gridy = (int)(((ds->y1 - 1) - Ylowerbound) / PitchY) - 1;
-			    if (gridy < 0) gridy = 0;
-			    while (1) {
-				dy = (gridy * PitchY) + Ylowerbound;
-				if (dy > (ds->y2 + 1) || gridy >= NumChannelsY)
-				    break;
+    for (k = 0; k < numgates; k++)
+	report_unreachable_taps(gates[k]);
 
-				is_inside = (dx >= ds->x1 && dx <= ds->x2 &&
-					     dy >= ds->y1 && dy <= ds->y2) ? 1 : 0;
-
-				is_inrange = (dx > ds->x1 - deltax &&
-					     dx < ds->x2 + deltax &&
-					     dy > ds->y1 - deltay &&
-					     dy < ds->y2 + deltay) ? 1 : 0;
-
-			        if (is_inrange) {
-				    Fprintf(stderr, "Grid position (%d %d) at (%g %g) "
-					    "layer %d is %s tap geometry.\n",
-					    gridx, gridy, dx, dy, ds->layer,
-					    (is_inside == 1) ? "inside" : "outside");
-				    print_grid_information(gridx, gridy, ds->layer);
-				    found_inrange++;
-				    if (is_inside) found_inside++;
-				}
-				gridy++;
-			    }
-			    gridx++;
+    free(gates);
+}
+
+/*--------------------------------------------------------------*/
+/* update_reachable_taps()					*/
+/*								*/
+/*  Redo count_reachable_taps() for the "numgates" gates in	*/
+/*  "gates" only (or for all gates if "gates" is NULL), after	*/
+/*  the design has been set up:  for example, when "unblock"	*/
+/*  is turned on, or when gates have been changed.  The taps	*/
+/*  of each gate are counted again within the grid area that	*/
+/*  the gate passes use for it (see gate_pass_area()).		*/
+/*--------------------------------------------------------------*/
+
+void
+update_reachable_taps(GATE *gates, int numgates, u_char unblock_all)
+{
+    NODE node;
+    NODEINFO lnode;
+    GATE g, *allgates;
+    int i, k, l, x, y;
+    int gx1, gy1, gx2, gy2;
+    double halo;
+
+    allgates = NULL;
+    if (gates == NULL) {
+	numgates = all_gates(&allgates);
+	gates = allgates;
+    }
+
+    halo = gate_pass_halo();
+
+    for (k = 0; k < numgates; k++) {
+	g = gates[k];
+	for (i = 0; i < g->nodes; i++)
+	    if (g->noderec[i]) g->noderec[i]->numtaps = 0;
+    }
+
+    for (k = 0; k < numgates; k++) {
+	g = gates[k];
+	if (!gate_pass_area(g, halo, &gx1, &gy1, &gx2, &gy2)) continue;
+	for (l = 0; l < Num_layers; l++) {
+	    if (Nodeinfo[l] == NULL) continue;
+	    for (x = gx1; x <= gx2; x++)
+		for (y = gy1; y <= gy2; y++) {
+		    lnode = NODEIPTR(x, y, l);
+		    if ((lnode == NULL) || (lnode->nodeloc == NULL)) continue;
+		    if (OBSVAL(x, y, l) & NO_NET) continue;
+		    node = lnode->nodeloc;
+		    for (i = 0; i < g->nodes; i++)
+			if (g->noderec[i] == node) {
+			    node->numtaps++;
+			    break;
 			}
-		    }
-		    if (found_inrange == 0) Fprintf(stderr, "No positions analyzed.\n");
-		    Fprintf(stderr, "%d grid position%s found "
-			    "inside tap geometry\n", found_inside,
-			    ((found_inside == 1) ? " was" : "s were"));
-		    Fprintf(stderr, "%d grid position%s found "
-			    "nearby tap geometry\n", found_inrange,
-			    ((found_inrange == 1) ? " was" : "s were"));
 		}
-	    }
 	}
     }
+
+    ReachUnblockAll = unblock_all;
+    run_gate_list(reachable_taps_gate, gates, numgates, 1);
+
+    /* Bring the bit planes up to date with the taps just made	*/
+    /* routable.  This is done here, and not as each position	*/
+    /* changes, because neighboring gates of a level may share	*/
+    /* plane words.							*/
+
+    if (PlaneWords > 0) {
+	for (k = 0; k < numgates; k++) {
+	    if (!gate_pass_area(gates[k], halo, &gx1, &gy1, &gx2, &gy2))
+		continue;
+	    for (l = 0; l < Num_layers; l++)
+		for (x = gx1; x <= gx2; x++)
+		    for (y = gy1; y <= gy2; y++)
+			update_obs_planes(x, y, l);
+	}
+    }
+
+    for (k = 0; k < numgates; k++)
+	report_unreachable_taps(gates[k]);
+
+    if (allgates) free(allgates);
 }
 
 /*--------------------------------------------------------------*/
@@ -644,9 +825,11 @@ disable_gridpos(int x, int y, int lay)
 {
     int apos = OGRID(x, y);
 
-    Obs[lay][apos] = (u_int)(NO_NET | OBSTRUCT_MASK);
+    Obs[lay][apos] = (obsword)(NO_NET | OBSTRUCT_MASK);
     if (Nodeinfo[lay][apos]) {
-	free(Nodeinfo[lay][apos]);
+	LOCK_NODEINFO();
+	freeNODEINFO(Nodeinfo[lay][apos]);
+	UNLOCK_NODEINFO();
 	Nodeinfo[lay][apos] = NULL;
     }
 }
@@ -694,7 +877,7 @@ static void
 check_obstruct(int gridx, int gridy, DSEG ds, double dx, double dy, double delta)
 {
     ObsInfoRec *obsinfoptr;
-    u_int *obsptr;
+    obsword *obsptr;
     u_int origmask;
     float distx, disty;
 
@@ -819,6 +1002,78 @@ static double get_route_clear(int lay, DSEG rect) {
    return rdelta + mdelta;
 }
 
+/*--------------------------------------------------------------*/
+/* Design rules used by the gate passes (see run_gate_pass()),	*/
+/* by layer.  These depend only on the technology, so they are	*/
+/* looked up once for each pass by set_pin_rules(), instead of	*/
+/* for every grid position around every pin of every gate.	*/
+/*--------------------------------------------------------------*/
+
+typedef struct pinrules_ {
+    double spacing;		/* LefGetRouteSpacing() */
+    double width;		/* LefGetRouteWidth() */
+    double keepout;		/* LefGetRouteKeepout() */
+    int    orientation;		/* LefGetRouteOrientation() */
+    double viawidth[2][4];	/* LefGetXYViaWidth(l, l, dir, orient) */
+    double viahalf[2][4];	/* Via part of get_via_clear(l, horiz, orient) */
+    lefSpacingRule *wide;	/* Spacing by width, if a route layer */
+} PinRules;
+
+static PinRules PinRule[MAX_LAYERS];
+
+static void
+set_pin_rules(void)
+{
+    LefList lefl;
+    double vdelta, v2delta;
+    int l, d, o;
+
+    for (l = 0; l < Num_layers; l++) {
+	PinRule[l].spacing = LefGetRouteSpacing(l);
+	PinRule[l].width = LefGetRouteWidth(l);
+	PinRule[l].keepout = LefGetRouteKeepout(l);
+	PinRule[l].orientation = LefGetRouteOrientation(l);
+	for (d = 0; d < 2; d++)
+	    for (o = 0; o < 4; o++)
+		PinRule[l].viawidth[d][o] = LefGetXYViaWidth(l, l, d, o);
+	for (d = 0; d < 2; d++)
+	    for (o = 0; o < 4; o++) {
+		vdelta = PinRule[l].viawidth[1 - d][o];
+		if (l > 0) {
+		    v2delta = LefGetXYViaWidth(l - 1, l, 1 - d, o);
+		    if (v2delta > vdelta) vdelta = v2delta;
+		}
+		PinRule[l].viahalf[d][o] = vdelta / 2.0;
+	    }
+	lefl = LefFindLayerByNum(l);
+	if (lefl && (lefl->lefClass == CLASS_ROUTE))
+	    PinRule[l].wide = lefl->info.route.spacing;
+	else
+	    PinRule[l].wide = NULL;
+    }
+}
+
+/* get_via_clear(), using the rules in PinRule[] */
+
+static double
+pin_via_clear(int lay, int horiz, int orient, DSEG rect)
+{
+    lefSpacingRule *srule;
+    double mwidth, mdelta;
+
+    mwidth = MIN(rect->x2 - rect->x1, rect->y2 - rect->y1);
+    if (PinRule[lay].wide == NULL)
+	mdelta = LefGetRouteWideSpacing(lay, mwidth);
+    else {
+	mdelta = PinRule[lay].wide->spacing;
+	for (srule = PinRule[lay].wide; srule; srule = srule->next) {
+	    if (srule->width > mwidth) break;
+	    mdelta = srule->spacing;
+	}
+    }
+    return PinRule[lay].viahalf[horiz][orient] + mdelta;
+}
+
 /*--------------------------------------------------------------*/
 /* Truncate gates to the set of tracks.  Warn about any gates	*/
 /* with nodes that are clipped entirely outside the routing	*/
@@ -852,7 +1107,7 @@ void clip_gate_taps(void)
 		    else
 			dpl->next = dp->next;
 
-		    free(dp);
+		    freeDPOINT(dp);
 		    dp = (dpl == NULL) ? node->taps : dpl->next;
 		}
 		else {
@@ -865,140 +1120,609 @@ void clip_gate_taps(void)
 }
 
 /*--------------------------------------------------------------*/
-/* create_obstructions_from_gates()				*/
+/* Obstructions from gate geometry are made in two steps.	*/
+/* First, the grid positions blocked by each of a gate's	*/
+/* obstruction rectangles are found, and kept as runs of	*/
+/* positions up a grid column.  Then the runs are stamped into	*/
+/* Obs[] and Obsinfo[] in order.				*/
 /*								*/
-/*  Fills in the Obs[][] grid from obstructions that were	*/
-/*  defined for each macro in the technology LEF file and	*/
-/*  translated into a list of grid coordinates in each		*/
-/*  instance.							*/
+/* The positions blocked are the same for every instance of a	*/
+/* macro in the same orientation and at the same offset from	*/
+/* the routing grid (its "phase"), so they are found once for	*/
+/* each such combination and kept as a pattern relative to the	*/
+/* grid position of the instance.  Each instance then only	*/
+/* stamps its pattern at its own position.			*/
 /*								*/
-/*  Also, fills in the Obs[][] grid with obstructions that	*/
-/*  are defined by nodes of the gate that are unconnected in	*/
-/*  this netlist.						*/
+/* With NumThreads > 1, the patterns are found on worker	*/
+/* threads as soon as the grid is known (when DefRead()		*/
+/* reaches the nets) while the rest of the DEF file is read.	*/
+/* The stamping is always done in gate order by			*/
+/* create_obstructions_from_gates(), and so does not depend on	*/
+/* the threads.							*/
 /*--------------------------------------------------------------*/
 
-void create_obstructions_from_gates(void)
+#define OBS_PHASE_STEPS	1000000		/* Resolution of phase, per pitch */
+
+typedef struct obsrun_ {
+    int dsidx;		/* Index of the rectangle in the gate's obs list */
+    int gridx, gridy;	/* First position blocked, relative to the gate */
+    int count;		/* Number of positions blocked, going up in y */
+} ObsRun;
+
+typedef struct obspattern_ *OBSPATTERN;
+
+struct obspattern_ {
+    OBSPATTERN next;
+    char   *key;	/* Macro, orientation and phase (NULL if not shared) */
+    ObsRun *runs;	/* Positions blocked, in stamping order */
+    int     numruns, maxruns;
+};
+
+typedef struct gateobs_ {
+    GATE       gate;
+    OBSPATTERN pattern;		/* NULL if the gate has no obstructions */
+    int        gridx, gridy;	/* Grid position of the gate */
+} GateObs;
+
+static HashTable  ObsPatternTable;
+static OBSPATTERN ObsPatterns = NULL;	/* All shared patterns */
+
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t ObsPatternLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* Gate obstructions found ahead of time, in Nlgates order */
+
+static GateObs *GateObsList = NULL;
+static int      NumGateObs = 0;
+
+/* Add the position (gridx, gridy) blocked by rectangle "dsidx"	*/
+
+static void
+add_obs_run(OBSPATTERN pat, int dsidx, int gridx, int gridy)
 {
-    GATE g;
-    DSEG ds;
-    int i, gridx, gridy, orient;
-    double deltax, deltay, delta[MAX_LAYERS];
-    double dx, dy, deltaxy;
+    ObsRun *run;
+
+    if (pat->numruns > 0) {
+	run = &pat->runs[pat->numruns - 1];
+	if ((run->dsidx == dsidx) && (run->gridx == gridx) &&
+			(run->gridy + run->count == gridy)) {
+	    run->count++;
+	    return;
+	}
+    }
+    if (pat->numruns == pat->maxruns) {
+	pat->maxruns = (pat->maxruns == 0) ? 16 : pat->maxruns * 2;
+	pat->runs = (ObsRun *)realloc(pat->runs, pat->maxruns * sizeof(ObsRun));
+    }
+    run = &pat->runs[pat->numruns++];
+    run->dsidx = dsidx;
+    run->gridx = gridx;
+    run->gridy = gridy;
+    run->count = 1;
+}
 
-    // Give a single net number to all obstructions, over the range of the
-    // number of known nets, so these positions cannot be routed through.
-    // If a grid position is not wholly inside an obstruction, then we
-    // maintain the direction of the nearest obstruction in Obs and the
-    // distance to it in Obsinfo.  This indicates that a route can avoid
-    // the obstruction by moving away from it by the amount in Obsinfo
-    // plus spacing clearance.  If another obstruction is found that
-    // prevents such a move, then all direction flags will be set, indicating
-    // that the position is not routable under any condition. 
+/* Find the grid positions blocked by the obstructions of gate	*/
+/* "g", relative to grid position (gx0, gy0).  Positions off	*/
+/* the grid are included, so that the pattern may be used	*/
+/* anywhere;  they are dropped when it is stamped.  This only	*/
+/* reads the database.						*/
 
-    for (g = Nlgates; g; g = g->next) {
-       orient = 0;
-       for (ds = g->obs;; ds = ds->next) {
-	  // Run through ds list twice, checking against horizontally and
-	  // vertically oriented vias.
+static void
+find_obs_pattern(OBSPATTERN pat, GATE g, int gx0, int gy0)
+{
+    DSEG ds;
+    int gridx, gridy, orient, dsidx;
+    double deltax, deltay;
+    double dx, dy;
 
-	  if (ds == NULL) {
-	     if (orient == 2)
-		break;
-	     else {
-		orient = 2;
-	 	ds = g->obs;
-		if (ds == NULL) break;
-	     }
+    orient = 0;
+    dsidx = 0;
+    for (ds = g->obs;; ds = ds->next, dsidx++) {
+       // Run through ds list twice, checking against horizontally and
+       // vertically oriented vias.
+
+       if (ds == NULL) {
+	  if (orient == 2)
+	     break;
+	  else {
+	     orient = 2;
+	     ds = g->obs;
+	     dsidx = 0;
+	     if (ds == NULL) break;
 	  }
+       }
 
-	  deltax = get_via_clear(ds->layer, 1, orient, ds);
-	  gridx = (int)((ds->x1 - Xlowerbound - deltax) / PitchX) - 1;
-	  while (1) {
-	     dx = (gridx * PitchX) + Xlowerbound;
-	     if ((dx + EPS) > (ds->x2 + deltax)
-			|| gridx >= NumChannelsX) break;
-	     else if ((dx - EPS) > (ds->x1 - deltax) && gridx >= 0) {
-		deltay = get_via_clear(ds->layer, 0, orient, ds);
-	        gridy = (int)((ds->y1 - Ylowerbound - deltay) / PitchY) - 1;
-	        while (1) {
-		   dy = (gridy * PitchY) + Ylowerbound;
-	           if ((dy + EPS) > (ds->y2 + deltay)
-				|| gridy >= NumChannelsY) break;
-		   if ((dy - EPS) > (ds->y1 - deltay) && gridy >= 0) {
-		      double s, edist, xp, yp;
-
-		      // Check Euclidean distance measure
-		      s = LefGetRouteSpacing(ds->layer);
-
-		      if (dx < (ds->x1 + s - deltax)) {
-		         xp = dx + deltax - s;
-			 edist = (ds->x1 - xp) * (ds->x1 - xp);
-		      }
-		      else if (dx > (ds->x2 - s + deltax)) {
-		         xp = dx - deltax + s;
-			 edist = (xp - ds->x2) * (xp - ds->x2);
-		      }
-		      else edist = 0;
-		      if ((edist > 0) && (dy < (ds->y1 + s - deltay))) {
-		         yp = dy + deltay - s;
-			 edist += (ds->y1 - yp) * (ds->y1 - yp);
-		      }
-		      else if ((edist > 0) && (dy > (ds->y2 - s + deltay))) {
-		         yp = dy - deltay + s;
-			 edist += (yp - ds->y2) * (yp - ds->y2);
-		      }
-		      else edist = 0;
-
-		      if ((edist + EPS) < (s * s)) {
-			 check_obstruct(gridx, gridy, ds, dx, dy, s);
-			 if (is_testpoint(gridx, gridy, g, -1, ds) != NULL)
-			    Fprintf(stderr, " Position blocked by gate obstruction.\n");
-		      }
-		      else
-			 edist = 0;	// diagnostic break
+       deltax = get_via_clear(ds->layer, 1, orient, ds);
+       gridx = (int)((ds->x1 - Xlowerbound - deltax) / PitchX) - 1;
+       while (1) {
+	  dx = (gridx * PitchX) + Xlowerbound;
+	  if ((dx + EPS) > (ds->x2 + deltax)) break;
+	  else if ((dx - EPS) > (ds->x1 - deltax)) {
+	     deltay = get_via_clear(ds->layer, 0, orient, ds);
+	     gridy = (int)((ds->y1 - Ylowerbound - deltay) / PitchY) - 1;
+	     while (1) {
+		dy = (gridy * PitchY) + Ylowerbound;
+		if ((dy + EPS) > (ds->y2 + deltay)) break;
+		if ((dy - EPS) > (ds->y1 - deltay)) {
+		   double s, edist, xp, yp;
+
+		   // Check Euclidean distance measure
+		   s = LefGetRouteSpacing(ds->layer);
+
+		   if (dx < (ds->x1 + s - deltax)) {
+		      xp = dx + deltax - s;
+		      edist = (ds->x1 - xp) * (ds->x1 - xp);
+		   }
+		   else if (dx > (ds->x2 - s + deltax)) {
+		      xp = dx - deltax + s;
+		      edist = (xp - ds->x2) * (xp - ds->x2);
+		   }
+		   else edist = 0;
+		   if ((edist > 0) && (dy < (ds->y1 + s - deltay))) {
+		      yp = dy + deltay - s;
+		      edist += (ds->y1 - yp) * (ds->y1 - yp);
 		   }
-		   gridy++;
+		   else if ((edist > 0) && (dy > (ds->y2 - s + deltay))) {
+		      yp = dy - deltay + s;
+		      edist += (yp - ds->y2) * (yp - ds->y2);
+		   }
+		   else edist = 0;
+
+		   if ((edist + EPS) < (s * s))
+		      add_obs_run(pat, dsidx, gridx - gx0, gridy - gy0);
 		}
+		gridy++;
 	     }
-	     gridx++;
 	  }
+	  gridx++;
        }
+    }
+}
 
-       for (i = 0; i < g->nodes; i++) {
-	  if (g->netnum[i] == 0) {	/* Unconnected node */
-	     // Diagnostic, and power bus handling
-	     if (g->node[i]) {
-		// Should we flag a warning if we see something that looks
-		// like a power or ground net here?
-		if (Verbose > 1)
-		   Fprintf(stdout, "Gate instance %s unconnected node %s\n",
-			g->gatename, g->node[i]);
-	     }
-	     else {
-		if (Verbose > 1)
-	           Fprintf(stdout, "Gate instance %s unconnected node (%d)\n",
-			g->gatename, i);
-	     }
-             for (ds = g->taps[i]; ds; ds = ds->next) {
-
-		deltax = get_via_clear(ds->layer, 1, orient, ds);
-		gridx = (int)((ds->x1 - Xlowerbound - deltax) / PitchX) - 1;
-		while (1) {
-		   dx = (gridx * PitchX) + Xlowerbound;
-		   if (dx > (ds->x2 + deltax)
-				|| gridx >= NumChannelsX) break;
-		   else if (dx >= (ds->x1 - deltax) && gridx >= 0) {
-		      deltay = get_via_clear(ds->layer, 0, orient, ds);
-		      gridy = (int)((ds->y1 - Ylowerbound - deltay) / PitchY) - 1;
-		      while (1) {
-		         dy = (gridy * PitchY) + Ylowerbound;
-		         if ((dy + EPS) > (ds->y2 + deltay)
-					|| gridy >= NumChannelsY) break;
-		         if ((dy - EPS) >= (ds->y1 - deltay) && gridy >= 0) {
+static void
+free_obs_pattern(OBSPATTERN pat)
+{
+    free(pat->key);
+    free(pat->runs);
+    free(pat);
+}
 
-		            double s, edist = 0.0, xp, yp;
+/* Find the grid position of gate go->gate and the pattern of	*/
+/* positions blocked by its obstructions, looking for a pattern	*/
+/* already found for the same macro, orientation and phase.	*/
 
-		            // Check Euclidean distance measure
+static void
+find_gate_obstructions(GateObs *go)
+{
+    GATE g = go->gate;
+    OBSPATTERN pat, other;
+    double fx, fy;
+    int qx, qy;
+    char key[80];
+
+    go->pattern = NULL;
+    if (g->obs == NULL) return;
+
+    fx = (g->placedX - Xlowerbound) / PitchX;
+    fy = (g->placedY - Ylowerbound) / PitchY;
+    go->gridx = (int)floor(fx);
+    go->gridy = (int)floor(fy);
+    qx = (int)((fx - go->gridx) * OBS_PHASE_STEPS + 0.5);
+    qy = (int)((fy - go->gridy) * OBS_PHASE_STEPS + 0.5);
+    if (qx == OBS_PHASE_STEPS) {
+	qx = 0;
+	go->gridx++;
+    }
+    if (qy == OBS_PHASE_STEPS) {
+	qy = 0;
+	go->gridy++;
+    }
+
+    pat = (OBSPATTERN)calloc(1, sizeof(struct obspattern_));
+    if (g->gatetype == NULL) {
+	/* Not an instance of a macro, so the pattern is its own */
+	find_obs_pattern(pat, g, go->gridx, go->gridy);
+	go->pattern = pat;
+	return;
+    }
+
+    sprintf(key, "%lx/%d/%d/%d", (unsigned long)g->gatetype, g->orient, qx, qy);
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&ObsPatternLock);
+#endif
+    if (ObsPatternTable.table == NULL)
+	HashInit(&ObsPatternTable, 256, HASH_CASE);
+    other = (OBSPATTERN)HashLookup(&ObsPatternTable, key);
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&ObsPatternLock);
+#endif
+    if (other != NULL) {
+	free(pat);
+	go->pattern = other;
+	return;
+    }
+
+    find_obs_pattern(pat, g, go->gridx, go->gridy);
+    pat->key = strdup(key);
+
+    /* Another thread may have found the same pattern meanwhile */
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&ObsPatternLock);
+#endif
+    other = (OBSPATTERN)HashLookup(&ObsPatternTable, key);
+    if (other == NULL) {
+	HashInsert(&ObsPatternTable, pat->key, (void *)pat);
+	pat->next = ObsPatterns;
+	ObsPatterns = pat;
+    }
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&ObsPatternLock);
+#endif
+    if (other != NULL) {
+	free_obs_pattern(pat);
+	pat = other;
+    }
+    go->pattern = pat;
+}
+
+/* Stamp the pattern of a gate at the gate's position		*/
+
+static void
+stamp_gate_obstructions(GateObs *go)
+{
+    static DSEG *dslist = NULL;
+    static int maxds = 0;
+    OBSPATTERN pat = go->pattern;
+    ObsRun *run;
+    DSEG ds;
+    int n, gridx, gridy, gy1, gy2;
+    double dx, dy, s;
+
+    if (pat == NULL) return;
+
+    for (n = 0, ds = go->gate->obs; ds; ds = ds->next, n++) {
+	if (n == maxds) {
+	    maxds = (maxds == 0) ? 32 : maxds * 2;
+	    dslist = (DSEG *)realloc(dslist, maxds * sizeof(DSEG));
+	}
+	dslist[n] = ds;
+    }
+
+    for (run = pat->runs; run < pat->runs + pat->numruns; run++) {
+	gridx = run->gridx + go->gridx;
+	if ((gridx < 0) || (gridx >= NumChannelsX)) continue;
+	gy1 = run->gridy + go->gridy;
+	gy2 = gy1 + run->count;
+	if (gy1 < 0) gy1 = 0;
+	if (gy2 > NumChannelsY) gy2 = NumChannelsY;
+
+	ds = dslist[run->dsidx];
+	s = LefGetRouteSpacing(ds->layer);
+	dx = (gridx * PitchX) + Xlowerbound;
+	for (gridy = gy1; gridy < gy2; gridy++) {
+	    dy = (gridy * PitchY) + Ylowerbound;
+	    check_obstruct(gridx, gridy, ds, dx, dy, s);
+	    if (is_testpoint(gridx, gridy, go->gate, -1, ds) != NULL)
+		Fprintf(stderr, " Position blocked by gate obstruction.\n");
+	}
+    }
+}
+
+#ifdef HAVE_LIBPTHREAD
+
+typedef struct gateobsjob_ {
+    pthread_t thread;
+    int       first, stride;	/* Gates handled by this worker */
+    u_char    started;
+} GateObsJob;
+
+static GateObsJob *GateObsJobs = NULL;
+static int         NumGateObsJobs = 0;
+
+static void *
+gate_obstructions_worker(void *arg)
+{
+    GateObsJob *job = (GateObsJob *)arg;
+    int i;
+
+    for (i = job->first; i < NumGateObs; i += job->stride)
+	find_gate_obstructions(&GateObsList[i]);
+    return NULL;
+}
+
+#endif
+
+/* Wait for the workers started by begin_obstructions_from_gates() */
+
+static void
+finish_obstructions_from_gates(void)
+{
+#ifdef HAVE_LIBPTHREAD
+    int c;
+
+    if (GateObsJobs == NULL) return;
+    for (c = 0; c < NumGateObsJobs; c++)
+	if (GateObsJobs[c].started)
+	    pthread_join(GateObsJobs[c].thread, NULL);
+    free(GateObsJobs);
+    GateObsJobs = NULL;
+    NumGateObsJobs = 0;
+#endif
+}
+
+/*--------------------------------------------------------------*/
+/* begin_obstructions_from_gates()				*/
+/*								*/
+/*  Start finding the obstructions of all gates read so far on	*/
+/*  worker threads.  Called by DefRead() once the routing grid	*/
+/*  is known.  Does nothing unless NumThreads > 1.		*/
+/*--------------------------------------------------------------*/
+
+void begin_obstructions_from_gates(void)
+{
+#ifdef HAVE_LIBPTHREAD
+    GATE g;
+    int i, c;
+
+    if ((NumThreads < 2) || (GateObsList != NULL) || (Nlgates == NULL))
+	return;
+    if ((Num_layers <= 0) || (NumChannelsX <= 0) || (NumChannelsY <= 0))
+	return;
+
+    // Bring the layer hash table up to date now, so that the
+    // workers only read it.
+    LefFindLayer("");
+
+    for (NumGateObs = 0, g = Nlgates; g; g = g->next) NumGateObs++;
+    GateObsList = (GateObs *)calloc(NumGateObs, sizeof(GateObs));
+    for (i = 0, g = Nlgates; g; g = g->next) GateObsList[i++].gate = g;
+
+    NumGateObsJobs = NumThreads;
+    GateObsJobs = (GateObsJob *)calloc(NumGateObsJobs, sizeof(GateObsJob));
+    for (c = 0; c < NumGateObsJobs; c++) {
+	GateObsJobs[c].first = c;
+	GateObsJobs[c].stride = NumGateObsJobs;
+	if (pthread_create(&GateObsJobs[c].thread, NULL, gate_obstructions_worker,
+			(void *)&GateObsJobs[c]) == 0)
+	    GateObsJobs[c].started = TRUE;
+	else
+	    gate_obstructions_worker((void *)&GateObsJobs[c]);
+    }
+#endif
+}
+
+/*--------------------------------------------------------------*/
+/* cancel_obstructions_from_gates()				*/
+/*								*/
+/*  Discard any obstructions found ahead of time.  Called by	*/
+/*  DefRead() for any section that may change what they depend	*/
+/*  on.								*/
+/*--------------------------------------------------------------*/
+
+void cancel_obstructions_from_gates(void)
+{
+    OBSPATTERN pat;
+    int i;
+
+    finish_obstructions_from_gates();
+    for (i = 0; i < NumGateObs; i++) {
+	pat = GateObsList[i].pattern;
+	if ((pat != NULL) && (pat->key == NULL)) free_obs_pattern(pat);
+    }
+    free(GateObsList);
+    GateObsList = NULL;
+    NumGateObs = 0;
+
+    while (ObsPatterns != NULL) {
+	pat = ObsPatterns->next;
+	free_obs_pattern(ObsPatterns);
+	ObsPatterns = pat;
+    }
+    HashKill(&ObsPatternTable);
+}
+
+/*--------------------------------------------------------------*/
+/* grid_span() ---						*/
+/*	Find the grid positions first to last (inclusive) along	*/
+/*	one axis, of "num" positions at "lower + n * pitch",	*/
+/*	that lie between "lo" and "hi".  If "closed" is TRUE	*/
+/*	then the ends are included, otherwise not.  Positions	*/
+/*	are computed as the grid loops of the obstruction	*/
+/*	routines compute them, so the result is the same as	*/
+/*	testing each position in turn.  Returns FALSE if there	*/
+/*	are no such positions.					*/
+/*--------------------------------------------------------------*/
+
+static u_char
+grid_span(double lo, double hi, double lower, double pitch, int num,
+		u_char closed, int *first, int *last)
+{
+    int f, l;
+
+    if (num <= 0) return FALSE;
+
+    f = (int)((lo - lower) / pitch);
+    if (f < 0) f = 0;
+    if (f > num - 1) f = num - 1;
+    while ((f > 0) && (closed ? ((((f - 1) * pitch) + lower) >= lo) :
+		((((f - 1) * pitch) + lower) > lo)))
+	f--;
+    while ((f < num) && (closed ? (((f * pitch) + lower) < lo) :
+		(((f * pitch) + lower) <= lo)))
+	f++;
+
+    l = (int)((hi - lower) / pitch);
+    if (l < 0) l = 0;
+    if (l > num - 1) l = num - 1;
+    while ((l < num - 1) && (closed ? ((((l + 1) * pitch) + lower) <= hi) :
+		((((l + 1) * pitch) + lower) < hi)))
+	l++;
+    while ((l >= 0) && (closed ? (((l * pitch) + lower) > hi) :
+		(((l * pitch) + lower) >= hi)))
+	l--;
+
+    *first = f;
+    *last = l;
+    return (f <= l) ? TRUE : FALSE;
+}
+
+/*--------------------------------------------------------------*/
+/* rasterize_obstruction() ---					*/
+/*	Mark the Obs[] grid with the obstruction rectangle ds,	*/
+/*	expanded by "delta" on all sides.  This is the same as	*/
+/*	calling check_obstruct() on every grid position inside	*/
+/*	the expanded rectangle, but the range of positions in	*/
+/*	each row is found once, and the positions completely	*/
+/*	inside the rectangle (the bulk of a large blockage or	*/
+/*	power strap) are filled as one run.  Used for all the	*/
+/*	obstructions in UserObs:  those from the configuration	*/
+/*	file and the "obstruction" command, DEF BLOCKAGES, and	*/
+/*	SPECIALNETS wiring.					*/
+/*--------------------------------------------------------------*/
+
+void
+rasterize_obstruction(DSEG ds, double delta)
+{
+    obsword *obsrow;
+    int gridx, gridy, gx1, gx2, gy1, gy2, ix1, ix2;
+    u_char inside;
+    double dx, dy;
+
+    if (!grid_span(ds->x1 - delta, ds->x2 + delta, Xlowerbound, PitchX,
+		NumChannelsX, TRUE, &gx1, &gx2))
+	return;
+    if (!grid_span(ds->y1 - delta, ds->y2 + delta, Ylowerbound, PitchY,
+		NumChannelsY, TRUE, &gy1, &gy2))
+	return;
+
+    // Columns strictly inside the rectangle, clipped to the
+    // expanded range.
+
+    inside = grid_span(ds->x1, ds->x2, Xlowerbound, PitchX,
+		NumChannelsX, FALSE, &ix1, &ix2);
+    if (inside) {
+	if (ix1 < gx1) ix1 = gx1;
+	if (ix2 > gx2) ix2 = gx2;
+	if (ix1 > ix2) inside = FALSE;
+    }
+
+    for (gridy = gy1; gridy <= gy2; gridy++) {
+	dy = (gridy * PitchY) + Ylowerbound;
+	if (inside && (dy > ds->y1) && (dy < ds->y2)) {
+	    for (gridx = gx1; gridx < ix1; gridx++) {
+		dx = (gridx * PitchX) + Xlowerbound;
+		check_obstruct(gridx, gridy, ds, dx, dy, delta);
+	    }
+	    obsrow = &OBSVAL(0, gridy, ds->layer);
+	    for (gridx = ix1; gridx <= ix2; gridx++)
+		obsrow[gridx] |= NO_NET | OBSTRUCT_MASK;
+	    for (gridx = ix2 + 1; gridx <= gx2; gridx++) {
+		dx = (gridx * PitchX) + Xlowerbound;
+		check_obstruct(gridx, gridy, ds, dx, dy, delta);
+	    }
+	}
+	else {
+	    for (gridx = gx1; gridx <= gx2; gridx++) {
+		dx = (gridx * PitchX) + Xlowerbound;
+		check_obstruct(gridx, gridy, ds, dx, dy, delta);
+	    }
+	}
+	if (testpoint != NULL)
+	    for (gridx = gx1; gridx <= gx2; gridx++)
+		if (is_testpoint(gridx, gridy, NULL, -1, ds) != NULL)
+		    Fprintf(stderr, " Position blocked by defined obstruction.\n");
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* create_obstructions_from_gates()				*/
+/*								*/
+/*  Fills in the Obs[][] grid from obstructions that were	*/
+/*  defined for each macro in the technology LEF file and	*/
+/*  translated into a list of grid coordinates in each		*/
+/*  instance.							*/
+/*								*/
+/*  Also, fills in the Obs[][] grid with obstructions that	*/
+/*  are defined by nodes of the gate that are unconnected in	*/
+/*  this netlist.						*/
+/*--------------------------------------------------------------*/
+
+void create_obstructions_from_gates(void)
+{
+    GATE g;
+    DSEG ds;
+    GateObs *go, gateobs;
+    int i, k, gridx, gridy, orient;
+    double deltax, deltay, delta[MAX_LAYERS];
+    double dx, dy, deltaxy;
+
+    // Give a single net number to all obstructions, over the range of the
+    // number of known nets, so these positions cannot be routed through.
+    // If a grid position is not wholly inside an obstruction, then we
+    // maintain the direction of the nearest obstruction in Obs and the
+    // distance to it in Obsinfo.  This indicates that a route can avoid
+    // the obstruction by moving away from it by the amount in Obsinfo
+    // plus spacing clearance.  If another obstruction is found that
+    // prevents such a move, then all direction flags will be set, indicating
+    // that the position is not routable under any condition. 
+
+    finish_obstructions_from_gates();
+    k = 0;
+
+    for (g = Nlgates; g; g = g->next) {
+
+       // Use the positions found ahead of time, if this gate was
+       // among those read at the time (gates read later are at
+       // the front of the list).
+
+       if ((k < NumGateObs) && (GateObsList[k].gate == g))
+	  go = &GateObsList[k++];
+       else {
+	  go = &gateobs;
+	  go->gate = g;
+	  find_gate_obstructions(go);
+       }
+       stamp_gate_obstructions(go);
+       if ((go == &gateobs) && (go->pattern != NULL) && (go->pattern->key == NULL))
+	  free_obs_pattern(go->pattern);
+       orient = 2;	/* As left by the passes over the obstructions */
+
+       for (i = 0; i < g->nodes; i++) {
+	  if (g->netnum[i] == 0) {	/* Unconnected node */
+	     // Diagnostic, and power bus handling
+	     if (g->node[i]) {
+		// Should we flag a warning if we see something that looks
+		// like a power or ground net here?
+		if (Verbose > 1)
+		   Fprintf(stdout, "Gate instance %s unconnected node %s\n",
+			g->gatename, g->node[i]);
+	     }
+	     else {
+		if (Verbose > 1)
+	           Fprintf(stdout, "Gate instance %s unconnected node (%d)\n",
+			g->gatename, i);
+	     }
+             for (ds = g->taps[i]; ds; ds = ds->next) {
+
+		deltax = get_via_clear(ds->layer, 1, orient, ds);
+		gridx = (int)((ds->x1 - Xlowerbound - deltax) / PitchX) - 1;
+		while (1) {
+		   dx = (gridx * PitchX) + Xlowerbound;
+		   if (dx > (ds->x2 + deltax)
+				|| gridx >= NumChannelsX) break;
+		   else if (dx >= (ds->x1 - deltax) && gridx >= 0) {
+		      deltay = get_via_clear(ds->layer, 0, orient, ds);
+		      gridy = (int)((ds->y1 - Ylowerbound - deltay) / PitchY) - 1;
+		      while (1) {
+		         dy = (gridy * PitchY) + Ylowerbound;
+		         if ((dy + EPS) > (ds->y2 + deltay)
+					|| gridy >= NumChannelsY) break;
+		         if ((dy - EPS) >= (ds->y1 - deltay) && gridy >= 0) {
+
+		            double s, edist = 0.0, xp, yp;
+
+		            // Check Euclidean distance measure
 		            s = LefGetRouteSpacing(ds->layer);
 
 		            if (dx < (ds->x1 + s - deltax)) {
@@ -1037,6 +1761,8 @@ void create_obstructions_from_gates(void)
        }
     }
 
+    cancel_obstructions_from_gates();	/* Done with the patterns */
+
     // Create additional obstructions from the UserObs list
     // These obstructions are not considered to be metal layers,
     // so we don't compute a distance measure.  However, we need
@@ -1049,28 +1775,7 @@ void create_obstructions_from_gates(void)
 
     for (ds = UserObs; ds; ds = ds->next) {
 	if (ds->layer >= Num_layers) continue;
-	gridx = (int)((ds->x1 - Xlowerbound - delta[ds->layer]) / PitchX) - 1;
-	while (1) {
-	    dx = (gridx * PitchX) + Xlowerbound;
-	    if (dx > (ds->x2 + delta[ds->layer])
-			|| gridx >= NumChannelsX) break;
-	    else if (dx >= (ds->x1 - delta[ds->layer]) && gridx >= 0) {
-		gridy = (int)((ds->y1 - Ylowerbound - delta[ds->layer]) / PitchY) - 1;
-		while (1) {
-		    dy = (gridy * PitchY) + Ylowerbound;
-		    if (dy > (ds->y2 + delta[ds->layer])
-				|| gridy >= NumChannelsY) break;
-		    if (dy >= (ds->y1 - delta[ds->layer]) && gridy >= 0) {
-		       check_obstruct(gridx, gridy, ds, dx, dy, delta[i]);
-		       if (is_testpoint(gridx, gridy, NULL, -1, ds) != NULL)
-			  Fprintf(stderr, " Position blocked by defined obstruction.\n");
-		    }
-
-		    gridy++;
-		}
-	    }
-	    gridx++;
-	}
+	rasterize_obstruction(ds, delta[ds->layer]);
     }
 }
 
@@ -1224,36 +1929,325 @@ is_testpoint(int gridx, int gridy, GATE g, int nidx, DSEG ds)
 }
 
 /*--------------------------------------------------------------*/
-/* create_obstructions_inside_nodes()				*/
+/* Gate passes							*/
 /*								*/
-/*  Fills in the Obs[][] grid from the position of each node	*/
-/*  (net terminal), which may have multiple unconnected		*/
-/*  positions.							*/
+/*  The passes that mark the grid around pins (from		*/
+/*  create_obstructions_inside_nodes() to find_route_blocks())	*/
+/*  each work through Nlgates and only look at grid positions	*/
+/*  within a short distance of the gate's pins.  With		*/
+/*  NumThreads > 1, run_gate_pass() divides the grid into tiles	*/
+/*  and puts each gate in a "level" one higher than that of	*/
+/*  any earlier gate touching the same tiles.  Gates in the	*/
+/*  same level have no tiles in common and are handled on	*/
+/*  worker threads together, one level after another.  Any two	*/
+/*  gates that touch the same part of the grid are therefore	*/
+/*  still handled in Nlgates order, and the result is the same	*/
+/*  as that of a serial pass.					*/
+/*--------------------------------------------------------------*/
+
+#define GATE_PASS_TILE	4	/* Tile size, in grid positions */
+#define GATE_PASS_MIN	512	/* Fewest gates worth using threads for */
+
+/*--------------------------------------------------------------*/
+/* Return the distance from a pin within which every gate pass	*/
+/* stays:  the via or route clearance of a pin (at its widest),	*/
+/* plus a pitch.						*/
+/*--------------------------------------------------------------*/
+
+static double
+gate_pass_halo(void)
+{
+    struct dseg_ wide;
+    double halo, clear;
+    int l, o;
+
+    wide.x1 = wide.y1 = 0.0;
+    wide.x2 = wide.y2 = 1.0e30;
+    halo = 0.0;
+    for (l = 0; l < Num_layers; l++) {
+	for (o = 0; o <= 2; o += 2) {
+	    clear = get_via_clear(l, 0, o, &wide);
+	    if (clear > halo) halo = clear;
+	    clear = get_via_clear(l, 1, o, &wide);
+	    if (clear > halo) halo = clear;
+	}
+	clear = get_route_clear(l, &wide);
+	if (clear > halo) halo = clear;
+    }
+    return halo + MAX(PitchX, PitchY);
+}
+
+/*--------------------------------------------------------------*/
+/* Find the grid area that the gate passes may look at for	*/
+/* gate g:  the pins expanded by "halo" and a few grid		*/
+/* positions, clipped to the grid.  Return FALSE if the gate	*/
+/* has no pins.							*/
+/*--------------------------------------------------------------*/
+
+static u_char
+gate_pass_area(GATE g, double halo, int *gx1, int *gy1, int *gx2, int *gy2)
+{
+    DSEG ds;
+    double x1, y1, x2, y2;
+    int i;
+
+    x1 = y1 = 1.0e30;
+    x2 = y2 = -1.0e30;
+    for (i = 0; i < g->nodes; i++)
+	for (ds = g->taps[i]; ds; ds = ds->next) {
+	    if (ds->x1 < x1) x1 = ds->x1;
+	    if (ds->y1 < y1) y1 = ds->y1;
+	    if (ds->x2 > x2) x2 = ds->x2;
+	    if (ds->y2 > y2) y2 = ds->y2;
+	}
+    if (x1 > x2) return FALSE;
+
+    *gx1 = (int)floor((x1 - halo - Xlowerbound) / PitchX) - 2;
+    *gy1 = (int)floor((y1 - halo - Ylowerbound) / PitchY) - 2;
+    *gx2 = (int)floor((x2 + halo - Xlowerbound) / PitchX) + 3;
+    *gy2 = (int)floor((y2 + halo - Ylowerbound) / PitchY) + 3;
+    *gx1 = MAX(0, MIN(*gx1, NumChannelsX - 1));
+    *gy1 = MAX(0, MIN(*gy1, NumChannelsY - 1));
+    *gx2 = MAX(0, MIN(*gx2, NumChannelsX - 1));
+    *gy2 = MAX(0, MIN(*gy2, NumChannelsY - 1));
+    return TRUE;
+}
+
+#ifdef HAVE_LIBPTHREAD
+
+typedef struct gatepass_ {
+    GatePassProc proc;
+    GATE   *gates;		/* All gates, by level and then in order */
+    int    *levels;		/* Index of the first gate of each level */
+    int     numlevels;
+    int     numjobs;		/* Threads taking part, including the caller */
+    int     waiting;		/* Threads waiting for the level to end */
+    int     generation;		/* Number of levels ended */
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+} GatePass;
+
+typedef struct gatepassjob_ {
+    pthread_t thread;
+    GatePass *pass;
+    int       index;
+} GatePassJob;
+
+/* Wait until all threads have finished the current level */
+
+static void
+gate_pass_wait(GatePass *pass)
+{
+    int generation;
+
+    pthread_mutex_lock(&pass->lock);
+    generation = pass->generation;
+    if (++pass->waiting == pass->numjobs) {
+	pass->waiting = 0;
+	pass->generation++;
+	pthread_cond_broadcast(&pass->cond);
+    }
+    else
+	while (generation == pass->generation)
+	    pthread_cond_wait(&pass->cond, &pass->lock);
+    pthread_mutex_unlock(&pass->lock);
+}
+
+static void *
+gate_pass_worker(void *arg)
+{
+    GatePassJob *job = (GatePassJob *)arg;
+    GatePass *pass = job->pass;
+    int l, k, numjobs;
+
+    // The number of threads is known once the caller lets go of the lock
+    pthread_mutex_lock(&pass->lock);
+    numjobs = pass->numjobs;
+    pthread_mutex_unlock(&pass->lock);
+
+    for (l = 0; l < pass->numlevels; l++) {
+	for (k = pass->levels[l] + job->index; k < pass->levels[l + 1];
+			k += numjobs)
+	    (*pass->proc)(pass->gates[k]);
+	if (l < pass->numlevels - 1) gate_pass_wait(pass);
+    }
+    return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* Find the level of each gate and sort the gates by level.	*/
+/* Return the number of levels.					*/
+/*--------------------------------------------------------------*/
+
+static int
+gate_pass_levels(GATE *gates, int numgates, int **levelsptr)
+{
+    GATE *sorted;
+    int *gatelevel, *tilelevel, *levels, *next;
+    int k, l, numlevels, tilesx, tilesy;
+    int tx, ty, tx1, ty1, tx2, ty2;
+    double halo;
+
+    halo = gate_pass_halo();
+
+    tilesx = (NumChannelsX + GATE_PASS_TILE - 1) / GATE_PASS_TILE;
+    tilesy = (NumChannelsY + GATE_PASS_TILE - 1) / GATE_PASS_TILE;
+    tilelevel = (int *)calloc(tilesx * tilesy, sizeof(int));
+    gatelevel = (int *)malloc(numgates * sizeof(int));
+
+    numlevels = 0;
+    for (k = 0; k < numgates; k++) {
+	if (!gate_pass_area(gates[k], halo, &tx1, &ty1, &tx2, &ty2)) {
+	    gatelevel[k] = 0;		/* No pins;  touches nothing */
+	    continue;
+	}
+	tx1 /= GATE_PASS_TILE;
+	ty1 /= GATE_PASS_TILE;
+	tx2 /= GATE_PASS_TILE;
+	ty2 /= GATE_PASS_TILE;
+
+	l = 0;
+	for (tx = tx1; tx <= tx2; tx++)
+	    for (ty = ty1; ty <= ty2; ty++)
+		if (tilelevel[ty * tilesx + tx] > l)
+		    l = tilelevel[ty * tilesx + tx];
+	gatelevel[k] = l;
+	for (tx = tx1; tx <= tx2; tx++)
+	    for (ty = ty1; ty <= ty2; ty++)
+		tilelevel[ty * tilesx + tx] = l + 1;
+	if (l + 1 > numlevels) numlevels = l + 1;
+    }
+    if (numlevels == 0) numlevels = 1;
+
+    // Sort the gates by level, keeping the order within each level
+
+    levels = (int *)calloc(numlevels + 1, sizeof(int));
+    for (k = 0; k < numgates; k++) levels[gatelevel[k] + 1]++;
+    for (l = 0; l < numlevels; l++) levels[l + 1] += levels[l];
+    free(tilelevel);
+
+    sorted = (GATE *)malloc(numgates * sizeof(GATE));
+    next = (int *)malloc(numlevels * sizeof(int));
+    for (l = 0; l < numlevels; l++) next[l] = levels[l];
+    for (k = 0; k < numgates; k++) sorted[next[gatelevel[k]]++] = gates[k];
+    memcpy(gates, sorted, numgates * sizeof(GATE));
+    free(sorted);
+    free(next);
+    free(gatelevel);
+
+    *levelsptr = levels;
+    return numlevels;
+}
+
+#endif /* HAVE_LIBPTHREAD */
+
+/*--------------------------------------------------------------*/
+/* run_gate_list()						*/
 /*								*/
-/*  Also fills in the Nodeinfo.nodeloc[] grid with the node	*/
-/*  number, which causes the router to put a premium on		*/
-/*  routing other nets over or under this position, to		*/
-/*  discourage boxing in a pin position and making it 		*/
-/*  unroutable.							*/
+/*  Call proc() for each of the "numgates" gates in "gates",	*/
+/*  which are in Nlgates order.  Uses NumThreads threads as	*/
+/*  described above, but stays serial for small numbers of	*/
+/*  gates, and when there is diagnostic output to keep in	*/
+/*  order:  with watch points, or when Verbose is above		*/
+/*  "quiet", the highest level at which proc() prints nothing.	*/
+/*--------------------------------------------------------------*/
+
+static void
+run_gate_list(GatePassProc proc, GATE *gates, int numgates, int quiet)
+{
+    int k;
+#ifdef HAVE_LIBPTHREAD
+    GatePass pass;
+    GatePassJob *jobs;
+    int c;
+#endif
+
+    set_pin_rules();
+
+#ifdef HAVE_LIBPTHREAD
+    if ((NumThreads > 1) && (numgates >= GATE_PASS_MIN) &&
+		(testpoint == NULL) && (Verbose <= quiet)) {
+
+	// Bring the layer hash table up to date now, so that the
+	// workers only read it.
+	LefFindLayer("");
+
+	memset(&pass, 0, sizeof(GatePass));
+	pass.proc = proc;
+	pass.gates = (GATE *)malloc(numgates * sizeof(GATE));
+	memcpy(pass.gates, gates, numgates * sizeof(GATE));
+	pass.numlevels = gate_pass_levels(pass.gates, numgates, &pass.levels);
+	pthread_mutex_init(&pass.lock, NULL);
+	pthread_cond_init(&pass.cond, NULL);
+
+	jobs = (GatePassJob *)calloc(NumThreads, sizeof(GatePassJob));
+	pthread_mutex_lock(&pass.lock);
+	for (c = 0; c < NumThreads; c++) {
+	    jobs[c].pass = &pass;
+	    jobs[c].index = c;
+	    if (c > 0 && pthread_create(&jobs[c].thread, NULL, gate_pass_worker,
+			(void *)&jobs[c]) != 0)
+		break;
+	}
+	pass.numjobs = c;
+	pthread_mutex_unlock(&pass.lock);
+
+	gate_pass_worker((void *)&jobs[0]);
+	for (c = 1; c < pass.numjobs; c++)
+	    pthread_join(jobs[c].thread, NULL);
+
+	if (Verbose > 2)
+	    Fprintf(stdout, "  Marked pins of %d gates in %d levels"
+			" using %d threads.\n", numgates, pass.numlevels,
+			pass.numjobs);
+
+	pthread_mutex_destroy(&pass.lock);
+	pthread_cond_destroy(&pass.cond);
+	free(jobs);
+	free(pass.levels);
+	free(pass.gates);
+	return;
+    }
+#endif
+
+    for (k = 0; k < numgates; k++)
+	(*proc)(gates[k]);
+}
+
+/*--------------------------------------------------------------*/
+/* run_gate_pass()						*/
 /*								*/
-/*  This routine is split into two passes.  This pass adds	*/
-/*  information for points inside node regions.			*/
+/*  Call proc() for each gate in Nlgates, with run_gate_list().	*/
+/*  The passes print nothing at Verbose levels up to 3.		*/
+/*--------------------------------------------------------------*/
+
+static void
+run_gate_pass(GatePassProc proc)
+{
+    GATE *gates;
+    int numgates;
+
+    numgates = all_gates(&gates);
+    run_gate_list(proc, gates, numgates, 3);
+    free(gates);
+}
+
+/*--------------------------------------------------------------*/
+/* create_obstructions_inside_gate()				*/
 /*								*/
-/*  ARGS: none.							*/
-/*  RETURNS: nothing						*/
-/*  SIDE EFFECTS: none						*/
-/*  AUTHOR:  Tim Edwards, June 2011, based on code by Steve	*/
-/*	Beccue.							*/
+/*  The part of create_obstructions_inside_nodes() done for	*/
+/*  each gate.							*/
 /*--------------------------------------------------------------*/
 
-void create_obstructions_inside_nodes(void)
+static void
+create_obstructions_inside_gate(GATE g)
 {
     NODE node;
     NODEINFO lnode;
-    GATE g;
     DSEG ds;
     DPOINT tpoint;
-    u_int dir, mask, k;
+    u_int dir;
+    obsword mask, k;
     int i, gridx, gridy;
     double dx, dy, xdist, vwx, vwy;
     u_char o0okay, o2okay, duplicate;
@@ -1268,226 +2262,223 @@ void create_obstructions_inside_nodes(void)
     // flag bit, so that the position can be ignored when routing the net
     // associated with the pin.  Normal obstructions take precedence.
 
-    for (g = Nlgates; g; g = g->next) {
-       for (i = 0; i < g->nodes; i++) {
-	  if (g->netnum[i] != 0) {
+    for (i = 0; i < g->nodes; i++) {
+       if (g->netnum[i] != 0) {
+
+	  // Get the node record associated with this pin.
+	  node = g->noderec[i];
+	  if (node == NULL) continue;
+
+	  // First mark all areas inside node geometry boundary.
+
+	  for (ds = g->taps[i]; ds; ds = ds->next) {
+	     gridx = (int)((ds->x1 - Xlowerbound) / PitchX) - 1;
+	     if (gridx < 0) gridx = 0;
+	     while (1) {
+		dx = (gridx * PitchX) + Xlowerbound;
+		if (dx > ds->x2 || gridx >= NumChannelsX) break;
+		else if (dx >= ds->x1 && gridx >= 0) {
+		   gridy = (int)((ds->y1 - Ylowerbound) / PitchY) - 1;
+		   if (gridy < 0) gridy = 0;
+		   while (1) {
+		      dy = (gridy * PitchY) + Ylowerbound;
+		      if (dy > ds->y2 || gridy >= NumChannelsY) break;
+
+		      // Area inside defined pin geometry
+
+		      if (dy > ds->y1 && gridy >= 0) {
+			  obsword orignet = OBSVAL(gridx, gridy, ds->layer);
+
+			  duplicate = FALSE;
+			  lnode = NULL;
+			  if ((orignet & ROUTED_NET_MASK & ~ROUTED_NET)
+				     == (u_int)node->netnum) {
+
+			     // Duplicate tap point, or pre-existing route.
+			     // Re-process carefully.  Check for alternate
+			     // restrictions.  This geometry may be better
+			     // than the last one(s) processed.
+
+			     if (((lnode = NODEIPTR(gridx, gridy, ds->layer)) != NULL)
+				     && (lnode->nodeloc != NULL))
+				 duplicate = TRUE;
+			  }
+
+			  else if (!(orignet & NO_NET) &&
+				     ((orignet & ROUTED_NET_MASK) != (u_int)0)) {
+
+			     // Net was assigned to other net, but is inside
+			     // this pin's geometry.  Declare point to be
+			     // unroutable, as it is too close to both pins.
+			     // NOTE:  This is a conservative rule and could
+			     // potentially make a pin unroutable.
+			     // Another note:  By setting Obs[] to
+			     // OBSTRUCT_MASK as well as NO_NET, we ensure
+			     // that it falls through on all subsequent
+			     // processing.
+
+			     if (is_testpoint(gridx, gridy, g, i, ds) != NULL)
+				 Fprintf(stderr, " Position is inside pin but cannot "
+					 "be routed without causing violation.\n");
+			     disable_gridpos(gridx, gridy, ds->layer);
+			     gridy++;
+			     continue;
+			  }
+
+			  if (!(orignet & NO_NET)) {
+
+			     // A grid point that is within 1/2 route width
+			     // of a tap rectangle corner can violate metal
+			     // width rules, and so should declare a stub.
+				
+			     mask = 0;
+			     dir = 0;
+			     dist = 0.0;
+			     xdist = 0.5 * PinRule[ds->layer].width;
 
-	     // Get the node record associated with this pin.
-	     node = g->noderec[i];
-	     if (node == NULL) continue;
+			     if (dx >= ds->x2 - xdist) {
+				if (dy > ds->y2 - xdist + EPS) {
+				   // Check northeast corner
 
-	     // First mark all areas inside node geometry boundary.
+				   if ((ds->x2 - dx) > (ds->y2 - dy)) {
+				      // West-pointing stub
+				      mask = STUBROUTE;
+				      dir = NI_STUB_EW;
+				      dist = ds->x2 - dx - 2.0 * xdist;
+				   }
+				   else {
+				      // South-pointing stub
+				      mask = STUBROUTE;
+				      dir = NI_STUB_NS;
+				      dist = ds->y2 - dy - 2.0 * xdist;
+				   }
 
-             for (ds = g->taps[i]; ds; ds = ds->next) {
-		gridx = (int)((ds->x1 - Xlowerbound) / PitchX) - 1;
-		if (gridx < 0) gridx = 0;
-		while (1) {
-		   dx = (gridx * PitchX) + Xlowerbound;
-		   if (dx > ds->x2 || gridx >= NumChannelsX) break;
-		   else if (dx >= ds->x1 && gridx >= 0) {
-		      gridy = (int)((ds->y1 - Ylowerbound) / PitchY) - 1;
-		      if (gridy < 0) gridy = 0;
-		      while (1) {
-		         dy = (gridy * PitchY) + Ylowerbound;
-		         if (dy > ds->y2 || gridy >= NumChannelsY) break;
-
-			 // Area inside defined pin geometry
-
-			 if (dy > ds->y1 && gridy >= 0) {
-			     int orignet = OBSVAL(gridx, gridy, ds->layer);
-
-			     duplicate = FALSE;
-			     lnode = NULL;
-			     if ((orignet & ROUTED_NET_MASK & ~ROUTED_NET)
-					== (u_int)node->netnum) {
-
-				// Duplicate tap point, or pre-existing route.
-				// Re-process carefully.  Check for alternate
-				// restrictions.  This geometry may be better
-				// than the last one(s) processed.
-
-				if (((lnode = NODEIPTR(gridx, gridy, ds->layer)) != NULL)
-					&& (lnode->nodeloc != NULL))
-				    duplicate = TRUE;
-			     }
-
-			     else if (!(orignet & NO_NET) &&
-					((orignet & ROUTED_NET_MASK) != (u_int)0)) {
-
-				// Net was assigned to other net, but is inside
-				// this pin's geometry.  Declare point to be
-				// unroutable, as it is too close to both pins.
-				// NOTE:  This is a conservative rule and could
-				// potentially make a pin unroutable.
-				// Another note:  By setting Obs[] to
-				// OBSTRUCT_MASK as well as NO_NET, we ensure
-				// that it falls through on all subsequent
-				// processing.
-
-				if (is_testpoint(gridx, gridy, g, i, ds) != NULL)
-				    Fprintf(stderr, " Position is inside pin but cannot "
-					    "be routed without causing violation.\n");
-				disable_gridpos(gridx, gridy, ds->layer);
-				gridy++;
-				continue;
-			     }
-
-			     if (!(orignet & NO_NET)) {
-
-				// A grid point that is within 1/2 route width
-				// of a tap rectangle corner can violate metal
-				// width rules, and so should declare a stub.
-				
-				mask = 0;
-				dir = 0;
-				dist = 0.0;
-			        xdist = 0.5 * LefGetRouteWidth(ds->layer);
-
-				if (dx >= ds->x2 - xdist) {
-				   if (dy > ds->y2 - xdist + EPS) {
-				      // Check northeast corner
-
-				      if ((ds->x2 - dx) > (ds->y2 - dy)) {
-					 // West-pointing stub
-					 mask = STUBROUTE;
-					 dir = NI_STUB_EW;
-					 dist = ds->x2 - dx - 2.0 * xdist;
-				      }
-				      else {
-					 // South-pointing stub
-					 mask = STUBROUTE;
-					 dir = NI_STUB_NS;
-					 dist = ds->y2 - dy - 2.0 * xdist;
-				      }
+				}
+				else if (dy < ds->y1 + xdist - EPS) {
+				   // Check southeast corner
 
+				   if ((ds->x2 - dx) > (dy - ds->y1)) {
+				      // West-pointing stub
+				      mask = STUBROUTE;
+				      dir = NI_STUB_EW;
+				      dist = ds->x2 - dx - 2.0 * xdist;
 				   }
-				   else if (dy < ds->y1 + xdist - EPS) {
-				      // Check southeast corner
-
-				      if ((ds->x2 - dx) > (dy - ds->y1)) {
-					 // West-pointing stub
-					 mask = STUBROUTE;
-					 dir = NI_STUB_EW;
-					 dist = ds->x2 - dx - 2.0 * xdist;
-				      }
-				      else {
-					 // North-pointing stub
-					 mask = STUBROUTE;
-					 dir = NI_STUB_NS;
-					 dist = ds->y1 - dy + 2.0 * xdist;
-				      }
+				   else {
+				      // North-pointing stub
+				      mask = STUBROUTE;
+				      dir = NI_STUB_NS;
+				      dist = ds->y1 - dy + 2.0 * xdist;
 				   }
 				}
-				else if (dx <= ds->x1 + xdist) {
-				   if (dy > ds->y2 - xdist + EPS) {
-				      // Check northwest corner
-
-				      if ((dx - ds->x1) > (ds->y2 - dy)) {
-					 // East-pointing stub
-					 mask = STUBROUTE;
-					 dir = NI_STUB_EW;
-					 dist = ds->x1 - dx + 2.0 * xdist;
-				      }
-				      else {
-					 // South-pointing stub
-					 mask = STUBROUTE;
-					 dir = NI_STUB_NS;
-					 dist = ds->y2 - dy - 2.0 * xdist;
-				      }
+			     }
+			     else if (dx <= ds->x1 + xdist) {
+				if (dy > ds->y2 - xdist + EPS) {
+				   // Check northwest corner
 
+				   if ((dx - ds->x1) > (ds->y2 - dy)) {
+				      // East-pointing stub
+				      mask = STUBROUTE;
+				      dir = NI_STUB_EW;
+				      dist = ds->x1 - dx + 2.0 * xdist;
 				   }
-				   else if (dy < ds->y1 + xdist - EPS) {
-				      // Check southwest corner
-
-				      if ((dx - ds->x2) > (dy - ds->y1)) {
-					 // East-pointing stub
-					 mask = STUBROUTE;
-					 dir = NI_STUB_EW;
-					 dist = ds->x1 - dx + 2.0 * xdist;
-				      }
-				      else {
-					 // North-pointing stub
-					 mask = STUBROUTE;
-					 dir = NI_STUB_NS;
-					 dist = ds->y1 - dy + 2.0 * xdist;
-				      }
+				   else {
+				      // South-pointing stub
+				      mask = STUBROUTE;
+				      dir = NI_STUB_NS;
+				      dist = ds->y2 - dy - 2.0 * xdist;
 				   }
-				}
 
-				if (!duplicate) {
-			           OBSVAL(gridx, gridy, ds->layer)
-			        	= (OBSVAL(gridx, gridy, ds->layer)
-					   & BLOCKED_MASK) | (u_int)node->netnum | mask;
-				   if (!lnode)
-				      lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						node);
-				   lnode->nodeloc = node;
-				   lnode->nodesav = node;
-				   lnode->stub = dist;
-				   lnode->flags |= dir;
 				}
+				else if (dy < ds->y1 + xdist - EPS) {
+				   // Check southwest corner
 
-				/* If a horizontal or vertical via fits completely */
-				/* inside the pin but the other orientation	   */
-				/* doesn't, then mark as prohibiting the other	   */
-				/* orientation.					   */
-
-				vwx = LefGetXYViaWidth(ds->layer, ds->layer, 0, 0) / 2.0;
-				vwy = LefGetXYViaWidth(ds->layer, ds->layer, 1, 0) / 2.0;
-				if ((dx - vwx > ds->x1 - EPS) &&
-					(dx + vwx < ds->x2 + EPS) &&
-				    	(dy - vwy > ds->y1 - EPS) &&
-					(dy + vwy < ds->y2 + EPS)) {
-				    o0okay = TRUE;
-				} else {
-				    o0okay = FALSE;
-				}
-				vwx = LefGetXYViaWidth(ds->layer, ds->layer, 0, 2) / 2.0;
-				vwy = LefGetXYViaWidth(ds->layer, ds->layer, 1, 2) / 2.0;
-				if ((dx - vwx > ds->x1 - EPS) &&
-					(dx + vwx < ds->x2 + EPS) &&
-				    	(dy - vwy > ds->y1 - EPS) &&
-					(dy + vwy < ds->y2 + EPS)) {
-				    o2okay = TRUE;
-				} else {
-				    o2okay = FALSE;
+				   if ((dx - ds->x2) > (dy - ds->y1)) {
+				      // East-pointing stub
+				      mask = STUBROUTE;
+				      dir = NI_STUB_EW;
+				      dist = ds->x1 - dx + 2.0 * xdist;
+				   }
+				   else {
+				      // North-pointing stub
+				      mask = STUBROUTE;
+				      dir = NI_STUB_NS;
+				      dist = ds->y1 - dy + 2.0 * xdist;
+				   }
 				}
-				if ((o0okay == TRUE) && (o2okay == FALSE))
-				    lnode->flags |= NI_NO_VIAY;
-				else if ((o0okay == FALSE) && (o2okay == TRUE))
-				    lnode->flags |= NI_NO_VIAX;
 			     }
-			     else if ((orignet & NO_NET) && ((orignet & OBSTRUCT_MASK)
-					!= OBSTRUCT_MASK)) {
-				/* Handled on next pass */
+
+			     if (!duplicate) {
+				OBSVAL(gridx, gridy, ds->layer)
+				     = (OBSVAL(gridx, gridy, ds->layer)
+					& BLOCKED_MASK) | (u_int)node->netnum | mask;
+				if (!lnode)
+				   lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     node);
+				lnode->nodeloc = node;
+				lnode->nodesav = node;
+				lnode->stub = dist;
+				lnode->flags |= dir;
 			     }
 
-			     // Check that we have not created a PINOBSTRUCT
-			     // route directly over this point.
-			     if ((!duplicate) && (ds->layer < Num_layers - 1)) {
-			        k = OBSVAL(gridx, gridy, ds->layer + 1);
-			        if (k & PINOBSTRUCTMASK) {
-			           if ((k & ROUTED_NET_MASK) != (u_int)node->netnum) {
-				       OBSVAL(gridx, gridy, ds->layer + 1) = NO_NET;
-				       FreeNodeinfo(gridx, gridy, ds->layer + 1);
-				   }
+			     /* If a horizontal or vertical via fits completely */
+			     /* inside the pin but the other orientation	   */
+			     /* doesn't, then mark as prohibiting the other	   */
+			     /* orientation.					   */
+
+			     vwx = PinRule[ds->layer].viawidth[0][0] / 2.0;
+			     vwy = PinRule[ds->layer].viawidth[1][0] / 2.0;
+			     if ((dx - vwx > ds->x1 - EPS) &&
+				     (dx + vwx < ds->x2 + EPS) &&
+				     (dy - vwy > ds->y1 - EPS) &&
+				     (dy + vwy < ds->y2 + EPS)) {
+				 o0okay = TRUE;
+			     } else {
+				 o0okay = FALSE;
+			     }
+			     vwx = PinRule[ds->layer].viawidth[0][2] / 2.0;
+			     vwy = PinRule[ds->layer].viawidth[1][2] / 2.0;
+			     if ((dx - vwx > ds->x1 - EPS) &&
+				     (dx + vwx < ds->x2 + EPS) &&
+				     (dy - vwy > ds->y1 - EPS) &&
+				     (dy + vwy < ds->y2 + EPS)) {
+				 o2okay = TRUE;
+			     } else {
+				 o2okay = FALSE;
+			     }
+			     if ((o0okay == TRUE) && (o2okay == FALSE))
+				 lnode->flags |= NI_NO_VIAY;
+			     else if ((o0okay == FALSE) && (o2okay == TRUE))
+				 lnode->flags |= NI_NO_VIAX;
+			  }
+			  else if ((orignet & NO_NET) && ((orignet & OBSTRUCT_MASK)
+				     != OBSTRUCT_MASK)) {
+			     /* Handled on next pass */
+			  }
+
+			  // Check that we have not created a PINOBSTRUCT
+			  // route directly over this point.
+			  if ((!duplicate) && (ds->layer < Num_layers - 1)) {
+			     k = OBSVAL(gridx, gridy, ds->layer + 1);
+			     if (k & PINOBSTRUCTMASK) {
+				if ((k & ROUTED_NET_MASK) != (u_int)node->netnum) {
+				    OBSVAL(gridx, gridy, ds->layer + 1) = NO_NET;
+				    FreeNodeinfo(gridx, gridy, ds->layer + 1);
 				}
 			     }
-			 }
-		         gridy++;
+			  }
 		      }
+		      gridy++;
 		   }
-		   gridx++;
 		}
+		gridx++;
 	     }
 	  }
        }
     }
-
-} /* void create_obstructions_inside_nodes( void ) */
+}
 
 /*--------------------------------------------------------------*/
-/* create_obstructions_outside_nodes()				*/
+/* create_obstructions_inside_nodes()				*/
 /*								*/
 /*  Fills in the Obs[][] grid from the position of each node	*/
 /*  (net terminal), which may have multiple unconnected		*/
@@ -1500,8 +2491,7 @@ void create_obstructions_inside_nodes(void)
 /*  unroutable.							*/
 /*								*/
 /*  This routine is split into two passes.  This pass adds	*/
-/*  information for points outside node regions but close	*/
-/*  enough to interact with the node.				*/
+/*  information for points inside node regions.			*/
 /*								*/
 /*  ARGS: none.							*/
 /*  RETURNS: nothing						*/
@@ -1510,15 +2500,28 @@ void create_obstructions_inside_nodes(void)
 /*	Beccue.							*/
 /*--------------------------------------------------------------*/
 
+void create_obstructions_inside_nodes(void)
+{
+    run_gate_pass(create_obstructions_inside_gate);
 
-void create_obstructions_outside_nodes(void)
+} /* void create_obstructions_inside_nodes( void ) */
+
+/*--------------------------------------------------------------*/
+/* create_obstructions_outside_gate()				*/
+/*								*/
+/*  The part of create_obstructions_outside_nodes() done for	*/
+/*  each gate.							*/
+/*--------------------------------------------------------------*/
+
+static void
+create_obstructions_outside_gate(GATE g)
 {
     NODE node, n2;
     NODEINFO lnode;
-    GATE g;
     DSEG ds;
     DPOINT tpoint;
-    u_int dir, mask, k;
+    u_int dir;
+    obsword mask, k;
     int i, gridx, gridy, orient;
     double dx, dy, xdist, deltax, deltay;
     float dist;
@@ -1532,1220 +2535,1227 @@ void create_obstructions_outside_nodes(void)
     // flag bit, so that the position can be ignored when routing the net
     // associated with the pin.  Normal obstructions take precedence.
 
-    for (g = Nlgates; g; g = g->next) {
-       for (i = 0; i < g->nodes; i++) {
-	  if (g->netnum[i] != 0) {
-
-	     // Get the node record associated with this pin.
-	     node = g->noderec[i];
-	     if (node == NULL) continue;
-
-	     // Repeat this whole exercise for areas in the halo outside
-	     // the node geometry.  We have to do this after enumerating
-	     // all inside areas because the tap rectangles often overlap,
-	     // and one rectangle's halo may be inside another tap.
-
-	     orient = 0;
-             for (ds = g->taps[i];; ds = ds->next) {
-		if (ds == NULL) {
-		    if (orient == 2)
-			break;
-		    else {
-			orient = 2;
-			ds = g->taps[i];
-			if (ds == NULL) break;
-		    }
-		}
+    for (i = 0; i < g->nodes; i++) {
+       if (g->netnum[i] != 0) {
+
+	  // Get the node record associated with this pin.
+	  node = g->noderec[i];
+	  if (node == NULL) continue;
+
+	  // Repeat this whole exercise for areas in the halo outside
+	  // the node geometry.  We have to do this after enumerating
+	  // all inside areas because the tap rectangles often overlap,
+	  // and one rectangle's halo may be inside another tap.
+
+	  orient = 0;
+	  for (ds = g->taps[i];; ds = ds->next) {
+	     if (ds == NULL) {
+		 if (orient == 2)
+		     break;
+		 else {
+		     orient = 2;
+		     ds = g->taps[i];
+		     if (ds == NULL) break;
+		 }
+	     }
 
-		// Note:  Should be handling get_route_clear as a less
-		// restrictive case, as was done above.
+	     // Note:  Should be handling get_route_clear as a less
+	     // restrictive case, as was done above.
  
-		deltax = get_via_clear(ds->layer, 1, orient, ds);
-		gridx = (int)((ds->x1 - Xlowerbound - deltax) / PitchX) - 1;
-		if (gridx < 0) gridx = 0;
-
-		while (1) {
-		   dx = (gridx * PitchX) + Xlowerbound;
-
-		   // Check if obstruction position is too close for
-		   // a via in either orientation.  The position can
-		   // be marked as prohibiting one orientation or the
-		   // other.
-
-		   if (((dx + EPS) > (ds->x2 + deltax)) ||
-				(gridx >= NumChannelsX))
-		      break;
-
-		   else if ((dx - EPS) > (ds->x1 - deltax) && gridx >= 0) {
-		      deltay = get_via_clear(ds->layer, 0, orient, ds);
-		      gridy = (int)((ds->y1 - Ylowerbound - deltay) / PitchY) - 1;
-		      if (gridy < 0) gridy = 0;
-
-		      while (1) {
-		         dy = (gridy * PitchY) + Ylowerbound;
-
-		         if (((dy + EPS) > (ds->y2 + deltay)) ||
-				(gridy >= NumChannelsY))
-			    break;
-
-			 // 2nd pass on area inside defined pin geometry,
-			 // allowing terminal connections to be made using
-			 // an offset tap, where possible.
-
-			 if ((dy >= ds->y1 && gridy >= 0) && (dx >= ds->x1)
-					&& (dy <= ds->y2) && (dx <= ds->x2)) {
-			     int orignet = OBSVAL(gridx, gridy, ds->layer);
-
-			     if ((orignet & ROUTED_NET_MASK) == (u_int)node->netnum) {
-
-				// Duplicate tap point.   Don't re-process it.
-				gridy++;
-				continue;
+	     deltax = pin_via_clear(ds->layer, 1, orient, ds);
+	     gridx = (int)((ds->x1 - Xlowerbound - deltax) / PitchX) - 1;
+	     if (gridx < 0) gridx = 0;
+
+	     while (1) {
+		dx = (gridx * PitchX) + Xlowerbound;
+
+		// Check if obstruction position is too close for
+		// a via in either orientation.  The position can
+		// be marked as prohibiting one orientation or the
+		// other.
+
+		if (((dx + EPS) > (ds->x2 + deltax)) ||
+			     (gridx >= NumChannelsX))
+		   break;
+
+		else if ((dx - EPS) > (ds->x1 - deltax) && gridx >= 0) {
+		   deltay = pin_via_clear(ds->layer, 0, orient, ds);
+		   gridy = (int)((ds->y1 - Ylowerbound - deltay) / PitchY) - 1;
+		   if (gridy < 0) gridy = 0;
+
+		   while (1) {
+		      dy = (gridy * PitchY) + Ylowerbound;
+
+		      if (((dy + EPS) > (ds->y2 + deltay)) ||
+			     (gridy >= NumChannelsY))
+			 break;
+
+		      // 2nd pass on area inside defined pin geometry,
+		      // allowing terminal connections to be made using
+		      // an offset tap, where possible.
+
+		      if ((dy >= ds->y1 && gridy >= 0) && (dx >= ds->x1)
+				     && (dy <= ds->y2) && (dx <= ds->x2)) {
+			  obsword orignet = OBSVAL(gridx, gridy, ds->layer);
+
+			  if ((orignet & ROUTED_NET_MASK) == (u_int)node->netnum) {
+
+			     // Duplicate tap point.   Don't re-process it.
+			     gridy++;
+			     continue;
+			  }
+
+			  if (!(orignet & NO_NET) &&
+				     ((orignet & ROUTED_NET_MASK) != (u_int)0)) {
+			     /* Do nothing;  previously handled */
+			  }
+
+			  else if ((orignet & NO_NET) && ((orignet & OBSTRUCT_MASK)
+				     != OBSTRUCT_MASK)) {
+			     double sdistxx, sdistxy, sdistyx, sdistyy;
+			     float offdx, offdy;
+			     ObsInfoRec *offdptr;
+
+			     // width of horizontal via
+			     sdistxx = PinRule[ds->layer].viawidth[0][0] / 2.0 +
+				     PinRule[ds->layer].spacing;
+			     // width of vertical via
+			     sdistxy = PinRule[ds->layer].viawidth[0][2] / 2.0 +
+				     PinRule[ds->layer].spacing;
+			     // height of horizontal via
+			     sdistyx = PinRule[ds->layer].viawidth[1][0] / 2.0 +
+				     PinRule[ds->layer].spacing;
+			     // height of vertical via
+			     sdistyy = PinRule[ds->layer].viawidth[1][2] / 2.0 +
+				     PinRule[ds->layer].spacing;
+
+			     // Define a maximum offset we can have in X or
+			     // Y above which the placement of a via will
+			     // cause a DRC violation with a wire in the
+			     // adjacent route track in the direction of the
+			     // offset.
+
+			     int maxerr = 0;
+
+			     // If a cell is positioned off-grid, then a grid
+			     // point may be inside a pin and still be unroutable.
+			     // The Obsinfo[] array tells where an obstruction is,
+			     // if there was only one obstruction in one direction
+			     // blocking the grid point.  If so, then we set the
+			     // Nodeinfo.stub[] distance to move the tap away from
+			     // the obstruction to resolve the DRC error.
+
+			     // Make sure we have marked this as a node.
+			     lnode = SetNodeinfo(gridx, gridy, ds->layer, node);
+			     lnode->nodeloc = node;
+			     lnode->nodesav = node;
+			     OBSVAL(gridx, gridy, ds->layer)
+				     = (OBSVAL(gridx, gridy, ds->layer)
+					& BLOCKED_MASK) | (u_int)node->netnum;
+
+			     offdptr = &(OBSINFO(gridx, gridy, ds->layer));
+			     offdx = offdptr->xoffset;
+			     offdy = offdptr->yoffset;
+
+			     // If obstruction is on a corner (NE, SW, etc.) then
+			     // only look at the case with the smaller offset
+			     // required.
+
+			     if ((orignet & (OBSTRUCT_N | OBSTRUCT_S)) &&
+				     (orignet & (OBSTRUCT_E | OBSTRUCT_W))) {
+				 if (offdy > offdx)
+				     orignet &= ~(OBSTRUCT_E | OBSTRUCT_W);
+				 else
+				     orignet &= ~(OBSTRUCT_N | OBSTRUCT_S);
 			     }
 
-			     if (!(orignet & NO_NET) &&
-					((orignet & ROUTED_NET_MASK) != (u_int)0)) {
-				/* Do nothing;  previously handled */
-			     }
+			     if (orignet & OBSTRUCT_N) {
+				if (sdistyy - offdy > EPS) {
+				   lnode->flags |= NI_NO_VIAY;
+				   if (sdistyx - offdy > EPS) {
+				      /* Cannot route cleanly, so use offset */
+				      if (offdy - sdistyx > PitchY / 2.0) 
+					 /* Offset distance is too large */
+					 maxerr = 1;
+				      else {
 
-			     else if ((orignet & NO_NET) && ((orignet & OBSTRUCT_MASK)
-					!= OBSTRUCT_MASK)) {
-				double sdistxx, sdistxy, sdistyx, sdistyy;
-				float offdx, offdy;
-				ObsInfoRec *offdptr;
-
-				// width of horizontal via
-				sdistxx = LefGetXYViaWidth(ds->layer, ds->layer,
-					0, 0) / 2.0 +
-					LefGetRouteSpacing(ds->layer);
-				// width of vertical via
-				sdistxy = LefGetXYViaWidth(ds->layer, ds->layer,
-					0, 2) / 2.0 +
-					LefGetRouteSpacing(ds->layer);
-				// height of horizontal via
-				sdistyx = LefGetXYViaWidth(ds->layer, ds->layer,
-					1, 0) / 2.0 +
-					LefGetRouteSpacing(ds->layer);
-				// height of vertical via
-				sdistyy = LefGetXYViaWidth(ds->layer, ds->layer,
-					1, 2) / 2.0 +
-					LefGetRouteSpacing(ds->layer);
-
-				// Define a maximum offset we can have in X or
-				// Y above which the placement of a via will
-				// cause a DRC violation with a wire in the
-				// adjacent route track in the direction of the
-				// offset.
-
-				int maxerr = 0;
-
-				// If a cell is positioned off-grid, then a grid
-				// point may be inside a pin and still be unroutable.
-				// The Obsinfo[] array tells where an obstruction is,
-				// if there was only one obstruction in one direction
-				// blocking the grid point.  If so, then we set the
-				// Nodeinfo.stub[] distance to move the tap away from
-				// the obstruction to resolve the DRC error.
-
-				// Make sure we have marked this as a node.
-				lnode = SetNodeinfo(gridx, gridy, ds->layer, node);
-				lnode->nodeloc = node;
-				lnode->nodesav = node;
-			        OBSVAL(gridx, gridy, ds->layer)
-			        	= (OBSVAL(gridx, gridy, ds->layer)
-					   & BLOCKED_MASK) | (u_int)node->netnum;
-
-			        offdptr = &(OBSINFO(gridx, gridy, ds->layer));
-			        offdx = offdptr->xoffset;
-			        offdy = offdptr->yoffset;
-
-				// If obstruction is on a corner (NE, SW, etc.) then
-				// only look at the case with the smaller offset
-				// required.
-
-				if ((orignet & (OBSTRUCT_N | OBSTRUCT_S)) &&
-					(orignet & (OBSTRUCT_E | OBSTRUCT_W))) {
-				    if (offdy > offdx)
-					orignet &= ~(OBSTRUCT_E | OBSTRUCT_W);
-				    else
-					orignet &= ~(OBSTRUCT_N | OBSTRUCT_S);
-				}
+					 OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
+					 lnode->offset = offdy - sdistyx;
+					 lnode->flags |= NI_OFFSET_NS;
 
-				if (orignet & OBSTRUCT_N) {
-				   if (sdistyy - offdy > EPS) {
-				      lnode->flags |= NI_NO_VIAY;
-				      if (sdistyx - offdy > EPS) {
-					 /* Cannot route cleanly, so use offset */
-				         if (offdy - sdistyx > PitchY / 2.0) 
-					    /* Offset distance is too large */
-					    maxerr = 1;
-					 else {
-
-			                    OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
-				            lnode->offset = offdy - sdistyx;
-				            lnode->flags |= NI_OFFSET_NS;
-
-				            /* If position above has obstruction, then */
-				            /* add up/down block to prevent vias.      */
-
-				            if ((ds->layer < Num_layers - 1) &&
-							(gridy > 0) &&
-							(OBSVAL(gridx, gridy - 1,
-							ds->layer + 1) & OBSTRUCT_MASK)) {
-					       block_route(gridx, gridy, ds->layer, UP);
-					    }
+					 /* If position above has obstruction, then */
+					 /* add up/down block to prevent vias.      */
+
+					 if ((ds->layer < Num_layers - 1) &&
+						     (gridy > 0) &&
+						     (OBSVAL(gridx, gridy - 1,
+						     ds->layer + 1) & OBSTRUCT_MASK)) {
+					    block_route(gridx, gridy, ds->layer, UP);
 					 }
 				      }
 				   }
 				}
-				else if (orignet & OBSTRUCT_S) {
-				   if (sdistyy - offdy > EPS) {
-				      lnode->flags |= NI_NO_VIAY;
-				      if (sdistyx - offdy > EPS) {
-				         if (offdy - sdistyx > PitchY / 2.0)
-					    /* Offset distance is too large */
-					    maxerr = 1;
-					 else {
-			                    OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
-				            lnode->offset = sdistyx - offdy;
-				            lnode->flags |= NI_OFFSET_NS;
-
-				            /* If position above has obstruction, then */
-				            /* add up/down block to prevent vias.      */
-
-				             if ((ds->layer < Num_layers - 1) &&
-							(gridy < NumChannelsY - 1) &&
-						   	(OBSVAL(gridx, gridy + 1,
-							ds->layer + 1) & OBSTRUCT_MASK)) {
-					        block_route(gridx, gridy, ds->layer, UP);
-					     }
-					 }
+			     }
+			     else if (orignet & OBSTRUCT_S) {
+				if (sdistyy - offdy > EPS) {
+				   lnode->flags |= NI_NO_VIAY;
+				   if (sdistyx - offdy > EPS) {
+				      if (offdy - sdistyx > PitchY / 2.0)
+					 /* Offset distance is too large */
+					 maxerr = 1;
+				      else {
+					 OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
+					 lnode->offset = sdistyx - offdy;
+					 lnode->flags |= NI_OFFSET_NS;
+
+					 /* If position above has obstruction, then */
+					 /* add up/down block to prevent vias.      */
+
+					  if ((ds->layer < Num_layers - 1) &&
+						     (gridy < NumChannelsY - 1) &&
+						     (OBSVAL(gridx, gridy + 1,
+						     ds->layer + 1) & OBSTRUCT_MASK)) {
+					     block_route(gridx, gridy, ds->layer, UP);
+					  }
 				      }
 				   }
 				}
-				else if (orignet & OBSTRUCT_E) {
-				   if (sdistxx - offdx > EPS) {
-				      lnode->flags |= NI_NO_VIAX;
-				      if (sdistxy - offdx > EPS) {
-				         if (offdx - sdistxy > PitchX / 2.0)
-					    /* Offset distance is too large */
-					    maxerr = 1;
-					 else {
-			                    OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
-				            lnode->offset = offdx - sdistxy;
-				            lnode->flags |= NI_OFFSET_EW;
-
-				            /* If position above has obstruction, then */
-				            /* add up/down block to prevent vias.      */
-
-				             if ((ds->layer < Num_layers - 1) &&
-							(gridx > 0) &&
-							(OBSVAL(gridx - 1, gridy,
-							ds->layer + 1) & OBSTRUCT_MASK)) {
-					        block_route(gridx, gridy, ds->layer, UP);
-					     }
-					 }
+			     }
+			     else if (orignet & OBSTRUCT_E) {
+				if (sdistxx - offdx > EPS) {
+				   lnode->flags |= NI_NO_VIAX;
+				   if (sdistxy - offdx > EPS) {
+				      if (offdx - sdistxy > PitchX / 2.0)
+					 /* Offset distance is too large */
+					 maxerr = 1;
+				      else {
+					 OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
+					 lnode->offset = offdx - sdistxy;
+					 lnode->flags |= NI_OFFSET_EW;
+
+					 /* If position above has obstruction, then */
+					 /* add up/down block to prevent vias.      */
+
+					  if ((ds->layer < Num_layers - 1) &&
+						     (gridx > 0) &&
+						     (OBSVAL(gridx - 1, gridy,
+						     ds->layer + 1) & OBSTRUCT_MASK)) {
+					     block_route(gridx, gridy, ds->layer, UP);
+					  }
 				      }
 				   }
 				}
-				else if (orignet & OBSTRUCT_W) {
-				   if (sdistxx - offdx > EPS) {
-				      lnode->flags |= NI_NO_VIAX;
-				      if (sdistxy - offdx > EPS) {
-				         if (offdx - sdistxy > PitchX / 2.0)
-					    /* Offset distance is too large */
-					    maxerr = 1;
-					 else {
-			                    OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
-				            lnode->offset = sdistxy - offdx;
-				            lnode->flags |= NI_OFFSET_EW;
-
-				            /* If position above has obstruction, then */
-				            /* add up/down block to prevent vias.      */
-
-				            if ((ds->layer < Num_layers - 1) &&
-							(gridx < NumChannelsX - 1) &&
-							(OBSVAL(gridx + 1, gridy,
-							ds->layer + 1) & OBSTRUCT_MASK)) {
-					       block_route(gridx, gridy, ds->layer, UP);
-					    }
+			     }
+			     else if (orignet & OBSTRUCT_W) {
+				if (sdistxx - offdx > EPS) {
+				   lnode->flags |= NI_NO_VIAX;
+				   if (sdistxy - offdx > EPS) {
+				      if (offdx - sdistxy > PitchX / 2.0)
+					 /* Offset distance is too large */
+					 maxerr = 1;
+				      else {
+					 OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
+					 lnode->offset = sdistxy - offdx;
+					 lnode->flags |= NI_OFFSET_EW;
+
+					 /* If position above has obstruction, then */
+					 /* add up/down block to prevent vias.      */
+
+					 if ((ds->layer < Num_layers - 1) &&
+						     (gridx < NumChannelsX - 1) &&
+						     (OBSVAL(gridx + 1, gridy,
+						     ds->layer + 1) & OBSTRUCT_MASK)) {
+					    block_route(gridx, gridy, ds->layer, UP);
 					 }
 				      }
 				   }
 				}
+			     }
 
-			        if (maxerr == 1) {
-				    if (is_testpoint(gridx, gridy, g, i, ds) != NULL)
-					Fprintf(stderr,
-					    "Attempted to clear obstruction with"
-					    " offset, but offset is more than 1/2"
-					    " route pitch.\n");
-				    disable_gridpos(gridx, gridy, ds->layer);
-				}
-
-				// Diagnostic
-				else if (Verbose > 3)
-				   Fprintf(stderr, "Port overlaps obstruction"
-					" at grid %d %d, position %g %g\n",
-					gridx, gridy, dx, dy);
+			     if (maxerr == 1) {
+				 if (is_testpoint(gridx, gridy, g, i, ds) != NULL)
+				     Fprintf(stderr,
+					 "Attempted to clear obstruction with"
+					 " offset, but offset is more than 1/2"
+					 " route pitch.\n");
+				 disable_gridpos(gridx, gridy, ds->layer);
 			     }
+
+			     // Diagnostic
+			     else if (Verbose > 3)
+				Fprintf(stderr, "Port overlaps obstruction"
+				     " at grid %d %d, position %g %g\n",
+				     gridx, gridy, dx, dy);
+			  }
+		      }
+
+		      if ((dy - EPS) > (ds->y1 - deltay) && gridy >= 0) {
+
+			 double s, edist, xp, yp;
+			 unsigned char epass = 0;
+
+			 // Area inside halo around defined pin geometry.
+			 // Exclude areas already processed (areas inside
+			 // some pin geometry have been marked with netnum)
+
+			 // Also check that we are not about to define a
+			 // route position for a pin on a layer above 0 that
+			 // blocks a pin underneath it.
+
+			 // Flag positions that pass a Euclidean distance check.
+			 // epass = 1 indicates that position clears a
+			 // Euclidean distance measurement.
+
+			 s = PinRule[ds->layer].spacing;
+
+			 if (dx < (ds->x1 + s - deltax)) {
+			     xp = dx + deltax - s;
+			     edist = (ds->x1 - xp) * (ds->x1 - xp);
+			 }
+			 else if (dx > (ds->x2 - s + deltax)) {
+			     xp = dx - deltax + s;
+			     edist = (xp - ds->x2) * (xp - ds->x2);
+			 }
+			 else edist = 0;
+			 if ((edist > 0) && (dy < (ds->y1 + s - deltay))) {
+			     yp = dy + deltay - s;
+			     edist += (ds->y1 - yp) * (ds->y1 - yp);
+			 }
+			 else if ((edist > 0) && (dy > (ds->y2 - s + deltay))) {
+			     yp = dy - deltay + s;
+			     edist += (yp - ds->y2) * (yp - ds->y2);
 			 }
+			 else edist = 0;
+			 if ((edist + EPS) > (s * s)) epass = 1;
 
-		         if ((dy - EPS) > (ds->y1 - deltay) && gridy >= 0) {
+			 xdist = 0.5 * PinRule[ds->layer].width;
 
-			    double s, edist, xp, yp;
-			    unsigned char epass = 0;
+			 n2 = NULL;
+			 if (ds->layer > 0) {
+			    lnode = NODEIPTR(gridx, gridy, ds->layer - 1);
+			    n2 = (lnode) ? lnode->nodeloc : NULL;
+			 }
+			 if (n2 == NULL) {
+			    lnode = NODEIPTR(gridx, gridy, ds->layer);
+			    n2 = (lnode) ? lnode->nodeloc : NULL;
+			 }
+			 else {
+			    // Watch out for the case where a tap crosses
+			    // over a different tap.  Don't treat the tap
+			    // on top as if it is not there!
 
-			    // Area inside halo around defined pin geometry.
-			    // Exclude areas already processed (areas inside
-			    // some pin geometry have been marked with netnum)
+			    NODE n3;
+			    lnode = NODEIPTR(gridx, gridy, ds->layer);
+			    n3 = (lnode) ? lnode->nodeloc : NULL;
+			    if (n3 != NULL && n3 != node) n2 = n3;
+			 }
 
-			    // Also check that we are not about to define a
-			    // route position for a pin on a layer above 0 that
-			    // blocks a pin underneath it.
+			 // Ignore my own node.
+			 if (n2 == node) n2 = NULL;
 
-			    // Flag positions that pass a Euclidean distance check.
-			    // epass = 1 indicates that position clears a
-			    // Euclidean distance measurement.
+			 k = OBSVAL(gridx, gridy, ds->layer);
 
-			    s = LefGetRouteSpacing(ds->layer);
+			 // In case of a port that is inaccessible from a grid
+			 // point, or not completely overlapping it, the
+			 // stub information will show how to adjust the
+			 // route position to cleanly attach to the port.
 
-			    if (dx < (ds->x1 + s - deltax)) {
-				xp = dx + deltax - s;
-				edist = (ds->x1 - xp) * (ds->x1 - xp);
-			    }
-			    else if (dx > (ds->x2 - s + deltax)) {
-				xp = dx - deltax + s;
-				edist = (xp - ds->x2) * (xp - ds->x2);
-			    }
-			    else edist = 0;
-			    if ((edist > 0) && (dy < (ds->y1 + s - deltay))) {
-				yp = dy + deltay - s;
-				edist += (ds->y1 - yp) * (ds->y1 - yp);
-			    }
-			    else if ((edist > 0) && (dy > (ds->y2 - s + deltay))) {
-				yp = dy - deltay + s;
-				edist += (yp - ds->y2) * (yp - ds->y2);
-			    }
-			    else edist = 0;
-			    if ((edist + EPS) > (s * s)) epass = 1;
+			 mask = STUBROUTE;
+			 dir = NI_STUB_NS | NI_STUB_EW;
+			 dist = 0.0;
 
-			    xdist = 0.5 * LefGetRouteWidth(ds->layer);
+			 if (((k & ROUTED_NET_MASK) != (u_int)node->netnum)
+				     && (n2 == NULL)) {
 
-			    n2 = NULL;
-			    if (ds->layer > 0) {
-			       lnode = NODEIPTR(gridx, gridy, ds->layer - 1);
-			       n2 = (lnode) ? lnode->nodeloc : NULL;
-			    }
-			    if (n2 == NULL) {
-			       lnode = NODEIPTR(gridx, gridy, ds->layer);
-			       n2 = (lnode) ? lnode->nodeloc : NULL;
-			    }
-			    else {
-			       // Watch out for the case where a tap crosses
-			       // over a different tap.  Don't treat the tap
-			       // on top as if it is not there!
+			     if ((k & OBSTRUCT_MASK) != 0) {
+				ObsInfoRec *obsinfoptr;
+				float sdistx, sdisty;
 
-			       NODE n3;
-			       lnode = NODEIPTR(gridx, gridy, ds->layer);
-			       n3 = (lnode) ? lnode->nodeloc : NULL;
-			       if (n3 != NULL && n3 != node) n2 = n3;
-			    }
+				obsinfoptr = &(OBSINFO(gridx, gridy, ds->layer));
+				sdistx = obsinfoptr->xoffset;
+				sdisty = obsinfoptr->yoffset;
 
-			    // Ignore my own node.
-			    if (n2 == node) n2 = NULL;
-
-			    k = OBSVAL(gridx, gridy, ds->layer);
-
-			    // In case of a port that is inaccessible from a grid
-			    // point, or not completely overlapping it, the
-			    // stub information will show how to adjust the
-			    // route position to cleanly attach to the port.
-
-			    mask = STUBROUTE;
-			    dir = NI_STUB_NS | NI_STUB_EW;
-			    dist = 0.0;
-
-			    if (((k & ROUTED_NET_MASK) != (u_int)node->netnum)
-					&& (n2 == NULL)) {
-
-				if ((k & OBSTRUCT_MASK) != 0) {
-				   ObsInfoRec *obsinfoptr;
-				   float sdistx, sdisty;
-
-				   obsinfoptr = &(OBSINFO(gridx, gridy, ds->layer));
-				   sdistx = obsinfoptr->xoffset;
-				   sdisty = obsinfoptr->yoffset;
-
-				   // If the point is marked as close to an
-				   // obstruction, we can declare this an
-				   // offset tap if we are not on a corner.
-				   // Because we cannot define both an offset
-				   // and a stub simultaneously, if the distance
-				   // to clear the obstruction does not make the
-				   // route reach the tap, then we mark the grid
-				   // position as unroutable.
-
-				   if (dy >= (ds->y1 - xdist) &&
-						dy <= (ds->y2 + xdist)) {
-				      if ((dx >= ds->x2) &&
-						((k & OBSTRUCT_MASK) == OBSTRUCT_E)) {
-				         dist = sdistx - LefGetRouteKeepout(ds->layer);
-					 if ((dx - ds->x2 + dist) < xdist) {
-				 	    mask = OFFSET_TAP;
-				 	    dir = NI_OFFSET_EW;
-
-				            if ((ds->layer < Num_layers - 1) &&
-							(gridx > 0) &&
-							(OBSVAL(gridx - 1, gridy,
-							ds->layer + 1)
-							& OBSTRUCT_MASK)) {
-					       block_route(gridx, gridy, ds->layer, UP);
-					    }
+				// If the point is marked as close to an
+				// obstruction, we can declare this an
+				// offset tap if we are not on a corner.
+				// Because we cannot define both an offset
+				// and a stub simultaneously, if the distance
+				// to clear the obstruction does not make the
+				// route reach the tap, then we mark the grid
+				// position as unroutable.
+
+				if (dy >= (ds->y1 - xdist) &&
+					     dy <= (ds->y2 + xdist)) {
+				   if ((dx >= ds->x2) &&
+					     ((k & OBSTRUCT_MASK) == OBSTRUCT_E)) {
+				      dist = sdistx - PinRule[ds->layer].keepout;
+				      if ((dx - ds->x2 + dist) < xdist) {
+					 mask = OFFSET_TAP;
+					 dir = NI_OFFSET_EW;
+
+					 if ((ds->layer < Num_layers - 1) &&
+						     (gridx > 0) &&
+						     (OBSVAL(gridx - 1, gridy,
+						     ds->layer + 1)
+						     & OBSTRUCT_MASK)) {
+					    block_route(gridx, gridy, ds->layer, UP);
 					 }
 				      }
-				      else if ((dx <= ds->x1) &&
-						((k & OBSTRUCT_MASK) == OBSTRUCT_W)) {
-				         dist = LefGetRouteKeepout(ds->layer) - sdistx;
-					 if ((ds->x1 - dx - dist) < xdist) {
-				 	    mask = OFFSET_TAP;
-				            dir = NI_OFFSET_EW;
-
-				            if ((ds->layer < Num_layers - 1) &&
-							gridx <
-							(NumChannelsX - 1)
-							&& (OBSVAL(gridx + 1, gridy,
-							ds->layer + 1)
-							& OBSTRUCT_MASK)) {
-					       block_route(gridx, gridy, ds->layer, UP);
-					    }
+				   }
+				   else if ((dx <= ds->x1) &&
+					     ((k & OBSTRUCT_MASK) == OBSTRUCT_W)) {
+				      dist = PinRule[ds->layer].keepout - sdistx;
+				      if ((ds->x1 - dx - dist) < xdist) {
+					 mask = OFFSET_TAP;
+					 dir = NI_OFFSET_EW;
+
+					 if ((ds->layer < Num_layers - 1) &&
+						     gridx <
+						     (NumChannelsX - 1)
+						     && (OBSVAL(gridx + 1, gridy,
+						     ds->layer + 1)
+						     & OBSTRUCT_MASK)) {
+					    block_route(gridx, gridy, ds->layer, UP);
 					 }
 				      }
-			 	   }	
-				   if (dx >= (ds->x1 - xdist) &&
-						dx <= (ds->x2 + xdist)) {
-				      if ((dy >= ds->y2) &&
-						((k & OBSTRUCT_MASK) == OBSTRUCT_N)) {
-				         dist = sdisty - LefGetRouteKeepout(ds->layer);
-					 if ((dy - ds->y2 + dist) < xdist) {
-				 	    mask = OFFSET_TAP;
-				            dir = NI_OFFSET_NS;
-
-				            if ((ds->layer < Num_layers - 1) &&
-							gridy < 
-							(NumChannelsY - 1)
-							&& (OBSVAL(gridx, gridy - 1,
-							ds->layer + 1)
-							& OBSTRUCT_MASK)) {
-					       block_route(gridx, gridy, ds->layer, UP);
-					    }
+				   }
+				}	
+				if (dx >= (ds->x1 - xdist) &&
+					     dx <= (ds->x2 + xdist)) {
+				   if ((dy >= ds->y2) &&
+					     ((k & OBSTRUCT_MASK) == OBSTRUCT_N)) {
+				      dist = sdisty - PinRule[ds->layer].keepout;
+				      if ((dy - ds->y2 + dist) < xdist) {
+					 mask = OFFSET_TAP;
+					 dir = NI_OFFSET_NS;
+
+					 if ((ds->layer < Num_layers - 1) &&
+						     gridy < 
+						     (NumChannelsY - 1)
+						     && (OBSVAL(gridx, gridy - 1,
+						     ds->layer + 1)
+						     & OBSTRUCT_MASK)) {
+					    block_route(gridx, gridy, ds->layer, UP);
 					 }
 				      }
-				      else if ((dy <= ds->y1) &&
-						((k & OBSTRUCT_MASK) == OBSTRUCT_S)) {
-				         dist = LefGetRouteKeepout(ds->layer) - sdisty;
-					 if ((ds->y1 - dy - dist) < xdist) {
-				 	    mask = OFFSET_TAP;
-				            dir = NI_OFFSET_NS;
-
-				            if ((ds->layer < Num_layers - 1) &&
-							(gridy > 0) &&
-							(OBSVAL(gridx, gridy + 1,
-							ds->layer + 1)
-							& OBSTRUCT_MASK)) {
-					       block_route(gridx, gridy, ds->layer, UP);
-					    }
+				   }
+				   else if ((dy <= ds->y1) &&
+					     ((k & OBSTRUCT_MASK) == OBSTRUCT_S)) {
+				      dist = PinRule[ds->layer].keepout - sdisty;
+				      if ((ds->y1 - dy - dist) < xdist) {
+					 mask = OFFSET_TAP;
+					 dir = NI_OFFSET_NS;
+
+					 if ((ds->layer < Num_layers - 1) &&
+						     (gridy > 0) &&
+						     (OBSVAL(gridx, gridy + 1,
+						     ds->layer + 1)
+						     & OBSTRUCT_MASK)) {
+					    block_route(gridx, gridy, ds->layer, UP);
 					 }
 				      }
 				   }
-				   // Otherwise, dir is left as NI_STUB_MASK
 				}
-				else {
-
-				   // Cleanly unobstructed area.  Define stub
-				   // route from point to tap, with a route width
-				   // overlap if necessary to avoid a DRC width
-				   // violation.
-
-				   if ((dx >= ds->x2) &&
-					((dx - ds->x2) > (dy - ds->y2)) &&
-					((dx - ds->x2) > (ds->y1 - dy))) {
-				      // West-pointing stub
-				      if ((dy - ds->y2) <= xdist &&
-					  (ds->y1 - dy) <= xdist) {
-					 // Within reach of tap rectangle
-					 mask = STUBROUTE;
-					 dir = NI_STUB_EW;
-					 dist = ds->x2 - dx;
-					 if (dy < (ds->y2 - xdist) &&
-						dy > (ds->y1 + xdist)) {
-					    if (dx < ds->x2 + xdist) dist = 0.0;
-					 }
-					 else {
-					    dist -= 2.0 * xdist;
-					 }
+				// Otherwise, dir is left as NI_STUB_MASK
+			     }
+			     else {
+
+				// Cleanly unobstructed area.  Define stub
+				// route from point to tap, with a route width
+				// overlap if necessary to avoid a DRC width
+				// violation.
+
+				if ((dx >= ds->x2) &&
+				     ((dx - ds->x2) > (dy - ds->y2)) &&
+				     ((dx - ds->x2) > (ds->y1 - dy))) {
+				   // West-pointing stub
+				   if ((dy - ds->y2) <= xdist &&
+				       (ds->y1 - dy) <= xdist) {
+				      // Within reach of tap rectangle
+				      mask = STUBROUTE;
+				      dir = NI_STUB_EW;
+				      dist = ds->x2 - dx;
+				      if (dy < (ds->y2 - xdist) &&
+					     dy > (ds->y1 + xdist)) {
+					 if (dx < ds->x2 + xdist) dist = 0.0;
+				      }
+				      else {
+					 dist -= 2.0 * xdist;
 				      }
 				   }
-				   else if ((dx <= ds->x1) &&
-					((ds->x1 - dx) > (dy - ds->y2)) &&
-					((ds->x1 - dx) > (ds->y1 - dy))) {
-				      // East-pointing stub
-				      if ((dy - ds->y2) <= xdist &&
-					  (ds->y1 - dy) <= xdist) {
-					 // Within reach of tap rectangle
-					 mask = STUBROUTE;
-					 dir = NI_STUB_EW;
-					 dist = ds->x1 - dx;
-					 if (dy < (ds->y2 - xdist) &&
-						dy > (ds->y1 + xdist)) {
-					    if (dx > ds->x1 - xdist) dist = 0.0;
-					 }
-					 else {
-					    dist += 2.0 * xdist;
-					 }
+				}
+				else if ((dx <= ds->x1) &&
+				     ((ds->x1 - dx) > (dy - ds->y2)) &&
+				     ((ds->x1 - dx) > (ds->y1 - dy))) {
+				   // East-pointing stub
+				   if ((dy - ds->y2) <= xdist &&
+				       (ds->y1 - dy) <= xdist) {
+				      // Within reach of tap rectangle
+				      mask = STUBROUTE;
+				      dir = NI_STUB_EW;
+				      dist = ds->x1 - dx;
+				      if (dy < (ds->y2 - xdist) &&
+					     dy > (ds->y1 + xdist)) {
+					 if (dx > ds->x1 - xdist) dist = 0.0;
+				      }
+				      else {
+					 dist += 2.0 * xdist;
 				      }
 				   }
-				   else if ((dy >= ds->y2) &&
-					((dy - ds->y2) > (dx - ds->x2)) &&
-					((dy - ds->y2) > (ds->x1 - dx))) {
-				      // South-pointing stub
-				      if ((dx - ds->x2) <= xdist &&
-					  (ds->x1 - dx) <= xdist) {
-					 // Within reach of tap rectangle
-					 mask = STUBROUTE;
-					 dir = NI_STUB_NS;
-					 dist = ds->y2 - dy;
-					 if (dx < (ds->x2 - xdist) &&
-						dx > (ds->x1 + xdist)) {
-					    if (dy < ds->y2 + xdist) dist = 0.0;
-					 }
-					 else {
-					    dist -= 2.0 * xdist;
-					 }
+				}
+				else if ((dy >= ds->y2) &&
+				     ((dy - ds->y2) > (dx - ds->x2)) &&
+				     ((dy - ds->y2) > (ds->x1 - dx))) {
+				   // South-pointing stub
+				   if ((dx - ds->x2) <= xdist &&
+				       (ds->x1 - dx) <= xdist) {
+				      // Within reach of tap rectangle
+				      mask = STUBROUTE;
+				      dir = NI_STUB_NS;
+				      dist = ds->y2 - dy;
+				      if (dx < (ds->x2 - xdist) &&
+					     dx > (ds->x1 + xdist)) {
+					 if (dy < ds->y2 + xdist) dist = 0.0;
+				      }
+				      else {
+					 dist -= 2.0 * xdist;
 				      }
 				   }
-				   else if ((dy <= ds->y1) &&
-					((ds->y1 - dy) > (dx - ds->x2)) &&
-					((ds->y1 - dy) > (ds->x1 - dx))) {
-				      // North-pointing stub
-				      if ((dx - ds->x2) <= xdist &&
-					  (ds->x1 - dx) <= xdist) {
-					 // Within reach of tap rectangle
-					 mask = STUBROUTE;
-					 dir = NI_STUB_NS;
-					 dist = ds->y1 - dy;
-					 if (dx < (ds->x2 - xdist) &&
-						dx > (ds->x1 + xdist)) {
-					    if (dy > ds->y1 - xdist) dist = 0.0;
-					 }
-					 else {
-					    dist += 2.0 * xdist;
-					 }
+				}
+				else if ((dy <= ds->y1) &&
+				     ((ds->y1 - dy) > (dx - ds->x2)) &&
+				     ((ds->y1 - dy) > (ds->x1 - dx))) {
+				   // North-pointing stub
+				   if ((dx - ds->x2) <= xdist &&
+				       (ds->x1 - dx) <= xdist) {
+				      // Within reach of tap rectangle
+				      mask = STUBROUTE;
+				      dir = NI_STUB_NS;
+				      dist = ds->y1 - dy;
+				      if (dx < (ds->x2 - xdist) &&
+					     dx > (ds->x1 + xdist)) {
+					 if (dy > ds->y1 - xdist) dist = 0.0;
+				      }
+				      else {
+					 dist += 2.0 * xdist;
 				      }
 				   }
+				}
 
-				   if ((mask == STUBROUTE) && (dir == NI_STUB_MASK)) {
+				if ((mask == STUBROUTE) && (dir == NI_STUB_MASK)) {
 
-				      // Outside of pin at a corner.  First, if one
-				      // direction is too far away to connect to a
-				      // pin, then we must route the other direction.
+				   // Outside of pin at a corner.  First, if one
+				   // direction is too far away to connect to a
+				   // pin, then we must route the other direction.
 
-				      if (dx < ds->x1 - xdist || dx > ds->x2 + xdist) {
-				         if (dy >= ds->y1 - xdist &&
-							dy <= ds->y2 + xdist) {
-					    mask = STUBROUTE;
-				            dir = NI_STUB_EW;
-				            dist = (float)(((ds->x1 + ds->x2) / 2.0)
-							- dx);
-					 }
-				      }
-				      else if (dy < ds->y1 - xdist ||
-							dy > ds->y2 + xdist) {
+				   if (dx < ds->x1 - xdist || dx > ds->x2 + xdist) {
+				      if (dy >= ds->y1 - xdist &&
+						     dy <= ds->y2 + xdist) {
 					 mask = STUBROUTE;
-				         dir = NI_STUB_NS;
-				         dist = (float)(((ds->y1 + ds->y2) / 2.0) - dy);
+					 dir = NI_STUB_EW;
+					 dist = (float)(((ds->x1 + ds->x2) / 2.0)
+						     - dx);
 				      }
+				   }
+				   else if (dy < ds->y1 - xdist ||
+						     dy > ds->y2 + xdist) {
+				      mask = STUBROUTE;
+				      dir = NI_STUB_NS;
+				      dist = (float)(((ds->y1 + ds->y2) / 2.0) - dy);
+				   }
 
-				      // Otherwise we are too far away at a diagonal
-				      // to reach the pin by moving in any single
-				      // direction.  To be pedantic, we could define
-				      // some jogged stub, but for now, we just call
-				      // the point unroutable (leave dir = NI_STUB_MASK)
+				   // Otherwise we are too far away at a diagonal
+				   // to reach the pin by moving in any single
+				   // direction.  To be pedantic, we could define
+				   // some jogged stub, but for now, we just call
+				   // the point unroutable (leave dir = NI_STUB_MASK)
 
-				      // To do:  Apply offset + stub
-				   }
+				   // To do:  Apply offset + stub
 				}
+			     }
 
-				// Additional checks on stub routes
+			     // Additional checks on stub routes
 
-				// Stub distances of <= 1/2 route width are
-				// unnecessary, so don't create them.
+			     // Stub distances of <= 1/2 route width are
+			     // unnecessary, so don't create them.
 
-				if (mask == STUBROUTE && (dir == NI_STUB_NS
-					|| dir == NI_STUB_EW) &&
-					(fabs(dist) < (xdist + EPS))) {
-				    mask = 0;
-				    dir = 0;
-				    dist = 0.0;
+			     if (mask == STUBROUTE && (dir == NI_STUB_NS
+				     || dir == NI_STUB_EW) &&
+				     (fabs(dist) < (xdist + EPS))) {
+				 mask = 0;
+				 dir = 0;
+				 dist = 0.0;
+			     }
+			     else if (mask == STUBROUTE && (dir == NI_STUB_NS
+				     || dir == NI_STUB_EW)) {
+				struct dseg_ de;
+				DSEG ds2;
+				u_char errbox = TRUE;
+
+				// Additional check:  Sometimes the above
+				// checks put stub routes where they are
+				// not needed because the stub is completely
+				// covered by other tap geometry.  Take the
+				// stub area and remove parts covered by
+				// other tap rectangles.  If the entire
+				// stub is gone, then don't put a stub here.
+
+				if (dir == NI_STUB_NS) {
+				    de.x1 = dx - xdist;
+				    de.x2 = dx + xdist;
+				    if (dist > 0) {
+				       de.y1 = dy + xdist;
+				       de.y2 = dy + dist;
+				    }
+				    else {
+				       de.y1 = dy + dist;
+				       de.y2 = dy - xdist;
+				    }
+				}
+				if (dir == NI_STUB_EW) {
+				    de.y1 = dy - xdist;
+				    de.y2 = dy + xdist;
+				    if (dist > 0) {
+				       de.x1 = dx + xdist;
+				       de.x2 = dx + dist;
+				    }
+				    else {
+				       de.x1 = dx + dist;
+				       de.x2 = dx - xdist;
+				    }
 				}
-				else if (mask == STUBROUTE && (dir == NI_STUB_NS
-					|| dir == NI_STUB_EW)) {
-				   struct dseg_ de;
-				   DSEG ds2;
-				   u_char errbox = TRUE;
-
-				   // Additional check:  Sometimes the above
-				   // checks put stub routes where they are
-				   // not needed because the stub is completely
-				   // covered by other tap geometry.  Take the
-				   // stub area and remove parts covered by
-				   // other tap rectangles.  If the entire
-				   // stub is gone, then don't put a stub here.
-
-				   if (dir == NI_STUB_NS) {
-				       de.x1 = dx - xdist;
-				       de.x2 = dx + xdist;
-				       if (dist > 0) {
-					  de.y1 = dy + xdist;
-					  de.y2 = dy + dist;
-				       }
-				       else {
-					  de.y1 = dy + dist;
-					  de.y2 = dy - xdist;
-				       }
-				   }
-				   if (dir == NI_STUB_EW) {
-				       de.y1 = dy - xdist;
-				       de.y2 = dy + xdist;
-				       if (dist > 0) {
-					  de.x1 = dx + xdist;
-					  de.x2 = dx + dist;
-				       }
-				       else {
-					  de.x1 = dx + dist;
-					  de.x2 = dx - xdist;
-				       }
-				   }
-
-				   // For any tap that overlaps the
-				   // stub extension box, remove that
-				   // part of the box.
 
-			           for (ds2 = g->taps[i]; ds2; ds2 = ds2->next) {
-				      if (ds2 == ds) continue;
-				      if (ds2->layer != ds->layer) continue;
+				// For any tap that overlaps the
+				// stub extension box, remove that
+				// part of the box.
 
-				      if (ds2->x1 <= de.x1 && ds2->x2 >= de.x2 &&
-						ds2->y1 <= de.y1 && ds2->y2 >= de.y2) {
-				         errbox = FALSE;	// Completely covered
-				         break;
-				      }
+				for (ds2 = g->taps[i]; ds2; ds2 = ds2->next) {
+				   if (ds2 == ds) continue;
+				   if (ds2->layer != ds->layer) continue;
 
-				      // Look for partial coverage.  Note that any
-				      // change can cause a change in the original
-				      // two conditionals, so we have to keep
-				      // evaluating those conditionals.
-
-				      // ds2 covers left side of de
-				      if (ds2->x1 < de.x2 && ds2->x2 > de.x1 + EPS)
-				         if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
-					    if (ds2->x1 < de.x1 + EPS &&
-							ds2->x2 < de.x2 - EPS) {
-					       de.x1 = ds2->x2;
-					       if (de.x1 > de.x2 - EPS) errbox = FALSE;
-					    }
+				   if (ds2->x1 <= de.x1 && ds2->x2 >= de.x2 &&
+					     ds2->y1 <= de.y1 && ds2->y2 >= de.y2) {
+				      errbox = FALSE;	// Completely covered
+				      break;
+				   }
 
-				      // ds2 covers right side of de
-				      if (ds2->x1 < de.x2 - EPS && ds2->x2 > de.x1)
-				         if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
-					    if (ds2->x2 > de.x2 - EPS &&
-							ds2->x1 > de.x1 + EPS) {
-					       de.x2 = ds2->x1;
-					       if (de.x2 < de.x1 + EPS) errbox = FALSE;
-					    }
+				   // Look for partial coverage.  Note that any
+				   // change can cause a change in the original
+				   // two conditionals, so we have to keep
+				   // evaluating those conditionals.
 
-				      // ds2 covers bottom side of de
-				      if (ds2->y1 < de.y2 && ds2->y2 > de.y1 + EPS)
-				         if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
-					    if (ds2->y1 < de.y1 + EPS &&
-							ds2->y2 < de.y2 - EPS) {
-					       de.y1 = ds2->y2;
-					       if (de.y1 > de.y2 - EPS) errbox = FALSE;
-					    }
+				   // ds2 covers left side of de
+				   if (ds2->x1 < de.x2 && ds2->x2 > de.x1 + EPS)
+				      if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
+					 if (ds2->x1 < de.x1 + EPS &&
+						     ds2->x2 < de.x2 - EPS) {
+					    de.x1 = ds2->x2;
+					    if (de.x1 > de.x2 - EPS) errbox = FALSE;
+					 }
 
-				      // ds2 covers top side of de
-				      if (ds2->y1 < de.y2 - EPS && ds2->y2 > de.y1)
-				         if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
-					    if (ds2->y2 > de.y2 - EPS &&
-							ds2->y1 > de.y1 + EPS) {
-					       de.y2 = ds2->y1;
-					       if (de.y2 < de.y1 + EPS) errbox = FALSE;
-					    }
-			           }
+				   // ds2 covers right side of de
+				   if (ds2->x1 < de.x2 - EPS && ds2->x2 > de.x1)
+				      if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
+					 if (ds2->x2 > de.x2 - EPS &&
+						     ds2->x1 > de.x1 + EPS) {
+					    de.x2 = ds2->x1;
+					    if (de.x2 < de.x1 + EPS) errbox = FALSE;
+					 }
 
-				   // If nothing is left of the stub box,
-				   // then remove the stub.
+				   // ds2 covers bottom side of de
+				   if (ds2->y1 < de.y2 && ds2->y2 > de.y1 + EPS)
+				      if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
+					 if (ds2->y1 < de.y1 + EPS &&
+						     ds2->y2 < de.y2 - EPS) {
+					    de.y1 = ds2->y2;
+					    if (de.y1 > de.y2 - EPS) errbox = FALSE;
+					 }
 
-				   if (errbox == FALSE) {
-				      mask = 0;
-				      dir = 0;
-				      dist = 0;
-				   }
-                                }
+				   // ds2 covers top side of de
+				   if (ds2->y1 < de.y2 - EPS && ds2->y2 > de.y1)
+				      if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
+					 if (ds2->y2 > de.y2 - EPS &&
+						     ds2->y1 > de.y1 + EPS) {
+					    de.y2 = ds2->y1;
+					    if (de.y2 < de.y1 + EPS) errbox = FALSE;
+					 }
+				}
 
-				lnode = SetNodeinfo(gridx, gridy, ds->layer, node);
-				lnode->nodeloc = node;
-				lnode->nodesav = node;
+				// If nothing is left of the stub box,
+				// then remove the stub.
 
-				if ((k < Numnets) && (dir != NI_STUB_MASK)) {
-				   OBSVAL(gridx, gridy, ds->layer)
-				   	= (OBSVAL(gridx, gridy, ds->layer)
-					  & BLOCKED_MASK) | (u_int)g->netnum[i] | mask; 
-				   lnode->flags |= dir;
-				}
-				else if ((OBSVAL(gridx, gridy, ds->layer)
-					& NO_NET) != 0) {
-				   // Keep showing an obstruction, but add the
-				   // direction info and log the stub distance.
-				   OBSVAL(gridx, gridy, ds->layer) |= mask;
-				   lnode->flags |= dir;
-				}
-				else {
-				   OBSVAL(gridx, gridy, ds->layer)
-					|= (mask | (g->netnum[i] & ROUTED_NET_MASK));
-				   lnode->flags |= dir;
-				}
-				if ((mask & STUBROUTE) != 0) {
-				   lnode->stub = dist;
-				}
-				else if (((mask & OFFSET_TAP) != 0) || (dist != 0.0)) {
-				   lnode->offset = dist;
+				if (errbox == FALSE) {
+				   mask = 0;
+				   dir = 0;
+				   dist = 0;
 				}
+			     }
+
+			     lnode = SetNodeinfo(gridx, gridy, ds->layer, node);
+			     lnode->nodeloc = node;
+			     lnode->nodesav = node;
+
+			     if ((k < Numnets) && (dir != NI_STUB_MASK)) {
+				OBSVAL(gridx, gridy, ds->layer)
+				     = (OBSVAL(gridx, gridy, ds->layer)
+				       & BLOCKED_MASK) | (u_int)g->netnum[i] | mask; 
+				lnode->flags |= dir;
+			     }
+			     else if ((OBSVAL(gridx, gridy, ds->layer)
+				     & NO_NET) != 0) {
+				// Keep showing an obstruction, but add the
+				// direction info and log the stub distance.
+				OBSVAL(gridx, gridy, ds->layer) |= mask;
+				lnode->flags |= dir;
+			     }
+			     else {
+				OBSVAL(gridx, gridy, ds->layer)
+				     |= (mask | (g->netnum[i] & ROUTED_NET_MASK));
+				lnode->flags |= dir;
+			     }
+			     if ((mask & STUBROUTE) != 0) {
+				lnode->stub = dist;
+			     }
+			     else if (((mask & OFFSET_TAP) != 0) || (dist != 0.0)) {
+				lnode->offset = dist;
+			     }
 				
-				// Remove entries with NI_STUB_MASK---these
-				// are blocked-in taps that are not routable
-				// without causing DRC violations (formerly
-				// called STUBROUTE_X).
-
-				if (dir == NI_STUB_MASK) {
-				    if (is_testpoint(gridx, gridy, g, i, ds) != NULL)
-					Fprintf(stderr, "Tap point is blocked in "
-					    "and cannot be routed without causing "
-					    "DRC violations.\n");
-				    disable_gridpos(gridx, gridy, ds->layer);
-				}
-			    }
-			    else if (epass == 0) {
-
-			       // Position fails euclidean distance check
-
-			       int othernet = (k & ROUTED_NET_MASK);
-
-			       if (othernet != 0 && othernet != (u_int)node->netnum) {
-
-			          // This location is too close to two different
-				  // node terminals and should not be used
-
-				  // If there is a stub, then we can't specify
-				  // an offset tap, so just disable it.  If
-				  // there is already an offset, then just
-				  // disable it.  Otherwise, check if othernet
-				  // could be routed using a tap offset.
-
-				  // To avoid having to check all nearby
-				  // geometry, place a restriction that the
-				  // next grid point in the direction of the
-				  // offset must be free (not a tap point of
-				  // any net, including this one).  That is
-				  // still "more restrictive than necessary",
-				  // but since the alternative is an efficient
-				  // area search for interacting geometry, this
-				  // restriction will stand until an example
-				  // comes along that requires the detailed
-				  // search.
-
-				  // Such an example has come along, leading to
-				  // an additional relaxation allowing an offset
-				  // if the neighboring channel does not have a
-				  // node record.  This will probably need
-				  // revisiting.
+			     // Remove entries with NI_STUB_MASK---these
+			     // are blocked-in taps that are not routable
+			     // without causing DRC violations (formerly
+			     // called STUBROUTE_X).
+
+			     if (dir == NI_STUB_MASK) {
+				 if (is_testpoint(gridx, gridy, g, i, ds) != NULL)
+				     Fprintf(stderr, "Tap point is blocked in "
+					 "and cannot be routed without causing "
+					 "DRC violations.\n");
+				 disable_gridpos(gridx, gridy, ds->layer);
+			     }
+			 }
+			 else if (epass == 0) {
+
+			    // Position fails euclidean distance check
+
+			    obsword othernet = (k & ROUTED_NET_MASK);
+
+			    if (othernet != 0 && othernet != (u_int)node->netnum) {
+
+			       // This location is too close to two different
+			       // node terminals and should not be used
+
+			       // If there is a stub, then we can't specify
+			       // an offset tap, so just disable it.  If
+			       // there is already an offset, then just
+			       // disable it.  Otherwise, check if othernet
+			       // could be routed using a tap offset.
+
+			       // To avoid having to check all nearby
+			       // geometry, place a restriction that the
+			       // next grid point in the direction of the
+			       // offset must be free (not a tap point of
+			       // any net, including this one).  That is
+			       // still "more restrictive than necessary",
+			       // but since the alternative is an efficient
+			       // area search for interacting geometry, this
+			       // restriction will stand until an example
+			       // comes along that requires the detailed
+			       // search.
+
+			       // Such an example has come along, leading to
+			       // an additional relaxation allowing an offset
+			       // if the neighboring channel does not have a
+			       // node record.  This will probably need
+			       // revisiting.
 				
-				  if ((k & PINOBSTRUCTMASK) != 0) {
-				     if (is_testpoint(gridx, gridy, g, i, ds) != NULL) {
-					if (k & STUBROUTE)
-					    Fprintf(stderr, "Position marked as a "
-						"stub route for the net.\n");
-					else
-					    Fprintf(stderr, "Position marked as a "
-						"tap offset for the net.\n");
-				     }
-				     // Don't disable unless both via orientations
-				     // have been checked.
-				     if (orient == 2)
-					disable_gridpos(gridx, gridy, ds->layer);
+			       if ((k & PINOBSTRUCTMASK) != 0) {
+				  if (is_testpoint(gridx, gridy, g, i, ds) != NULL) {
+				     if (k & STUBROUTE)
+					 Fprintf(stderr, "Position marked as a "
+					     "stub route for the net.\n");
 				     else
-					lnode->flags |= NI_NO_VIAX;
+					 Fprintf(stderr, "Position marked as a "
+					     "tap offset for the net.\n");
 				  }
-				  else if ((lnode = NODEIPTR(gridx, gridy, ds->layer))
-					!= NULL && (lnode->nodesav != NULL)) {
-
-				     u_char no_offsets = TRUE;
-				     int offset_net;
-
-				     // By how much would a tap need to be moved
-				     // to clear the obstructing geometry?
-
-				     // Check tap to right
-
-				     if ((dx > ds->x2) && (gridx <
-						NumChannelsX - 1)) {
-					offset_net = OBSVAL(gridx + 1, gridy, ds->layer);
-					if (offset_net == 0 || offset_net == othernet) {
-					   xdist = 0.5 * LefGetXYViaWidth(ds->layer,
-							ds->layer, 0, orient);
-					   dist = ds->x2 - dx + xdist +
-							LefGetRouteSpacing(ds->layer);
-					   // Only accept an alternative solution if
-					   // it has a smaller offset than previously
-					   // found.
-					   if ((no_offsets == FALSE) ||
-						    (fabs(lnode->offset) > fabs(dist))) {
-					      mask = OFFSET_TAP;
-					      dir = NI_OFFSET_EW;
-					      OBSVAL(gridx, gridy, ds->layer) |= mask;
-					      lnode->offset = dist;
-					      lnode->flags &= ~(NI_OFFSET_NS);
-					      lnode->flags |= dir;
-					      no_offsets = FALSE;
-
-				              if ((ds->layer < Num_layers - 1) &&
-							(gridx > 0) &&
-							(OBSVAL(gridx + 1, gridy,
-							ds->layer + 1) & OBSTRUCT_MASK)) {
-					         block_route(gridx, gridy, ds->layer, UP);
-					      }
-				              else if ((ds->layer < Num_layers - 1) &&
-							(gridx > 0) &&
-							(dist > PitchX / 2)) {
-					         block_route(gridx, gridy, ds->layer, UP);
-					      }
+				  // Don't disable unless both via orientations
+				  // have been checked.
+				  if (orient == 2)
+				     disable_gridpos(gridx, gridy, ds->layer);
+				  else
+				     lnode->flags |= NI_NO_VIAX;
+			       }
+			       else if ((lnode = NODEIPTR(gridx, gridy, ds->layer))
+				     != NULL && (lnode->nodesav != NULL)) {
+
+				  u_char no_offsets = TRUE;
+				  obsword offset_net;
+
+				  // By how much would a tap need to be moved
+				  // to clear the obstructing geometry?
+
+				  // Check tap to right
+
+				  if ((dx > ds->x2) && (gridx <
+					     NumChannelsX - 1)) {
+				     offset_net = OBSVAL(gridx + 1, gridy, ds->layer);
+				     if (offset_net == 0 || offset_net == othernet) {
+					xdist = 0.5 * PinRule[ds->layer].viawidth[0][orient];
+					dist = ds->x2 - dx + xdist +
+						     PinRule[ds->layer].spacing;
+					// Only accept an alternative solution if
+					// it has a smaller offset than previously
+					// found.
+					if ((no_offsets == FALSE) ||
+						 (fabs(lnode->offset) > fabs(dist))) {
+					   mask = OFFSET_TAP;
+					   dir = NI_OFFSET_EW;
+					   OBSVAL(gridx, gridy, ds->layer) |= mask;
+					   lnode->offset = dist;
+					   lnode->flags &= ~(NI_OFFSET_NS);
+					   lnode->flags |= dir;
+					   no_offsets = FALSE;
+
+					   if ((ds->layer < Num_layers - 1) &&
+						     (gridx > 0) &&
+						     (OBSVAL(gridx + 1, gridy,
+						     ds->layer + 1) & OBSTRUCT_MASK)) {
+					      block_route(gridx, gridy, ds->layer, UP);
+					   }
+					   else if ((ds->layer < Num_layers - 1) &&
+						     (gridx > 0) &&
+						     (dist > PitchX / 2)) {
+					      block_route(gridx, gridy, ds->layer, UP);
 					   }
 					}
 				     }
+				  }
 
-				     // Check tap to left
-
-				     if ((dx < ds->x1) && (gridx > 0)) {
-					offset_net = OBSVAL(gridx - 1, gridy, ds->layer);
-					if (offset_net == 0 || offset_net == othernet) {
-					   xdist = 0.5 * LefGetXYViaWidth(ds->layer,
-							ds->layer, 0, orient);
-					   dist = ds->x1 - dx - xdist -
-							LefGetRouteSpacing(ds->layer);
-					   if ((no_offsets == FALSE) ||
-						    (fabs(lnode->offset) > fabs(dist))) {
-					      mask = OFFSET_TAP;
-					      dir = NI_OFFSET_EW;
-					      OBSVAL(gridx, gridy, ds->layer) |= mask;
-					      lnode->offset = dist;
-					      lnode->flags &= ~(NI_OFFSET_NS);
-					      lnode->flags |= dir;
-					      no_offsets = FALSE;
-
-				              if ((ds->layer < Num_layers - 1) && gridx <
-							(NumChannelsX - 1) &&
-							(OBSVAL(gridx - 1, gridy,
-							ds->layer + 1) & OBSTRUCT_MASK)) {
-					         block_route(gridx, gridy, ds->layer, UP);
-					      }
-				              else if ((ds->layer < Num_layers - 1) &&
-							gridx <
-							(NumChannelsX - 1) &&
-							(dist < -PitchX / 2)) {
-					         block_route(gridx, gridy, ds->layer, UP);
-					      }
+				  // Check tap to left
+
+				  if ((dx < ds->x1) && (gridx > 0)) {
+				     offset_net = OBSVAL(gridx - 1, gridy, ds->layer);
+				     if (offset_net == 0 || offset_net == othernet) {
+					xdist = 0.5 * PinRule[ds->layer].viawidth[0][orient];
+					dist = ds->x1 - dx - xdist -
+						     PinRule[ds->layer].spacing;
+					if ((no_offsets == FALSE) ||
+						 (fabs(lnode->offset) > fabs(dist))) {
+					   mask = OFFSET_TAP;
+					   dir = NI_OFFSET_EW;
+					   OBSVAL(gridx, gridy, ds->layer) |= mask;
+					   lnode->offset = dist;
+					   lnode->flags &= ~(NI_OFFSET_NS);
+					   lnode->flags |= dir;
+					   no_offsets = FALSE;
+
+					   if ((ds->layer < Num_layers - 1) && gridx <
+						     (NumChannelsX - 1) &&
+						     (OBSVAL(gridx - 1, gridy,
+						     ds->layer + 1) & OBSTRUCT_MASK)) {
+					      block_route(gridx, gridy, ds->layer, UP);
+					   }
+					   else if ((ds->layer < Num_layers - 1) &&
+						     gridx <
+						     (NumChannelsX - 1) &&
+						     (dist < -PitchX / 2)) {
+					      block_route(gridx, gridy, ds->layer, UP);
 					   }
 					}
 				     }
+				  }
 
-				     // Check tap up
-
-				     if ((dy > ds->y2) && (gridy <
-						NumChannelsY - 1)) {
-					offset_net = OBSVAL(gridx, gridy + 1, ds->layer);
-					if (offset_net == 0 || offset_net == othernet) {
-					   xdist = 0.5 * LefGetXYViaWidth(ds->layer,
-							ds->layer, 1, orient);
-					   dist = ds->y2 - dy + xdist +
-							LefGetRouteSpacing(ds->layer);
-					   if ((no_offsets == FALSE) ||
-						    (fabs(lnode->offset) > fabs(dist))) {
-					      mask = OFFSET_TAP;
-					      dir = NI_OFFSET_NS;
-					      OBSVAL(gridx, gridy, ds->layer) |= mask;
-					      lnode->offset = dist;
-					      lnode->flags &= ~(NI_OFFSET_EW);
-					      lnode->flags |= dir;
-					      no_offsets = FALSE;
-
-				              if ((ds->layer < Num_layers - 1) &&
-							(gridy > 0) && (OBSVAL(gridx,
-							gridy + 1, ds->layer + 1)
-							& OBSTRUCT_MASK)) {
-					         block_route(gridx, gridy, ds->layer, UP);
-					      }
-				              else if ((ds->layer < Num_layers - 1) &&
-							(gridy > 0) &&
-							(dist > PitchY / 2)) {
-					         block_route(gridx, gridy, ds->layer, UP);
-					      }
+				  // Check tap up
+
+				  if ((dy > ds->y2) && (gridy <
+					     NumChannelsY - 1)) {
+				     offset_net = OBSVAL(gridx, gridy + 1, ds->layer);
+				     if (offset_net == 0 || offset_net == othernet) {
+					xdist = 0.5 * PinRule[ds->layer].viawidth[1][orient];
+					dist = ds->y2 - dy + xdist +
+						     PinRule[ds->layer].spacing;
+					if ((no_offsets == FALSE) ||
+						 (fabs(lnode->offset) > fabs(dist))) {
+					   mask = OFFSET_TAP;
+					   dir = NI_OFFSET_NS;
+					   OBSVAL(gridx, gridy, ds->layer) |= mask;
+					   lnode->offset = dist;
+					   lnode->flags &= ~(NI_OFFSET_EW);
+					   lnode->flags |= dir;
+					   no_offsets = FALSE;
+
+					   if ((ds->layer < Num_layers - 1) &&
+						     (gridy > 0) && (OBSVAL(gridx,
+						     gridy + 1, ds->layer + 1)
+						     & OBSTRUCT_MASK)) {
+					      block_route(gridx, gridy, ds->layer, UP);
+					   }
+					   else if ((ds->layer < Num_layers - 1) &&
+						     (gridy > 0) &&
+						     (dist > PitchY / 2)) {
+					      block_route(gridx, gridy, ds->layer, UP);
 					   }
 					}
 				     }
+				  }
 
-				     // Check tap down
-
-				     if ((dy < ds->y1) && (gridy > 0)) {
-					offset_net = OBSVAL(gridx, gridy - 1, ds->layer);
-					if (offset_net == 0 || offset_net == othernet) {
-					   xdist = 0.5 * LefGetXYViaWidth(ds->layer,
-							ds->layer, 1, orient);
-					   dist = ds->y1 - dy - xdist -
-							LefGetRouteSpacing(ds->layer);
-					   if ((no_offsets == FALSE) ||
-						    (fabs(lnode->offset) > fabs(dist))) {
-					      mask = OFFSET_TAP;
-					      dir = NI_OFFSET_NS;
-					      OBSVAL(gridx, gridy, ds->layer) |= mask;
-					      lnode->offset = dist;
-					      lnode->flags &= ~(NI_OFFSET_EW);
-					      lnode->flags |= dir;
-					      no_offsets = FALSE;
-
-				              if ((ds->layer < Num_layers - 1) &&
-							gridx <
-							(NumChannelsX - 1) &&
-							(OBSVAL(gridx, gridy - 1,
-							ds->layer + 1) & OBSTRUCT_MASK)) {
-					         block_route(gridx, gridy, ds->layer, UP);
-					      }
-				              else if ((ds->layer < Num_layers - 1) &&
-							gridx <
-							(NumChannelsX - 1) &&
-							(dist < -PitchY / 2)) {
-					         block_route(gridx, gridy, ds->layer, UP);
-					      }
+				  // Check tap down
+
+				  if ((dy < ds->y1) && (gridy > 0)) {
+				     offset_net = OBSVAL(gridx, gridy - 1, ds->layer);
+				     if (offset_net == 0 || offset_net == othernet) {
+					xdist = 0.5 * PinRule[ds->layer].viawidth[1][orient];
+					dist = ds->y1 - dy - xdist -
+						     PinRule[ds->layer].spacing;
+					if ((no_offsets == FALSE) ||
+						 (fabs(lnode->offset) > fabs(dist))) {
+					   mask = OFFSET_TAP;
+					   dir = NI_OFFSET_NS;
+					   OBSVAL(gridx, gridy, ds->layer) |= mask;
+					   lnode->offset = dist;
+					   lnode->flags &= ~(NI_OFFSET_EW);
+					   lnode->flags |= dir;
+					   no_offsets = FALSE;
+
+					   if ((ds->layer < Num_layers - 1) &&
+						     gridx <
+						     (NumChannelsX - 1) &&
+						     (OBSVAL(gridx, gridy - 1,
+						     ds->layer + 1) & OBSTRUCT_MASK)) {
+					      block_route(gridx, gridy, ds->layer, UP);
+					   }
+					   else if ((ds->layer < Num_layers - 1) &&
+						     gridx <
+						     (NumChannelsX - 1) &&
+						     (dist < -PitchY / 2)) {
+					      block_route(gridx, gridy, ds->layer, UP);
 					   }
 					}
 				     }
+				  }
 
-				     // No offsets were possible.  If orient is 0
-				     // then mark as NI_NO_VIAX and try again with
-				     // orient 2.  If orient is 2 and no offsets
-				     // are possible, then disable the position.
-
-				     if (no_offsets == TRUE) {
-				 	if (orient == 2) {
-					    // Maybe no need to revert the flag?
-					    lnode->flags &= ~NI_NO_VIAX;
-					    if (is_testpoint(gridx, gridy,
-						    g, i, ds) != NULL)
-						Fprintf(stderr, "Unable to find "
-							"a viable offset for a tap.\n");
-				            disable_gridpos(gridx, gridy, ds->layer);
-					}
-					else
-					    lnode->flags |= NI_NO_VIAX;
+				  // No offsets were possible.  If orient is 0
+				  // then mark as NI_NO_VIAX and try again with
+				  // orient 2.  If orient is 2 and no offsets
+				  // are possible, then disable the position.
+
+				  if (no_offsets == TRUE) {
+				     if (orient == 2) {
+					 // Maybe no need to revert the flag?
+					 lnode->flags &= ~NI_NO_VIAX;
+					 if (is_testpoint(gridx, gridy,
+						 g, i, ds) != NULL)
+					     Fprintf(stderr, "Unable to find "
+						     "a viable offset for a tap.\n");
+					 disable_gridpos(gridx, gridy, ds->layer);
 				     }
-				  }
-				  else {
-				     if (is_testpoint(gridx, gridy,
-						    g, i, ds) != NULL)
-					Fprintf(stderr, "Tap point is too "
-						"close to two different nodes "
-						"and no offsets are possible.\n");
-				     disable_gridpos(gridx, gridy, ds->layer);
+				     else
+					 lnode->flags |= NI_NO_VIAX;
 				  }
 			       }
+			       else {
+				  if (is_testpoint(gridx, gridy,
+						 g, i, ds) != NULL)
+				     Fprintf(stderr, "Tap point is too "
+					     "close to two different nodes "
+					     "and no offsets are possible.\n");
+				  disable_gridpos(gridx, gridy, ds->layer);
+			       }
+			    }
 
-			       /* If we are on a layer > 0, then this geometry	*/
-			       /* may block or partially block a pin on layer	*/
-			       /* zero.  Mark this point as belonging to the	*/
-			       /* net with a stub route to it.			*/
-			       /* NOTE:  This is possibly too restrictive.	*/
-			       /* May want to force a tap offset for vias on	*/
-			       /* layer zero. . .				*/
-
-			       if ((ds->layer > 0) && (n2 != NULL) && (n2->netnum
-					!= node->netnum) && ((othernet == 0) ||
-					(othernet == (u_int)node->netnum))) {
-
-				  lnode = NODEIPTR(gridx, gridy, ds->layer);
-				  xdist = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer,
-						0, orient);
-				  if ((dy + xdist + LefGetRouteSpacing(ds->layer) >
-					ds->y1) && (dy + xdist < ds->y1)) {
-				     if ((dx - xdist < ds->x2) &&
-						(dx + xdist > ds->x1) &&
-						(lnode == NULL || lnode->stub
-						== 0.0)) {
-					OBSVAL(gridx, gridy, ds->layer)
-				   		= (OBSVAL(gridx, gridy, ds->layer)
-						& BLOCKED_MASK) |
-						node->netnum | STUBROUTE;
-				        lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						node);
-					lnode->nodeloc = node;
-					lnode->nodesav = node;
-					lnode->stub = ds->y1 - dy;
-					lnode->flags |= NI_STUB_NS;
-				     }
+			    /* If we are on a layer > 0, then this geometry	*/
+			    /* may block or partially block a pin on layer	*/
+			    /* zero.  Mark this point as belonging to the	*/
+			    /* net with a stub route to it.			*/
+			    /* NOTE:  This is possibly too restrictive.	*/
+			    /* May want to force a tap offset for vias on	*/
+			    /* layer zero. . .				*/
+
+			    if ((ds->layer > 0) && (n2 != NULL) && (n2->netnum
+				     != node->netnum) && ((othernet == 0) ||
+				     (othernet == (u_int)node->netnum))) {
+
+			       lnode = NODEIPTR(gridx, gridy, ds->layer);
+			       xdist = 0.5 * PinRule[ds->layer].viawidth[0][orient];
+			       if ((dy + xdist + PinRule[ds->layer].spacing >
+				     ds->y1) && (dy + xdist < ds->y1)) {
+				  if ((dx - xdist < ds->x2) &&
+					     (dx + xdist > ds->x1) &&
+					     (lnode == NULL || lnode->stub
+					     == 0.0)) {
+				     OBSVAL(gridx, gridy, ds->layer)
+					     = (OBSVAL(gridx, gridy, ds->layer)
+					     & BLOCKED_MASK) |
+					     node->netnum | STUBROUTE;
+				     lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     node);
+				     lnode->nodeloc = node;
+				     lnode->nodesav = node;
+				     lnode->stub = ds->y1 - dy;
+				     lnode->flags |= NI_STUB_NS;
 				  }
-				  if ((dy - xdist - LefGetRouteSpacing(ds->layer) <
-					ds->y2) && (dy - xdist > ds->y2)) {
-				     if ((dx - xdist < ds->x2) &&
-						(dx + xdist > ds->x1) &&
-						(lnode == NULL || lnode->stub
-						== 0.0)) {
-					OBSVAL(gridx, gridy, ds->layer)
-				   		= (OBSVAL(gridx, gridy, ds->layer)
-						& BLOCKED_MASK) |
-						node->netnum | STUBROUTE;
-				        lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						node);
-					lnode->nodeloc = node;
-					lnode->nodesav = node;
-					lnode->stub = ds->y2 - dy;
-					lnode->flags |= NI_STUB_NS;
-				     }
+			       }
+			       if ((dy - xdist - PinRule[ds->layer].spacing <
+				     ds->y2) && (dy - xdist > ds->y2)) {
+				  if ((dx - xdist < ds->x2) &&
+					     (dx + xdist > ds->x1) &&
+					     (lnode == NULL || lnode->stub
+					     == 0.0)) {
+				     OBSVAL(gridx, gridy, ds->layer)
+					     = (OBSVAL(gridx, gridy, ds->layer)
+					     & BLOCKED_MASK) |
+					     node->netnum | STUBROUTE;
+				     lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     node);
+				     lnode->nodeloc = node;
+				     lnode->nodesav = node;
+				     lnode->stub = ds->y2 - dy;
+				     lnode->flags |= NI_STUB_NS;
 				  }
+			       }
 
-				  xdist = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer,
-						1, orient);
-				  if ((dx + xdist + LefGetRouteSpacing(ds->layer) >
-					ds->x1) && (dx + xdist < ds->x1)) {
-				     if ((dy - xdist < ds->y2) &&
-						(dy + xdist > ds->y1) &&
-						(lnode == NULL || lnode->stub
-						 == 0.0)) {
-					OBSVAL(gridx, gridy, ds->layer)
-				   		= (OBSVAL(gridx, gridy, ds->layer)
-						& BLOCKED_MASK) |
-						node->netnum | STUBROUTE;
-				        lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						node);
-					lnode->nodeloc = node;
-					lnode->nodesav = node;
-					lnode->stub = ds->x1 - dx;
-					lnode->flags |= NI_STUB_EW;
-				     }
+			       xdist = 0.5 * PinRule[ds->layer].viawidth[1][orient];
+			       if ((dx + xdist + PinRule[ds->layer].spacing >
+				     ds->x1) && (dx + xdist < ds->x1)) {
+				  if ((dy - xdist < ds->y2) &&
+					     (dy + xdist > ds->y1) &&
+					     (lnode == NULL || lnode->stub
+					      == 0.0)) {
+				     OBSVAL(gridx, gridy, ds->layer)
+					     = (OBSVAL(gridx, gridy, ds->layer)
+					     & BLOCKED_MASK) |
+					     node->netnum | STUBROUTE;
+				     lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     node);
+				     lnode->nodeloc = node;
+				     lnode->nodesav = node;
+				     lnode->stub = ds->x1 - dx;
+				     lnode->flags |= NI_STUB_EW;
 				  }
-				  if ((dx - xdist - LefGetRouteSpacing(ds->layer) <
-					ds->x2) && (dx - xdist > ds->x2)) {
-				     if ((dy - xdist < ds->y2) &&
-						(dy + xdist > ds->y1) &&
-						(lnode == NULL || lnode->stub
-						== 0.0)) {
-					OBSVAL(gridx, gridy, ds->layer)
-				   		= (OBSVAL(gridx, gridy, ds->layer)
-						& BLOCKED_MASK) |
-						node->netnum | STUBROUTE;
-				        lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						node);
-					lnode->nodeloc = node;
-					lnode->nodesav = node;
-					lnode->stub = ds->x2 - dx;
-					lnode->flags |= NI_STUB_EW;
-				     }
+			       }
+			       if ((dx - xdist - PinRule[ds->layer].spacing <
+				     ds->x2) && (dx - xdist > ds->x2)) {
+				  if ((dy - xdist < ds->y2) &&
+					     (dy + xdist > ds->y1) &&
+					     (lnode == NULL || lnode->stub
+					     == 0.0)) {
+				     OBSVAL(gridx, gridy, ds->layer)
+					     = (OBSVAL(gridx, gridy, ds->layer)
+					     & BLOCKED_MASK) |
+					     node->netnum | STUBROUTE;
+				     lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     node);
+				     lnode->nodeloc = node;
+				     lnode->nodesav = node;
+				     lnode->stub = ds->x2 - dx;
+				     lnode->flags |= NI_STUB_EW;
 				  }
 			       }
 			    }
-		         }
-		         gridy++;
+			 }
 		      }
+		      gridy++;
 		   }
-		   gridx++;
 		}
+		gridx++;
 	     }
 	  }
        }
     }
+}
+
+/*--------------------------------------------------------------*/
+/* create_obstructions_outside_nodes()				*/
+/*								*/
+/*  Fills in the Obs[][] grid from the position of each node	*/
+/*  (net terminal), which may have multiple unconnected		*/
+/*  positions.							*/
+/*								*/
+/*  Also fills in the Nodeinfo.nodeloc[] grid with the node	*/
+/*  number, which causes the router to put a premium on		*/
+/*  routing other nets over or under this position, to		*/
+/*  discourage boxing in a pin position and making it 		*/
+/*  unroutable.							*/
+/*								*/
+/*  This routine is split into two passes.  This pass adds	*/
+/*  information for points outside node regions but close	*/
+/*  enough to interact with the node.				*/
+/*								*/
+/*  ARGS: none.							*/
+/*  RETURNS: nothing						*/
+/*  SIDE EFFECTS: none						*/
+/*  AUTHOR:  Tim Edwards, June 2011, based on code by Steve	*/
+/*	Beccue.							*/
+/*--------------------------------------------------------------*/
+
+
+void create_obstructions_outside_nodes(void)
+{
+    run_gate_pass(create_obstructions_outside_gate);
 
 } /* void create_obstructions_outside_nodes( void ) */
 
+/* Half width of a via plus route spacing, by via orientation */
+
+static double TapDeltaXX[MAX_LAYERS];
+static double TapDeltaXY[MAX_LAYERS];
+static double TapDeltaYX[MAX_LAYERS];
+static double TapDeltaYY[MAX_LAYERS];
+
 /*--------------------------------------------------------------*/
-/* tap_to_tap_interactions()					*/
+/* tap_to_tap_gate()						*/
 /*								*/
-/*  Similar to create_obstructions_from_nodes(), but looks at	*/
-/*  each node's tap geometry, looks at every grid point in a	*/
-/*  wider area surrounding the tap.  If any other node has an	*/
-/*  offset that would place it too close to this node's	tap	*/
-/*  geometry, then we mark the other node as unroutable at that	*/
-/*  grid point.							*/
+/*  The part of tap_to_tap_interactions() done for each gate.	*/
 /*--------------------------------------------------------------*/
 
-void tap_to_tap_interactions(void)
+static void
+tap_to_tap_gate(GATE g)
 {
     NODEINFO lnode;
-    GATE g;
     DSEG ds;
     DPOINT tpoint;
     struct dseg_ de;
     int mingridx, mingridy, maxgridx, maxgridy;
-    int i, gridx, gridy, net, orignet;
+    int i, gridx, gridy, net;
+    obsword orignet;
     double dx, dy;
     float dist;
 
-    double deltaxx[MAX_LAYERS];
-    double deltaxy[MAX_LAYERS];
-    double deltayx[MAX_LAYERS];
-    double deltayy[MAX_LAYERS];
-
-    for (i = 0; i < Num_layers; i++) {
-	deltaxx[i] = 0.5 * LefGetXYViaWidth(i, i, 0, 0) + LefGetRouteSpacing(i);
-	deltayx[i] = 0.5 * LefGetXYViaWidth(i, i, 1, 0) + LefGetRouteSpacing(i);
-	deltaxy[i] = 0.5 * LefGetXYViaWidth(i, i, 0, 2) + LefGetRouteSpacing(i);
-	deltayy[i] = 0.5 * LefGetXYViaWidth(i, i, 1, 2) + LefGetRouteSpacing(i);
-    }
-
-    for (g = Nlgates; g; g = g->next) {
-       for (i = 0; i < g->nodes; i++) {
-	  net = g->netnum[i];
-	  if (net > 0) {
-             for (ds = g->taps[i]; ds; ds = ds->next) {
-
-		mingridx = (int)((ds->x1 - Xlowerbound) / PitchX) - 1;
-		if (mingridx < 0) mingridx = 0;
-		maxgridx = (int)((ds->x2 - Xlowerbound) / PitchX) + 2;
-		if (maxgridx >= NumChannelsX)
-		   maxgridx = NumChannelsX - 1;
-		mingridy = (int)((ds->y1 - Ylowerbound) / PitchY) - 1;
-		if (mingridy < 0) mingridy = 0;
-		maxgridy = (int)((ds->y2 - Ylowerbound) / PitchY) + 2;
-		if (maxgridy >= NumChannelsY)
-		   maxgridy = NumChannelsY - 1;
+    for (i = 0; i < g->nodes; i++) {
+       net = g->netnum[i];
+       if (net > 0) {
+	  for (ds = g->taps[i]; ds; ds = ds->next) {
 
-		for (gridx = mingridx; gridx <= maxgridx; gridx++) {
-		   for (gridy = mingridy; gridy <= maxgridy; gridy++) {
+	     mingridx = (int)((ds->x1 - Xlowerbound) / PitchX) - 1;
+	     if (mingridx < 0) mingridx = 0;
+	     maxgridx = (int)((ds->x2 - Xlowerbound) / PitchX) + 2;
+	     if (maxgridx >= NumChannelsX)
+		maxgridx = NumChannelsX - 1;
+	     mingridy = (int)((ds->y1 - Ylowerbound) / PitchY) - 1;
+	     if (mingridy < 0) mingridy = 0;
+	     maxgridy = (int)((ds->y2 - Ylowerbound) / PitchY) + 2;
+	     if (maxgridy >= NumChannelsY)
+		maxgridy = NumChannelsY - 1;
 
-		      /* Is there an offset tap at this position, and	*/
-		      /* does it belong to a net that is != net?	*/
+	     for (gridx = mingridx; gridx <= maxgridx; gridx++) {
+		for (gridy = mingridy; gridy <= maxgridy; gridy++) {
 
-		      orignet = OBSVAL(gridx, gridy, ds->layer);
-		      if (orignet & OFFSET_TAP) {
-			 orignet &= ROUTED_NET_MASK;
-			 if (orignet != net) {
+		   /* Is there an offset tap at this position, and	*/
+		   /* does it belong to a net that is != net?	*/
 
-		            dx = (gridx * PitchX) + Xlowerbound;
-		            dy = (gridy * PitchY) + Ylowerbound;
+		   orignet = OBSVAL(gridx, gridy, ds->layer);
+		   if (orignet & OFFSET_TAP) {
+		      orignet &= ROUTED_NET_MASK;
+		      if (orignet != net) {
 
-			    lnode = NODEIPTR(gridx, gridy, ds->layer);
-			    dist = (lnode) ? lnode->offset : 0.0;
+			 dx = (gridx * PitchX) + Xlowerbound;
+			 dy = (gridy * PitchY) + Ylowerbound;
 
-			    /* "de" is the bounding box of a via placed	  */
-			    /* at (gridx, gridy) and offset as specified. */
-			    /* Expanded by metal spacing requirement.	  */
+			 lnode = NODEIPTR(gridx, gridy, ds->layer);
+			 dist = (lnode) ? lnode->offset : 0.0;
 
-			    de.x1 = dx - deltaxx[ds->layer];
-			    de.x2 = dx + deltaxx[ds->layer];
-			    de.y1 = dy - deltayx[ds->layer];
-			    de.y2 = dy + deltayx[ds->layer];
+			 /* "de" is the bounding box of a via placed	  */
+			 /* at (gridx, gridy) and offset as specified. */
+			 /* Expanded by metal spacing requirement.	  */
 
-			    if (lnode->flags & NI_OFFSET_NS) {
-			       de.y1 += dist;
-			       de.y2 += dist;
-			    }
-			    else if (lnode->flags & NI_OFFSET_EW) {
-			       de.x1 += dist;
-			       de.x2 += dist;
-			    }
+			 de.x1 = dx - TapDeltaXX[ds->layer];
+			 de.x2 = dx + TapDeltaXX[ds->layer];
+			 de.y1 = dy - TapDeltaYX[ds->layer];
+			 de.y2 = dy + TapDeltaYX[ds->layer];
 
-			    // Shrink by EPS to avoid roundoff errors
-			    de.x1 += EPS;
-			    de.x2 -= EPS;
-			    de.y1 += EPS;
-			    de.y2 -= EPS;
-
-			    /* Does the via bounding box interact with	*/
-			    /* the tap geometry?			*/
-
-			    if ((de.x1 < ds->x2) && (ds->x1 < de.x2) &&
-					(de.y1 < ds->y2) && (ds->y1 < de.y2)) {
-			       if (is_testpoint(gridx, gridy,
-						    g, i, ds) != NULL)
-				    Fprintf(stderr, "Offset tap interferes "
-					    "with position.\n");
-			       disable_gridpos(gridx, gridy, ds->layer);
-			    }
+			 if (lnode->flags & NI_OFFSET_NS) {
+			    de.y1 += dist;
+			    de.y2 += dist;
+			 }
+			 else if (lnode->flags & NI_OFFSET_EW) {
+			    de.x1 += dist;
+			    de.x2 += dist;
+			 }
+
+			 // Shrink by EPS to avoid roundoff errors
+			 de.x1 += EPS;
+			 de.x2 -= EPS;
+			 de.y1 += EPS;
+			 de.y2 -= EPS;
+
+			 /* Does the via bounding box interact with	*/
+			 /* the tap geometry?			*/
+
+			 if ((de.x1 < ds->x2) && (ds->x1 < de.x2) &&
+				     (de.y1 < ds->y2) && (ds->y1 < de.y2)) {
+			    if (is_testpoint(gridx, gridy,
+						 g, i, ds) != NULL)
+				 Fprintf(stderr, "Offset tap interferes "
+					 "with position.\n");
+			    disable_gridpos(gridx, gridy, ds->layer);
 			 }
 		      }
+		   }
 
-		      /* Does the distance to the tap prohibit a specific */
-		      /* via orientation?				  */
-		      if ((orignet & (~(BLOCKED_N | BLOCKED_S | BLOCKED_E | BLOCKED_W)))
-				== 0) {
-			 lnode = NODEIPTR(gridx, gridy, ds->layer);
-			 /* Positions belonging to nodes should have	*/
-			 /* already been handled.			*/
-			 if (lnode == NULL) {
-		            dx = (gridx * PitchX) + Xlowerbound;
-		            dy = (gridy * PitchY) + Ylowerbound;
-
-			    /* For a horizontally-oriented via on ds->layer */
-			    de.x1 = dx - deltaxx[ds->layer];
-			    de.x2 = dx + deltaxx[ds->layer];
-			    de.y1 = dy - deltayx[ds->layer];
-			    de.y2 = dy + deltayx[ds->layer];
-
-			    if (ds->x2 > de.x1 && ds->x1 < de.x2) {
-			        /* Check north and south */
-			        if ((ds->y1 < de.y2 && ds->y2 > de.y2) ||
-			 		(ds->y2 > de.y1 && ds->y1 < de.y1)) {
-				    /* prohibit horizontal via */
-				    lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						g->noderec[i]);
-				    lnode->flags |= NI_NO_VIAX;
-				}
-			    }
+		   /* Does the distance to the tap prohibit a specific */
+		   /* via orientation?				  */
+		   if ((orignet & (~(BLOCKED_N | BLOCKED_S | BLOCKED_E | BLOCKED_W)))
+			     == 0) {
+		      lnode = NODEIPTR(gridx, gridy, ds->layer);
+		      /* Positions belonging to nodes should have	*/
+		      /* already been handled.			*/
+		      if (lnode == NULL) {
+			 dx = (gridx * PitchX) + Xlowerbound;
+			 dy = (gridy * PitchY) + Ylowerbound;
+
+			 /* For a horizontally-oriented via on ds->layer */
+			 de.x1 = dx - TapDeltaXX[ds->layer];
+			 de.x2 = dx + TapDeltaXX[ds->layer];
+			 de.y1 = dy - TapDeltaYX[ds->layer];
+			 de.y2 = dy + TapDeltaYX[ds->layer];
+
+			 if (ds->x2 > de.x1 && ds->x1 < de.x2) {
+			     /* Check north and south */
+			     if ((ds->y1 < de.y2 && ds->y2 > de.y2) ||
+				     (ds->y2 > de.y1 && ds->y1 < de.y1)) {
+				 /* prohibit horizontal via */
+				 lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     g->noderec[i]);
+				 lnode->flags |= NI_NO_VIAX;
+			     }
+			 }
 
-			    if (ds->y2 > de.y1 && ds->y1 < de.y2) {
-			        /* Check east and west*/
-			        if ((ds->x1 < de.x2 && ds->x2 > de.x2) ||
-					(ds->x2 > de.x1 && ds->x1 < de.x1)) {
-				    /* prohibit horizontal via */
-				    lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						g->noderec[i]);
-				    lnode->flags |= NI_NO_VIAX;
-				}
-			    }
+			 if (ds->y2 > de.y1 && ds->y1 < de.y2) {
+			     /* Check east and west*/
+			     if ((ds->x1 < de.x2 && ds->x2 > de.x2) ||
+				     (ds->x2 > de.x1 && ds->x1 < de.x1)) {
+				 /* prohibit horizontal via */
+				 lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     g->noderec[i]);
+				 lnode->flags |= NI_NO_VIAX;
+			     }
+			 }
 
-			    /* For a vertically-oriented via on ds->layer */
-			    de.x1 = dx - deltaxy[ds->layer];
-			    de.x2 = dx + deltaxy[ds->layer];
-			    de.y1 = dy - deltayy[ds->layer];
-			    de.y2 = dy + deltayy[ds->layer];
-
-			    if (ds->x2 > de.x1 && ds->x1 < de.x2) {
-			        /* Check north and south */
-			        if ((ds->y1 < de.y2 && ds->y2 > de.y2) ||
-			 		(ds->y2 > de.y1 && ds->y1 < de.y1)) {
-				    /* prohibit horizontal via */
-				    lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						g->noderec[i]);
-				    lnode->flags |= NI_NO_VIAY;
-				}
-			    }
+			 /* For a vertically-oriented via on ds->layer */
+			 de.x1 = dx - TapDeltaXY[ds->layer];
+			 de.x2 = dx + TapDeltaXY[ds->layer];
+			 de.y1 = dy - TapDeltaYY[ds->layer];
+			 de.y2 = dy + TapDeltaYY[ds->layer];
+
+			 if (ds->x2 > de.x1 && ds->x1 < de.x2) {
+			     /* Check north and south */
+			     if ((ds->y1 < de.y2 && ds->y2 > de.y2) ||
+				     (ds->y2 > de.y1 && ds->y1 < de.y1)) {
+				 /* prohibit horizontal via */
+				 lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     g->noderec[i]);
+				 lnode->flags |= NI_NO_VIAY;
+			     }
+			 }
 
-			    if (ds->y2 > de.y1 && ds->y1 < de.y2) {
-			        /* Check east and west*/
-			        if ((ds->x1 < de.x2 && ds->x2 > de.x2) ||
-					(ds->x2 > de.x1 && ds->x1 < de.x1)) {
-				    /* prohibit horizontal via */
-				    lnode = SetNodeinfo(gridx, gridy, ds->layer,
-						g->noderec[i]);
-				    lnode->flags |= NI_NO_VIAY;
-				}
-			    }
+			 if (ds->y2 > de.y1 && ds->y1 < de.y2) {
+			     /* Check east and west*/
+			     if ((ds->x1 < de.x2 && ds->x2 > de.x2) ||
+				     (ds->x2 > de.x1 && ds->x1 < de.x1)) {
+				 /* prohibit horizontal via */
+				 lnode = SetNodeinfo(gridx, gridy, ds->layer,
+					     g->noderec[i]);
+				 lnode->flags |= NI_NO_VIAY;
+			     }
 			 }
 		      }
 		   }
@@ -2756,6 +3766,31 @@ void tap_to_tap_interactions(void)
     }
 }
 
+/*--------------------------------------------------------------*/
+/* tap_to_tap_interactions()					*/
+/*								*/
+/*  Similar to create_obstructions_from_nodes(), but looks at	*/
+/*  each node's tap geometry, looks at every grid point in a	*/
+/*  wider area surrounding the tap.  If any other node has an	*/
+/*  offset that would place it too close to this node's	tap	*/
+/*  geometry, then we mark the other node as unroutable at that	*/
+/*  grid point.							*/
+/*--------------------------------------------------------------*/
+
+void tap_to_tap_interactions(void)
+{
+    int i;
+
+    for (i = 0; i < Num_layers; i++) {
+	TapDeltaXX[i] = 0.5 * LefGetXYViaWidth(i, i, 0, 0) + LefGetRouteSpacing(i);
+	TapDeltaYX[i] = 0.5 * LefGetXYViaWidth(i, i, 1, 0) + LefGetRouteSpacing(i);
+	TapDeltaXY[i] = 0.5 * LefGetXYViaWidth(i, i, 0, 2) + LefGetRouteSpacing(i);
+	TapDeltaYY[i] = 0.5 * LefGetXYViaWidth(i, i, 1, 2) + LefGetRouteSpacing(i);
+    }
+
+    run_gate_pass(tap_to_tap_gate);
+}
+
 /*--------------------------------------------------------------*/
 /* make_routable()						*/
 /*								*/
@@ -2801,10 +3836,11 @@ make_routable(NODE node)
 			 // Area inside defined pin geometry
 
 			 if (dy > ds->y1 && gridy >= 0) {
-			    int orignet = OBSVAL(gridx, gridy, ds->layer);
+			    obsword orignet = OBSVAL(gridx, gridy, ds->layer);
 
 			    if (orignet & NO_NET) {
 				OBSVAL(gridx, gridy, ds->layer) = g->netnum[i];
+				update_obs_planes(gridx, gridy, ds->layer);
 				lnode = SetNodeinfo(gridx, gridy, ds->layer,
 						g->noderec[i]);
 				lnode->nodeloc = node;
@@ -2824,27 +3860,20 @@ make_routable(NODE node)
 }
 
 /*--------------------------------------------------------------*/
-/* adjust_stub_lengths()					*/
-/*								*/
-/*  Makes an additional pass through the tap and obstruction	*/
-/*  databases, checking geometry against the potential stub	*/
-/*  routes for DRC spacing violations.  Adjust stub routes as	*/
-/*  necessary to resolve the DRC error(s).			*/
+/* adjust_stub_lengths_gate()					*/
 /*								*/
-/*  ARGS: none.							*/
-/*  RETURNS: nothing						*/
-/*  SIDE EFFECTS: none						*/
-/*  AUTHOR:  Tim Edwards, April 2013				*/
+/*  The part of adjust_stub_lengths() done for each gate.	*/
 /*--------------------------------------------------------------*/
 
-void adjust_stub_lengths(void)
+static void
+adjust_stub_lengths_gate(GATE g)
 {
     NODE node;
     NODEINFO lnode;
-    GATE g;
     DSEG ds, ds2;
     struct dseg_ dt, de;
-    int i, gridx, gridy, orignet, o;
+    int i, gridx, gridy, o;
+    obsword orignet;
     double dx, dy, wx, wy, s;
     float dist;
     u_char errbox;
@@ -2862,464 +3891,481 @@ void adjust_stub_lengths(void)
     // out one grid pitch in each direction, to catch information about stubs that
     // may terminate within a DRC interaction distance of the tap rectangle.
 
-    for (g = Nlgates; g; g = g->next) {
-       for (i = 0; i < g->nodes; i++) {
-	  if (g->netnum[i] != 0) {
-
-	     // Get the node record associated with this pin.
-	     node = g->noderec[i];
-	     if (node == NULL) continue;
-
-	     // Work through each rectangle in the tap geometry twice.  The
-	     // second sweep checks for errors created by geometry that
-	     // interacts with stub routes created by the first sweep, and
-	     // also for geometry that interacts with vias in 90 degree
-	     // orientation.
-
-	     orient = 0;
-             for (ds = g->taps[i];; ds = ds->next) {
-		if (ds == NULL) {
-		    if (orient == 0) {
-			orient = 2;
-			ds = g->taps[i];
-			if (ds == NULL) break;
-		    }
-		    else
-			break;
-		}
-		wx = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 0, orient);
-		wy = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer, 1, orient);
-		s = LefGetRouteSpacing(ds->layer);
-		gridx = (int)((ds->x1 - Xlowerbound - PitchX) / PitchX) - 1;
-		while (1) {
-		   dx = (gridx * PitchX) + Xlowerbound;
-		   if (dx > (ds->x2 + PitchX) ||
-				gridx >= NumChannelsX) break;
-		   else if (dx >= (ds->x1 - PitchX) && gridx >= 0) {
-		      gridy = (int)((ds->y1 - Ylowerbound - PitchY) / PitchY) - 1;
-		      while (1) {
-		         dy = (gridy * PitchY) + Ylowerbound;
-		         if (dy > (ds->y2 + PitchY) ||
-				gridy >= NumChannelsY) break;
-		         if (dy >= (ds->y1 - PitchY) && gridy >= 0) {
-
-			     orignet = OBSVAL(gridx, gridy, ds->layer);
-
-			     // Ignore this location if it is assigned to another
-			     // net, or is assigned to NO_NET.
-
-			     if ((orignet & ROUTED_NET_MASK) != node->netnum) {
+    for (i = 0; i < g->nodes; i++) {
+       if (g->netnum[i] != 0) {
+
+	  // Get the node record associated with this pin.
+	  node = g->noderec[i];
+	  if (node == NULL) continue;
+
+	  // Work through each rectangle in the tap geometry twice.  The
+	  // second sweep checks for errors created by geometry that
+	  // interacts with stub routes created by the first sweep, and
+	  // also for geometry that interacts with vias in 90 degree
+	  // orientation.
+
+	  orient = 0;
+	  for (ds = g->taps[i];; ds = ds->next) {
+	     if (ds == NULL) {
+		 if (orient == 0) {
+		     orient = 2;
+		     ds = g->taps[i];
+		     if (ds == NULL) break;
+		 }
+		 else
+		     break;
+	     }
+	     wx = 0.5 * PinRule[ds->layer].viawidth[0][orient];
+	     wy = 0.5 * PinRule[ds->layer].viawidth[1][orient];
+	     s = PinRule[ds->layer].spacing;
+	     gridx = (int)((ds->x1 - Xlowerbound - PitchX) / PitchX) - 1;
+	     while (1) {
+		dx = (gridx * PitchX) + Xlowerbound;
+		if (dx > (ds->x2 + PitchX) ||
+			     gridx >= NumChannelsX) break;
+		else if (dx >= (ds->x1 - PitchX) && gridx >= 0) {
+		   gridy = (int)((ds->y1 - Ylowerbound - PitchY) / PitchY) - 1;
+		   while (1) {
+		      dy = (gridy * PitchY) + Ylowerbound;
+		      if (dy > (ds->y2 + PitchY) ||
+			     gridy >= NumChannelsY) break;
+		      if (dy >= (ds->y1 - PitchY) && gridy >= 0) {
+
+			  orignet = OBSVAL(gridx, gridy, ds->layer);
+
+			  // Ignore this location if it is assigned to another
+			  // net, or is assigned to NO_NET.
+
+			  if ((orignet & ROUTED_NET_MASK) != node->netnum) {
+			     gridy++;
+			     continue;
+			  }
+			  lnode = NODEIPTR(gridx, gridy, ds->layer);
+
+			  // Even if it's on the same net, we need to check
+			  // if the stub is to this node, otherwise it is not
+			  // an issue.
+			  if ((!lnode) || (lnode->nodesav != node)) {
+			     gridy++;
+			     continue;
+			  }
+
+			  // NI_STUB_MASK are unroutable;  leave them alone
+			  if (orignet & STUBROUTE) {
+			     if ((lnode->flags & NI_OFFSET_MASK) == NI_OFFSET_MASK) {
 				gridy++;
 				continue;
 			     }
-			     lnode = NODEIPTR(gridx, gridy, ds->layer);
+			  }
 
-			     // Even if it's on the same net, we need to check
-			     // if the stub is to this node, otherwise it is not
-			     // an issue.
-			     if ((!lnode) || (lnode->nodesav != node)) {
-				gridy++;
-				continue;
-			     }
+			  // define a route box around the grid point
 
-			     // NI_STUB_MASK are unroutable;  leave them alone
-			     if (orignet & STUBROUTE) {
-				if ((lnode->flags & NI_OFFSET_MASK) == NI_OFFSET_MASK) {
-				   gridy++;
-				   continue;
-				}
-			     }
+			  errbox = FALSE;
+			  dt.x1 = dx - wx;
+			  dt.x2 = dx + wx;
+			  dt.y1 = dy - wy;
+			  dt.y2 = dy + wy;
 
-			     // define a route box around the grid point
+			  // adjust the route box according to the stub
+			  // or offset geometry, provided that the stub
+			  // is longer than the route box.
 
-			     errbox = FALSE;
-			     dt.x1 = dx - wx;
-			     dt.x2 = dx + wx;
-			     dt.y1 = dy - wy;
-			     dt.y2 = dy + wy;
-
-			     // adjust the route box according to the stub
-			     // or offset geometry, provided that the stub
-			     // is longer than the route box.
-
-			     if (orignet & OFFSET_TAP) {
-			        dist = lnode->offset;
-				if (lnode->flags & NI_OFFSET_EW) {
-				   dt.x1 += dist;
-				   dt.x2 += dist;
+			  if (orignet & OFFSET_TAP) {
+			     dist = lnode->offset;
+			     if (lnode->flags & NI_OFFSET_EW) {
+				dt.x1 += dist;
+				dt.x2 += dist;
+			     }
+			     else if (lnode->flags & NI_OFFSET_NS) {
+				dt.y1 += dist;
+				dt.y2 += dist;
+			     }
+			  }
+			  else if (orignet & STUBROUTE) {
+			     dist = (double)lnode->stub;
+			     if (lnode->flags & NI_STUB_EW) {
+				if (dist > EPS) {
+				   if (dx + dist > dt.x2)
+				      dt.x2 = dx + dist;
 				}
-				else if (lnode->flags & NI_OFFSET_NS) {
-				   dt.y1 += dist;
-				   dt.y2 += dist;
+				else {
+				   if (dx + dist < dt.x1)
+				      dt.x1 = dx + dist;
 				}
 			     }
-			     else if (orignet & STUBROUTE) {
-			        dist = (double)lnode->stub;
-				if (lnode->flags & NI_STUB_EW) {
-				   if (dist > EPS) {
-				      if (dx + dist > dt.x2)
-				 	 dt.x2 = dx + dist;
-				   }
-				   else {
-				      if (dx + dist < dt.x1)
-					 dt.x1 = dx + dist;
-				   }
+			     else if (lnode->flags & NI_STUB_NS) {
+				if (dist > EPS) {
+				   if (dy + dist > dt.y2)
+				      dt.y2 = dy + dist;
 				}
-				else if (lnode->flags & NI_STUB_NS) {
-				   if (dist > EPS) {
-				      if (dy + dist > dt.y2)
-					 dt.y2 = dy + dist;
-				   }
-				   else {
-				      if (dy + dist < dt.y1)
-					 dt.y1 = dy + dist;
-				   }
+				else {
+				   if (dy + dist < dt.y1)
+				      dt.y1 = dy + dist;
 				}
 			     }
+			  }
 
-			     de = dt;
+			  de = dt;
 
-			     // check for DRC spacing interactions between
-			     // the tap box and the route box
+			  // check for DRC spacing interactions between
+			  // the tap box and the route box
 
-			     if ((dt.y1 - ds->y2) > EPS && (dt.y1 - ds->y2) + EPS < s) {
-				if (ds->x2 > (dt.x1 - s) && ds->x1 < (dt.x2 + s)) {
-				   de.y2 = dt.y1;
-				   de.y1 = ds->y2;
-				   if (ds->x2 + s < dt.x2) de.x2 = ds->x2 + s;
-				   if (ds->x1 - s > dt.x1) de.x1 = ds->x1 - s;
-				   errbox = TRUE;
-				}
+			  if ((dt.y1 - ds->y2) > EPS && (dt.y1 - ds->y2) + EPS < s) {
+			     if (ds->x2 > (dt.x1 - s) && ds->x1 < (dt.x2 + s)) {
+				de.y2 = dt.y1;
+				de.y1 = ds->y2;
+				if (ds->x2 + s < dt.x2) de.x2 = ds->x2 + s;
+				if (ds->x1 - s > dt.x1) de.x1 = ds->x1 - s;
+				errbox = TRUE;
 			     }
-			     else if ((ds->y1 - dt.y2) > EPS && (ds->y1 - dt.y2) + EPS < s) {
-				if (ds->x2 > (dt.x1 - s) && ds->x1 < (dt.x2 + s)) {
-				   de.y1 = dt.y2;
-				   de.y2 = ds->y1;
-				   if (ds->x2 + s < dt.x2) de.x2 = ds->x2 + s;
-				   if (ds->x1 - s > dt.x1) de.x1 = ds->x1 - s;
-				   errbox = TRUE;
-				}
+			  }
+			  else if ((ds->y1 - dt.y2) > EPS && (ds->y1 - dt.y2) + EPS < s) {
+			     if (ds->x2 > (dt.x1 - s) && ds->x1 < (dt.x2 + s)) {
+				de.y1 = dt.y2;
+				de.y2 = ds->y1;
+				if (ds->x2 + s < dt.x2) de.x2 = ds->x2 + s;
+				if (ds->x1 - s > dt.x1) de.x1 = ds->x1 - s;
+				errbox = TRUE;
 			     }
-
-			     if ((dt.x1 - ds->x2) > EPS && (dt.x1 - ds->x2) + EPS < s) {
-				if (ds->y2 > (dt.y1 - s) && ds->y1 < (dt.y2 + s)) {
-				   de.x2 = dt.x1;
-				   de.x1 = ds->x2;
-				   if (ds->y2 + s < dt.y2) de.y2 = ds->y2 + s;
-				   if (ds->y1 - s > dt.y1) de.y1 = ds->y1 - s;
-				   errbox = TRUE;
-				}
+			  }
+
+			  if ((dt.x1 - ds->x2) > EPS && (dt.x1 - ds->x2) + EPS < s) {
+			     if (ds->y2 > (dt.y1 - s) && ds->y1 < (dt.y2 + s)) {
+				de.x2 = dt.x1;
+				de.x1 = ds->x2;
+				if (ds->y2 + s < dt.y2) de.y2 = ds->y2 + s;
+				if (ds->y1 - s > dt.y1) de.y1 = ds->y1 - s;
+				errbox = TRUE;
 			     }
-			     else if ((ds->x1 - dt.x2) > EPS && (ds->x1 - dt.x2) + EPS < s) {
-				if (ds->y2 > (dt.y1 - s) && ds->y1 < (dt.y2 + s)) {
-				   de.x1 = dt.x2;
-				   de.x2 = ds->x1;
-				   if (ds->y2 + s < dt.y2) de.y2 = ds->y2 + s;
-				   if (ds->y1 - s > dt.y1) de.y1 = ds->y1 - s;
-				   errbox = TRUE;
-				}
+			  }
+			  else if ((ds->x1 - dt.x2) > EPS && (ds->x1 - dt.x2) + EPS < s) {
+			     if (ds->y2 > (dt.y1 - s) && ds->y1 < (dt.y2 + s)) {
+				de.x1 = dt.x2;
+				de.x2 = ds->x1;
+				if (ds->y2 + s < dt.y2) de.y2 = ds->y2 + s;
+				if (ds->y1 - s > dt.y1) de.y1 = ds->y1 - s;
+				errbox = TRUE;
 			     }
+			  }
 
-			     if (errbox == TRUE) {
+			  if (errbox == TRUE) {
 	
-			        // Chop areas off the error box that are covered by
-			        // other taps of the same port.
-
-			        for (ds2 = g->taps[i]; ds2; ds2 = ds2->next) {
-				   if (ds2 == ds) continue;
-				   if (ds2->layer != ds->layer) continue;
+			     // Chop areas off the error box that are covered by
+			     // other taps of the same port.
 
-				   if (ds2->x1 <= de.x1 && ds2->x2 >= de.x2 &&
-					ds2->y1 <= de.y1 && ds2->y2 >= de.y2) {
-				      errbox = FALSE;	// Completely covered
-				      break;
-				   }
+			     for (ds2 = g->taps[i]; ds2; ds2 = ds2->next) {
+				if (ds2 == ds) continue;
+				if (ds2->layer != ds->layer) continue;
 
-				   // Look for partial coverage.  Note that any
-				   // change can cause a change in the original
-				   // two conditionals, so we have to keep
-				   // evaluating those conditionals.
+				if (ds2->x1 <= de.x1 && ds2->x2 >= de.x2 &&
+				     ds2->y1 <= de.y1 && ds2->y2 >= de.y2) {
+				   errbox = FALSE;	// Completely covered
+				   break;
+				}
 
-				   if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
-				      if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
-					 // if (ds2->x1 < de.x1 - EPS &&
-					 if (ds2->x1 < de.x1 + EPS &&
-							ds2->x2 < de.x2 - EPS) {
-					    de.x1 = ds2->x2;
-					    if (ds2->x2 >= ds->x2) errbox = FALSE;
-					 }
+				// Look for partial coverage.  Note that any
+				// change can cause a change in the original
+				// two conditionals, so we have to keep
+				// evaluating those conditionals.
+
+				if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
+				   if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
+				      // if (ds2->x1 < de.x1 - EPS &&
+				      if (ds2->x1 < de.x1 + EPS &&
+						     ds2->x2 < de.x2 - EPS) {
+					 de.x1 = ds2->x2;
+					 if (ds2->x2 >= ds->x2) errbox = FALSE;
+				      }
 
-				   if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
-				      if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
-					 // if (ds2->x2 > de.x2 + EPS &&
-					 if (ds2->x2 > de.x2 - EPS &&
-							ds2->x1 > de.x1 + EPS) {
-					    de.x2 = ds2->x1;
-					    if (ds2->x1 <= ds->x1) errbox = FALSE;
-					 }
+				if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
+				   if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
+				      // if (ds2->x2 > de.x2 + EPS &&
+				      if (ds2->x2 > de.x2 - EPS &&
+						     ds2->x1 > de.x1 + EPS) {
+					 de.x2 = ds2->x1;
+					 if (ds2->x1 <= ds->x1) errbox = FALSE;
+				      }
 
-				   if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
-				      if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
-					 // if (ds2->y1 < de.y1 - EPS &&
-					 if (ds2->y1 < de.y1 + EPS &&
-							ds2->y2 < de.y2 - EPS) {
-					    de.y1 = ds2->y2;
-					    if (ds2->y2 >= ds->y2) errbox = FALSE;
-					 }
+				if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
+				   if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
+				      // if (ds2->y1 < de.y1 - EPS &&
+				      if (ds2->y1 < de.y1 + EPS &&
+						     ds2->y2 < de.y2 - EPS) {
+					 de.y1 = ds2->y2;
+					 if (ds2->y2 >= ds->y2) errbox = FALSE;
+				      }
 
-				   if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
-				      if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
-					 // if (ds2->y2 > de.y2 + EPS &&
-					 if (ds2->y2 > de.y2 - EPS &&
-							ds2->y1 > de.y1 + EPS) {
-					    de.y2 = ds2->y1;
-					    if (ds2->y1 <= ds->y1) errbox = FALSE;
-					 }
-				}
+				if (ds2->x1 < de.x2 && ds2->x2 > de.x1)
+				   if (ds2->y1 < de.y2 && ds2->y2 > de.y1)
+				      // if (ds2->y2 > de.y2 + EPS &&
+				      if (ds2->y2 > de.y2 - EPS &&
+						     ds2->y1 > de.y1 + EPS) {
+					 de.y2 = ds2->y1;
+					 if (ds2->y1 <= ds->y1) errbox = FALSE;
+				      }
 			     }
+			  }
 
-			     // Any area left over is a potential DRC error.
+			  // Any area left over is a potential DRC error.
 
-			     if ((de.x2 <= de.x1) || (de.y2 <= de.y1))
-				errbox = FALSE;
+			  if ((de.x2 <= de.x1) || (de.y2 <= de.y1))
+			     errbox = FALSE;
 		
-			     if (errbox == TRUE) {
-
-				// Create stub route to cover error box, or
-				// if possible, stretch existing stub route
-				// to cover error box.
-
-				// Allow EW stubs to be changed to NS stubs and
-				// vice versa if the original stub length was less
-				// than a route width.  This means the grid position
-				// makes contact without the stub.  Moving the stub
-				// to another side should not create an error.
-
-				// NOTE:  error box must touch ds geometry, and by
-				// more than just a point.
-
-				// 8/31/2016:
-				// If DRC violations are created on two adjacent
-				// sides, then create both a stub route and a tap
-				// offset.  Put the stub route in the preferred
-				// metal direction of the layer, and set the tap
-				// offset to prevent the DRC error in the other
-				// direction.
-				// 10/3/2016:  The tap offset can be set either
-				// by moving toward the obstructing edge to
-				// remove the gap, or moving away from it to
-				// avoid the DRC spacing error.  Choose the one
-				// that offsets by the smaller distance.
-
-				if ((de.x2 > dt.x2) && (de.y1 < ds->y2) &&
-						(de.y2 > ds->y1)) {
-				   if ((orignet & STUBROUTE) == 0) {
-			              OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
+			  if (errbox == TRUE) {
+
+			     // Create stub route to cover error box, or
+			     // if possible, stretch existing stub route
+			     // to cover error box.
+
+			     // Allow EW stubs to be changed to NS stubs and
+			     // vice versa if the original stub length was less
+			     // than a route width.  This means the grid position
+			     // makes contact without the stub.  Moving the stub
+			     // to another side should not create an error.
+
+			     // NOTE:  error box must touch ds geometry, and by
+			     // more than just a point.
+
+			     // 8/31/2016:
+			     // If DRC violations are created on two adjacent
+			     // sides, then create both a stub route and a tap
+			     // offset.  Put the stub route in the preferred
+			     // metal direction of the layer, and set the tap
+			     // offset to prevent the DRC error in the other
+			     // direction.
+			     // 10/3/2016:  The tap offset can be set either
+			     // by moving toward the obstructing edge to
+			     // remove the gap, or moving away from it to
+			     // avoid the DRC spacing error.  Choose the one
+			     // that offsets by the smaller distance.
+
+			     if ((de.x2 > dt.x2) && (de.y1 < ds->y2) &&
+					     (de.y2 > ds->y1)) {
+				if ((orignet & STUBROUTE) == 0) {
+				   OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
+				   lnode->stub = de.x2 - dx;
+				   lnode->flags |= NI_STUB_EW;
+				   errbox = FALSE;
+				}
+				else if ((orignet & STUBROUTE)
+					     && (lnode->flags & NI_STUB_EW)) {
+				   // Beware, if dist > 0 then this reverses
+				   // the stub.  For U-shaped ports may need
+				   // to have separate E and W stubs.
+				   lnode->stub = de.x2 - dx;
+				   errbox = FALSE;
+				}
+				else if ((orignet & STUBROUTE)
+					     && (lnode->flags & NI_STUB_NS)) {
+
+				   // If preferred route direction is
+				   // horizontal, then change the stub
+
+				   OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
+				   if (PinRule[ds->layer].orientation == 1) {
+				      lnode->flags = NI_OFFSET_NS | NI_STUB_EW;
+				      if (lnode->stub > 0) {
+					 lnode->offset = lnode->stub - wy;
+					 if (lnode->offset < 0) lnode->offset = 0;
+				      }
+				      else {
+					 lnode->offset = lnode->stub + wy;
+					 if (lnode->offset > 0) lnode->offset = 0;
+				      }
 				      lnode->stub = de.x2 - dx;
-				      lnode->flags |= NI_STUB_EW;
 				      errbox = FALSE;
 				   }
-				   else if ((orignet & STUBROUTE)
-						&& (lnode->flags & NI_STUB_EW)) {
-				      // Beware, if dist > 0 then this reverses
-				      // the stub.  For U-shaped ports may need
-				      // to have separate E and W stubs.
-				      lnode->stub = de.x2 - dx;
+				   else {
+				      // Add the offset
+				      lnode->offset = de.x2 - dx - wx;
+				      if (lnode->offset > s - lnode->offset)
+					  lnode->offset -= s;
+				      lnode->flags |= NI_OFFSET_EW;
 				      errbox = FALSE;
 				   }
-				   else if ((orignet & STUBROUTE)
-						&& (lnode->flags & NI_STUB_NS)) {
-
-				      // If preferred route direction is
-				      // horizontal, then change the stub
-
-			              OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
-				      if (LefGetRouteOrientation(ds->layer) == 1) {
-					 lnode->flags = NI_OFFSET_NS | NI_STUB_EW;
-					 if (lnode->stub > 0) {
-					    lnode->offset = lnode->stub - wy;
-					    if (lnode->offset < 0) lnode->offset = 0;
-					 }
-					 else {
-					    lnode->offset = lnode->stub + wy;
-					    if (lnode->offset > 0) lnode->offset = 0;
-					 }
-				         lnode->stub = de.x2 - dx;
-				         errbox = FALSE;
+				}
+			     }
+			     else if ((de.x1 < dt.x1) && (de.y1 < ds->y2) &&
+					     (de.y2 > ds->y1)) {
+				if ((orignet & STUBROUTE) == 0) {
+				   OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
+				   lnode->stub = de.x1 - dx;
+				   lnode->flags |= NI_STUB_EW;
+				   errbox = FALSE;
+				}
+				else if ((orignet & STUBROUTE)
+					     && (lnode->flags & NI_STUB_EW)) {
+				   // Beware, if dist > 0 then this reverses
+				   // the stub.  For U-shaped ports may need
+				   // to have separate E and W stubs.
+				   lnode->stub = de.x1 - dx;
+				   errbox = FALSE;
+				}
+				else if ((orignet & STUBROUTE)
+					     && (lnode->flags & NI_STUB_NS)) {
+
+				   // If preferred route direction is
+				   // horizontal, then change the stub
+
+				   OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
+				   if (PinRule[ds->layer].orientation == 1) {
+				      lnode->flags = NI_OFFSET_NS | NI_STUB_EW;
+				      if (lnode->stub > 0) {
+					 lnode->offset = lnode->stub - wy;
+					 if (lnode->offset < 0) lnode->offset = 0;
 				      }
 				      else {
-					 // Add the offset
-				         lnode->offset = de.x2 - dx - wx;
-					 if (lnode->offset > s - lnode->offset)
-					     lnode->offset -= s;
-					 lnode->flags |= NI_OFFSET_EW;
-				         errbox = FALSE;
+					 lnode->offset = lnode->stub + wy;
+					 if (lnode->offset > 0) lnode->offset = 0;
 				      }
-				   }
-				}
-				else if ((de.x1 < dt.x1) && (de.y1 < ds->y2) &&
-						(de.y2 > ds->y1)) {
-				   if ((orignet & STUBROUTE) == 0) {
-			              OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
 				      lnode->stub = de.x1 - dx;
-				      lnode->flags |= NI_STUB_EW;
 				      errbox = FALSE;
 				   }
-				   else if ((orignet & STUBROUTE)
-						&& (lnode->flags & NI_STUB_EW)) {
-				      // Beware, if dist > 0 then this reverses
-				      // the stub.  For U-shaped ports may need
-				      // to have separate E and W stubs.
-				      lnode->stub = de.x1 - dx;
+				   else {
+				      // Add the offset
+				      lnode->offset = de.x1 - dx + wx;
+				      if (-lnode->offset > s + lnode->offset)
+					  lnode->offset += s;
+				      lnode->flags |= NI_OFFSET_EW;
 				      errbox = FALSE;
 				   }
-				   else if ((orignet & STUBROUTE)
-						&& (lnode->flags & NI_STUB_NS)) {
-
-				      // If preferred route direction is
-				      // horizontal, then change the stub
-
-			              OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
-				      if (LefGetRouteOrientation(ds->layer) == 1) {
-					 lnode->flags = NI_OFFSET_NS | NI_STUB_EW;
-					 if (lnode->stub > 0) {
-					    lnode->offset = lnode->stub - wy;
-					    if (lnode->offset < 0) lnode->offset = 0;
-					 }
-					 else {
-					    lnode->offset = lnode->stub + wy;
-					    if (lnode->offset > 0) lnode->offset = 0;
-					 }
-				         lnode->stub = de.x1 - dx;
-				         errbox = FALSE;
+				}
+			     }
+			     else if ((de.y2 > dt.y2) && (de.x1 < ds->x2) &&
+				     (de.x2 > ds->x1)) {
+				if ((orignet & STUBROUTE) == 0) {
+				   OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
+				   lnode->stub = de.y2 - dy;
+				   lnode->flags |= NI_STUB_NS;
+				   errbox = FALSE;
+				}
+				else if ((orignet & STUBROUTE)
+					     && (lnode->flags & NI_STUB_NS)) {
+				   // Beware, if dist > 0 then this reverses
+				   // the stub.  For C-shaped ports may need
+				   // to have separate N and S stubs.
+				   lnode->stub = de.y2 - dy;
+				   errbox = FALSE;
+				}
+				else if ((orignet & STUBROUTE)
+					     && (lnode->flags & NI_STUB_EW)) {
+
+				   // If preferred route direction is
+				   // vertical, then change the stub
+
+				   OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
+				   if (PinRule[ds->layer].orientation == 0) {
+				      lnode->flags = NI_OFFSET_EW | NI_STUB_NS;
+				      if (lnode->stub > 0) {
+					 lnode->offset = lnode->stub - wx;
+					 if (lnode->offset < 0) lnode->offset = 0;
 				      }
 				      else {
-					 // Add the offset
-				         lnode->offset = de.x1 - dx + wx;
-					 if (-lnode->offset > s + lnode->offset)
-					     lnode->offset += s;
-					 lnode->flags |= NI_OFFSET_EW;
-				         errbox = FALSE;
+					 lnode->offset = lnode->stub + wx;
+					 if (lnode->offset > 0) lnode->offset = 0;
 				      }
-				   }
-				}
-				else if ((de.y2 > dt.y2) && (de.x1 < ds->x2) &&
-					(de.x2 > ds->x1)) {
-				   if ((orignet & STUBROUTE) == 0) {
-			              OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
 				      lnode->stub = de.y2 - dy;
-				      lnode->flags |= NI_STUB_NS;
 				      errbox = FALSE;
 				   }
-				   else if ((orignet & STUBROUTE)
-						&& (lnode->flags & NI_STUB_NS)) {
-				      // Beware, if dist > 0 then this reverses
-				      // the stub.  For C-shaped ports may need
-				      // to have separate N and S stubs.
-				      lnode->stub = de.y2 - dy;
+				   else {
+				      // Add the offset
+				      lnode->offset = de.y2 - dy - wy;
+				      if (lnode->offset > s - lnode->offset)
+					  lnode->offset -= s;
+				      lnode->flags |= NI_OFFSET_NS;
 				      errbox = FALSE;
 				   }
-				   else if ((orignet & STUBROUTE)
-						&& (lnode->flags & NI_STUB_EW)) {
-
-				      // If preferred route direction is
-				      // vertical, then change the stub
-
-			              OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
-				      if (LefGetRouteOrientation(ds->layer) == 0) {
-					 lnode->flags = NI_OFFSET_EW | NI_STUB_NS;
-					 if (lnode->stub > 0) {
-					    lnode->offset = lnode->stub - wx;
-					    if (lnode->offset < 0) lnode->offset = 0;
-					 }
-					 else {
-					    lnode->offset = lnode->stub + wx;
-					    if (lnode->offset > 0) lnode->offset = 0;
-					 }
-				         lnode->stub = de.y2 - dy;
-				         errbox = FALSE;
+				}
+			     }
+			     else if ((de.y1 < dt.y1) && (de.x1 < ds->x2) &&
+				     (de.x2 > ds->x1)) {
+				if ((orignet & STUBROUTE) == 0) {
+				   OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
+				   lnode->stub = de.y1 - dy;
+				   lnode->flags |= NI_STUB_NS;
+				   errbox = FALSE;
+				}
+				else if ((orignet & STUBROUTE)
+					     && (lnode->flags & NI_STUB_NS)) {
+				   // Beware, if dist > 0 then this reverses
+				   // the stub.  For C-shaped ports may need
+				   // to have separate N and S stubs.
+				   lnode->stub = de.y1 - dy;
+				   errbox = FALSE;
+				}
+				else if ((orignet & STUBROUTE)
+					     && (lnode->flags & NI_STUB_EW)) {
+
+				   // If preferred route direction is
+				   // vertical, then change the stub
+
+				   OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
+				   if (PinRule[ds->layer].orientation == 0) {
+				      lnode->flags = NI_OFFSET_EW | NI_STUB_NS;
+				      if (lnode->stub > 0) {
+					 lnode->offset = lnode->stub - wx;
+					 if (lnode->offset < 0) lnode->offset = 0;
 				      }
 				      else {
-					 // Add the offset
-				         lnode->offset = de.y2 - dy - wy;
-					 if (lnode->offset > s - lnode->offset)
-					     lnode->offset -= s;
-					 lnode->flags |= NI_OFFSET_NS;
-				         errbox = FALSE;
+					 lnode->offset = lnode->stub + wx;
+					 if (lnode->offset > 0) lnode->offset = 0;
 				      }
-				   }
-				}
-				else if ((de.y1 < dt.y1) && (de.x1 < ds->x2) &&
-					(de.x2 > ds->x1)) {
-				   if ((orignet & STUBROUTE) == 0) {
-			              OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
-				      lnode->stub = de.y1 - dy;
-				      lnode->flags |= NI_STUB_NS;
+				      lnode->stub = de.y1 - dy + wy;
 				      errbox = FALSE;
 				   }
-				   else if ((orignet & STUBROUTE)
-						&& (lnode->flags & NI_STUB_NS)) {
-				      // Beware, if dist > 0 then this reverses
-				      // the stub.  For C-shaped ports may need
-				      // to have separate N and S stubs.
-				      lnode->stub = de.y1 - dy;
+				   else {
+				      // Add the offset
+				      lnode->offset = de.y1 - dy + wy;
+				      if (-lnode->offset > s + lnode->offset)
+					  lnode->offset += s;
+				      lnode->flags |= NI_OFFSET_NS;
 				      errbox = FALSE;
 				   }
-				   else if ((orignet & STUBROUTE)
-						&& (lnode->flags & NI_STUB_EW)) {
-
-				      // If preferred route direction is
-				      // vertical, then change the stub
-
-			              OBSVAL(gridx, gridy, ds->layer) |= OFFSET_TAP;
-				      if (LefGetRouteOrientation(ds->layer) == 0) {
-					 lnode->flags = NI_OFFSET_EW | NI_STUB_NS;
-					 if (lnode->stub > 0) {
-					    lnode->offset = lnode->stub - wx;
-					    if (lnode->offset < 0) lnode->offset = 0;
-					 }
-					 else {
-					    lnode->offset = lnode->stub + wx;
-					    if (lnode->offset > 0) lnode->offset = 0;
-					 }
-				         lnode->stub = de.y1 - dy + wy;
-				         errbox = FALSE;
-				      }
-				      else {
-					 // Add the offset
-				         lnode->offset = de.y1 - dy + wy;
-					 if (-lnode->offset > s + lnode->offset)
-					     lnode->offset += s;
-					 lnode->flags |= NI_OFFSET_NS;
-				         errbox = FALSE;
-				      }
-				   }
 				}
+			     }
 
-				// Where the error box did not touch the stub
-				// route, there is assumed to be no error.
+			     // Where the error box did not touch the stub
+			     // route, there is assumed to be no error.
 
-				if (errbox == TRUE)
-				   if ((de.x2 > dt.x2) || (de.x1 < dt.x1) ||
-					(de.y2 > dt.y2) || (de.y1 < dt.y1))
-				      errbox = FALSE;
+			     if (errbox == TRUE)
+				if ((de.x2 > dt.x2) || (de.x1 < dt.x1) ||
+				     (de.y2 > dt.y2) || (de.y1 < dt.y1))
+				   errbox = FALSE;
 
-				if (errbox == TRUE) {
-				   // Unroutable position, so mark it unroutable
-			           OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
-				   lnode->flags |= NI_STUB_MASK;
-				}
+			     if (errbox == TRUE) {
+				// Unroutable position, so mark it unroutable
+				OBSVAL(gridx, gridy, ds->layer) |= STUBROUTE;
+				lnode->flags |= NI_STUB_MASK;
 			     }
-		         }
-		         gridy++;
+			  }
 		      }
+		      gridy++;
 		   }
-		   gridx++;
 		}
+		gridx++;
 	     }
 	  }
        }
     }
+}
+
+/*--------------------------------------------------------------*/
+/* adjust_stub_lengths()					*/
+/*								*/
+/*  Makes an additional pass through the tap and obstruction	*/
+/*  databases, checking geometry against the potential stub	*/
+/*  routes for DRC spacing violations.  Adjust stub routes as	*/
+/*  necessary to resolve the DRC error(s).			*/
+/*								*/
+/*  ARGS: none.							*/
+/*  RETURNS: nothing						*/
+/*  SIDE EFFECTS: none						*/
+/*  AUTHOR:  Tim Edwards, April 2013				*/
+/*--------------------------------------------------------------*/
+
+void adjust_stub_lengths(void)
+{
+    run_gate_pass(adjust_stub_lengths_gate);
 
 } /* void adjust_stub_lengths() */
 
@@ -3336,7 +4382,8 @@ void adjust_stub_lengths(void)
 void
 block_route(int x, int y, int lay, u_char dir)
 {
-   int bx, by, bl, ob;
+   int bx, by, bl;
+   obsword ob;
 
    bx = x;
    by = y;
@@ -3402,21 +4449,14 @@ block_route(int x, int y, int lay, u_char dir)
 }
 
 /*--------------------------------------------------------------*/
-/* find_route_blocks() ---					*/
+/* find_route_blocks_gate()					*/
 /*								*/
-/*	Search tap geometry for edges that cause DRC spacing	*/
-/*	errors with route edges.  This specifically checks	*/
-/*	edges of the route tracks, not the intersection points.	*/
-/*	If a tap would cause an error with a route segment,	*/
-/*	the grid points on either end of the segment are	*/
-/*	flagged to prevent generating a route along that	*/
-/*	specific segment.					*/
+/*  The part of find_route_blocks() done for each gate.		*/
 /*--------------------------------------------------------------*/
 
-void
-find_route_blocks()
+static void
+find_route_blocks_gate(GATE g)
 {
-   GATE g;
    NODEINFO lnode;
    DSEG ds;
    struct dseg_ dt, lds;
@@ -3425,176 +4465,174 @@ find_route_blocks()
    double dist;
    int orient = 0;	/* Need to check orient = 2! */
 
-   for (g = Nlgates; g; g = g->next) {
-      for (i = 0; i < g->nodes; i++) {
-	 if (g->netnum[i] != 0) {
+   for (i = 0; i < g->nodes; i++) {
+      if (g->netnum[i] != 0) {
 
-	    // Work through each rectangle in the tap geometry
+	 // Work through each rectangle in the tap geometry
 
-            for (ds = g->taps[i]; ds; ds = ds->next) {
-	       lds = *ds;	/* Make local copy of tap rect */
+	 for (ds = g->taps[i]; ds; ds = ds->next) {
+	    lds = *ds;	/* Make local copy of tap rect */
 
-	       /* Trim to array bounds and reject if out-of-bounds */
-	       gridx = (int)((lds.x1 - Xlowerbound) / PitchX);
-	       if (gridx >= NumChannelsX) continue;
-	       if (gridx < 0) lds.x1 = Xlowerbound;
+	    /* Trim to array bounds and reject if out-of-bounds */
+	    gridx = (int)((lds.x1 - Xlowerbound) / PitchX);
+	    if (gridx >= NumChannelsX) continue;
+	    if (gridx < 0) lds.x1 = Xlowerbound;
 
-	       gridx = (int)((lds.x2 - Xlowerbound) / PitchX);
-	       if (gridx < 0) continue;
-	       if (gridx >= NumChannelsX)
-		   lds.x2 = Xlowerbound + (NumChannelsX * PitchX);
+	    gridx = (int)((lds.x2 - Xlowerbound) / PitchX);
+	    if (gridx < 0) continue;
+	    if (gridx >= NumChannelsX)
+		lds.x2 = Xlowerbound + (NumChannelsX * PitchX);
 	       
-	       gridy = (int)((lds.y1 - Ylowerbound) / PitchY);
-	       if (gridy >= NumChannelsY) continue;
-	       if (gridy < 0) lds.y1 = Ylowerbound;
-
-	       gridy = (int)((lds.y2 - Ylowerbound) / PitchY);
-	       if (gridy < 0) continue;
-	       if (gridy >= NumChannelsY)
-		   lds.y2 = Ylowerbound + (NumChannelsY * PitchY);
+	    gridy = (int)((lds.y1 - Ylowerbound) / PitchY);
+	    if (gridy >= NumChannelsY) continue;
+	    if (gridy < 0) lds.y1 = Ylowerbound;
+
+	    gridy = (int)((lds.y2 - Ylowerbound) / PitchY);
+	    if (gridy < 0) continue;
+	    if (gridy >= NumChannelsY)
+		lds.y2 = Ylowerbound + (NumChannelsY * PitchY);
 	       
-	       w = 0.5 * LefGetRouteWidth(lds.layer);
-	       v = 0.5 * LefGetXYViaWidth(lds.layer, lds.layer, 0, orient);
-	       s = LefGetRouteSpacing(lds.layer);
+	    w = 0.5 * PinRule[lds.layer].width;
+	    v = 0.5 * PinRule[lds.layer].viawidth[0][orient];
+	    s = PinRule[lds.layer].spacing;
 
-	       // Look west
+	    // Look west
 
-	       gridx = (int)((lds.x1 - Xlowerbound) / PitchX);
-	       dx = (gridx * PitchX) + Xlowerbound;
-	       dist = lds.x1 - dx - w;
-	       if (dist > 0 && dist < s && gridx >= 0) {
-		  dt.x1 = dt.x2 = dx;
-		  dt.y1 = lds.y1;
-		  dt.y2 = lds.y2;
-
-		  // Check for other taps covering this edge
-		  // (to do)
-
-		  // Find all grid points affected
-	          gridy = (int)((lds.y1 - Ylowerbound - PitchY) / PitchY);
-	          dy = (gridy * PitchY) + Ylowerbound;
-		  while ((dy < lds.y1 - s) || (gridy < 0)) {
-		     dy += PitchY;
-		     gridy++;
+	    gridx = (int)((lds.x1 - Xlowerbound) / PitchX);
+	    dx = (gridx * PitchX) + Xlowerbound;
+	    dist = lds.x1 - dx - w;
+	    if (dist > 0 && dist < s && gridx >= 0) {
+	       dt.x1 = dt.x2 = dx;
+	       dt.y1 = lds.y1;
+	       dt.y2 = lds.y2;
+
+	       // Check for other taps covering this edge
+	       // (to do)
+
+	       // Find all grid points affected
+	       gridy = (int)((lds.y1 - Ylowerbound - PitchY) / PitchY);
+	       dy = (gridy * PitchY) + Ylowerbound;
+	       while ((dy < lds.y1 - s) || (gridy < 0)) {
+		  dy += PitchY;
+		  gridy++;
+	       }
+	       while (dy < lds.y2 + s) {
+		  lnode = NODEIPTR(gridx, gridy, lds.layer);
+		  u = ((OBSVAL(gridx, gridy, lds.layer) & STUBROUTE)
+			     && (lnode->flags & NI_STUB_EW)) ? v : w;
+		  if (dy + EPS < lds.y2 - u) {
+		     block_route(gridx, gridy, lds.layer, NORTH);
 		  }
-		  while (dy < lds.y2 + s) {
-		     lnode = NODEIPTR(gridx, gridy, lds.layer);
-		     u = ((OBSVAL(gridx, gridy, lds.layer) & STUBROUTE)
-				&& (lnode->flags & NI_STUB_EW)) ? v : w;
-		     if (dy + EPS < lds.y2 - u) {
-			block_route(gridx, gridy, lds.layer, NORTH);
-		     }
-		     if (dy - EPS > lds.y1 + u) {
-			block_route(gridx, gridy, lds.layer, SOUTH);
-		     }
-		     dy += PitchY;
-		     gridy++;
+		  if (dy - EPS > lds.y1 + u) {
+		     block_route(gridx, gridy, lds.layer, SOUTH);
 		  }
+		  dy += PitchY;
+		  gridy++;
 	       }
+	    }
 
-	       // Look east
+	    // Look east
 
-	       gridx = (int)(1.0 + (lds.x2 - Xlowerbound) / PitchX);
-	       dx = (gridx * PitchX) + Xlowerbound;
-	       dist = dx - lds.x2 - w;
-	       if (dist > 0 && dist < s && gridx < NumChannelsX) {
-		  dt.x1 = dt.x2 = dx;
-		  dt.y1 = lds.y1;
-		  dt.y2 = lds.y2;
-
-		  // Check for other taps covering this edge
-		  // (to do)
-
-		  // Find all grid points affected
-	          gridy = (int)((lds.y1 - Ylowerbound - PitchY) / PitchY);
-	          dy = (gridy * PitchY) + Ylowerbound;
-		  while ((dy < lds.y1 - s) || (gridy < 0)) {
-		     dy += PitchY;
-		     gridy++;
+	    gridx = (int)(1.0 + (lds.x2 - Xlowerbound) / PitchX);
+	    dx = (gridx * PitchX) + Xlowerbound;
+	    dist = dx - lds.x2 - w;
+	    if (dist > 0 && dist < s && gridx < NumChannelsX) {
+	       dt.x1 = dt.x2 = dx;
+	       dt.y1 = lds.y1;
+	       dt.y2 = lds.y2;
+
+	       // Check for other taps covering this edge
+	       // (to do)
+
+	       // Find all grid points affected
+	       gridy = (int)((lds.y1 - Ylowerbound - PitchY) / PitchY);
+	       dy = (gridy * PitchY) + Ylowerbound;
+	       while ((dy < lds.y1 - s) || (gridy < 0)) {
+		  dy += PitchY;
+		  gridy++;
+	       }
+	       while (dy < lds.y2 + s) {
+		  lnode = NODEIPTR(gridx, gridy, lds.layer);
+		  u = ((OBSVAL(gridx, gridy, lds.layer) & STUBROUTE)
+			     && (lnode->flags & NI_STUB_EW)) ? v : w;
+		  if (dy + EPS < lds.y2 - u) {
+		     block_route(gridx, gridy, lds.layer, NORTH);
 		  }
-		  while (dy < lds.y2 + s) {
-		     lnode = NODEIPTR(gridx, gridy, lds.layer);
-		     u = ((OBSVAL(gridx, gridy, lds.layer) & STUBROUTE)
-				&& (lnode->flags & NI_STUB_EW)) ? v : w;
-		     if (dy + EPS < lds.y2 - u) {
-			block_route(gridx, gridy, lds.layer, NORTH);
-		     }
-		     if (dy - EPS > lds.y1 + u) {
-			block_route(gridx, gridy, lds.layer, SOUTH);
-		     }
-		     dy += PitchY;
-		     gridy++;
+		  if (dy - EPS > lds.y1 + u) {
+		     block_route(gridx, gridy, lds.layer, SOUTH);
 		  }
+		  dy += PitchY;
+		  gridy++;
 	       }
+	    }
 
-	       // Look south
+	    // Look south
 
-	       gridy = (int)((lds.y1 - Ylowerbound) / PitchY);
-	       dy = (gridy * PitchY) + Ylowerbound;
-	       dist = lds.y1 - dy - w;
-	       if (dist > 0 && dist < s && gridy >= 0) {
-		  dt.x1 = lds.x1;
-		  dt.x2 = lds.x2;
-		  dt.y1 = dt.y2 = dy;
-
-		  // Check for other taps covering this edge
-		  // (to do)
-
-		  // Find all grid points affected
-	          gridx = (int)((lds.x1 - Xlowerbound - PitchX) / PitchX);
-	          dx = (gridx * PitchX) + Xlowerbound;
-		  while ((dx < lds.x1 - s) || (gridx < 0)) {
-		     dx += PitchX;
-		     gridx++;
+	    gridy = (int)((lds.y1 - Ylowerbound) / PitchY);
+	    dy = (gridy * PitchY) + Ylowerbound;
+	    dist = lds.y1 - dy - w;
+	    if (dist > 0 && dist < s && gridy >= 0) {
+	       dt.x1 = lds.x1;
+	       dt.x2 = lds.x2;
+	       dt.y1 = dt.y2 = dy;
+
+	       // Check for other taps covering this edge
+	       // (to do)
+
+	       // Find all grid points affected
+	       gridx = (int)((lds.x1 - Xlowerbound - PitchX) / PitchX);
+	       dx = (gridx * PitchX) + Xlowerbound;
+	       while ((dx < lds.x1 - s) || (gridx < 0)) {
+		  dx += PitchX;
+		  gridx++;
+	       }
+	       while (dx < lds.x2 + s) {
+		  lnode = NODEIPTR(gridx, gridy, lds.layer);
+		  u = ((OBSVAL(gridx, gridy, lds.layer) & STUBROUTE)
+			     && (lnode->flags & NI_STUB_NS)) ? v : w;
+		  if (dx + EPS < lds.x2 - u) {
+		     block_route(gridx, gridy, lds.layer, EAST);
 		  }
-		  while (dx < lds.x2 + s) {
-		     lnode = NODEIPTR(gridx, gridy, lds.layer);
-		     u = ((OBSVAL(gridx, gridy, lds.layer) & STUBROUTE)
-				&& (lnode->flags & NI_STUB_NS)) ? v : w;
-		     if (dx + EPS < lds.x2 - u) {
-			block_route(gridx, gridy, lds.layer, EAST);
-		     }
-		     if (dx - EPS > lds.x1 + u) {
-			block_route(gridx, gridy, lds.layer, WEST);
-		     }
-		     dx += PitchX;
-		     gridx++;
+		  if (dx - EPS > lds.x1 + u) {
+		     block_route(gridx, gridy, lds.layer, WEST);
 		  }
+		  dx += PitchX;
+		  gridx++;
 	       }
+	    }
 
-	       // Look north
+	    // Look north
 
-	       gridy = (int)(1.0 + (lds.y2 - Ylowerbound) / PitchY);
-	       dy = (gridy * PitchY) + Ylowerbound;
-	       dist = dy - lds.y2 - w;
-	       if (dist > 0 && dist < s && gridy < NumChannelsY) {
-		  dt.x1 = lds.x1;
-		  dt.x2 = lds.x2;
-		  dt.y1 = dt.y2 = dy;
-
-		  // Check for other taps covering this edge
-		  // (to do)
-
-		  // Find all grid points affected
-	          gridx = (int)((lds.x1 - Xlowerbound - PitchX) / PitchX);
-	          dx = (gridx * PitchX) + Xlowerbound;
-		  while ((dx < lds.x1 - s) || (gridx < 0)) {
-		     dx += PitchX;
-		     gridx++;
+	    gridy = (int)(1.0 + (lds.y2 - Ylowerbound) / PitchY);
+	    dy = (gridy * PitchY) + Ylowerbound;
+	    dist = dy - lds.y2 - w;
+	    if (dist > 0 && dist < s && gridy < NumChannelsY) {
+	       dt.x1 = lds.x1;
+	       dt.x2 = lds.x2;
+	       dt.y1 = dt.y2 = dy;
+
+	       // Check for other taps covering this edge
+	       // (to do)
+
+	       // Find all grid points affected
+	       gridx = (int)((lds.x1 - Xlowerbound - PitchX) / PitchX);
+	       dx = (gridx * PitchX) + Xlowerbound;
+	       while ((dx < lds.x1 - s) || (gridx < 0)) {
+		  dx += PitchX;
+		  gridx++;
+	       }
+	       while (dx < lds.x2 + s) {
+		  lnode = NODEIPTR(gridx, gridy, lds.layer);
+		  u = ((OBSVAL(gridx, gridy, lds.layer) & STUBROUTE)
+			     && (lnode->flags & NI_STUB_NS)) ? v : w;
+		  if (dx + EPS < lds.x2 - u) {
+		     block_route(gridx, gridy, lds.layer, EAST);
 		  }
-		  while (dx < lds.x2 + s) {
-		     lnode = NODEIPTR(gridx, gridy, lds.layer);
-		     u = ((OBSVAL(gridx, gridy, lds.layer) & STUBROUTE)
-				&& (lnode->flags & NI_STUB_NS)) ? v : w;
-		     if (dx + EPS < lds.x2 - u) {
-			block_route(gridx, gridy, lds.layer, EAST);
-		     }
-		     if (dx - EPS > lds.x1 + u) {
-			block_route(gridx, gridy, lds.layer, WEST);
-		     }
-		     dx += PitchX;
-		     gridx++;
+		  if (dx - EPS > lds.x1 + u) {
+		     block_route(gridx, gridy, lds.layer, WEST);
 		  }
+		  dx += PitchX;
+		  gridx++;
 	       }
 	    }
 	 }
@@ -3602,4 +4640,22 @@ find_route_blocks()
    }
 }
 
+/*--------------------------------------------------------------*/
+/* find_route_blocks() ---					*/
+/*								*/
+/*	Search tap geometry for edges that cause DRC spacing	*/
+/*	errors with route edges.  This specifically checks	*/
+/*	edges of the route tracks, not the intersection points.	*/
+/*	If a tap would cause an error with a route segment,	*/
+/*	the grid points on either end of the segment are	*/
+/*	flagged to prevent generating a route along that	*/
+/*	specific segment.					*/
+/*--------------------------------------------------------------*/
+
+void
+find_route_blocks()
+{
+    run_gate_pass(find_route_blocks_gate);
+}
+
 /* node.c */
@@ -15,10 +15,14 @@ void find_bounding_box(NET net);
 void defineRouteTree(NET);
 DPOINT is_testpoint(int, int, GATE, int, DSEG);
 void count_reachable_taps(u_char);
+void update_reachable_taps(GATE *, int, u_char);
 void check_variable_pitch(int, int *, int *);
 void create_obstructions_from_variable_pitch(void);
 void count_pinlayers(void);
 void create_obstructions_from_gates(void);
+void rasterize_obstruction(DSEG ds, double delta);
+void begin_obstructions_from_gates(void);
+void cancel_obstructions_from_gates(void);
 void expand_tap_geometry(void);
 void create_obstructions_inside_nodes(void);
 void create_obstructions_outside_nodes(void);
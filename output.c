@@ -13,6 +13,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 
 #ifdef TCL_QROUTER
 #include <tk.h>
@@ -28,16 +35,43 @@
 #include "lef.h"
 #include "def.h"
 #include "graphics.h"
+#include "zfile.h"
+
+/* Path state is per thread, as nets may be written by worker	*/
+/* threads (see emit_nets_parallel()).				*/
 
-int  Pathon = -1;
+static STORE_THREAD_LOCAL int  Pathon = -1;
 
-struct _savepath {
+static STORE_THREAD_LOCAL struct _savepath {
     u_char active;
     int x;
     int y;
     int orient;
 } path_delayed;
 
+/* A net's NETS entry as written ahead of time by a worker	*/
+/* thread, with what is needed to either use it or undo it.	*/
+
+typedef struct emitmark_ {
+    NODEINFO node;
+    u_char   flag;
+} EmitMark;
+
+typedef struct emitnet_ {
+    NET       net;
+    char     *text;		/* Route text, or NULL if not (or no longer) held */
+    size_t    len;
+    u_char    held;		/* A message was held back;  write serially */
+    u_char    netflags;		/* net->flags before writing */
+    u_char   *rtflags;		/* Each route's flags before writing */
+    EmitMark *marks;		/* Via directions to mark on the taps */
+    int       nummarks, maxmarks;
+} EmitNet;
+
+/* The net being written by this thread, if it is a worker */
+
+static STORE_THREAD_LOCAL EmitNet *emitCurrent = NULL;
+
 /*--------------------------------------------------------------*/
 /* Output a list of failed nets.				*/
 /*--------------------------------------------------------------*/
@@ -120,7 +154,10 @@ pathstart(FILE *cmd, int layer, int x, int y, u_char special, double oscale,
           double invscale, u_char horizontal, NODEINFO node)
 {
    if (Pathon == 1) {
-      Fprintf( stderr, "pathstart():  Major error.  Started a new "
+      if (emitCurrent != NULL)
+	 emitCurrent->held = TRUE;
+      else
+	 Fprintf( stderr, "pathstart():  Major error.  Started a new "
 		"path while one is in progress!\n"
 		"Doing it anyway.\n" );
    }
@@ -179,9 +216,12 @@ pathto(FILE *cmd, int x, int y, int horizontal, int lastx, int lasty,
        double invscale, u_char nextvia)
 {
     if (Pathon <= 0) {
-	Fprintf(stderr, "pathto():  Major error.  Added to a "
-		"non-existent path!\n"
-		"Doing it anyway.\n");
+	if (emitCurrent != NULL)
+	    emitCurrent->held = TRUE;
+	else
+	    Fprintf(stderr, "pathto():  Major error.  Added to a "
+			"non-existent path!\n"
+			"Doing it anyway.\n");
     }
 
     /* If the route is not manhattan, then it's because an offset
@@ -618,7 +658,7 @@ void print_nlnets( char *filename )
 void
 print_grid_information(int gridx, int gridy, int layer)
 {
-    u_int obsval;
+    obsword obsval;
     int i, apos;
     double dx, dy;
     int netidx;
@@ -1056,7 +1096,7 @@ void cleanup_net(NET net)
 			   // avoid notch DRC errors.
 
 			   SEG newseg;
-			   newseg = (SEG)malloc(sizeof(struct seg_));
+			   newseg = allocSEG();
 			   rt->segments = newseg;
 			   newseg->next = segf;
 			   newseg->layer = lf;
@@ -1086,7 +1126,7 @@ void cleanup_net(NET net)
 			   // avoid notch DRC errors.
 
 			   SEG newseg;
-			   newseg = (SEG)malloc(sizeof(struct seg_));
+			   newseg = allocSEG();
 			   rt->segments = newseg;
 			   newseg->next = segf;
 			   newseg->layer = lf;
@@ -1122,7 +1162,7 @@ void cleanup_net(NET net)
 			   // avoid notch DRC errors.
 
 			   SEG newseg;
-			   newseg = (SEG)malloc(sizeof(struct seg_));
+			   newseg = allocSEG();
 			   segl->next = newseg;
 			   newseg->next = NULL;
 			   newseg->layer = ll;
@@ -1153,7 +1193,7 @@ void cleanup_net(NET net)
 			   // avoid notch DRC errors.
 
 			   SEG newseg;
-			   newseg = (SEG)malloc(sizeof(struct seg_));
+			   newseg = allocSEG();
 			   segl->next = newseg;
 			   newseg->next = NULL;
 			   newseg->layer = ll;
@@ -1190,7 +1230,8 @@ void cleanup_net(NET net)
       /* Check for this case and resolve if needed.			*/
 
       if ((fcheck == FALSE) && (lcheck == FALSE)) {
-	 int wlen, oval0, oval1, oval2;
+	 int wlen;
+	 obsword oval1, oval2;
 
 	 segf = rt->segments;
 	 if ((segf == NULL) || (segf->next == NULL)) continue;
@@ -1212,7 +1253,7 @@ void cleanup_net(NET net)
 			viabase = segf->layer;
 			segf->layer = (viabase == seg->layer) ? seg->layer + 1 :
 				seg->layer;
-			if (!link_up_seg(net, seg, viabase, rt)) free(seg);
+			if (!link_up_seg(net, seg, viabase, rt)) freeSEG(seg);
 		    }
 		}
 	    }
@@ -1232,7 +1273,7 @@ void cleanup_net(NET net)
 			viabase = segf->layer;
 			segf->layer = (viabase == seg->layer) ? seg->layer + 1 :
 				seg->layer;
-			if (!link_up_seg(net, seg, viabase, rt)) free(seg);
+			if (!link_up_seg(net, seg, viabase, rt)) freeSEG(seg);
 		    }
 		}
 	    }
@@ -1262,7 +1303,7 @@ void cleanup_net(NET net)
 			seg->y1 = segl->y1;
 			seg->x2 = segl->x2;
 			seg->y2 = segl->y2;
-			if (!link_up_seg(net, segl, viabase, rt)) free(segl);
+			if (!link_up_seg(net, segl, viabase, rt)) freeSEG(segl);
 		    }
 		}
 	    }
@@ -1285,7 +1326,7 @@ void cleanup_net(NET net)
 			seg->y1 = segl->y1;
 			seg->x2 = segl->x2;
 			seg->y2 = segl->y2;
-			if (!link_up_seg(net, segl, viabase, rt)) free(segl);
+			if (!link_up_seg(net, segl, viabase, rt)) freeSEG(segl);
 		    }
 		}
 	    }
@@ -1297,6 +1338,30 @@ void cleanup_net(NET net)
 	 route_set_connections(net, rt);
 }
 
+/*--------------------------------------------------------------*/
+/* Mark a tap with the direction of the via placed on it.  A	*/
+/* worker thread keeps the mark with the net, to be made when	*/
+/* the net is written out.					*/
+/*--------------------------------------------------------------*/
+
+static void
+emit_mark_via(NODEINFO lnode, u_char flag)
+{
+   EmitNet *en = emitCurrent;
+
+   if (en == NULL) {
+      lnode->flags |= flag;
+      return;
+   }
+   if (en->nummarks == en->maxmarks) {
+      en->maxmarks = (en->maxmarks == 0) ? 8 : en->maxmarks * 2;
+      en->marks = (EmitMark *)realloc(en->marks, en->maxmarks * sizeof(EmitMark));
+   }
+   en->marks[en->nummarks].node = lnode;
+   en->marks[en->nummarks].flag = flag;
+   en->nummarks++;
+}
+
 /*--------------------------------------------------------------*/
 /* emit_routed_net --						*/
 /*								*/
@@ -1319,7 +1384,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
    SEG seg, saveseg, lastseg, prevseg;
    NODEINFO lnode, lnode1, lnode2;
    ROUTE rt;
-   u_int dir1, dir2, tdir;
+   obsword dir1, dir2, tdir;
    int layer;
    int x = 0, y = 0, x2, y2;
    double dc;
@@ -1764,7 +1829,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		     int vx = 0;
 		     int vy = 0;
 		     int flags;
-		     u_int tdirpp, tdirp, tdirn;
+		     obsword tdirpp, tdirp, tdirn;
 		     u_char viaNL, viaNM, viaNU;
 		     u_char viaSL, viaSM, viaSU;
 		     u_char viaEL, viaEM, viaEU;
@@ -1821,9 +1886,9 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 			    }
 			    /* Mark the node with which via direction was used */
 			    if ((s == ViaYY[layer]) || (s == ViaYX[layer]))
-				lnode->flags |= NI_VIA_Y;
+				emit_mark_via(lnode, NI_VIA_Y);
 			    else
-				lnode->flags |= NI_VIA_X;
+				emit_mark_via(lnode, NI_VIA_X);
 			}
 		     }
 
@@ -2790,6 +2855,269 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
    }
 }
 
+/*--------------------------------------------------------------*/
+/* Copy "len" bytes (or if "len" is negative, the rest of the	*/
+/* file) from DEF file "fdef" to "Cmd" in large blocks, rather	*/
+/* than line by line.  If the input is a plain file, the kernel	*/
+/* copies the data directly.  Returns the number of bytes	*/
+/* copied.							*/
+/*--------------------------------------------------------------*/
+
+#define DEF_COPY_BLOCK	(1024 * 1024)
+
+static off_t
+copy_def_block(FILE *fdef, FILE *Cmd, off_t len)
+{
+    char *buf;
+    size_t n, want;
+    off_t done = 0;
+#ifdef HAVE_SYS_SENDFILE_H
+    struct stat st;
+    off_t inoff;
+    ssize_t sent;
+
+    if ((fstat(fileno(fdef), &st) == 0) && S_ISREG(st.st_mode) &&
+		((inoff = ftello(fdef)) >= 0) && (fflush(Cmd) == 0)) {
+	if (len < 0) len = st.st_size - inoff;
+	while (done < len) {
+	    sent = sendfile(fileno(Cmd), fileno(fdef), &inoff, (size_t)(len - done));
+	    if (sent <= 0) break;
+	    done += sent;
+	}
+	fseeko(fdef, inoff, SEEK_SET);
+	if (done == len) return done;
+
+	/* Otherwise, finish (or do all of) the copy below */
+    }
+#endif
+
+    buf = (char *)malloc(DEF_COPY_BLOCK);
+    while ((len < 0) || (done < len)) {
+	want = DEF_COPY_BLOCK;
+	if ((len >= 0) && ((off_t)want > len - done)) want = (size_t)(len - done);
+	n = fread(buf, 1, want, fdef);
+	if (n == 0) break;
+	if (fwrite(buf, 1, n, Cmd) != n) break;
+	done += (off_t)n;
+    }
+    free(buf);
+    return done;
+}
+
+/* Return the position of the first section at or after "pos"	*/
+/* that emit_routes() does not copy unchanged, or -1 if none.	*/
+
+static off_t
+next_def_section(off_t pos)
+{
+    off_t sect[3], next = (off_t)(-1);
+    int i;
+
+    sect[0] = DefSectionInfo.vias;
+    sect[1] = DefSectionInfo.pins;
+    sect[2] = DefSectionInfo.nets;
+    for (i = 0; i < 3; i++)
+	if ((sect[i] >= pos) && ((next < 0) || (sect[i] < next)))
+	    next = sect[i];
+    return next;
+}
+
+/*--------------------------------------------------------------*/
+/* Parallel writing of the NETS section.			*/
+/*								*/
+/* When NumThreads > 1, worker threads write the route of each	*/
+/* net ahead of time into a buffer of its own, using		*/
+/* emit_routed_net() exactly as the serial code does.		*/
+/* emit_routes() then copies each net's buffer to the output	*/
+/* as the net comes up in the DEF file.  A net for which a	*/
+/* message was raised is written again serially, so that the	*/
+/* message appears in order, and a net that is never written	*/
+/* (not being in the NETS section) has its flags put back as	*/
+/* they were.  Above verbose level 2, messages are raised for	*/
+/* most nets, so the nets are all written serially.		*/
+/*--------------------------------------------------------------*/
+
+#define EMIT_PARALLEL_MIN	256	/* Fewest nets to write in parallel */
+
+typedef struct emitjob_ {
+    EmitNet *nets;
+    int      numnets;
+    int      first, stride;	/* Nets handled by this worker */
+    double   oscale;
+    int      iscale;
+} EmitJob;
+
+static int
+emit_net_compare(const void *a, const void *b)
+{
+    unsigned long na = (unsigned long)((EmitNet *)a)->net;
+    unsigned long nb = (unsigned long)((EmitNet *)b)->net;
+
+    return (na < nb) ? -1 : (na > nb) ? 1 : 0;
+}
+
+/* Put back the flags changed by writing a net */
+
+static void
+emit_net_restore(EmitNet *en)
+{
+    ROUTE rt;
+    int r;
+
+    en->net->flags = en->netflags;
+    for (r = 0, rt = en->net->routes; rt; rt = rt->next)
+	rt->flags = en->rtflags[r++];
+}
+
+#if defined(HAVE_LIBPTHREAD) && defined(HAVE_STORE_THREAD_LOCAL) && \
+	defined(HAVE_OPEN_MEMSTREAM)
+
+static void *
+emit_net_worker(void *arg)
+{
+    EmitJob *job = (EmitJob *)arg;
+    EmitNet *en;
+    ROUTE rt;
+    FILE *f;
+    int i, r;
+
+    for (i = job->first; i < job->numnets; i += job->stride) {
+	en = &job->nets[i];
+	for (r = 0, rt = en->net->routes; rt; rt = rt->next) r++;
+	en->rtflags = (u_char *)malloc(r + 1);
+	en->netflags = en->net->flags;
+	for (r = 0, rt = en->net->routes; rt; rt = rt->next)
+	    en->rtflags[r++] = rt->flags;
+
+	f = open_memstream(&en->text, &en->len);
+	if (f == NULL) {
+	    en->held = TRUE;
+	    continue;
+	}
+	emitCurrent = en;
+	emit_routed_net(f, en->net, (u_char)0, job->oscale, job->iscale);
+	emitCurrent = NULL;
+	if (fclose(f) != 0) en->held = TRUE;
+    }
+    return NULL;
+}
+
+#endif
+
+/* Write the routes of all nets into buffers.  Returns the	*/
+/* buffers, sorted for emit_net_buffered(), or NULL if the nets	*/
+/* are to be written serially.					*/
+
+static EmitNet *
+emit_nets_parallel(double oscale, int iscale, int *numemit)
+{
+#if defined(HAVE_LIBPTHREAD) && defined(HAVE_STORE_THREAD_LOCAL) && \
+	defined(HAVE_OPEN_MEMSTREAM)
+    EmitNet *nets, *en;
+    EmitJob *jobs;
+    pthread_t *threads;
+    u_char *started;
+    int i, n, c;
+
+    if ((NumThreads < 2) || (Verbose > 2) || (Numnets < EMIT_PARALLEL_MIN))
+	return NULL;
+
+    nets = (EmitNet *)calloc(Numnets, sizeof(EmitNet));
+    for (i = n = 0; i < Numnets; i++)
+	if (!(Nlnets[i]->flags & NET_IGNORED))
+	    nets[n++].net = Nlnets[i];
+
+    /* Bring the layer hash table up to date now, so that the	*/
+    /* workers only read it.					*/
+    LefFindLayer("");
+
+    jobs = (EmitJob *)malloc(NumThreads * sizeof(EmitJob));
+    threads = (pthread_t *)malloc(NumThreads * sizeof(pthread_t));
+    started = (u_char *)calloc(NumThreads, sizeof(u_char));
+    for (c = 0; c < NumThreads; c++) {
+	jobs[c].nets = nets;
+	jobs[c].numnets = n;
+	jobs[c].first = c;
+	jobs[c].stride = NumThreads;
+	jobs[c].oscale = oscale;
+	jobs[c].iscale = iscale;
+	if (pthread_create(&threads[c], NULL, emit_net_worker, (void *)&jobs[c]) == 0)
+	    started[c] = TRUE;
+    }
+    for (c = 0; c < NumThreads; c++) {
+	if (started[c])
+	    pthread_join(threads[c], NULL);
+	else
+	    emit_net_worker((void *)&jobs[c]);
+    }
+    free(jobs);
+    free(threads);
+    free(started);
+
+    for (i = 0; i < n; i++) {
+	en = &nets[i];
+	if (en->held) {
+	    emit_net_restore(en);
+	    free(en->text);
+	    en->text = NULL;
+	}
+    }
+    qsort(nets, n, sizeof(EmitNet), emit_net_compare);
+    *numemit = n;
+
+    if (Verbose > 1)
+	Fprintf(stdout, "  Wrote routes of %d nets using %d threads.\n",
+		n, NumThreads);
+    return nets;
+#else
+    return NULL;
+#endif
+}
+
+/* Copy the buffered route of "net" to the output and make the	*/
+/* tap marks that writing it made.  Returns FALSE if the net	*/
+/* is to be written serially.					*/
+
+static u_char
+emit_net_buffered(FILE *Cmd, EmitNet *nets, int numemit, NET net)
+{
+    EmitNet key, *en;
+    int m;
+
+    if (nets == NULL) return FALSE;
+    key.net = net;
+    en = (EmitNet *)bsearch(&key, nets, numemit, sizeof(EmitNet),
+		emit_net_compare);
+    if ((en == NULL) || (en->text == NULL)) return FALSE;
+
+    fwrite(en->text, 1, en->len, Cmd);
+    for (m = 0; m < en->nummarks; m++)
+	en->marks[m].node->flags |= en->marks[m].flag;
+    free(en->text);
+    en->text = NULL;
+    return TRUE;
+}
+
+/* Undo the writing of any net whose buffer was not used, and	*/
+/* free the buffers.						*/
+
+static void
+emit_nets_done(EmitNet *nets, int numemit)
+{
+    EmitNet *en;
+
+    if (nets == NULL) return;
+    for (en = nets; en < nets + numemit; en++) {
+	if (en->text != NULL) {
+	    emit_net_restore(en);
+	    free(en->text);
+	}
+	free(en->rtflags);
+	free(en->marks);
+    }
+    free(nets);
+}
+
 /*--------------------------------------------------------------*/
 /* emit_routes - DEF file output from the list of routes	*/
 /*								*/
@@ -2817,13 +3145,18 @@ static void emit_routes(char *filename, double oscale, int iscale)
     u_char need_cleanup = FALSE;
     u_char purge_routed = FALSE;
     u_char skip_net = FALSE;
+    u_char usesections = FALSE;
+    off_t defpos, next;
+    struct stat st;
+    EmitNet *emitnets;
+    int numemit = 0;
 
-    fdef = fopen(DEFfilename, "r");
+    fdef = ZFileOpen(DEFfilename, "r");
     if ((fdef == NULL) && (DEFfilename != NULL)) {
 	if (strchr(DEFfilename, '.') == NULL) {
 	    char *extfilename = malloc(strlen(DEFfilename) + 5);
 	    sprintf(extfilename, "%s.def", DEFfilename);
-	    fdef = fopen(extfilename, "r");
+	    fdef = ZFileOpen(extfilename, "r");
 	    free(extfilename);
 	}
     }
@@ -2839,26 +3172,31 @@ static void emit_routes(char *filename, double oscale, int iscale)
 	char *dotptr;
 
 	if (filename == DEFfilename) {
+	    /* A compressed input ("x.def.gz") gives a compressed	*/
+	    /* output ("x_route.def.gz").			*/
+	    char *zsuffix = ZFileSuffix(filename);
 	    char *newDEFfile = (char *)malloc(strlen(filename) + 11);
 	    strcpy(newDEFfile, filename);
+	    if (zsuffix) newDEFfile[zsuffix - filename] = '\0';
 	    dotptr = strrchr(newDEFfile, '.');
 	    if (dotptr)
 		strcpy(dotptr, "_route.def");
 	    else
 		strcat(newDEFfile, "_route.def");
+	    if (zsuffix) strcat(newDEFfile, zsuffix);
 	    
-	    Cmd = fopen(newDEFfile, "w");
+	    Cmd = ZFileOpen(newDEFfile, "w");
 	    free(newDEFfile);
 	}
 	else {
 	    dotptr = strrchr(filename, '.');
 	    if (dotptr)
-	       Cmd = fopen(filename, "w");
+	       Cmd = ZFileOpen(filename, "w");
 	    else {
 	       char *newDEFfile = (char *)malloc(strlen(filename) + 11);
 	       strcpy(newDEFfile, filename);
 	       strcat(newDEFfile, ".def");
-	       Cmd = fopen(newDEFfile, "w");
+	       Cmd = ZFileOpen(newDEFfile, "w");
 	       free(newDEFfile);
 	    }
 	}
@@ -2868,10 +3206,29 @@ static void emit_routes(char *filename, double oscale, int iscale)
 	return;
     }
 
+    // If this is the DEF file that was read, the positions of the
+    // sections that need changing are known, and everything between
+    // them is copied as a block.
+
+    if ((DefSectionInfo.nets >= 0) &&
+		(fstat(ZFileDescriptor(fdef), &st) == 0) &&
+		((unsigned long)st.st_size == DefSectionInfo.size) &&
+		((unsigned long)st.st_mtime == DefSectionInfo.mtime) &&
+		((unsigned long)st.st_ino == DefSectionInfo.inode))
+	usesections = TRUE;
+
     // Copy DEF file up to NETS line
     numnets = 0;
     numvias = 0;
-    while (fgets(line, MAX_LINE_LEN, fdef) != NULL) {
+    defpos = 0;
+    for (;;) {
+       if (usesections) {
+	  next = next_def_section(defpos);
+	  if (next > defpos)
+	     defpos += copy_def_block(fdef, Cmd, next - defpos);
+       }
+       if (fgets(line, MAX_LINE_LEN, fdef) == NULL) break;
+       defpos += (off_t)strlen(line);
        lptr = line;
        while (isspace(*lptr)) lptr++;
        if (!strncmp(lptr, "NETS", 4)) {
@@ -2900,6 +3257,9 @@ static void emit_routes(char *filename, double oscale, int iscale)
 			Numnets);
     }
 
+    // With multiple threads, write the nets' routes ahead of time
+    emitnets = emit_nets_parallel(oscale, iscale, &numemit);
+
     for (i = 0; i < numnets; i++) {
        char *instname, *pinname;
 
@@ -2982,10 +3342,12 @@ static void emit_routes(char *filename, double oscale, int iscale)
 	  /* Add last net terminal, without the semicolon */
 	  fputs(line, Cmd);
 
-	  emit_routed_net(Cmd, net, (u_char)0, oscale, iscale);
+	  if (!emit_net_buffered(Cmd, emitnets, numemit, net))
+	     emit_routed_net(Cmd, net, (u_char)0, oscale, iscale);
 	  fprintf(Cmd, ";\n");
        }
     }
+    emit_nets_done(emitnets, numemit);
 
     // Finish copying the rest of the NETS section
     if (errcond == FALSE) {
@@ -3033,7 +3395,15 @@ static void emit_routes(char *filename, double oscale, int iscale)
 
     // Finish copying the rest of the file.  Ignore ROUTED specialnets if
     // the nets are known nets and not power or ground nets.  FIXED or
-    // COVER nets are output verbatim.
+    // COVER nets are output verbatim.  Unless SPECIALNETS follows, that
+    // is the whole of the rest of the file.
+
+    if ((stubroutes == 0) || (usesections &&
+		(DefSectionInfo.specialnets < DefSectionInfo.nets)))
+       copy_def_block(fdef, Cmd, (off_t)(-1));
+    else if (usesections && ((defpos = ftello(fdef)) >= 0) &&
+		(DefSectionInfo.specialnets > defpos))
+       copy_def_block(fdef, Cmd, DefSectionInfo.specialnets - defpos);
 
     while (fgets(line, MAX_LINE_LEN, fdef) != NULL) {
        lptr = line;
@@ -3069,8 +3439,9 @@ static void emit_routes(char *filename, double oscale, int iscale)
 	  }
        }
     }
-    fclose(fdef);
-    fclose(Cmd);
+    ZFileClose(fdef);
+    if (ZFileClose(Cmd) != 0)
+	Fprintf(stderr, "emit_routes():  Error writing output (routed) DEF file.\n");
 
 } /* emit_routes() */
 
@@ -8,8 +8,6 @@
 #ifndef _OUTPUTINT_H
 #define _OUTPUTINT_H
 
-extern int  Pathon;
-
 /* Function prototypes */
 static void emit_routes(char *filename, double oscale, int iscale);
 
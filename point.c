@@ -1,7 +1,7 @@
 /*--------------------------------------------------------------*/
 /* point.c --							*/
 /*								*/
-/* Memory mapped point allocation				*/
+/* Memory mapped point and route record allocation		*/
 /*--------------------------------------------------------------*/
 /* Written by Tim Edwards, April 2017, based on code from Magic	*/
 /*--------------------------------------------------------------*/
@@ -10,105 +10,382 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "qrouter.h"
 #include "point.h"
 
+/*--------------------------------------------------------------*/
+/* Record stores (see point.h)					*/
+/*--------------------------------------------------------------*/
+
+static STORE_THREAD_LOCAL RecStore _point_store = {"point", sizeof(struct point_)};
+
+RecStore SEGStore      = {"seg",      sizeof(struct seg_)};
+RecStore ROUTEStore    = {"route",    sizeof(struct route_)};
+RecStore NETLISTStore  = {"netlist",  sizeof(struct netlist_)};
+RecStore DPOINTStore   = {"dpoint",   sizeof(struct dpoint_)};
+RecStore NODEINFOStore = {"nodeinfo", sizeof(struct nodeinfo_)};
+RecStore DesignArena   = {"design",   0};
+
+/* Arena used by allocDesign() in this thread */
+static STORE_THREAD_LOCAL RecStore *_design_arena = &DesignArena;
+
+RecStore *RecordStores[] = {
+    &SEGStore, &ROUTEStore, &NETLISTStore, &DPOINTStore, &NODEINFOStore,
+    &DesignArena, NULL
+};
+
+/* If set, new blocks are 2MB, aligned to 2MB, and backed by	*/
+/* huge pages where the system provides them.			*/
+
+u_char RecordStoreHugePages = FALSE;
+
+/* Each block begins with a header linking it into the list of	*/
+/* blocks owned by its store, so that a store can be released	*/
+/* in one pass over its blocks.					*/
+
+typedef struct blockhdr_ {
+    void   *next;
+    u_long  len;
+} BlockHdr;
+
+#define BLOCK_HEADER_SIZE ((sizeof(BlockHdr) + 15) & ~15)
+
+/* Design arena requests larger than this get a block of their	*/
+/* own rather than wasting the tail of a shared block.		*/
+
+#define ARENA_LARGE_REQUEST (RECORD_STORE_BLOCK_SIZE / 4)
+
 #ifdef HAVE_SYS_MMAN_H
 
-POINT POINTStoreFreeList = NULL;
-POINT POINTStoreFreeList_end = NULL;
+/* MMAP a block aligned to its own size, so that the kernel can	*/
+/* back it with a transparent huge page.  Over-map by one block	*/
+/* length and trim the excess from either end.			*/
+
+static void *
+mmapAlignedBlock(u_long map_len)
+{
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_ANON | MAP_PRIVATE;
+    char *block, *aligned;
+
+    block = (char *)mmap(NULL, 2 * map_len, prot, flags, -1, 0);
+    if ((void *)block == MAP_FAILED) return MAP_FAILED;
 
-/* The memory mapped POINT Allocation scheme */
+    aligned = (char *)(((unsigned long)block + map_len - 1) & ~(map_len - 1));
+    if (aligned > block)
+	munmap(block, aligned - block);
+    munmap(aligned + map_len, (block + map_len) - aligned);
 
-static void *_block_begin = NULL;
-static void *_current_ptr = NULL;
-static void *_block_end = NULL;
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, map_len, MADV_HUGEPAGE);
+#endif
+    return (void *)aligned;
+}
+
+/* MMAP a new (zero-filled) block of length map_len.		*/
 
-/* MMAP the point store */
-static signed char
-mmapPOINTStore()
+static void *
+mmapBlock(u_long map_len)
 {
     int prot = PROT_READ | PROT_WRITE;
     int flags = MAP_ANON | MAP_PRIVATE;
-    u_long map_len = POINT_STORE_BLOCK_SIZE; 	
+    void *block = MAP_FAILED;
+
+    if (RecordStoreHugePages && (map_len == RECORD_STORE_HUGE_BLOCK_SIZE)) {
+#ifdef MAP_HUGETLB
+	block = mmap(NULL, map_len, prot, flags | MAP_HUGETLB, -1, 0);
+#endif
+	if (block == MAP_FAILED)
+	    block = mmapAlignedBlock(map_len);
+    }
+    if (block == MAP_FAILED)
+	block = mmap(NULL, map_len, prot, flags, -1, 0);
 
-    _block_begin = mmap(NULL, map_len, prot, flags, -1, 0);
-    if (_block_begin == MAP_FAILED)
+    if (block == MAP_FAILED)
     {
-	fprintf(stderr, "mmapPOINTStore: Unable to mmap ANON SEGMENT\n");
+	fprintf(stderr, "mmapBlock: Unable to mmap ANON SEGMENT\n");
 	exit(1);
     }
-    _block_end = (void *) ((unsigned long) _block_begin + map_len);
-    _current_ptr = _block_begin;
-    return 0;
+    return block;
 }
 
-POINT
-allocPOINT()
+#define getBlock(len)		mmapBlock(len)
+#define releaseBlock(b, len)	munmap((b), (len))
+
+#else
+
+static void *
+callocBlock(u_long len)
 {
-    POINT _return_point = NULL;
+    void *block;
 
-    if (!_block_begin && !_block_end) mmapPOINTStore();
+    block = calloc(1, len);
+    if (block == NULL)
+    {
+	fprintf(stderr, "callocBlock: Unable to allocate memory\n");
+	exit(1);
+    }
+    return block;
+}
+
+#define getBlock(len)		callocBlock(len)
+#define releaseBlock(b, len)	free(b)
+
+#endif /* !HAVE_SYS_MMAN_H */
+
+/* Get a new block of at least "len" bytes and link it into	*/
+/* the store's block list.  Return the first usable address.	*/
 
-    /* Check if we can get the point from the 
-     * Free list
-     */
+static char *
+newBlock(RecStore *store, u_long len)
+{
+    BlockHdr *hdr;
 
-    if (POINTStoreFreeList) {
-	_return_point = POINTStoreFreeList;
-	POINTStoreFreeList = (POINT)POINTStoreFreeList->next;
-	return _return_point;
+    hdr = (BlockHdr *)getBlock(len);
+    hdr->len = len;
+    hdr->next = store->blocklist;
+    store->blocklist = (void *)hdr;
+    store->blocks++;
+    return (char *)hdr + BLOCK_HEADER_SIZE;
+}
+
+/* Start a new block for carving records.  Any unused tail of	*/
+/* the previous block is abandoned.				*/
+
+static void
+newRecordBlock(RecStore *store)
+{
+    u_long len;
+
+    len = (RecordStoreHugePages) ? RECORD_STORE_HUGE_BLOCK_SIZE :
+		RECORD_STORE_BLOCK_SIZE;
+    store->current = newBlock(store, len);
+    store->block_end = store->current + len - BLOCK_HEADER_SIZE;
+}
+
+void *
+allocRecord(RecStore *store)
+{
+    void *rec;
+
+    if (store->freelist) {
+	rec = store->freelist;
+	store->freelist = *(void **)rec;
+	store->hits++;
+	return rec;
     }
 
-    /* Get it from the mmap */
+    if ((store->current == NULL) ||
+		(store->current + store->size > store->block_end))
+	newRecordBlock(store);
 
-    if (((unsigned long)_current_ptr + sizeof(struct point_)) >
-		(unsigned long)_block_end)
-	 mmapPOINTStore();
+    rec = (void *)store->current;
+    store->current += store->size;
+    store->misses++;
+    return rec;
+}
 
-    _current_ptr  = (void *)((unsigned long)_current_ptr
-		+ sizeof(struct point_));
-	
-    if ((unsigned long)_current_ptr > (unsigned long) _block_end) {
-	fprintf(stderr,
-		"allocPOINT(): internal assertion failure.");
-	exit(1);
+void
+freeRecord(RecStore *store, void *rec)
+{
+    if (rec == NULL) return;
+    *(void **)rec = store->freelist;
+    store->freelist = rec;
+    store->frees++;
+}
+
+/* Release an entire linked list of records.  The list is	*/
+/* already threaded through the "next" pointer, so it is	*/
+/* spliced onto the front of the free list as it stands.	*/
+
+void
+freeRecordList(RecStore *store, void *list)
+{
+    void *rec;
+
+    if (list == NULL) return;
+    for (rec = list; *(void **)rec != NULL; rec = *(void **)rec)
+	store->frees++;
+    store->frees++;
+    *(void **)rec = store->freelist;
+    store->freelist = list;
+}
+
+/* Return all of a store's blocks to the system.  Every record	*/
+/* handed out by the store becomes invalid.			*/
+
+void
+releaseRecordStore(RecStore *store)
+{
+    BlockHdr *hdr, *next;
+
+    for (hdr = (BlockHdr *)store->blocklist; hdr; hdr = next) {
+	next = (BlockHdr *)hdr->next;
+	releaseBlock((void *)hdr, hdr->len);
     }
-    return (POINT)((unsigned long)_current_ptr - sizeof(struct point_));
+    store->blocklist = NULL;
+    store->freelist = NULL;
+    store->current = NULL;
+    store->block_end = NULL;
+    store->frees = store->hits + store->misses;
 }
 
+/* Move all of the blocks and free records of store "from"	*/
+/* into store "to", leaving "from" empty.  Records carved from	*/
+/* "from" remain valid and now belong to "to".  The unused tail	*/
+/* of the block "from" was carving is abandoned.		*/
+
 void
-freePOINT(POINT gp)
+mergeRecordStore(RecStore *to, RecStore *from)
 {
-    if (!POINTStoreFreeList_end || !POINTStoreFreeList) {
-	POINTStoreFreeList_end = gp;
-	gp->next = (POINT)NULL;
-	POINTStoreFreeList = POINTStoreFreeList_end;
+    BlockHdr *hdr;
+    void *rec;
+
+    if (from->blocklist != NULL) {
+	for (hdr = (BlockHdr *)from->blocklist; hdr->next; hdr = (BlockHdr *)hdr->next);
+	hdr->next = to->blocklist;
+	to->blocklist = from->blocklist;
     }
-    else {
-	POINTStoreFreeList_end->next = gp;
-	POINTStoreFreeList_end = gp;
-	POINTStoreFreeList_end->next = (POINT)NULL;
+    if (from->freelist != NULL) {
+	for (rec = from->freelist; *(void **)rec != NULL; rec = *(void **)rec);
+	*(void **)rec = to->freelist;
+	to->freelist = from->freelist;
     }
+    to->hits += from->hits;
+    to->misses += from->misses;
+    to->frees += from->frees;
+    to->blocks += from->blocks;
+
+    from->blocklist = NULL;
+    from->freelist = NULL;
+    from->current = NULL;
+    from->block_end = NULL;
+    from->hits = from->misses = from->frees = from->blocks = 0;
 }
 
-#else
+/*--------------------------------------------------------------*/
+/* Design arena (see point.h)					*/
+/*--------------------------------------------------------------*/
+
+void *
+allocDesign(size_t size)
+{
+    RecStore *arena = _design_arena;
+    char *rec;
+    u_long len;
+
+    size = (size + sizeof(double) - 1) & ~(sizeof(double) - 1);
+    arena->misses++;
+
+    if (size > ARENA_LARGE_REQUEST) {
+	len = (size + BLOCK_HEADER_SIZE + 4095) & ~4095;
+	return (void *)newBlock(arena, len);
+    }
+
+    if ((arena->current == NULL) || (arena->current + size > arena->block_end))
+	newRecordBlock(arena);
+
+    rec = arena->current;
+    arena->current += size;
+    return (void *)rec;
+}
+
+char *
+strdupDesign(const char *str)
+{
+    char *newstr;
+
+    newstr = (char *)allocDesign(strlen(str) + 1);
+    strcpy(newstr, str);
+    return newstr;
+}
+
+/* Direct this thread's design allocations to "arena" (or back	*/
+/* to DesignArena if NULL).  Returns the arena previously used.	*/
+
+RecStore *
+setDesignArena(RecStore *arena)
+{
+    RecStore *prev = _design_arena;
+
+    _design_arena = (arena) ? arena : &DesignArena;
+    return prev;
+}
+
+/* Release everything belonging to the current design.		*/
+
+void
+releaseDesign()
+{
+    releaseRecordStore(&DesignArena);
+    releaseRecordStore(&SEGStore);
+    releaseRecordStore(&ROUTEStore);
+    releaseRecordStore(&NETLISTStore);
+    releaseRecordStore(&DPOINTStore);
+    releaseRecordStore(&NODEINFOStore);
+}
+
+/*--------------------------------------------------------------*/
+/* POINT records, from the calling thread's store		*/
+/*--------------------------------------------------------------*/
+
+RecStore *
+POINTStore()
+{
+    return &_point_store;
+}
 
 POINT
 allocPOINT()
 {
-    POINT newpoint;
-
-    newpoint = (POINT)malloc((unsigned)(sizeof(struct point_)));
-    return (newpoint);
+    return (POINT)allocRecord(&_point_store);
 }
 
 void
 freePOINT(POINT gp)
 {
-    free((char *)gp);
+    freeRecord(&_point_store, (void *)gp);
 }
 
-#endif /* !HAVE_SYS_MMAN_H */
+/* Release a linked list of points, such as a route search	*/
+/* list or a predecessor chain, in one operation.		*/
 
+void
+freePOINTlist(POINT gp)
+{
+    freeRecordList(&_point_store, (void *)gp);
+}
+
+/*--------------------------------------------------------------*/
+/* ROUTE records own their list of segments, so releasing a	*/
+/* route releases its segments with it.				*/
+/*--------------------------------------------------------------*/
+
+ROUTE
+allocROUTE()
+{
+    return (ROUTE)allocRecord(&ROUTEStore);
+}
+
+void
+freeROUTE(ROUTE rt)
+{
+    if (rt == NULL) return;
+    freeSEGlist(rt->segments);
+    freeRecord(&ROUTEStore, (void *)rt);
+}
+
+/* Release a whole chain of routes, such as a net's route list	*/
+/* when the net is ripped up.					*/
+
+void
+freeROUTElist(ROUTE rt)
+{
+    ROUTE r;
+
+    for (r = rt; r; r = r->next)
+	freeSEGlist(r->segments);
+    freeRecordList(&ROUTEStore, (void *)rt);
+}
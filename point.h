@@ -9,14 +9,109 @@
 #ifdef HAVE_SYS_MMAN_H
 #include <sys/mman.h>
 #include <unistd.h>
+#endif /* HAVE_SYS_MMAN_H */
+
+/*--------------------------------------------------------------*/
+/* Typed record stores.  Points, route segments, route headers,	*/
+/* net lists and tap points are allocated and released		*/
+/* constantly during routing and rip-up.  Each record type gets	*/
+/* its own store, carved out of mmap'd blocks.  Released	*/
+/* records are kept on a per-store free list threaded through	*/
+/* the "next" pointer, which is the first member of every	*/
+/* record type handled here.  The free list is last in, first	*/
+/* out, so that the most recently released (and most likely	*/
+/* cached) record is the next one handed out.			*/
+/*--------------------------------------------------------------*/
 
 /* Page size is 4KB so we mmap a segment equal to 64 pages */
-#define POINT_STORE_BLOCK_SIZE (4 * 1024 * 64)
+#define RECORD_STORE_BLOCK_SIZE (4 * 1024 * 64)
 
-extern POINT PointStoreFreeList;
-extern POINT PointStoreFreeList_end;
+/* Block size when huge pages are requested (one 2MB page) */
+#define RECORD_STORE_HUGE_BLOCK_SIZE (2 * 1024 * 1024)
 
-#endif /* HAVE_SYS_MMAN_H */
+/* The POINT store is used by the maze search and is kept per	*/
+/* thread, so that concurrent searches do not share a free	*/
+/* list.  Other stores are global.				*/
+
+#if defined(__GNUC__) && !defined(__APPLE__)
+#define STORE_THREAD_LOCAL __thread
+#define HAVE_STORE_THREAD_LOCAL
+#else
+#define STORE_THREAD_LOCAL
+#endif
+
+typedef struct recstore_ {
+    char   *name;		/* Record type name, for statistics	*/
+    size_t  size;		/* Size of one record in bytes		*/
+    void   *freelist;		/* Released records, last in first out	*/
+    void   *blocklist;		/* Blocks owned by this store		*/
+    char   *current;		/* Next unused record in current block	*/
+    char   *block_end;		/* End of current block			*/
+    u_long  hits;		/* Allocations satisfied by free list	*/
+    u_long  misses;		/* Allocations taken from a new record	*/
+    u_long  frees;		/* Records released			*/
+    u_long  blocks;		/* Number of blocks obtained		*/
+} RecStore;
+
+extern RecStore SEGStore;
+extern RecStore ROUTEStore;
+extern RecStore NETLISTStore;
+extern RecStore DPOINTStore;
+extern RecStore NODEINFOStore;
+extern RecStore DesignArena;
+
+extern RecStore *RecordStores[];	/* NULL-terminated list of the above */
+extern u_char RecordStoreHugePages;
+
+extern void *allocRecord(RecStore *store);
+extern void freeRecord(RecStore *store, void *rec);
+extern void freeRecordList(RecStore *store, void *list);
+extern void releaseRecordStore(RecStore *store);
+extern void mergeRecordStore(RecStore *to, RecStore *from);
+
+/*--------------------------------------------------------------*/
+/* The design arena holds variable-sized records that live	*/
+/* exactly as long as the current DEF design:  nets, nodes,	*/
+/* gate instances and their arrays and tap geometry, and the	*/
+/* names of all of these.  Memory from the arena is returned	*/
+/* zeroed and is never freed individually.  The arena, along	*/
+/* with the SEG, ROUTE, NETLIST, DPOINT and NODEINFO stores,	*/
+/* is released all at once by releaseDesign() when a new DEF	*/
+/* file is read.						*/
+/*--------------------------------------------------------------*/
+
+extern void *allocDesign(size_t size);
+extern char *strdupDesign(const char *str);
+extern void releaseDesign();
+
+/* A worker thread building part of the design (such as a	*/
+/* chunk of the DEF file) may direct its allocations to an	*/
+/* arena of its own, which is merged into DesignArena when the	*/
+/* thread is done.						*/
+
+extern RecStore *setDesignArena(RecStore *arena);
+
+extern RecStore *POINTStore();		/* This thread's POINT store */
 
 extern POINT allocPOINT();
 extern void freePOINT(POINT gp);
+extern void freePOINTlist(POINT gp);
+
+#define allocSEG()		((SEG)allocRecord(&SEGStore))
+#define freeSEG(s)		freeRecord(&SEGStore, (void *)(s))
+#define freeSEGlist(s)		freeRecordList(&SEGStore, (void *)(s))
+
+#define allocNETLIST()		((NETLIST)allocRecord(&NETLISTStore))
+#define freeNETLIST(nl)		freeRecord(&NETLISTStore, (void *)(nl))
+#define freeNETLISTlist(nl)	freeRecordList(&NETLISTStore, (void *)(nl))
+
+#define allocDPOINT()		((DPOINT)allocRecord(&DPOINTStore))
+#define freeDPOINT(dp)		freeRecord(&DPOINTStore, (void *)(dp))
+#define freeDPOINTlist(dp)	freeRecordList(&DPOINTStore, (void *)(dp))
+
+#define allocNODEINFO()		((NODEINFO)allocRecord(&NODEINFOStore))
+#define freeNODEINFO(ni)	freeRecord(&NODEINFOStore, (void *)(ni))
+
+extern ROUTE allocROUTE();
+extern void freeROUTE(ROUTE rt);
+extern void freeROUTElist(ROUTE rt);
@@ -234,7 +234,15 @@ int read_config(FILE *fconfig, int is_info)
 	lineptr = line;
 	while (isspace(*lineptr)) lineptr++;
 
-	if (!strncasecmp(lineptr, "lef", 3) || !strncmp(lineptr, "read_lef", 8)) {
+	if (!strncasecmp(lineptr, "lef_cache", 9)) {
+	    if ((i = sscanf(lineptr, "%*s %s\n", sarg)) == 1) {
+	       // Argument is a directory in which to keep parsed LEF
+	       // files for fast reloading, or "none"
+	       OK = 1;
+	       LefSetCacheDir(sarg);
+	    }
+	}
+	else if (!strncasecmp(lineptr, "lef", 3) || !strncmp(lineptr, "read_lef", 8)) {
 	    int mscale;
 	    if ((i = sscanf(lineptr, "%*s %s\n", sarg)) == 1) {
 	       // Argument is a filename of a LEF file from which we
@@ -441,6 +449,7 @@ int read_config(FILE *fconfig, int is_info)
 	    gateinfo = (GATE)malloc(sizeof(struct gate_));
 	    gateinfo->gatename = strdup(sarg);
 	    gateinfo->gatetype = NULL;
+	    gateinfo->pinindex = NULL;
 	    gateinfo->width = darg;
 	    gateinfo->height = darg2;
 	    gateinfo->placedX = 0.0;	// implicit cell origin
@@ -460,6 +469,7 @@ int read_config(FILE *fconfig, int is_info)
 	    gateinfo->node[0] = NULL;
  
 	    GateInfo = gateinfo;
+	    LefHashCell(gateinfo);
 	}
 	
         if ((i = sscanf(lineptr, "endgate %s\n", sarg)) == 1) {
@@ -25,10 +25,13 @@
 #include "node.h"
 #include "maze.h"
 #include "mask.h"
+#include "bitplane.h"
 #include "output.h"
 #include "lef.h"
 #include "def.h"
 #include "graphics.h"
+#include "checkpoint.h"
+#include "zfile.h"
 
 int  TotalRoutes = 0;
 
@@ -41,7 +44,7 @@ GATE	PinMacro;	// macro definition for a pin
 GATE    Nlgates;	// gate instance information
 NETLIST FailedNets;	// list of nets that failed to route
 
-u_int    *Obs[MAX_LAYERS];      // net obstructions in layer
+obsword  *Obs[MAX_LAYERS];      // net obstructions in layer
 PROUTE   *Obs2[MAX_LAYERS];     // used for pt->pt routes on layer
 ObsInfoRec *Obsinfo[MAX_LAYERS];  // temporary array used for detailed obstruction info
 NODEINFO *Nodeinfo[MAX_LAYERS]; // nodes and stub information is here. . .
@@ -65,6 +68,7 @@ u_char mapType = MAP_OBSTRUCT | DRAW_ROUTES;
 u_char ripLimit = 10;	// Fail net rather than rip up more than
 			// this number of other nets.
 u_char unblockAll = FALSE;
+int    NumThreads = 1;	// Worker threads for parallel tasks (1 = serial)
 
 char *DEFfilename = NULL;
 char *delayfilename = NULL;
@@ -202,8 +206,8 @@ int allocate_obs_array(void)
    if (Obs[0] != NULL) return 0;	/* Already been called */
 
    for (i = 0; i < Num_layers; i++) {
-      Obs[i] = (u_int *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(u_int));
+      Obs[i] = (obsword *)calloc(NumChannelsX * NumChannelsY,
+			sizeof(obsword));
       if (!Obs[i]) {
 	 Fprintf(stderr, "Out of memory 4.\n");
 	 return(4);
@@ -250,7 +254,7 @@ runqrouter(int argc, char *argv[])
    static char configdefault[] = CONFIGFILENAME;
    char *configfile = configdefault;
    char *infofile = NULL;
-   char *dotptr;
+   char *dotptr, *zsuffix;
    char *Filename = NULL;
    u_char readconfig = FALSE;
    u_char doscript = FALSE;
@@ -280,6 +284,9 @@ runqrouter(int argc, char *argv[])
 	    case 'g':
 	    case 'r':
 	    case 's':
+	    case 't':
+	    case 'S':
+	    case 'L':
 	       argsep = *(argv[i] + 2);
 	       if (argsep == '\0') {
 		  i++;
@@ -335,6 +342,32 @@ runqrouter(int argc, char *argv[])
 		   Scales.iscale = 1;
 	       }
 	       break;
+	    case 't':
+	       if ((sscanf(optarg, "%d", &NumThreads) != 1) || (NumThreads < 1)) {
+		   Fprintf(stderr, "Bad thread count \"%s\", positive "
+			"integer expected.\n", optarg);
+		   NumThreads = 1;
+	       }
+	       break;
+#ifdef TCL_QROUTER
+	    // The Tcl version has no fixed route sequence to checkpoint;
+	    // scripts use the save_checkpoint and load_checkpoint commands.
+	    case 'S':
+	    case 'L':
+	       Fprintf(stderr, "Option -%c is not available in the Tcl version;"
+			" use the %s_checkpoint command.\n", optc,
+			(optc == 'S') ? "save" : "load");
+	       break;
+#else
+	    case 'S':
+	       if (ckptsavename != NULL) free(ckptsavename);
+	       ckptsavename = strdup(optarg);
+	       break;
+	    case 'L':
+	       if (ckptloadname != NULL) free(ckptloadname);
+	       ckptloadname = strdup(optarg);
+	       break;
+#endif
 	    case 'h':
 	       helpmessage();
 	       return 1;
@@ -442,13 +475,19 @@ runqrouter(int argc, char *argv[])
 
    if (Filename != NULL) {
 
-      /* process last non-option string */
+      /* process last non-option string.  A compression suffix	*/
+      /* (".gz" or ".zst") is kept.				*/
 
+      zsuffix = ZFileSuffix(Filename);
+      if (zsuffix != NULL) *zsuffix++ = '\0';
       dotptr = strrchr(Filename, '.');
       if (dotptr != NULL) *dotptr = '\0';
       if (DEFfilename != NULL) free(DEFfilename);
-      DEFfilename = (char *)malloc(strlen(Filename) + 5);
-      sprintf(DEFfilename, "%s.def", Filename);
+      DEFfilename = (char *)malloc(strlen(Filename) + 10);
+      if (zsuffix != NULL)
+	 sprintf(DEFfilename, "%s.def.%s", Filename, zsuffix);
+      else
+	 sprintf(DEFfilename, "%s.def", Filename);
    }
    else if (readconfig) {
       Fprintf(stdout, "No netlist file specified, continuing without.\n");
@@ -457,7 +496,7 @@ runqrouter(int argc, char *argv[])
       helpmessage();
    }
 
-   Obs[0] = (u_int *)NULL;
+   Obs[0] = (obsword *)NULL;
    NumChannelsX = 0;	// This is so we can check if NumChannelsX/Y were
 			// set from within DefRead() due to reading in
 			// existing nets.
@@ -485,7 +524,7 @@ u_char remove_from_failed(NET net)
 		FailedNets = nl->next;
 	    else
 		lastnl->next = nl->next;
-	    free(nl);
+	    freeNETLIST(nl);
 	    return TRUE;
 	}
 	lastnl = nl;
@@ -501,12 +540,8 @@ u_char remove_from_failed(NET net)
 
 void remove_failed()
 {
-    NETLIST nl;
-    while (FailedNets) {
-	nl = FailedNets;
-	FailedNets = FailedNets->next;
-	free(nl);
-    }
+    freeNETLISTlist(FailedNets);
+    FailedNets = NULL;
 }
 
 /*--------------------------------------------------------------*/
@@ -516,16 +551,10 @@ void remove_failed()
 void remove_top_route(NET net)
 {
     ROUTE rt;
-    SEG seg;
 
     rt = net->routes;
     net->routes = net->routes->next;
-    while (rt->segments) {
-	seg = rt->segments;
-	rt->segments = rt->segments->next;
-	    free(seg);
-    }
-    free(rt);
+    freeROUTE(rt);
 }
 
 /*--------------------------------------------------------------*/
@@ -536,22 +565,12 @@ void remove_top_route(NET net)
 
 static void reinitialize()
 {
-    int i, j;
-    NETLIST nl;
-    NET net;
-    ROUTE rt;
-    SEG seg;
-    DSEG obs, tap;
-    NODE node;
-    GATE gate;
-    DPOINT dpt;
+    int i;
 
-    // Free up all of the matrices
+    // Free up all of the matrices.  Nodeinfo records are in
+    // the design's NODEINFO store, so only the arrays are freed.
 
     for (i = 0; i < Pinlayers; i++) {
-	for (j = 0; j < NumChannelsX * NumChannelsY; j++)
-	    if (Nodeinfo[i][j])
-		free(Nodeinfo[i][j]);
 	free(Nodeinfo[i]);
 	Nodeinfo[i] = NULL;
     }
@@ -562,76 +581,200 @@ static void reinitialize()
 	Obs2[i] = NULL;
 	Obs[i] = NULL;
     }
+    free_obs_planes();
     if (RMask != NULL) {
 	free(RMask);
 	RMask = NULL;
     }
 
-    // Free the netlist of failed nets (if there is one)
+    // All nets, nodes, gates, routes, net lists and tap records
+    // belong to the design and are released together.
 
-    remove_failed();
+    free(Nlnets);
+    Nlnets = NULL;
+    Numnets = 0;
+    Nlgates = NULL;
+    FailedNets = NULL;
+    TotalRoutes = 0;
 
-    // Free all net and route information
+    // The route grid is set up again for the next design.
 
-    for (i = 0; i < Numnets; i++) {
-	net = Nlnets[i];
-	while (net->noripup) {
-	    nl = net->noripup;
-	    net->noripup = net->noripup->next;
-	    free(nl);
-	}
-	while (net->routes)
-            remove_top_route(net);
+    NumChannelsX = NumChannelsY = 0;
 
-	while (net->netnodes) {
-	    node = net->netnodes;
-	    net->netnodes = net->netnodes->next;
+    releaseDesign();
+    DefReset();
+}
 
-	    while (node->taps) {
-		dpt = node->taps;
-		node->taps = node->taps->next;
-		free(dpt);
-	    }
-	    while (node->extend) {
-		dpt = node->extend;
-		node->extend = node->extend->next;
-		free(dpt);
-	    }
-	    // Note: node->netname is not allocated
-	    // but copied from net record
-	    free(node);
-	}
-	free (net->netname);
-	free (net);
+/*--------------------------------------------------------------*/
+/* save_setup ---						*/
+/*								*/
+/* Record the settings made by the configuration file and by	*/
+/* commands (pitches, layer directions, costs, net lists,	*/
+/* obstructions, and so on), which reading a DEF file or	*/
+/* routing a design may change.  restore_setup() releases the	*/
+/* current design and returns all of them to the recorded	*/
+/* values, so that the next design is set up exactly as if it	*/
+/* were the first one read.  LEF data is not recorded.		*/
+/*--------------------------------------------------------------*/
+
+static struct {
+    u_char  valid;
+    double  pitchx, pitchy;
+    double  xlower, xupper, ylower, yupper;
+    int     vert[MAX_LAYERS];
+    u_char  needblock[MAX_LAYERS];
+    int     num_layers;
+    ScaleRec scales;
+    int     cost[7];
+    int     numpasses;
+    char    stacked;
+    u_char  verbose, force, mask, riplimit, unblock, maptype;
+    u_int   mineffort;
+    int     numthreads;
+    char    *vdd, *gnd;
+    STRING  dontroute, critical;
+    DSEG    userobs;
+} Setup = {FALSE};
+
+static STRING copy_string_list(STRING list)
+{
+    STRING copy = NULL;
+
+    for (; list; list = list->next)
+	string_list_append(&copy, list->name);
+    return copy;
+}
+
+static void free_string_list(STRING list)
+{
+    STRING next;
+
+    for (; list; list = next) {
+	next = list->next;
+	free(list->name);
+	free(list);
     }
-    free(Nlnets);
-    Nlnets = NULL;
-    Numnets = 0;
+}
 
-    // Free all gates information
+static DSEG copy_dseg_list(DSEG list)
+{
+    DSEG copy = NULL, last = NULL, ds;
+
+    for (; list; list = list->next) {
+	ds = (DSEG)malloc(sizeof(struct dseg_));
+	*ds = *list;
+	ds->next = NULL;
+	if (last) last->next = ds; else copy = ds;
+	last = ds;
+    }
+    return copy;
+}
 
-    while (Nlgates) {
-	gate = Nlgates;
-	Nlgates = Nlgates->next;
-	while (gate->obs) {
-	    obs = gate->obs;
-	    gate->obs = gate->obs->next;
-	    free(obs);
-	}
-	for (i = 0; i < gate->nodes; i++) {
-	    while (gate->taps[i]) {
-	        tap = gate->taps[i];
-		gate->taps[i] = gate->taps[i]->next;
-		free(tap);
-	    }
-	    // Note: gate->node[i] is not allocated
-	    // but copied from cell record in GateInfo
-	    // Likewise for gate->noderec[i]
-	}
+static void free_dseg_list(DSEG list)
+{
+    DSEG next;
 
-	free(gate->gatename);
+    for (; list; list = next) {
+	next = list->next;
+	free(list);
     }
-    Nlgates = NULL;
+}
+
+void save_setup()
+{
+    if (Setup.valid) {
+	free(Setup.vdd);
+	free(Setup.gnd);
+	free_string_list(Setup.dontroute);
+	free_string_list(Setup.critical);
+	free_dseg_list(Setup.userobs);
+    }
+    Setup.pitchx = PitchX;
+    Setup.pitchy = PitchY;
+    Setup.xlower = Xlowerbound;
+    Setup.xupper = Xupperbound;
+    Setup.ylower = Ylowerbound;
+    Setup.yupper = Yupperbound;
+    memcpy(Setup.vert, Vert, sizeof(Vert));
+    memcpy(Setup.needblock, needblock, sizeof(needblock));
+    Setup.num_layers = Num_layers;
+    Setup.scales = Scales;
+    Setup.cost[0] = SegCost;
+    Setup.cost[1] = ViaCost;
+    Setup.cost[2] = JogCost;
+    Setup.cost[3] = XverCost;
+    Setup.cost[4] = BlockCost;
+    Setup.cost[5] = OffsetCost;
+    Setup.cost[6] = ConflictCost;
+    Setup.numpasses = Numpasses;
+    Setup.stacked = StackedContacts;
+    Setup.verbose = Verbose;
+    Setup.force = forceRoutable;
+    Setup.mask = maskMode;
+    Setup.riplimit = ripLimit;
+    Setup.unblock = unblockAll;
+    Setup.maptype = mapType;
+    Setup.mineffort = minEffort;
+    Setup.numthreads = NumThreads;
+    Setup.vdd = (vddnet) ? strdup(vddnet) : NULL;
+    Setup.gnd = (gndnet) ? strdup(gndnet) : NULL;
+    Setup.dontroute = copy_string_list(DontRoute);
+    Setup.critical = copy_string_list(CriticalNet);
+    Setup.userobs = copy_dseg_list(UserObs);
+    Setup.valid = TRUE;
+}
+
+void restore_setup()
+{
+    if (!Setup.valid) return;
+
+    // Release the design first, as it depends on the grid.
+
+    if (DEFfilename != NULL) {
+	reinitialize();
+	free(DEFfilename);
+	DEFfilename = NULL;
+    }
+
+    PitchX = Setup.pitchx;
+    PitchY = Setup.pitchy;
+    Xlowerbound = Setup.xlower;
+    Xupperbound = Setup.xupper;
+    Ylowerbound = Setup.ylower;
+    Yupperbound = Setup.yupper;
+    memcpy(Vert, Setup.vert, sizeof(Vert));
+    memcpy(needblock, Setup.needblock, sizeof(needblock));
+    Num_layers = Setup.num_layers;
+    Scales = Setup.scales;
+    SegCost = Setup.cost[0];
+    ViaCost = Setup.cost[1];
+    JogCost = Setup.cost[2];
+    XverCost = Setup.cost[3];
+    BlockCost = Setup.cost[4];
+    OffsetCost = Setup.cost[5];
+    ConflictCost = Setup.cost[6];
+    Numpasses = Setup.numpasses;
+    StackedContacts = Setup.stacked;
+    Verbose = Setup.verbose;
+    forceRoutable = Setup.force;
+    maskMode = Setup.mask;
+    ripLimit = Setup.riplimit;
+    unblockAll = Setup.unblock;
+    mapType = Setup.maptype;
+    minEffort = Setup.mineffort;
+    NumThreads = Setup.numthreads;
+
+    if (vddnet) free(vddnet);
+    vddnet = (Setup.vdd) ? strdup(Setup.vdd) : NULL;
+    if (gndnet) free(gndnet);
+    gndnet = (Setup.gnd) ? strdup(Setup.gnd) : NULL;
+
+    free_string_list(DontRoute);
+    DontRoute = copy_string_list(Setup.dontroute);
+    free_string_list(CriticalNet);
+    CriticalNet = copy_string_list(Setup.critical);
+    free_dseg_list(UserObs);
+    UserObs = copy_dseg_list(Setup.userobs);
 }
 
 /*--------------------------------------------------------------*/
@@ -858,7 +1001,7 @@ static int post_def_setup()
 
    if (Verbose > 1)
       Fprintf(stderr, "Diagnostic: memory block is %d bytes\n",
-		(int)sizeof(u_int) * NumChannelsX * NumChannelsY);
+		(int)sizeof(obsword) * NumChannelsX * NumChannelsY);
 
    /* If any watch points were made, make sure that they have	*/
    /* the correct geometry values, since they were made before	*/
@@ -893,8 +1036,10 @@ static int post_def_setup()
    count_reachable_taps(unblockAll);
    count_pinlayers();
    
-   // If any nets are pre-routed, calculate route endpoints, and
-   // place those routes.
+   // If any nets are pre-routed, check the routes, calculate route
+   // endpoints, and place those routes.
+
+   check_def_routes();
 
    for (i = 0; i < Numnets; i++) {
       net = Nlnets[i];
@@ -925,6 +1070,12 @@ static int post_def_setup()
    remove_tap_blocks(GND_NET);
    remove_tap_blocks(ANTENNA_NET);
 
+   // Obstructions are now final.  Derive the obstruction bitplanes,
+   // which are kept up to date from here on as routes are committed
+   // and ripped up.
+
+   build_obs_planes();
+
    // Now we have netlist data, and can use it to get a list of nets.
 
    FailedNets = (NETLIST)NULL;
@@ -1000,7 +1151,12 @@ int dofirststage(u_char graphdebug, int debug_netnum)
    for (i = (debug_netnum >= 0) ? debug_netnum : 0; i < Numnets; i++) {
 
       net = getnettoroute(i);
-      if ((net != NULL) && (net->netnodes != NULL)) {
+      if ((net != NULL) && (net->flags & NET_KEPT)) {
+	 if (Verbose > 0)
+	    Fprintf(stdout, "Keeping route for net %s\n", net->netname);
+	 remaining--;
+      }
+      else if ((net != NULL) && (net->netnodes != NULL)) {
 	 result = doroute(net, FALSE, graphdebug);
 	 if (result == 0) {
 	    remaining--;
@@ -1101,11 +1257,7 @@ static int ripup_colliding(NET net, u_char onlybreak)
     // cause the number of failed nets to keep increasing.
 
     if (ripped > ripLimit) {
-	while (nl) {
-	    nl2 = nl->next;
-	    free(nl);
-	    nl = nl2;
-	}
+	freeNETLISTlist(nl);
 	return -1;
     }
 
@@ -1129,7 +1281,7 @@ static int ripup_colliding(NET net, u_char onlybreak)
 	    // routed over again by the net.  Avoids infinite looping in
 	    // the second stage.
 
-	    fn = (NETLIST)malloc(sizeof(struct netlist_));
+	    fn = allocNETLIST();
 	    fn->next = net->noripup;
 	    net->noripup = fn;
 	    fn->net = nl->net;
@@ -1156,7 +1308,7 @@ int route_net_ripup(NET net, u_char graphdebug, u_char onlybreak)
 	if (FailedNets->net == net) {
 	    nl2 = FailedNets;
 	    FailedNets = FailedNets->next;
-	    free(nl2);
+	    freeNETLIST(nl2);
 	}
 	else {
 	    for (nl = FailedNets; nl->next; nl = nl->next) {
@@ -1165,7 +1317,7 @@ int route_net_ripup(NET net, u_char graphdebug, u_char onlybreak)
 	    }
 	    nl2 = nl->next;
 	    nl->next = nl2->next;
-	    free(nl2);
+	    freeNETLIST(nl2);
 	}
     }
 
@@ -1175,11 +1327,8 @@ int route_net_ripup(NET net, u_char graphdebug, u_char onlybreak)
 	    if ((net->flags & NET_PENDING) == 0) {
 		// Clear this net's "noripup" list and try again.
 
-		while (net->noripup) {
-		    nl = net->noripup->next;
-		    free(net->noripup);
-		    net->noripup = nl;
-		}
+		freeNETLISTlist(net->noripup);
+		net->noripup = NULL;
 		result = doroute(net, TRUE, graphdebug);
 		net->flags |= NET_PENDING;	// Next time we abandon it.
 	    }
@@ -1217,7 +1366,6 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
    NETLIST nl, nl2;
    NETLIST Abandoned;	// Abandoned routes---not even trying any more.
    ROUTE rt, rt2;
-   SEG seg;
    u_int loceffort = (effort > minEffort) ? effort : minEffort;
 
    fillMask((u_char)0);
@@ -1229,11 +1377,8 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
 
    for (nl2 = FailedNets; nl2; nl2 = nl2->next) {
        net = nl2->net;
-       while (net->noripup) {
-          nl = net->noripup->next;
-          free(net->noripup);
-          net->noripup = nl;
-       }
+       freeNETLISTlist(net->noripup);
+       net->noripup = NULL;
        net->flags &= ~NET_PENDING;
    }
 
@@ -1250,7 +1395,7 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
       // Remove this net from the fail list
       nl2 = FailedNets;
       FailedNets = FailedNets->next;
-      free(nl2);
+      freeNETLIST(nl2);
 
       // Keep track of which routes existed before the call to doroute().
       for (rt = net->routes; rt && rt->next; rt = rt->next);
@@ -1266,11 +1411,8 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
 	    if ((net->flags & NET_PENDING) == 0) {
 	       // Clear this net's "noripup" list and try again.
 
-	       while (net->noripup) {
-	          nl = net->noripup->next;
-	          free(net->noripup);
-	          net->noripup = nl;
-	       }
+	       freeNETLISTlist(net->noripup);
+	       net->noripup = NULL;
 	       result = doroute(net, TRUE, graphdebug);
 	       net->flags |= NET_PENDING;	// Next time we abandon it.
 	    }
@@ -1300,14 +1442,14 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
 			net->netname);
 
 	 // Add the net to the "abandoned" list
-	 nl = (NETLIST)malloc(sizeof(struct netlist_));
+	 nl = allocNETLIST();
 	 nl->net = net;
 	 nl->next = Abandoned;
 	 Abandoned = nl;
 
 	 while (FailedNets && (FailedNets->net == net)) {
 	    nl = FailedNets->next;
-	    free(FailedNets);
+	    freeNETLIST(FailedNets);
 	    FailedNets = nl;
 	 }
 
@@ -1322,16 +1464,7 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
 	    rt->next = NULL;
 	    rt = rt2;
 	 }
-	 while (rt != NULL) {
-	    rt2 = rt->next;
-            while (rt->segments) {
-              seg = rt->segments->next;
-              free(rt->segments);
-              rt->segments = seg;
-            }
-	    free(rt);
-	    rt = rt2;
-	 }
+	 freeROUTElist(rt);
 
 	 // Remove both routing information and remove the route from
 	 // Obs[] for all parts of the net that were previously routed
@@ -1431,6 +1564,15 @@ int dothirdstage(u_char graphdebug, int debug_netnum, u_int effort)
 	 // segments, then rerouting is almost certainly a waste of
 	 // time.
 
+	 // Routes kept by an ECO are not touched.
+
+	 if (!failed && (net->flags & NET_KEPT)) {
+	    if (Verbose > 0)
+	       Fprintf(stdout, "Keeping route for net %s\n", net->netname);
+	    remaining--;
+	    continue;
+	 }
+
 	 if (!failed) {
 	    for (rt = net->routes; rt; rt = rt->next) {
 	       int j;
@@ -1481,7 +1623,7 @@ int dothirdstage(u_char graphdebug, int debug_netnum, u_int effort)
 	    /* Pull net from FailedNets, since we restored it. */
 	    if (FailedNets && (FailedNets->net == net)) {
 	       nl = FailedNets->next;
-	       free(FailedNets);
+	       freeNETLIST(FailedNets);
 	       FailedNets = nl;
 	    }
 	 }
@@ -1549,13 +1691,12 @@ free_glist(struct routeinfo_ *iroute)
    int i;
    
    for (i = 0; i < 6; i++) {
-      while (iroute->glist[i]) {
-         gpoint = iroute->glist[i];
-         iroute->glist[i] = iroute->glist[i]->next;
+      for (gpoint = iroute->glist[i]; gpoint; gpoint = gpoint->next) {
          Pr = &OBS2VAL(gpoint->x1, gpoint->y1, gpoint->layer);
          Pr->flags &= ~PR_ON_STACK;
-         freePOINT(gpoint);
       }
+      freePOINTlist(iroute->glist[i]);
+      iroute->glist[i] = NULL;
    }
 }
 
@@ -1636,11 +1777,11 @@ int doroute(NET net, u_char stage, u_char graphdebug)
 	// working on this net and move on to the next.
 	if (FailedNets && (FailedNets->net == net)) break;
 
-	nlist = (NETLIST)malloc(sizeof(struct netlist_));
+	nlist = allocNETLIST();
 	nlist->net = net;
 	nlist->next = FailedNets;
 	FailedNets = nlist;
-	free(rt1);
+	freeROUTE(rt1);
      }
      else {
 
@@ -1671,7 +1812,7 @@ int doroute(NET net, u_char stage, u_char graphdebug)
   /* Route failure due to no taps or similar error---Log it */
   if ((result < 0) || (unroutable > 0)) {
      if ((FailedNets == NULL) || (FailedNets->net != net)) {
-	nlist = (NETLIST)malloc(sizeof(struct netlist_));
+	nlist = allocNETLIST();
 	nlist->net = net;
 	nlist->next = FailedNets;
 	FailedNets = nlist;
@@ -1806,7 +1947,7 @@ static int next_route_setup(struct routeinfo_ *iroute, u_char stage)
 static int route_setup(struct routeinfo_ *iroute, u_char stage)
 {
   int  i, j;
-  u_int netnum, dir;
+  obsword netnum;
   int  result, rval, unroutable;
   NODE node;
   NODEINFO lnode;
@@ -2018,7 +2159,7 @@ int route_segs(struct routeinfo_ *iroute, u_char stage, u_char graphdebug)
   POINT gpoint, gunproc, newpt;
   int  i, o;
   int  pass, maskpass;
-  u_int forbid;
+  obsword forbid;
   GRIDP best, curpt;
   int rval;
   u_char first = TRUE;
@@ -2338,7 +2479,7 @@ done:
 /* createemptyroute - begin a ROUTE structure			*/
 /*								*/
 /*   ARGS: a nodes						*/
-/*   RETURNS: ROUTE calloc'd and ready to begin			*/
+/*   RETURNS: ROUTE allocated and ready to begin		*/
 /*   SIDE EFFECTS: 						*/
 /*   AUTHOR and DATE: steve beccue      Fri Aug 8		*/
 /*--------------------------------------------------------------*/
@@ -2347,7 +2488,7 @@ ROUTE createemptyroute(void)
 {
    ROUTE rt;
 
-   rt = (ROUTE)calloc(1, sizeof(struct route_));
+   rt = allocROUTE();
    rt->netnum = 0;
    rt->segments = (SEG)NULL;
    rt->flags = (u_char)0;
@@ -2388,6 +2529,11 @@ static void helpmessage(void)
 	Fprintf(stdout, "\t-r <value>\t\t\tForce output resolution scale.\n");
 	Fprintf(stdout, "\t-f       \t\t\tForce all pins to be routable.\n");
 	Fprintf(stdout, "\t-e <level>\t\t\tLevel of effort to keep trying.\n");
+	Fprintf(stdout, "\t-t <count>\t\t\tNumber of threads for parallel tasks.\n");
+#ifndef TCL_QROUTER
+	Fprintf(stdout, "\t-S <file>\t\t\tSave a routing checkpoint after routing.\n");
+	Fprintf(stdout, "\t-L <file>\t\t\tResume routing from a checkpoint.\n");
+#endif
 	Fprintf(stdout, "\n");
     }
 #ifdef TCL_QROUTER
@@ -39,6 +39,13 @@ typedef unsigned long  u_long;
 #endif
 #endif /* _SYS_TYPES_H */
 
+/* Type of one grid position entry in Obs[] (see below) */
+#ifdef OBS_WIDE
+typedef unsigned long long obsword;
+#else
+typedef u_int obsword;
+#endif
+
 /* Compare functions aren't defined in the Mac's standard library */
 #if defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
 typedef int (*__compar_fn_t)(const void*, const void*);
@@ -122,7 +129,7 @@ struct proute_ {        // partial route
    u_short flags; 	// values PR_PROCESSED and PR_CONFLICT, and others
    union {
       u_int cost;	// cost of route coming from predecessor
-      u_int net;	// net number at route point
+      obsword net;	// net number at route point
    } prdata;
 };
 
@@ -298,6 +305,7 @@ struct gate_ {
     double placedX;                 
     double placedY;
     int orient;
+    struct hashtable_ *pinindex;  // pin name lookup (macros only)
 };
 
 // Define record holding information pointing to a gate and the
@@ -340,6 +348,7 @@ struct net_ {
 #define NET_IGNORED  		4	// net is ignored by router
 #define NET_STUB     		8	// Net has at least one stub
 #define NET_VERTICAL_TRUNK	16	// Trunk line is (preferred) vertical
+#define NET_KEPT		32	// Routes kept from before an ECO (see eco.c)
 
 // List of nets, used to maintain a list of failed routes
 
@@ -374,32 +383,47 @@ struct routeinfo_ {
 // The Stub[] vector indicates the distance needed to avoid the obstruction.
 //
 // The maximum number of nets must not overrun the area used by flags, so
-// the maximum number of nets is 0x3fffff, or 4,194,303 nets
-
-#define OFFSET_TAP	((u_int)0x80000000)  // tap position needs to be offset
-#define STUBROUTE	((u_int)0x40000000)  // route stub to reach terminal
-#define PINOBSTRUCTMASK	((u_int)0xc0000000)  // either offset tap or stub route
-#define NO_NET		((u_int)0x20000000)  // indicates a non-routable obstruction
-#define ROUTED_NET	((u_int)0x10000000)  // indicates position occupied by a routed
-
-#define BLOCKED_N	((u_int)0x08000000)  // grid point cannot be routed from the N
-#define BLOCKED_S	((u_int)0x04000000)  // grid point cannot be routed from the S
-#define BLOCKED_E	((u_int)0x02000000)  // grid point cannot be routed from the E
-#define BLOCKED_W	((u_int)0x01000000)  // grid point cannot be routed from the W
-#define BLOCKED_U	((u_int)0x00800000)  // grid point cannot be routed from top
-#define BLOCKED_D	((u_int)0x00400000)  // grid point cannot be routed from bottom
-#define BLOCKED_MASK	((u_int)0x0fc00000)
-#define OBSTRUCT_MASK	((u_int)0x0000000f)  // with NO_NET, directional obstruction
-#define OBSTRUCT_N	((u_int)0x00000008)  // Tells where the obstruction is
-#define OBSTRUCT_S	((u_int)0x00000004)  // relative to the grid point.  Nodeinfo
-#define OBSTRUCT_E	((u_int)0x00000002)  // offset contains distance to grid point
-#define OBSTRUCT_W	((u_int)0x00000001)
-#define MAX_NETNUMS	((u_int)0x003fffff)  // Maximum net number
-
-#define NETNUM_MASK	((u_int)0x203fffff)  // Mask for the net number field
-					     // (includes NO_NET)
-#define ROUTED_NET_MASK ((u_int)0x303fffff)  // Mask for the net number field
-					     // (includes NO_NET and ROUTED_NET)
+// the maximum number of nets is 0x3fffff, or 4,194,303 nets.
+//
+// When compiled with OBS_WIDE (configure --enable-wide-obs), each Obs[]
+// entry is 64 bits.  The flags move to the upper 32 bits and the net
+// number field becomes 32 bits.  Net numbers are held in an int
+// elsewhere, so the maximum number of nets is then 0x7fffffff.
+
+#ifdef OBS_WIDE
+#define OBSFLAG(f)	((obsword)(f) << 32)
+#define NETNUM_FIELD	((obsword)0xffffffff)
+#define MAX_NETNUMS	((obsword)0x7fffffff)  // Maximum net number
+#else
+#define OBSFLAG(f)	((obsword)(f))
+#define NETNUM_FIELD	((obsword)0x003fffff)
+#define MAX_NETNUMS	((obsword)0x003fffff)  // Maximum net number
+#endif
+
+#define OFFSET_TAP	OBSFLAG(0x80000000)  // tap position needs to be offset
+#define STUBROUTE	OBSFLAG(0x40000000)  // route stub to reach terminal
+#define PINOBSTRUCTMASK	OBSFLAG(0xc0000000)  // either offset tap or stub route
+#define NO_NET		OBSFLAG(0x20000000)  // indicates a non-routable obstruction
+#define ROUTED_NET	OBSFLAG(0x10000000)  // indicates position occupied by a routed
+
+#define BLOCKED_N	OBSFLAG(0x08000000)  // grid point cannot be routed from the N
+#define BLOCKED_S	OBSFLAG(0x04000000)  // grid point cannot be routed from the S
+#define BLOCKED_E	OBSFLAG(0x02000000)  // grid point cannot be routed from the E
+#define BLOCKED_W	OBSFLAG(0x01000000)  // grid point cannot be routed from the W
+#define BLOCKED_U	OBSFLAG(0x00800000)  // grid point cannot be routed from top
+#define BLOCKED_D	OBSFLAG(0x00400000)  // grid point cannot be routed from bottom
+#define BLOCKED_MASK	OBSFLAG(0x0fc00000)
+#define OBSTRUCT_MASK	((obsword)0x0000000f)  // with NO_NET, directional obstruction
+#define OBSTRUCT_N	((obsword)0x00000008)  // Tells where the obstruction is
+#define OBSTRUCT_S	((obsword)0x00000004)  // relative to the grid point.  Nodeinfo
+#define OBSTRUCT_E	((obsword)0x00000002)  // offset contains distance to grid point
+#define OBSTRUCT_W	((obsword)0x00000001)
+
+#define NETNUM_MASK	(NO_NET | NETNUM_FIELD)	// Mask for the net number field
+						// (includes NO_NET)
+#define ROUTED_NET_MASK (NO_NET | ROUTED_NET | NETNUM_FIELD)
+						// Mask for the net number field
+						// (includes NO_NET and ROUTED_NET)
 #define DRC_BLOCKAGE	(NO_NET | ROUTED_NET) // Special case
 
 // Map and draw modes
@@ -450,7 +474,7 @@ extern GATE   Nlgates;
 extern NET    *Nlnets;
 
 extern u_char *RMask;
-extern u_int  *Obs[MAX_LAYERS];		// obstructions by layer, y, x
+extern obsword *Obs[MAX_LAYERS];	// obstructions by layer, y, x
 extern PROUTE *Obs2[MAX_LAYERS]; 	// working copy of Obs 
 extern ObsInfoRec *Obsinfo[MAX_LAYERS];	// temporary detailed obstruction info
 extern NODEINFO *Nodeinfo[MAX_LAYERS];	// stub route distances to pins and
@@ -477,6 +501,7 @@ extern u_char maskMode;
 extern u_char mapType;
 extern u_char ripLimit;
 extern u_char unblockAll;
+extern int    NumThreads;
 
 extern char *vddnet;
 extern char *gndnet;
@@ -521,6 +546,8 @@ void   createMask(NET net, u_char slack, u_char halo);
 void   createBboxMask(NET net, u_char halo);
 
 int    read_def(char *filename);
+void   save_setup(void);
+void   restore_setup(void);
 
 #ifdef TCL_QROUTER
 int    write_delays(char *filename);
@@ -11,6 +11,15 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
 #include <math.h>	/* for round() */
 
 #include <tk.h>
@@ -19,6 +28,7 @@
 #include <X11/StringDefs.h>
 
 #include "qrouter.h"
+#include "point.h"
 #include "mask.h"
 #include "maze.h"
 #include "qconfig.h"
@@ -27,6 +37,8 @@
 #include "graphics.h"
 #include "node.h"
 #include "output.h"
+#include "checkpoint.h"
+#include "eco.h"
 #include "tkSimple.h"
 
 /* Global variables */
@@ -69,6 +81,12 @@ static int qrouter_cleanup(
 static int qrouter_writedef(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *const objv[]);
+static int qrouter_savecheckpoint(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *const objv[]);
+static int qrouter_loadcheckpoint(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *const objv[]);
 static int qrouter_writefailed(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *const objv[]);
@@ -93,6 +111,9 @@ static int qrouter_failing(
 static int qrouter_cost(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *const objv[]);
+static int qrouter_sweep(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *const objv[]);
 static int qrouter_tag(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *const objv[]);
@@ -144,9 +165,18 @@ static int qrouter_verbose(
 static int qrouter_print(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *const objv[]);
+static int qrouter_threads(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *const objv[]);
+static int qrouter_lefcache(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *const objv[]);
 static int qrouter_quit(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *const objv[]);
+static int qrouter_serve(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *const objv[]);
 static int qrouter_pitchx(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *const objv[]);
@@ -156,6 +186,9 @@ static int qrouter_pitchy(
 static int qrouter_unblock(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *const objv[]);
+static int qrouter_memory(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *const objv[]);
 
 static cmdstruct qrouter_commands[] =
 {
@@ -166,8 +199,11 @@ static cmdstruct qrouter_commands[] =
    {"stage3", qrouter_stage3},
    {"cleanup", qrouter_cleanup},
    {"write_def", qrouter_writedef},
+   {"save_checkpoint", qrouter_savecheckpoint},
+   {"load_checkpoint", qrouter_loadcheckpoint},
    {"read_def", qrouter_readdef},
    {"read_lef", qrouter_readlef},
+   {"lef_cache", qrouter_lefcache},
    {"read_config", qrouter_readconfig},
    {"write_delays", qrouter_writedelays},
    {"antenna", qrouter_antenna},
@@ -191,10 +227,14 @@ static cmdstruct qrouter_commands[] =
    {"failing", qrouter_failing},
    {"remove", qrouter_remove},
    {"cost", qrouter_cost},
+   {"sweep", qrouter_sweep},
    {"map", qrouter_map},
    {"verbose", qrouter_verbose},
+   {"threads", qrouter_threads},
    {"redraw", redraw},
    {"print", qrouter_print},
+   {"memory", qrouter_memory},
+   {"serve", qrouter_serve},
    {"quit", qrouter_quit},
    {"", NULL}  /* sentinel */
 };
@@ -718,6 +758,281 @@ qrouter_quit(ClientData clientData, Tcl_Interp *interp,
     return TCL_OK;       /* Not reached */
 }
 
+/*------------------------------------------------------*/
+/* Command "serve"					*/
+/*							*/
+/* Run qrouter as a routing daemon on a Unix-domain	*/
+/* socket.  Each client connection sends one job, a	*/
+/* script of qrouter commands, then shuts down its	*/
+/* side of the socket.  The job is evaluated in the	*/
+/* interpreter with all output going back to the	*/
+/* client, followed by a final line "OK <result>" or	*/
+/* "ERROR <message>".  Jobs are run one at a time.	*/
+/*							*/
+/* The technology (LEF and config file settings) stays	*/
+/* loaded between jobs, so a job normally needs only	*/
+/* "read_def", the routing stages, and "write_def".	*/
+/*							*/
+/* Before each job, the previous design is released	*/
+/* and every setting that a job may change (pitches,	*/
+/* layer directions, costs, passes, verbose level,	*/
+/* threads, effort, vdd/gnd names, net lists, user	*/
+/* obstructions, DRC blockages) is returned to its	*/
+/* value when "serve" was started.  Each job starts as	*/
+/* if it were the first run after the configuration	*/
+/* was read.  Changes to the LEF data ("read_lef",	*/
+/* "via") do persist.					*/
+/*							*/
+/* A client must send its whole job within one minute	*/
+/* (SERVE_TIMEOUT), and the output of a job that the	*/
+/* client does not read is dropped after the same time.	*/
+/* A job may use "serve stop" to shut down the daemon	*/
+/* after the job finishes;  "quit" in a job exits the	*/
+/* daemon immediately.					*/
+/*							*/
+/* Example client:					*/
+/*	socat - UNIX-CONNECT:<socket> < job.tcl		*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*	serve <socket>	start serving on file <socket>	*/
+/*	serve stop	stop after the current job	*/
+/*------------------------------------------------------*/
+
+#define SERVE_TIMEOUT	60	/* Seconds */
+
+static char *ServeSocket = NULL;
+static u_char ServeStop = FALSE;
+
+/* Remove the socket file if qrouter exits while serving */
+
+static void
+serve_exit_handler(ClientData clientData)
+{
+    if (ServeSocket != NULL) {
+	unlink(ServeSocket);
+	ServeSocket = NULL;
+    }
+}
+
+/* Flush both C stdio and Tcl standard channels (before	*/
+/* redirecting them, or before forking)			*/
+
+static void
+flush_std_channels(void)
+{
+    Tcl_Channel chan;
+
+    if ((chan = Tcl_GetStdChannel(TCL_STDOUT)) != NULL) Tcl_Flush(chan);
+    if ((chan = Tcl_GetStdChannel(TCL_STDERR)) != NULL) Tcl_Flush(chan);
+    fflush(stdout);
+    fflush(stderr);
+}
+
+/* Write a buffer to the client, ignoring a client that went away */
+
+static void
+serve_write(int fd, const char *buf, size_t len)
+{
+    ssize_t n;
+
+    while (len > 0) {
+	n = write(fd, buf, len);
+	if (n < 0) {
+	    if (errno == EINTR) continue;
+	    return;
+	}
+	buf += n;
+	len -= n;
+    }
+}
+
+/* Read and evaluate one job from connected socket "fd" */
+
+static void
+serve_job(Tcl_Interp *interp, int fd)
+{
+    Tcl_DString script, reply;
+    struct pollfd pfd;
+    struct timeval tv;
+    char buf[4096];
+    const char *msg;
+    time_t deadline, now;
+    ssize_t n;
+    int result, saveout, saveerr;
+
+    /* The whole job must arrive before the deadline, so that a	*/
+    /* client that never finishes cannot stall the daemon.	*/
+
+    deadline = time(NULL) + SERVE_TIMEOUT;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    Tcl_DStringInit(&script);
+    while (1) {
+	now = time(NULL);
+	if ((now >= deadline) ||
+		((n = poll(&pfd, 1, (int)(deadline - now) * 1000)) == 0)) {
+	    msg = "ERROR Timed out reading job\n";
+	    serve_write(fd, msg, strlen(msg));
+	    Tcl_DStringFree(&script);
+	    return;
+	}
+	if (n < 0) {
+	    if (errno == EINTR) continue;
+	    break;
+	}
+	n = read(fd, buf, sizeof(buf));
+	if (n < 0) {
+	    if (errno == EINTR) continue;
+	    break;
+	}
+	if (n == 0) break;
+	Tcl_DStringAppend(&script, buf, n);
+    }
+
+    /* Output that the client does not read is dropped, rather	*/
+    /* than blocking the job.					*/
+
+    tv.tv_sec = SERVE_TIMEOUT;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    /* Start from the setup recorded when serving began */
+    restore_setup();
+
+    /* Send all output of the job to the client */
+
+    flush_std_channels();
+    saveout = dup(1);
+    saveerr = dup(2);
+    dup2(fd, 1);
+    dup2(fd, 2);
+
+    result = Tcl_EvalEx(interp, Tcl_DStringValue(&script),
+		Tcl_DStringLength(&script), TCL_EVAL_GLOBAL);
+
+    /* Make sure Tcl has generated all output, then restore */
+    while (Tcl_DoOneEvent(TCL_DONT_WAIT) != 0);
+    flush_std_channels();
+    dup2(saveout, 1);
+    dup2(saveerr, 2);
+    close(saveout);
+    close(saveerr);
+
+    msg = Tcl_GetStringResult(interp);
+    Tcl_DStringInit(&reply);
+    Tcl_DStringAppend(&reply, (result == TCL_OK) ? "OK " : "ERROR ", -1);
+    Tcl_DStringAppend(&reply, msg, -1);
+    Tcl_DStringAppend(&reply, "\n", 1);
+    serve_write(fd, Tcl_DStringValue(&reply), Tcl_DStringLength(&reply));
+
+    Tcl_DStringFree(&reply);
+    Tcl_DStringFree(&script);
+    Tcl_ResetResult(interp);
+}
+
+static int
+qrouter_serve(ClientData clientData, Tcl_Interp *interp,
+	int objc, Tcl_Obj *const objv[])
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    void (*savepipe)(int);
+    char *path;
+    int sock, fd, jobs;
+
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "socket | stop");
+	return TCL_ERROR;
+    }
+    path = Tcl_GetString(objv[1]);
+
+    if (!strcmp(path, "stop")) {
+	if (ServeSocket == NULL) {
+	    Tcl_SetResult(interp, "Not serving.", NULL);
+	    return TCL_ERROR;
+	}
+	ServeStop = TRUE;
+	return QrouterTagCallback(interp, objc, objv);
+    }
+    if (ServeSocket != NULL) {
+	Tcl_SetResult(interp, "Already serving.", NULL);
+	return TCL_ERROR;
+    }
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+	Tcl_SetResult(interp, "Socket path name too long.", NULL);
+	return TCL_ERROR;
+    }
+
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+	Tcl_SetObjResult(interp, Tcl_ObjPrintf("Cannot create socket: %s",
+		strerror(errno)));
+	return TCL_ERROR;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    /* A socket left over from a previous daemon is replaced,	*/
+    /* but nothing else is.					*/
+    if (lstat(path, &st) == 0) {
+	if (!S_ISSOCK(st.st_mode)) {
+	    Tcl_SetObjResult(interp, Tcl_ObjPrintf("\"%s\" exists and is "
+			"not a socket.", path));
+	    close(sock);
+	    return TCL_ERROR;
+	}
+	unlink(path);
+    }
+    if ((bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+		(listen(sock, 8) < 0)) {
+	Tcl_SetObjResult(interp, Tcl_ObjPrintf("Cannot listen on \"%s\": %s",
+		path, strerror(errno)));
+	close(sock);
+	return TCL_ERROR;
+    }
+
+    ServeSocket = strdup(path);
+    ServeStop = FALSE;
+    Tcl_CreateExitHandler(serve_exit_handler, NULL);
+    save_setup();
+
+    /* A client that disconnects early must not kill the daemon */
+    savepipe = signal(SIGPIPE, SIG_IGN);
+
+    Fprintf(stdout, "Serving routing jobs on socket \"%s\".\n", path);
+    Flush(stdout);
+
+    for (jobs = 0; ServeStop == FALSE; ) {
+	fd = accept(sock, NULL, NULL);
+	if (fd < 0) {
+	    if (errno == EINTR) continue;
+	    Fprintf(stderr, "serve:  accept failed: %s\n", strerror(errno));
+	    break;
+	}
+	serve_job(interp, fd);
+	close(fd);
+	jobs++;
+	if (Verbose > 0) {
+	    Fprintf(stdout, "Finished job %d.\n", jobs);
+	    Flush(stdout);
+	}
+    }
+
+    close(sock);
+    signal(SIGPIPE, savepipe);
+    Tcl_DeleteExitHandler(serve_exit_handler, NULL);
+    serve_exit_handler(NULL);
+    ServeStop = FALSE;
+
+    Fprintf(stdout, "Stopped serving after %d job%s.\n", jobs,
+		(jobs == 1) ? "" : "s");
+    Flush(stdout);
+
+    return QrouterTagCallback(interp, objc, objv);
+}
+
 /*------------------------------------------------------*/
 /* Command "map"					*/
 /*							*/
@@ -977,7 +1292,7 @@ qrouter_stage1(ClientData clientData, Tcl_Interp *interp,
 			    FailedNets = fnet->next;
 			else
 			    lnet->next = fnet->next;
-			free(fnet);
+			freeNETLIST(fnet);
 			break;
 		    }
 		    lnet = fnet;
@@ -995,6 +1310,363 @@ qrouter_stage1(ClientData clientData, Tcl_Interp *interp,
     return QrouterTagCallback(interp, objc, objv);
 }
 
+/*------------------------------------------------------*/
+/* Forked routing jobs, used by "stage2 explore" and	*/
+/* "sweep".  Each job is a Tcl script run in a child	*/
+/* process forked from the current routing state, which	*/
+/* the child shares with the parent copy-on-write.  The	*/
+/* child reports its result back through a pipe and, if	*/
+/* asked, saves its routing state as a checkpoint.  Up	*/
+/* to "threads" children run at the same time.		*/
+/*------------------------------------------------------*/
+
+typedef struct forkresult_ {
+    int    ok;		/* Script ran (and checkpoint was saved) */
+    int    failcount;
+    int    wirelength;	/* In route grid units */
+    int    vias;
+    double runtime;	/* Seconds */
+} ForkResult;
+
+static u_char ForkedJobs = FALSE;
+
+/* Measure the total wire length and via count of all routes */
+
+static void
+route_totals(int *wirelength, int *vias)
+{
+    NET net;
+    ROUTE rt;
+    SEG seg;
+    int i;
+
+    *wirelength = *vias = 0;
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	for (rt = net->routes; rt; rt = rt->next)
+	    for (seg = rt->segments; seg; seg = seg->next) {
+		if (seg->segtype & ST_VIA)
+		    (*vias)++;
+		else
+		    *wirelength += abs(seg->x2 - seg->x1) + abs(seg->y2 - seg->y1);
+	    }
+    }
+}
+
+/* Body of a child process:  run "script" and report back on "fd" */
+
+static void
+fork_child(Tcl_Interp *interp, char *script, char *ckptname, int fd)
+{
+    extern Display *dpy;
+    ForkResult res;
+    struct timeval tstart, tend;
+    int devnull;
+
+    /* The child must not draw on the parent's display connection */
+    dpy = NULL;
+
+    devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+	dup2(devnull, 1);
+	dup2(devnull, 2);
+	close(devnull);
+    }
+
+    memset(&res, 0, sizeof(ForkResult));
+    gettimeofday(&tstart, NULL);
+    if (Tcl_EvalEx(interp, script, -1, TCL_EVAL_GLOBAL) == TCL_OK) {
+	gettimeofday(&tend, NULL);
+	res.runtime = (double)(tend.tv_sec - tstart.tv_sec) +
+		(double)(tend.tv_usec - tstart.tv_usec) / 1.0e6;
+	res.failcount = countlist(FailedNets);
+	route_totals(&res.wirelength, &res.vias);
+	if ((ckptname == NULL) || (save_checkpoint(ckptname) == 0))
+	    res.ok = 1;
+    }
+    flush_std_channels();
+    if (write(fd, &res, sizeof(ForkResult)) != sizeof(ForkResult))
+	res.ok = 0;
+    close(fd);
+
+    /* Skip exit handlers, which belong to the parent */
+    _exit(0);
+}
+
+/* Run "njobs" scripts in child processes and fill in "results".	*/
+/* If "ckptnames" is not NULL, job i saves its routing state to	*/
+/* ckptnames[i].  Returns TCL_ERROR if called from inside a job.	*/
+
+static int
+run_forked(Tcl_Interp *interp, int njobs, char **scripts, char **ckptnames,
+	ForkResult *results)
+{
+    pid_t *pids, pid;
+    struct pollfd *pollfds;
+    int *fds, *pollidx, pfd[2];
+    int i, k, npoll, running, next, status;
+
+    if (ForkedJobs == TRUE) {
+	Tcl_SetResult(interp, "Forked routing jobs cannot be nested.", NULL);
+	return TCL_ERROR;
+    }
+
+    pids = (pid_t *)malloc(njobs * sizeof(pid_t));
+    fds = (int *)malloc(njobs * sizeof(int));
+    pollfds = (struct pollfd *)malloc(njobs * sizeof(struct pollfd));
+    pollidx = (int *)malloc(njobs * sizeof(int));
+    for (i = 0; i < njobs; i++) {
+	memset(&results[i], 0, sizeof(ForkResult));
+	pids[i] = (pid_t)0;
+	fds[i] = -1;
+    }
+
+    ForkedJobs = TRUE;
+    running = next = 0;
+    while ((next < njobs) || (running > 0)) {
+
+	/* Start children up to the thread count */
+
+	while ((next < njobs) && (running < NumThreads)) {
+	    i = next++;
+	    if (pipe(pfd) < 0) {
+		Fprintf(stderr, "Cannot create pipe for job: %s\n",
+			strerror(errno));
+		continue;
+	    }
+	    flush_std_channels();
+	    pid = fork();
+	    if (pid == 0) {
+		close(pfd[0]);
+		fork_child(interp, scripts[i],
+			(ckptnames == NULL) ? NULL : ckptnames[i], pfd[1]);
+	    }
+	    close(pfd[1]);
+	    if (pid < 0) {
+		Fprintf(stderr, "Cannot fork job: %s\n", strerror(errno));
+		close(pfd[0]);
+		continue;
+	    }
+	    pids[i] = pid;
+	    fds[i] = pfd[0];
+	    running++;
+	}
+	if (running == 0) break;
+
+	/* Collect the children that have finished.  Each child	*/
+	/* writes its result to its pipe just before it exits, so	*/
+	/* the pipe becomes readable (or closed) when it is done.	*/
+	/* Only these children are waited for, and not any other	*/
+	/* child the interpreter may have started.			*/
+
+	for (npoll = 0, i = 0; i < njobs; i++) {
+	    if (pids[i] == (pid_t)0) continue;
+	    pollfds[npoll].fd = fds[i];
+	    pollfds[npoll].events = POLLIN;
+	    pollfds[npoll].revents = 0;
+	    pollidx[npoll++] = i;
+	}
+	if (poll(pollfds, npoll, -1) < 0) {
+	    if (errno == EINTR) continue;
+	    break;
+	}
+	for (k = 0; k < npoll; k++) {
+	    if (pollfds[k].revents == 0) continue;
+	    i = pollidx[k];
+	    if (read(fds[i], &results[i], sizeof(ForkResult)) !=
+			sizeof(ForkResult))
+		results[i].ok = 0;
+	    close(fds[i]);
+	    fds[i] = -1;
+	    while ((waitpid(pids[i], &status, 0) < 0) && (errno == EINTR));
+	    pids[i] = (pid_t)0;
+	    running--;
+	}
+    }
+    ForkedJobs = FALSE;
+
+    /* Any children left over from an error above */
+    for (i = 0; i < njobs; i++) {
+	if (pids[i] != (pid_t)0) waitpid(pids[i], &status, 0);
+	if (fds[i] >= 0) close(fds[i]);
+    }
+    free(pids);
+    free(fds);
+    free(pollfds);
+    free(pollidx);
+    return TCL_OK;
+}
+
+/*------------------------------------------------------*/
+/* "stage2 explore":  Run several stage 2 strategies at	*/
+/* once, each in a child process forked from the state	*/
+/* left by stage 1, and keep the best result.		*/
+/*							*/
+/* Each strategy is a Tcl script, normally a "stage2"	*/
+/* command with its options, but it may also change	*/
+/* costs or run further stages, for example:		*/
+/*							*/
+/*   stage2 explore {stage2 mask 20 effort 20} \	*/
+/*		    {cost via 20; stage2 mask none}	*/
+/*							*/
+/* With no strategies given, the mask and effort steps	*/
+/* of qrouter::standard_route are tried.  The parent	*/
+/* loads the checkpoint of the child with the fewest	*/
+/* failures (then the least wire length, then the	*/
+/* fewest vias), unless it has more failures than the	*/
+/* state it was forked from.  The cost and mask		*/
+/* settings of the parent are kept.			*/
+/*							*/
+/* The interpreter result is set to the number of	*/
+/* failed routes, as for "stage2".			*/
+/*------------------------------------------------------*/
+
+static char *ExploreDefaults[] = {
+    "stage2 mask 10 effort 10",
+    "stage2 mask 30 effort 20",
+    "stage2 mask 60 effort 20",
+    "stage2 mask 90 effort 20",
+    "stage2 mask none effort 50",
+    "stage2 mask none effort 100",
+    NULL
+};
+
+static int
+stage2_explore(Tcl_Interp *interp, int nstrat, Tcl_Obj *const sobjv[])
+{
+    char **scripts, **ckptnames, *tmpdir, *ckptdir;
+    ForkResult *results;
+    int i, best, failcount, result;
+    int saveCost[8];
+    u_char saveMask, saveLimit;
+
+    if ((Nlnets == NULL) || (Obs[0] == NULL)) {
+	Tcl_SetResult(interp, "No design has been read.", NULL);
+	return TCL_ERROR;
+    }
+
+    failcount = countlist(FailedNets);
+    if (failcount == 0) {
+	Tcl_SetObjResult(interp, Tcl_NewIntObj(0));
+	return TCL_OK;
+    }
+
+    if (nstrat == 0) {
+	for (; ExploreDefaults[nstrat] != NULL; nstrat++);
+	scripts = ExploreDefaults;
+    }
+    else {
+	scripts = (char **)malloc(nstrat * sizeof(char *));
+	for (i = 0; i < nstrat; i++)
+	    scripts[i] = Tcl_GetString(sobjv[i]);
+    }
+
+    /* The checkpoints go in a private directory, so that no	*/
+    /* other user can plant a file or link under their names.	*/
+
+    tmpdir = getenv("TMPDIR");
+    if (tmpdir == NULL) tmpdir = "/tmp";
+    ckptdir = (char *)malloc(strlen(tmpdir) + 24);
+    sprintf(ckptdir, "%s/qrouter_explore.XXXXXX", tmpdir);
+    if (mkdtemp(ckptdir) == NULL) {
+	Tcl_SetObjResult(interp, Tcl_ObjPrintf("Cannot create directory "
+		"in %s: %s", tmpdir, strerror(errno)));
+	free(ckptdir);
+	if (scripts != ExploreDefaults) free(scripts);
+	return TCL_ERROR;
+    }
+
+    ckptnames = (char **)malloc(nstrat * sizeof(char *));
+    results = (ForkResult *)malloc(nstrat * sizeof(ForkResult));
+    for (i = 0; i < nstrat; i++) {
+	ckptnames[i] = (char *)malloc(strlen(ckptdir) + 24);
+	sprintf(ckptnames[i], "%s/%d.ckpt", ckptdir, i);
+    }
+
+    if (Verbose > 0) {
+	Fprintf(stdout, "Exploring %d stage 2 strategies from %d failed nets.\n",
+		nstrat, failcount);
+	Flush(stdout);
+    }
+
+    result = run_forked(interp, nstrat, scripts, ckptnames, results);
+
+    /* Pick the best strategy */
+
+    best = -1;
+    for (i = 0; (i < nstrat) && (result == TCL_OK); i++) {
+	if (Verbose > 0) {
+	    if (results[i].ok)
+		Fprintf(stdout, "  Strategy \"%s\":  %d failed, wire length %d, "
+			"%d vias.\n", scripts[i], results[i].failcount,
+			results[i].wirelength, results[i].vias);
+	    else
+		Fprintf(stdout, "  Strategy \"%s\":  failed to run.\n",
+			scripts[i]);
+	}
+	if (!results[i].ok) continue;
+	if ((best < 0) || (results[i].failcount < results[best].failcount) ||
+		((results[i].failcount == results[best].failcount) &&
+		((results[i].wirelength < results[best].wirelength) ||
+		((results[i].wirelength == results[best].wirelength) &&
+		(results[i].vias < results[best].vias)))))
+	    best = i;
+    }
+
+    if ((best >= 0) && (results[best].failcount <= failcount)) {
+
+	/* The checkpoint also holds the costs and mask settings;	*/
+	/* those of the parent stay in effect.			*/
+
+	saveCost[0] = SegCost;
+	saveCost[1] = ViaCost;
+	saveCost[2] = JogCost;
+	saveCost[3] = XverCost;
+	saveCost[4] = BlockCost;
+	saveCost[5] = OffsetCost;
+	saveCost[6] = ConflictCost;
+	saveCost[7] = Numpasses;
+	saveMask = maskMode;
+	saveLimit = ripLimit;
+
+	if (load_checkpoint(ckptnames[best]) == 0) {
+	    failcount = results[best].failcount;
+	    if (Verbose > 0)
+		Fprintf(stdout, "Using the result of strategy \"%s\".\n",
+			scripts[best]);
+	}
+
+	SegCost = saveCost[0];
+	ViaCost = saveCost[1];
+	JogCost = saveCost[2];
+	XverCost = saveCost[3];
+	BlockCost = saveCost[4];
+	OffsetCost = saveCost[5];
+	ConflictCost = saveCost[6];
+	Numpasses = saveCost[7];
+	maskMode = saveMask;
+	ripLimit = saveLimit;
+    }
+    else if ((result == TCL_OK) && (Verbose > 0))
+	Fprintf(stdout, "No strategy improved on the current routes.\n");
+
+    for (i = 0; i < nstrat; i++) {
+	unlink(ckptnames[i]);
+	free(ckptnames[i]);
+    }
+    free(ckptnames);
+    rmdir(ckptdir);
+    free(ckptdir);
+    free(results);
+    if (scripts != ExploreDefaults) free(scripts);
+
+    if (result != TCL_OK) return result;
+
+    Tcl_SetObjResult(interp, Tcl_NewIntObj(failcount));
+    draw_layout();
+    return TCL_OK;
+}
+
 /*------------------------------------------------------*/
 /* Command "stage2"					*/
 /*							*/
@@ -1025,6 +1697,10 @@ qrouter_stage1(ClientData clientData, Tcl_Interp *interp,
 /*  stage2 force	Force a terminal to be routable	*/
 /*  stage2 break	Only rip up colliding segment	*/
 /*  stage2 effort <n>	Level of effort (default 100)	*/
+/*  stage2 explore [<strategy> ...]			*/
+/*			Try each strategy in a forked	*/
+/*			copy of the router and keep the	*/
+/*			best result.  See below.	*/
 /*------------------------------------------------------*/
 
 static int
@@ -1041,11 +1717,11 @@ qrouter_stage2(ClientData clientData, Tcl_Interp *interp,
 
     static char *subCmds[] = {
 	"debug", "mask", "limit", "route", "force", "tries", "step",
-	"break", "effort", NULL
+	"break", "effort", "explore", NULL
     };
     enum SubIdx {
 	DebugIdx, MaskIdx, LimitIdx, RouteIdx, ForceIdx, TriesIdx, StepIdx,
-	BreakIdx, EffortIdx
+	BreakIdx, EffortIdx, ExploreIdx
     };
    
     static char *maskSubCmds[] = {
@@ -1091,6 +1767,12 @@ qrouter_stage2(ClientData clientData, Tcl_Interp *interp,
 		    forceRoutable = TRUE;
 		    break;
 
+		case ExploreIdx:
+		    forceRoutable = saveForce;
+		    result = stage2_explore(interp, objc - i - 1, objv + i + 1);
+		    if (result != TCL_OK) return result;
+		    return QrouterTagCallback(interp, objc, objv);
+
 		case EffortIdx:
 		    if (i >= objc - 1) {
 			Tcl_WrongNumArgs(interp, 0, objv, "effort ?num?");
@@ -1358,7 +2040,7 @@ qrouter_stage3(ClientData clientData, Tcl_Interp *interp,
 			    FailedNets = fnet->next;
 			else
 			    lnet->next = fnet->next;
-			free(fnet);
+			freeNETLIST(fnet);
 			break;
 		    }
 		    lnet = fnet;
@@ -1531,15 +2213,11 @@ qrouter_failing(ClientData clientData, Tcl_Interp *interp,
 	    // Free up FailedNets list and then move all
 	    // nets to FailedNets
 
-	    while (FailedNets != NULL) {
-		nl = FailedNets->next;
-		FailedNets = FailedNets->next;
-		free(nl);
-	    }
+	    remove_failed();
 	    nlast = NULL;
 	    for (i = 0; i < Numnets; i++) {
 		net = Nlnets[i];
-		nl = (NETLIST)malloc(sizeof(struct netlist_));
+		nl = allocNETLIST();
 		nl->net = net;
 		nl->next = NULL;
 		if (nlast == NULL)
@@ -1550,16 +2228,12 @@ qrouter_failing(ClientData clientData, Tcl_Interp *interp,
 	    }
 	}
 	else if (!strncmp(Tcl_GetString(objv[1]), "all", 3)) {
-	    while (FailedNets != NULL) {
-		nl = FailedNets->next;
-		FailedNets = FailedNets->next;
-		free(nl);
-	    }
+	    remove_failed();
 	    create_netorder(0);
 	    nlast = NULL;
 	    for (i = 0; i < Numnets; i++) {
 		net = Nlnets[i];
-		nl = (NETLIST)malloc(sizeof(struct netlist_));
+		nl = allocNETLIST();
 		nl->net = net;
 		nl->next = NULL;
 		if (nlast == NULL)
@@ -1595,6 +2269,95 @@ qrouter_failing(ClientData clientData, Tcl_Interp *interp,
     return QrouterTagCallback(interp, objc, objv);
 }
 
+/*------------------------------------------------------*/
+/* Command "memory"					*/
+/*							*/
+/*   Report usage of the record stores used for points,	*/
+/*   route segments, routes, net lists, tap points and	*/
+/*   grid node information, and of the design arena.	*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*   memory		List of statistics for all	*/
+/*			record stores			*/
+/*   memory <type>	Statistics for one store (point,*/
+/*			seg, route, netlist, dpoint,	*/
+/*			nodeinfo, or design)		*/
+/*   memory hugepages [on|off]				*/
+/*			Use 2MB huge page blocks for	*/
+/*			any new store blocks		*/
+/*							*/
+/* Statistics are given as a list of record type,	*/
+/* record size, records in use, free list hits, free	*/
+/* list misses, and number of blocks allocated.		*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_memory(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *const objv[])
+{
+    Tcl_Obj *lobj, *sobj;
+    RecStore *store;
+    char *typename;
+    int i, value, result;
+
+    if (objc > 3) {
+	Tcl_WrongNumArgs(interp, 1, objv, "[type|hugepages [on|off]]");
+	return TCL_ERROR;
+    }
+    typename = (objc >= 2) ? Tcl_GetString(objv[1]) : NULL;
+
+    if (typename && !strcasecmp(typename, "hugepages")) {
+	if (objc == 3) {
+	    result = Tcl_GetBooleanFromObj(interp, objv[2], &value);
+	    if (result != TCL_OK) return result;
+	    RecordStoreHugePages = (value) ? TRUE : FALSE;
+	}
+	Tcl_SetObjResult(interp, Tcl_NewBooleanObj(RecordStoreHugePages));
+	return QrouterTagCallback(interp, objc, objv);
+    }
+    else if (objc == 3) {
+	Tcl_WrongNumArgs(interp, 1, objv, "[type|hugepages [on|off]]");
+	return TCL_ERROR;
+    }
+
+    lobj = Tcl_NewListObj(0, NULL);
+    for (i = -1; ; i++) {
+	store = (i < 0) ? POINTStore() : RecordStores[i];
+	if (store == NULL) break;
+	if (typename && strcasecmp(typename, store->name)) continue;
+
+	sobj = Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(interp, sobj,
+		Tcl_NewStringObj(store->name, -1));
+	Tcl_ListObjAppendElement(interp, sobj,
+		Tcl_NewIntObj((int)store->size));
+	Tcl_ListObjAppendElement(interp, sobj,
+		Tcl_NewWideIntObj((Tcl_WideInt)(store->hits + store->misses
+		- store->frees)));
+	Tcl_ListObjAppendElement(interp, sobj,
+		Tcl_NewWideIntObj((Tcl_WideInt)store->hits));
+	Tcl_ListObjAppendElement(interp, sobj,
+		Tcl_NewWideIntObj((Tcl_WideInt)store->misses));
+	Tcl_ListObjAppendElement(interp, sobj,
+		Tcl_NewWideIntObj((Tcl_WideInt)store->blocks));
+
+	if (typename) break;
+	Tcl_ListObjAppendElement(interp, lobj, sobj);
+    }
+    if (typename) {
+	Tcl_DecrRefCount(lobj);
+	if (store == NULL) {
+	    Tcl_SetResult(interp, "Unknown record type.", NULL);
+	    return TCL_ERROR;
+	}
+	lobj = sobj;
+    }
+    Tcl_SetObjResult(interp, lobj);
+
+    return QrouterTagCallback(interp, objc, objv);
+}
+
 /*------------------------------------------------------*/
 /* Command "read_lef"					*/
 /*------------------------------------------------------*/
@@ -1634,8 +2397,49 @@ qrouter_readlef(ClientData clientData, Tcl_Interp *interp,
     return QrouterTagCallback(interp, objc, objv);
 }
 
+/*------------------------------------------------------*/
+/* Command "lef_cache"					*/
+/*							*/
+/* Set the directory in which the results of parsing	*/
+/* LEF files are saved, so that later reads of the same	*/
+/* files are loaded from there instead.  "none" stops	*/
+/* using the cache.  With no argument, return the	*/
+/* directory, or "none".				*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*	lef_cache [<directory>|none]			*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_lefcache(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *const objv[])
+{
+    if (objc == 1) {
+	Tcl_SetObjResult(interp, Tcl_NewStringObj((LefCacheDir) ?
+		LefCacheDir : "none", -1));
+    }
+    else if (objc == 2) {
+	LefSetCacheDir(Tcl_GetString(objv[1]));
+    }
+    else {
+	Tcl_WrongNumArgs(interp, 1, objv, "?directory?");
+	return TCL_ERROR;
+    }
+    return QrouterTagCallback(interp, objc, objv);
+}
+
 /*------------------------------------------------------*/
 /* Command "read_def"					*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*	read_def [<filename>] [-abort] [-eco]		*/
+/*							*/
+/* With "-eco", the routes of the design already read	*/
+/* are kept for every net whose pins the new DEF file	*/
+/* does not change and whose routes are still clear,	*/
+/* and the stages route only the other nets.		*/
 /*------------------------------------------------------*/
 
 static int
@@ -1644,6 +2448,7 @@ qrouter_readdef(ClientData clientData, Tcl_Interp *interp,
 {
     char *argv;
     u_char abort_on_error = FALSE;
+    u_char eco = FALSE;
     int result;
 
     /* Parse out options */
@@ -1653,6 +2458,8 @@ qrouter_readdef(ClientData clientData, Tcl_Interp *interp,
 	if (*argv == '-') {
 	    if (!strncmp(argv + 1, "abort", 5))
 		abort_on_error = TRUE;
+	    else if (!strncmp(argv + 1, "eco", 3))
+		eco = TRUE;
 	    objc--;
 	}
 	else break;
@@ -1663,7 +2470,9 @@ qrouter_readdef(ClientData clientData, Tcl_Interp *interp,
 	return TCL_ERROR;
     }
 
-    if (objc == 2)
+    if (eco == TRUE)
+	result = read_eco((objc == 2) ? Tcl_GetString(objv[1]) : NULL);
+    else if (objc == 2)
 	result = read_def(Tcl_GetString(objv[1]));
     else
 	result = read_def(NULL);
@@ -1701,6 +2510,62 @@ qrouter_writedef(ClientData clientData, Tcl_Interp *interp,
     return QrouterTagCallback(interp, objc, objv);
 }
 
+/*------------------------------------------------------*/
+/* Command "save_checkpoint"				*/
+/*							*/
+/* Save the routing state of the design (routes, failed	*/
+/* nets, obstructions and routing parameters) to a	*/
+/* binary file, to be restored by "load_checkpoint".	*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*	save_checkpoint <filename>			*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_savecheckpoint(ClientData clientData, Tcl_Interp *interp,
+                 int objc, Tcl_Obj *const objv[])
+{
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "filename");
+	return TCL_ERROR;
+    }
+    if (save_checkpoint(Tcl_GetString(objv[1])) != 0) {
+	Tcl_SetResult(interp, "Failed to save checkpoint.", NULL);
+	return TCL_ERROR;
+    }
+    return QrouterTagCallback(interp, objc, objv);
+}
+
+/*------------------------------------------------------*/
+/* Command "load_checkpoint"				*/
+/*							*/
+/* Restore the routing state saved by "save_checkpoint".	*/
+/* The design must first be read from the same LEF,	*/
+/* DEF and configuration files with "read_def".  Routing	*/
+/* may then continue with any stage.			*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*	load_checkpoint <filename>			*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_loadcheckpoint(ClientData clientData, Tcl_Interp *interp,
+                 int objc, Tcl_Obj *const objv[])
+{
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "filename");
+	return TCL_ERROR;
+    }
+    if (load_checkpoint(Tcl_GetString(objv[1])) != 0) {
+	Tcl_SetResult(interp, "Failed to load checkpoint.", NULL);
+	return TCL_ERROR;
+    }
+    draw_layout();
+    return QrouterTagCallback(interp, objc, objv);
+}
+
 /*------------------------------------------------------*/
 /* Command "antenna"					*/
 /* Use:							*/
@@ -2377,6 +3242,44 @@ qrouter_verbose(ClientData clientData, Tcl_Interp *interp,
     return QrouterTagCallback(interp, objc, objv);
 }
 
+/*------------------------------------------------------*/
+/* Command "threads"					*/
+/*							*/
+/* Set the number of worker threads used by tasks that	*/
+/* can run in parallel (such as reading large DEF	*/
+/* sections).  1 runs everything serially.  With no	*/
+/* argument, return the number of threads.		*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*	threads [<count>]				*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_threads(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *const objv[])
+{
+    int result, value;
+
+    if (objc == 1) {
+	Tcl_SetObjResult(interp, Tcl_NewIntObj(NumThreads));
+    }
+    else if (objc == 2) {
+
+	result = Tcl_GetIntFromObj(interp, objv[1], &value);
+	if (result != TCL_OK) return result;
+	if (value < 1) {
+	    Tcl_SetResult(interp, "Thread count must be at least 1", NULL);
+	    return TCL_ERROR;
+	}
+	NumThreads = value;
+    }
+    else {
+	Tcl_WrongNumArgs(interp, 1, objv, "?count?");
+	return TCL_ERROR;
+    }
+    return QrouterTagCallback(interp, objc, objv);
+}
 
 /*------------------------------------------------------*/
 /* Command "resolution"					*/
@@ -2887,16 +3790,17 @@ qrouter_gnd(ClientData clientData, Tcl_Interp *interp,
 /*	cost conflict					*/
 /*------------------------------------------------------*/
 
+static char *CostSubCmds[] = {
+    "segment", "via", "jog", "crossover",
+    "block", "offset", "conflict", NULL
+};
+
 static int
 qrouter_cost(ClientData clientData, Tcl_Interp *interp,
              int objc, Tcl_Obj *const objv[])
 {
     int idx, result, value;
 
-    static char *subCmds[] = {
-	"segment", "via", "jog", "crossover",
-	"block", "offset", "conflict", NULL
-    };
     enum SubIdx {
 	SegIdx, ViaIdx, JogIdx, XOverIdx, BlockIdx, OffsetIdx, ConflictIdx
     };
@@ -2919,7 +3823,7 @@ qrouter_cost(ClientData clientData, Tcl_Interp *interp,
     }
 
     if ((result = Tcl_GetIndexFromObj(interp, objv[1],
-		(const char **)subCmds, "option", 0, &idx)) != TCL_OK)
+		(const char **)CostSubCmds, "option", 0, &idx)) != TCL_OK)
 	return result;
 
     switch (idx) {
@@ -2930,7 +3834,7 @@ qrouter_cost(ClientData clientData, Tcl_Interp *interp,
 	// Segment, via, and conflict costs must not be zero or
 	// bad things happen.
 
-	    if (value <= 0) {
+	    if ((objc == 3) && (value <= 0)) {
 		Tcl_SetResult(interp, "Bad cost value", NULL);
 		return TCL_ERROR;
 	    }
@@ -2990,6 +3894,181 @@ qrouter_cost(ClientData clientData, Tcl_Interp *interp,
     return QrouterTagCallback(interp, objc, objv);
 }
 
+/*------------------------------------------------------*/
+/* Command "sweep"					*/
+/*							*/
+/* Route the current design once for every combination	*/
+/* of the given cost values, and write the results to	*/
+/* a CSV file, one line per combination, with the cost	*/
+/* values followed by the number of failed nets, the	*/
+/* total wire length (in route grid units), the number	*/
+/* of vias, and the routing time in seconds.		*/
+/*							*/
+/* Each combination is routed in a child process forked	*/
+/* from the current state, so the design is read and	*/
+/* set up only once for the whole sweep.  Run "sweep"	*/
+/* after "read_def" and before routing.  Up to		*/
+/* "threads" combinations are routed at the same time.	*/
+/* The routing state and costs of the design itself	*/
+/* are not changed.					*/
+/*							*/
+/* The routing script defaults to stage 1, stage 2 (if	*/
+/* needed, and again with no mask), and stage 3.	*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*  sweep [-script <script>] <file> <cost> <values> ...	*/
+/*							*/
+/*  where <cost> is a name taken by the "cost" command	*/
+/*  and <values> is a list of integer values, e.g.:	*/
+/*							*/
+/*	sweep costs.csv via {10 20 50} jog {20 40}	*/
+/*							*/
+/* The interpreter result is set to the number of	*/
+/* combinations routed.					*/
+/*------------------------------------------------------*/
+
+static char *SweepScript =
+	"set r [stage1]\n"
+	"if {$r > 0} {set r [stage2]}\n"
+	"if {$r > 0} {set r [stage2 mask none]}\n"
+	"stage3\n";
+
+static int
+qrouter_sweep(ClientData clientData, Tcl_Interp *interp,
+              int objc, Tcl_Obj *const objv[])
+{
+    Tcl_Obj ***values;
+    Tcl_DString ds;
+    ForkResult *results;
+    FILE *fcsv;
+    char *script, *csvname, **scripts;
+    int *counts, *names;
+    int i, j, k, arg, nparams, ncombo, result;
+
+    script = SweepScript;
+    arg = 1;
+    if ((objc >= 3) && !strcmp(Tcl_GetString(objv[1]), "-script")) {
+	script = Tcl_GetString(objv[2]);
+	arg = 3;
+    }
+    if ((objc - arg < 3) || ((objc - arg) & 1) == 0) {
+	Tcl_WrongNumArgs(interp, 1, objv,
+		"?-script script? file cost values ?cost values ...?");
+	return TCL_ERROR;
+    }
+    if ((Nlnets == NULL) || (Obs[0] == NULL)) {
+	Tcl_SetResult(interp, "No design has been read.", NULL);
+	return TCL_ERROR;
+    }
+    csvname = Tcl_GetString(objv[arg]);
+
+    /* Check the cost names and values */
+
+    nparams = (objc - arg - 1) / 2;
+    names = (int *)malloc(nparams * sizeof(int));
+    counts = (int *)malloc(nparams * sizeof(int));
+    values = (Tcl_Obj ***)malloc(nparams * sizeof(Tcl_Obj **));
+    ncombo = 1;
+    result = TCL_OK;
+    for (i = 0; (i < nparams) && (result == TCL_OK); i++) {
+	result = Tcl_GetIndexFromObj(interp, objv[arg + 1 + 2 * i],
+		(const char **)CostSubCmds, "cost", 0, &names[i]);
+	if (result != TCL_OK) break;
+	result = Tcl_ListObjGetElements(interp, objv[arg + 2 + 2 * i], &counts[i],
+		&values[i]);
+	if (result != TCL_OK) break;
+	if (counts[i] == 0) {
+	    Tcl_SetResult(interp, "Empty list of cost values.", NULL);
+	    result = TCL_ERROR;
+	    break;
+	}
+	for (j = 0; j < counts[i]; j++) {
+	    result = Tcl_GetIntFromObj(interp, values[i][j], &k);
+	    if (result != TCL_OK) break;
+	}
+	ncombo *= counts[i];
+    }
+    if (result != TCL_OK) {
+	free(names);
+	free(counts);
+	free(values);
+	return result;
+    }
+
+    fcsv = fopen(csvname, "w");
+    if (fcsv == NULL) {
+	Tcl_SetObjResult(interp, Tcl_ObjPrintf("Cannot open \"%s\" for "
+		"writing.", csvname));
+	free(names);
+	free(counts);
+	free(values);
+	return TCL_ERROR;
+    }
+
+    /* One script per combination:  the cost settings followed by	*/
+    /* the routing script.  The last cost listed varies fastest.	*/
+
+    scripts = (char **)malloc(ncombo * sizeof(char *));
+    for (k = 0; k < ncombo; k++) {
+	Tcl_DStringInit(&ds);
+	for (i = nparams - 1, j = k; i >= 0; i--) {
+	    Tcl_DStringAppend(&ds, "cost ", -1);
+	    Tcl_DStringAppend(&ds, CostSubCmds[names[i]], -1);
+	    Tcl_DStringAppend(&ds, " ", 1);
+	    Tcl_DStringAppend(&ds, Tcl_GetString(values[i][j % counts[i]]), -1);
+	    Tcl_DStringAppend(&ds, "\n", 1);
+	    j /= counts[i];
+	}
+	Tcl_DStringAppend(&ds, script, -1);
+	scripts[k] = strdup(Tcl_DStringValue(&ds));
+	Tcl_DStringFree(&ds);
+    }
+
+    if (Verbose > 0) {
+	Fprintf(stdout, "Sweeping %d cost combinations.\n", ncombo);
+	Flush(stdout);
+    }
+
+    results = (ForkResult *)malloc(ncombo * sizeof(ForkResult));
+    result = run_forked(interp, ncombo, scripts, NULL, results);
+
+    if (result == TCL_OK) {
+	for (i = 0; i < nparams; i++)
+	    fprintf(fcsv, "%s,", CostSubCmds[names[i]]);
+	fprintf(fcsv, "failed,wirelength,vias,runtime\n");
+
+	for (k = 0; k < ncombo; k++) {
+	    for (i = 0, j = ncombo; i < nparams; i++) {
+		j /= counts[i];
+		fprintf(fcsv, "%s,", Tcl_GetString(values[i][(k / j) % counts[i]]));
+	    }
+	    if (results[k].ok)
+		fprintf(fcsv, "%d,%d,%d,%.3f\n", results[k].failcount,
+			results[k].wirelength, results[k].vias,
+			results[k].runtime);
+	    else
+		fprintf(fcsv, "error,,,\n");
+	}
+    }
+    fclose(fcsv);
+
+    if ((result == TCL_OK) && (Verbose > 0))
+	Fprintf(stdout, "Wrote results of cost sweep to %s.\n", csvname);
+
+    for (k = 0; k < ncombo; k++) free(scripts[k]);
+    free(scripts);
+    free(results);
+    free(names);
+    free(counts);
+    free(values);
+
+    if (result != TCL_OK) return result;
+
+    Tcl_SetObjResult(interp, Tcl_NewIntObj(ncombo));
+    return QrouterTagCallback(interp, objc, objv);
+}
+
 /*------------------------------------------------------*/
 
 typedef struct clist_ *CLIST;
@@ -3319,8 +4398,10 @@ qrouter_pitchy(ClientData clientData, Tcl_Interp *interp,
 /*							*/
 /* Set the unblocking flag, which indicates to qrouter	*/
 /* that all grid points that lie cleanly inside pin	*/
-/* geometry should be marked routable.  This command	*/
-/* must be issued before read_def to be effective.	*/
+/* geometry should be marked routable.  If a design has	*/
+/* already been read, turning the flag on unblocks its	*/
+/* pins at once;  turning it off takes effect at the	*/
+/* next read_def.					*/
 /*							*/
 /* Options:						*/
 /*							*/
@@ -3339,6 +4420,9 @@ qrouter_unblock(ClientData clientData, Tcl_Interp *interp,
     else if (objc == 2) {
 	result = Tcl_GetBooleanFromObj(interp, objv[1], &value);
 	if (result != TCL_OK) return result;
+	if ((value != 0) && (unblockAll == FALSE) && (Nlgates != NULL)
+			&& (Obs2[0] != NULL))
+	    update_reachable_taps(NULL, 0, TRUE);
 	unblockAll = (value == 0) ? FALSE : TRUE;
     }
     else {
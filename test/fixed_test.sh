@@ -0,0 +1,114 @@
+#!/bin/sh
+#
+# fixed_test.sh --
+#
+# Read a routed design in which the FIXED net n1 shares a metal3
+# wire with the route of net n2, and route it again.  The fixed
+# wiring must be kept and written out as it is, and no other net
+# may be routed over it.
+#
+# Run from the top of the build tree, after "make" (or "make check").
+# Needs python3 to compare the wiring of the nets.
+
+top=`pwd`
+testdir=$top/test
+tmp=`mktemp -d`
+trap 'rm -rf $tmp' 0
+
+if ! command -v python3 > /dev/null; then
+    echo "fixed_test:  python3 not found, skipped."
+    exit 0
+fi
+
+QROUTER="env QROUTER_LIB_DIR=$top $top/qrouternullg $top/qrouter.tcl -noc -s"
+
+cat > $tmp/route.tcl << EOF
+read_config route.cfg
+verbose 1
+read_def designF.def
+set r [stage1]
+if {\$r > 0} { set r [stage2] }
+stage3
+write_def $tmp/out.def
+quit
+EOF
+
+cd $testdir
+$QROUTER $tmp/route.tcl > $tmp/route.log 2>&1
+
+result=0
+if ! grep -q "Fixed route of net n1 from DEF" $tmp/route.log; then
+    echo "fixed_test:  the fixed route of net n1 was not reported."
+    result=1
+fi
+if grep -q "Route of net n1 from DEF" $tmp/route.log; then
+    echo "fixed_test:  the fixed route of net n1 was removed."
+    result=1
+fi
+if ! grep -q "Route of net n2 from DEF" $tmp/route.log; then
+    echo "fixed_test:  the route of net n2 was not removed."
+    result=1
+fi
+
+# List the nets with wiring on the same layer as any of that of
+# net n1, and check that the wiring of n1 is unchanged.
+
+python3 - $tmp/out.def designF.def << 'EOPY' > $tmp/check.log
+import re, sys
+
+def wiring(name):
+    text = open(name).read()
+    text = text[text.index('\nNETS '):text.index('\nEND NETS')]
+    wires = {}
+    for ent in text.split('\n- ')[1:]:
+        k = ent.find('+ ')
+        toks = re.findall(r'\([^)]*\)|[^\s()]+', ent[k:]) if k >= 0 else []
+        w = []
+        layer = last = None
+        i = 0
+        while i < len(toks):
+            t = toks[i]
+            if t in ('+', 'NEW'):
+                if t == '+': i += 1
+                layer = toks[i + 1]
+                last = None
+                i += 2
+                if i < len(toks) and toks[i].isdigit(): i += 1
+                continue
+            if t.startswith('('):
+                x, y = t[1:-1].split()[:2]
+                x = last[0] if x == '*' else int(x)
+                y = last[1] if y == '*' else int(y)
+                p = last if last else (x, y)
+                w.append((layer, min(p[0], x), min(p[1], y),
+                        max(p[0], x), max(p[1], y)))
+                last = (x, y)
+            elif last and re.match(r'M\d+_M\d+$', t):
+                for l in re.findall(r'\d+', t):
+                    w.append(('metal' + l, last[0], last[1], last[0], last[1]))
+            i += 1
+        wires[ent.split()[0]] = w
+    return wires
+
+out = wiring(sys.argv[1])
+fixed = out['n1']
+if fixed != wiring(sys.argv[2])['n1']:
+    print('changed n1')
+for name, w in out.items():
+    if name != 'n1' and any(a[0] == b[0] and a[1] <= b[3] and b[1] <= a[3]
+            and a[2] <= b[4] and b[2] <= a[4] for a in w for b in fixed):
+        print('short ' + name)
+EOPY
+
+if grep -q "changed" $tmp/check.log; then
+    echo "fixed_test:  the wiring of net n1 was changed."
+    result=1
+fi
+for net in `sed -n 's/^short //p' $tmp/check.log`; do
+    echo "fixed_test:  net $net is routed over the wiring of net n1."
+    result=1
+done
+if [ $result -eq 0 ]; then
+    echo "fixed_test:  passed."
+fi
+exit $result
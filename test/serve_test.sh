@@ -0,0 +1,95 @@
+#!/bin/sh
+#
+# serve_test.sh --
+#
+# Route two designs of different size, one after the other, in a
+# single "serve" daemon, and check that each result is the same as
+# that of a fresh qrouter run.  The smaller design goes first, so
+# that a route grid left over from it would be too small for the
+# larger one.  The first job also changes costs, to check that
+# settings do not carry over into later jobs.
+#
+# Run from the top of the build tree, after "make" (or "make check").
+# Needs python3 as the socket client.
+
+top=`pwd`
+testdir=$top/test
+tmp=`mktemp -d`
+sock=$tmp/qrouter.sock
+trap 'rm -rf $tmp' 0
+
+if ! command -v python3 > /dev/null; then
+    echo "serve_test:  python3 not found, skipped."
+    exit 0
+fi
+
+QROUTER="env QROUTER_LIB_DIR=$top $top/qrouternullg $top/qrouter.tcl -noc -s"
+
+# Job script routing design $1, writing $2.def and $2.rc
+
+job() {
+    cat << EOJ
+read_def $1.def
+set r [stage1]
+if {\$r > 0} { set r [stage2] }
+if {\$r > 0} { set r [stage2 mask none] }
+set r [stage3]
+write_def $2.def
+write_delays $2.rc
+set r
+EOJ
+}
+
+cd $testdir
+
+# Fresh runs
+
+for d in designA designB; do
+    { echo "read_config route.cfg"; job $d $tmp/fresh_$d; echo "quit"; } \
+		> $tmp/fresh_$d.tcl
+    $QROUTER $tmp/fresh_$d.tcl > $tmp/fresh_$d.log 2>&1
+done
+
+# The same designs in one daemon
+
+printf 'read_config route.cfg\nserve %s\nquit\n' $sock > $tmp/serve.tcl
+$QROUTER $tmp/serve.tcl > $tmp/serve.log 2>&1 &
+server=$!
+
+i=0
+while [ ! -S $sock ] && [ $i -lt 60 ]; do
+    sleep 1
+    i=`expr $i + 1`
+done
+
+{ echo "cost jog 7"; echo "passes 2"; job designA $tmp/tweak; } > $tmp/job0.tcl
+job designB $tmp/served_designB > $tmp/job1.tcl
+job designA $tmp/served_designA > $tmp/job2.tcl
+echo "serve stop" > $tmp/job3.tcl
+
+python3 - $sock $tmp/job0.tcl $tmp/job1.tcl $tmp/job2.tcl $tmp/job3.tcl << 'EOPY'
+import socket, sys
+for name in sys.argv[2:]:
+    c = socket.socket(socket.AF_UNIX)
+    c.connect(sys.argv[1])
+    c.sendall(open(name, 'rb').read())
+    c.shutdown(socket.SHUT_WR)
+    while c.recv(65536):
+        pass
+    c.close()
+EOPY
+wait $server
+
+result=0
+for d in designA designB; do
+    for ext in def rc; do
+	if ! cmp -s $tmp/fresh_$d.$ext $tmp/served_$d.$ext; then
+	    echo "serve_test:  $d.$ext differs from a fresh run."
+	    result=1
+	fi
+    done
+done
+if [ $result -eq 0 ]; then
+    echo "serve_test:  passed."
+fi
+exit $result
@@ -0,0 +1,542 @@
+/*--------------------------------------------------------------*/
+/* zfile.c --							*/
+/*								*/
+/* Transparent reading and writing of compressed LEF, DEF and	*/
+/* delay files.  A compressed file opened with ZFileOpen() is	*/
+/* presented to the caller as an ordinary stdio stream of the	*/
+/* uncompressed text.  The stream is one end of a pipe, and a	*/
+/* thread at the other end decompresses the file into it, or	*/
+/* compresses what is written to it into the file, so that	*/
+/* (de)compression runs alongside parsing or output.  Without	*/
+/* threads, the text passes through a temporary file instead.	*/
+/*								*/
+/* Input files are recognized as compressed by their contents;	*/
+/* output files by the suffix ".gz" (gzip) or ".zst" (zstd).	*/
+/* Each format is available only if qrouter was compiled with	*/
+/* its library.							*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#include "qrouter.h"
+#include "zfile.h"
+
+#define ZFILE_BUFSIZE	(256 * 1024)
+
+/* An open compressed file */
+
+typedef struct zfile_ {
+    struct zfile_ *next;
+    FILE   *f;		/* Uncompressed stream handed to the caller */
+    char   *name;	/* Name of the compressed file */
+    int     fd;		/* The compressed file */
+    int     codecfd;	/* Codec's end of the pipe, or the temporary file */
+    u_char  type;	/* ZFILE_GZIP or ZFILE_ZSTD */
+    u_char  writing;	/* TRUE if the file is being written */
+    int     result;	/* Nonzero if the codec failed */
+#ifdef HAVE_LIBPTHREAD
+    pthread_t thread;
+#endif
+} ZFile;
+
+static ZFile *ZFileList = NULL;
+
+static char *ZFileFormat[] = {"uncompressed", "gzip", "zstd"};
+
+/*--------------------------------------------------------------*/
+/* Write all of "len" bytes to "fd".  Returns 0 on success.	*/
+/*--------------------------------------------------------------*/
+
+static int
+zWriteAll(int fd, char *buf, size_t len)
+{
+    ssize_t n;
+
+    while (len > 0) {
+	n = write(fd, buf, len);
+	if (n < 0) {
+	    if (errno == EINTR) continue;
+	    return 1;
+	}
+	buf += n;
+	len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Read up to "len" bytes from "fd", retrying if interrupted.	*/
+
+static ssize_t
+zRead(int fd, char *buf, size_t len)
+{
+    ssize_t n;
+
+    do {
+	n = read(fd, buf, len);
+    } while ((n < 0) && (errno == EINTR));
+    return n;
+}
+
+/*--------------------------------------------------------------*/
+/* Codecs.  Each decompresses "src" into "dst", or compresses	*/
+/* "src" into "dst", and returns 0 on success.  A reader	*/
+/* closing its end of the pipe early is not a failure.		*/
+/*--------------------------------------------------------------*/
+
+#ifdef HAVE_LIBZ
+
+static int
+zGzipDecompress(int src, int dst)
+{
+    gzFile gz;
+    char *buf;
+    int n, zerr, result = 0;
+
+    gz = gzdopen(dup(src), "rb");
+    if (gz == NULL) return 1;
+    gzbuffer(gz, ZFILE_BUFSIZE);
+    buf = (char *)malloc(ZFILE_BUFSIZE);
+    while ((n = gzread(gz, buf, ZFILE_BUFSIZE)) > 0) {
+	if (zWriteAll(dst, buf, (size_t)n) != 0) {
+	    if (errno != EPIPE) result = 1;
+	    break;
+	}
+    }
+    if (n < 0) result = 1;
+
+    /* gzread() treats a file that was cut short as ending	*/
+    /* normally, but leaves an error.				*/
+    if (n == 0) {
+	gzerror(gz, &zerr);
+	if (zerr != Z_OK) result = 1;
+    }
+    free(buf);
+    gzclose(gz);
+    return result;
+}
+
+static int
+zGzipCompress(int src, int dst)
+{
+    gzFile gz;
+    char *buf;
+    ssize_t n;
+    int result = 0;
+
+    gz = gzdopen(dup(dst), "wb");
+    if (gz == NULL) return 1;
+    gzbuffer(gz, ZFILE_BUFSIZE);
+    buf = (char *)malloc(ZFILE_BUFSIZE);
+    while ((n = zRead(src, buf, ZFILE_BUFSIZE)) > 0) {
+	if (gzwrite(gz, buf, (unsigned)n) != (int)n) {
+	    result = 1;
+	    break;
+	}
+    }
+    if (n < 0) result = 1;
+    free(buf);
+    if (gzclose(gz) != Z_OK) result = 1;
+    return result;
+}
+
+#endif /* HAVE_LIBZ */
+
+#ifdef HAVE_LIBZSTD
+
+static int
+zZstdDecompress(int src, int dst)
+{
+    ZSTD_DCtx *dctx;
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    size_t insize, outsize, ret = 0;
+    char *inbuf, *outbuf;
+    ssize_t n;
+    int result = 0;
+    u_char done = FALSE;
+
+    dctx = ZSTD_createDCtx();
+    if (dctx == NULL) return 1;
+    insize = ZSTD_DStreamInSize();
+    outsize = ZSTD_DStreamOutSize();
+    inbuf = (char *)malloc(insize);
+    outbuf = (char *)malloc(outsize);
+
+    while (!done && ((n = zRead(src, inbuf, insize)) > 0)) {
+	in.src = inbuf;
+	in.size = (size_t)n;
+	in.pos = 0;
+	out.size = out.pos = 0;
+
+	/* Continue while there is input, or while the output	*/
+	/* buffer fills (the decoder may hold more).		*/
+
+	while (!done && ((in.pos < in.size) || (out.pos == out.size))) {
+	    out.dst = outbuf;
+	    out.size = outsize;
+	    out.pos = 0;
+	    ret = ZSTD_decompressStream(dctx, &out, &in);
+	    if (ZSTD_isError(ret)) {
+		result = 1;
+		done = TRUE;
+	    }
+	    else if (zWriteAll(dst, outbuf, out.pos) != 0) {
+		if (errno != EPIPE) result = 1;
+		done = TRUE;
+	    }
+	}
+    }
+
+    /* A read error, or a last frame that was cut short, is a	*/
+    /* failure.							*/
+
+    if (!done && ((n < 0) || (ret != 0))) result = 1;
+
+    free(inbuf);
+    free(outbuf);
+    ZSTD_freeDCtx(dctx);
+    return result;
+}
+
+static int
+zZstdCompress(int src, int dst)
+{
+    ZSTD_CCtx *cctx;
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    ZSTD_EndDirective mode;
+    size_t insize, outsize, ret;
+    char *inbuf, *outbuf;
+    ssize_t n;
+    int result = 0;
+
+    cctx = ZSTD_createCCtx();
+    if (cctx == NULL) return 1;
+    insize = ZSTD_CStreamInSize();
+    outsize = ZSTD_CStreamOutSize();
+    inbuf = (char *)malloc(insize);
+    outbuf = (char *)malloc(outsize);
+
+    do {
+	n = zRead(src, inbuf, insize);
+	if (n < 0) {
+	    result = 1;
+	    break;
+	}
+	mode = (n == 0) ? ZSTD_e_end : ZSTD_e_continue;
+	in.src = inbuf;
+	in.size = (size_t)n;
+	in.pos = 0;
+	do {
+	    out.dst = outbuf;
+	    out.size = outsize;
+	    out.pos = 0;
+	    ret = ZSTD_compressStream2(cctx, &out, &in, mode);
+	    if (ZSTD_isError(ret) || (zWriteAll(dst, outbuf, out.pos) != 0)) {
+		result = 1;
+		break;
+	    }
+	} while ((mode == ZSTD_e_end) ? (ret != 0) : (in.pos < in.size));
+    } while ((result == 0) && (n > 0));
+
+    free(inbuf);
+    free(outbuf);
+    ZSTD_freeCCtx(cctx);
+    return result;
+}
+
+#endif /* HAVE_LIBZSTD */
+
+/* Run the codec for "zf" between "src" and "dst" */
+
+static int
+zRunCodec(ZFile *zf, int src, int dst)
+{
+    switch (zf->type) {
+#ifdef HAVE_LIBZ
+	case ZFILE_GZIP:
+	    return (zf->writing) ? zGzipCompress(src, dst) :
+			zGzipDecompress(src, dst);
+#endif
+#ifdef HAVE_LIBZSTD
+	case ZFILE_ZSTD:
+	    return (zf->writing) ? zZstdCompress(src, dst) :
+			zZstdDecompress(src, dst);
+#endif
+    }
+    return 1;
+}
+
+#ifdef HAVE_LIBPTHREAD
+
+/* Body of the thread at the far end of the pipe */
+
+static void *
+zCodecThread(void *arg)
+{
+    ZFile *zf = (ZFile *)arg;
+    sigset_t sigs;
+
+    /* A reader that stops early (for instance, a DEF reader	*/
+    /* reaching END DESIGN) closes the pipe.  That should end	*/
+    /* the thread with EPIPE, not the program with SIGPIPE.	*/
+
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+    if (zf->writing) {
+	zf->result = zRunCodec(zf, zf->codecfd, zf->fd);
+
+	/* If compression failed, take the rest of the output	*/
+	/* anyway, so that the writer does not get SIGPIPE.	*/
+
+	if (zf->result != 0) {
+	    char *buf = (char *)malloc(ZFILE_BUFSIZE);
+	    while (zRead(zf->codecfd, buf, ZFILE_BUFSIZE) > 0);
+	    free(buf);
+	}
+    }
+    else
+	zf->result = zRunCodec(zf, zf->fd, zf->codecfd);
+    close(zf->codecfd);
+    return NULL;
+}
+
+#endif /* HAVE_LIBPTHREAD */
+
+/*--------------------------------------------------------------*/
+/* ZFileSuffix ---						*/
+/*								*/
+/* Return a pointer to the compression suffix (".gz" or	*/
+/* ".zst") ending "filename", or NULL if it has none.		*/
+/*--------------------------------------------------------------*/
+
+char *
+ZFileSuffix(char *filename)
+{
+    char *dotptr;
+
+    dotptr = strrchr(filename, '.');
+    if (dotptr == NULL) return NULL;
+    if (!strcmp(dotptr, ".gz") || !strcmp(dotptr, ".zst")) return dotptr;
+    return NULL;
+}
+
+/* Format of file "fd", from its first bytes */
+
+static u_char
+zFileType(int fd)
+{
+    u_char magic[4];
+
+    if (pread(fd, magic, 4, 0) != 4) return ZFILE_NONE;
+    if ((magic[0] == 0x1f) && (magic[1] == 0x8b)) return ZFILE_GZIP;
+    if ((magic[0] == 0x28) && (magic[1] == 0xb5) && (magic[2] == 0x2f) &&
+		(magic[3] == 0xfd)) return ZFILE_ZSTD;
+    return ZFILE_NONE;
+}
+
+/*--------------------------------------------------------------*/
+/* ZFileOpen ---						*/
+/*								*/
+/* Open "filename" for reading (mode "r") or writing ("w").	*/
+/* If the file is compressed, the stream returned reads or	*/
+/* writes the uncompressed text.  Otherwise this is fopen().	*/
+/* Streams returned must be closed with ZFileClose().		*/
+/*								*/
+/* Returns NULL on failure.					*/
+/*--------------------------------------------------------------*/
+
+FILE *
+ZFileOpen(char *filename, char *mode)
+{
+    ZFile *zf;
+    FILE *f;
+    u_char type, writing;
+    char *suffix;
+    int fd;
+#ifdef HAVE_LIBPTHREAD
+    int fds[2];
+#endif
+
+    writing = (*mode == 'w') ? TRUE : FALSE;
+    if (writing) {
+	suffix = ZFileSuffix(filename);
+	if (suffix == NULL)
+	    type = ZFILE_NONE;
+	else
+	    type = (!strcmp(suffix, ".gz")) ? ZFILE_GZIP : ZFILE_ZSTD;
+	if (type == ZFILE_NONE) return fopen(filename, mode);
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    }
+    else {
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) return NULL;
+	type = zFileType(fd);
+	if (type == ZFILE_NONE) {
+	    f = fdopen(fd, mode);
+	    if (f == NULL) close(fd);
+	    return f;
+	}
+    }
+    if (fd < 0) return NULL;
+
+#ifndef HAVE_LIBZ
+    if (type == ZFILE_GZIP) {
+	Fprintf(stderr, "%s:  qrouter was compiled without gzip support.\n",
+		filename);
+	close(fd);
+	errno = ENOTSUP;
+	return NULL;
+    }
+#endif
+#ifndef HAVE_LIBZSTD
+    if (type == ZFILE_ZSTD) {
+	Fprintf(stderr, "%s:  qrouter was compiled without zstd support.\n",
+		filename);
+	close(fd);
+	errno = ENOTSUP;
+	return NULL;
+    }
+#endif
+
+    zf = (ZFile *)calloc(1, sizeof(ZFile));
+    zf->name = strdup(filename);
+    zf->fd = fd;
+    zf->type = type;
+    zf->writing = writing;
+
+#ifdef HAVE_LIBPTHREAD
+    if (pipe(fds) == 0) {
+#ifdef F_SETPIPE_SZ
+	fcntl(fds[0], F_SETPIPE_SZ, 1024 * 1024);
+#endif
+	zf->codecfd = (writing) ? fds[0] : fds[1];
+	f = fdopen((writing) ? fds[1] : fds[0], mode);
+	if ((f != NULL) && (pthread_create(&zf->thread, NULL,
+			zCodecThread, (void *)zf) == 0)) {
+	    zf->f = f;
+	    zf->next = ZFileList;
+	    ZFileList = zf;
+	    return f;
+	}
+	if (f != NULL) fclose(f);
+	else close((writing) ? fds[1] : fds[0]);
+	close(zf->codecfd);
+    }
+#endif
+
+    /* No thread:  the text goes through a temporary file */
+
+    f = tmpfile();
+    if ((f != NULL) && !writing) {
+	if (zRunCodec(zf, fd, fileno(f)) != 0) {
+	    Fprintf(stderr, "%s:  Corrupt %s data.\n", filename,
+			ZFileFormat[type]);
+	    fclose(f);
+	    f = NULL;
+	    errno = EIO;
+	}
+	else
+	    lseek(fileno(f), 0, SEEK_SET);
+    }
+    if (f == NULL) {
+	close(fd);
+	free(zf->name);
+	free(zf);
+	return NULL;
+    }
+    zf->f = f;
+    zf->codecfd = -1;
+    zf->next = ZFileList;
+    ZFileList = zf;
+    return f;
+}
+
+/*--------------------------------------------------------------*/
+/* ZFileClose ---						*/
+/*								*/
+/* Close a stream opened with ZFileOpen() (or with fopen()),	*/
+/* completing the compressed file if it was being written.	*/
+/*								*/
+/* Returns 0 on success, or EOF if any data could not be	*/
+/* written or (once read to the end) was corrupt.		*/
+/*--------------------------------------------------------------*/
+
+int
+ZFileClose(FILE *f)
+{
+    ZFile *zf, **zp;
+    int result;
+
+    for (zp = &ZFileList; *zp; zp = &(*zp)->next)
+	if ((*zp)->f == f) break;
+    zf = *zp;
+    if (zf == NULL) return fclose(f);
+    *zp = zf->next;
+
+#ifdef HAVE_LIBPTHREAD
+    if (zf->codecfd >= 0) {
+	result = fclose(f);
+	pthread_join(zf->thread, NULL);
+    }
+    else
+#endif
+    if (zf->writing) {
+	if (fflush(f) != 0)
+	    result = EOF;
+	else {
+	    lseek(fileno(f), 0, SEEK_SET);
+	    zf->result = zRunCodec(zf, fileno(f), zf->fd);
+	    result = 0;
+	}
+	fclose(f);
+    }
+    else
+	result = fclose(f);
+
+    if (zf->result != 0) {
+	Fprintf(stderr, "%s:  Error in %s %s.\n", zf->name, ZFileFormat[zf->type],
+		(zf->writing) ? "compression" : "decompression");
+	result = EOF;
+    }
+    if (close(zf->fd) != 0) result = EOF;
+    free(zf->name);
+    free(zf);
+    return (result == 0) ? 0 : EOF;
+}
+
+/*--------------------------------------------------------------*/
+/* ZFileDescriptor ---						*/
+/*								*/
+/* Return the file descriptor of the file underlying "f".  For	*/
+/* a compressed file, this is the compressed file, not the	*/
+/* stream of text.						*/
+/*--------------------------------------------------------------*/
+
+int
+ZFileDescriptor(FILE *f)
+{
+    ZFile *zf;
+
+    for (zf = ZFileList; zf; zf = zf->next)
+	if (zf->f == f) return zf->fd;
+    return fileno(f);
+}
@@ -0,0 +1,20 @@
+/*
+ * zfile.h --
+ *
+ * Reading and writing of gzip- and zstd-compressed files.
+ *
+ */
+
+#ifndef _ZFILEINT_H
+#define _ZFILEINT_H
+
+#define ZFILE_NONE	0
+#define ZFILE_GZIP	1
+#define ZFILE_ZSTD	2
+
+FILE  *ZFileOpen(char *filename, char *mode);
+int    ZFileClose(FILE *f);
+int    ZFileDescriptor(FILE *f);
+char  *ZFileSuffix(char *filename);
+
+#endif /* _ZFILEINT_H */